@@ -24,6 +24,7 @@
       , "libantares-data"
       , "libantares-drawing"
       , "libantares-game"
+      , "libantares-lang"
       , "libantares-math"
       , "libantares-sound"
       , "libantares-ui"
@@ -35,6 +36,7 @@
       , "libantares-data"
       , "libantares-drawing"
       , "libantares-game"
+      , "libantares-lang"
       , "libantares-math"
       , "libantares-sound"
       , "libantares-ui"
@@ -71,12 +73,14 @@
   , { "target_name": "libantares-data"
     , "type": "static_library"
     , "sources":
-      [ "src/data/extractor.cpp"
+      [ "src/data/extraction.cpp"
+      , "src/data/extractor.cpp"
       , "src/data/interface.cpp"
       , "src/data/picture.cpp"
       , "src/data/races.cpp"
       , "src/data/replay-list.cpp"
       , "src/data/replay.cpp"
+      , "src/data/resource-index.cpp"
       , "src/data/resource.cpp"
       , "src/data/scenario-list.cpp"
       , "src/data/scenario.cpp"
@@ -95,6 +99,7 @@
       , "<(DEPTH)/ext/libzipxx/libzipxx.gyp:libzipxx"
       , "<(DEPTH)/ext/rezin/rezin.gyp:librezin"
       ]
+    , "link_settings": {"libraries": ["-lz"]}
     }
 
   , { "target_name": "libantares-drawing"
@@ -106,6 +111,7 @@
       , "src/drawing/interface.cpp"
       , "src/drawing/libpng-pix-map.cpp"
       , "src/drawing/pix-map.cpp"
+      , "src/drawing/pix-spans.cpp"
       , "src/drawing/pix-table.cpp"
       , "src/drawing/shapes.cpp"
       , "src/drawing/sprite-handling.cpp"
@@ -132,6 +138,7 @@
       , "src/game/globals.cpp"
       , "src/game/input-source.cpp"
       , "src/game/instruments.cpp"
+      , "src/game/kinematics.cpp"
       , "src/game/labels.cpp"
       , "src/game/main.cpp"
       , "src/game/messages.cpp"
@@ -139,15 +146,32 @@
       , "src/game/motion.cpp"
       , "src/game/non-player-ship.cpp"
       , "src/game/player-ship.cpp"
+      , "src/game/profile.cpp"
       , "src/game/scenario-maker.cpp"
+      , "src/game/snapshot.cpp"
       , "src/game/space-object.cpp"
+      , "src/game/spatial-index.cpp"
       , "src/game/starfield.cpp"
+      , "src/game/sync.cpp"
       , "src/game/time.cpp"
       ]
     , "dependencies": ["<(DEPTH)/ext/libsfz/libsfz.gyp:libsfz"]
     , "export_dependent_settings": ["<(DEPTH)/ext/libsfz/libsfz.gyp:libsfz"]
     }
 
+  , { "target_name": "libantares-lang"
+    , "type": "static_library"
+    , "sources": ["src/lang/worker-pool.cpp"]
+    , "dependencies": ["<(DEPTH)/ext/libsfz/libsfz.gyp:libsfz"]
+    , "export_dependent_settings": ["<(DEPTH)/ext/libsfz/libsfz.gyp:libsfz"]
+    , "conditions":
+      [ [ "OS != 'mac'"
+        , { "link_settings": {"libraries": ["-lpthread"]}
+          }
+        ]
+      ]
+    }
+
   , { "target_name": "libantares-math"
     , "type": "static_library"
     , "sources":
@@ -283,18 +307,42 @@
     , "dependencies": ["libantares-test"]
     }
 
+  , { "target_name": "motion-bench"
+    , "type": "executable"
+    , "sources": ["src/bin/motion-bench.cpp"]
+    , "dependencies": ["libantares-test"]
+    }
+
   , { "target_name": "object-data"
     , "type": "executable"
     , "sources": ["src/bin/object-data.cpp"]
     , "dependencies": ["libantares-test"]
     }
 
+  , { "target_name": "pack-sprites"
+    , "type": "executable"
+    , "sources": ["src/bin/pack-sprites.cpp"]
+    , "dependencies": ["libantares-test"]
+    }
+
+  , { "target_name": "pix-bench"
+    , "type": "executable"
+    , "sources": ["src/bin/pix-bench.cpp"]
+    , "dependencies": ["libantares-test"]
+    }
+
   , { "target_name": "replay"
     , "type": "executable"
     , "sources": ["src/bin/replay.cpp"]
     , "dependencies": ["libantares-test"]
     }
 
+  , { "target_name": "replay-batch"
+    , "type": "executable"
+    , "sources": ["src/bin/replay-batch.cpp"]
+    , "dependencies": ["libantares-test"]
+    }
+
   , { "target_name": "shapes"
     , "type": "executable"
     , "sources": ["src/bin/shapes.cpp"]
@@ -310,13 +358,50 @@
   , { "target_name": "libantares-test"
     , "type": "static_library"
     , "sources":
-      [ "src/test/resource.cpp"
+      [ "src/test/replay.cpp"
+      , "src/test/resource.cpp"
       , "src/video/offscreen-driver.cpp"
+      , "src/video/snapshot-encoder.cpp"
+      , "src/video/software-driver.cpp"
       , "src/video/text-driver.cpp"
+      , "src/video/y4m-writer.cpp"
       ]
     , "defines": ["ANTARES_DATA=<(DEPTH)/data"]
     , "dependencies": ["libantares"]
     , "export_dependent_settings": ["libantares"]
+    , "conditions":
+      [ [ "OS != 'mac'"
+        , { "sources!": ["src/video/offscreen-driver.cpp"]
+          }
+        ]
+      ]
+    }
+
+  , { "target_name": "delay-queue-test"
+    , "type": "executable"
+    , "sources": ["src/game/delay-queue.test.cpp"]
+    , "dependencies":
+      [ "libantares-test"
+      , "<(DEPTH)/ext/gmock-gyp/gmock.gyp:gmock_main"
+      ]
+    }
+
+  , { "target_name": "event-scheduler-test"
+    , "type": "executable"
+    , "sources": ["src/ui/event-scheduler.test.cpp"]
+    , "dependencies":
+      [ "libantares-test"
+      , "<(DEPTH)/ext/gmock-gyp/gmock.gyp:gmock_main"
+      ]
+    }
+
+  , { "target_name": "extraction-test"
+    , "type": "executable"
+    , "sources": ["src/data/extraction.test.cpp"]
+    , "dependencies":
+      [ "libantares-test"
+      , "<(DEPTH)/ext/gmock-gyp/gmock.gyp:gmock_main"
+      ]
     }
 
   , { "target_name": "fixed-test"
@@ -327,6 +412,51 @@
       , "<(DEPTH)/ext/gmock-gyp/gmock.gyp:gmock_main"
       ]
     }
+
+  , { "target_name": "kinematics-test"
+    , "type": "executable"
+    , "sources": ["src/game/kinematics.test.cpp"]
+    , "dependencies":
+      [ "libantares-test"
+      , "<(DEPTH)/ext/gmock-gyp/gmock.gyp:gmock_main"
+      ]
+    }
+
+  , { "target_name": "replay-test"
+    , "type": "executable"
+    , "sources": ["src/data/replay.test.cpp"]
+    , "dependencies":
+      [ "libantares-test"
+      , "<(DEPTH)/ext/gmock-gyp/gmock.gyp:gmock_main"
+      ]
+    }
+
+  , { "target_name": "resource-index-test"
+    , "type": "executable"
+    , "sources": ["src/data/resource-index.test.cpp"]
+    , "dependencies":
+      [ "libantares-test"
+      , "<(DEPTH)/ext/gmock-gyp/gmock.gyp:gmock_main"
+      ]
+    }
+
+  , { "target_name": "spatial-index-test"
+    , "type": "executable"
+    , "sources": ["src/game/spatial-index.test.cpp"]
+    , "dependencies":
+      [ "libantares-test"
+      , "<(DEPTH)/ext/gmock-gyp/gmock.gyp:gmock_main"
+      ]
+    }
+
+  , { "target_name": "sync-test"
+    , "type": "executable"
+    , "sources": ["src/game/sync.test.cpp"]
+    , "dependencies":
+      [ "libantares-test"
+      , "<(DEPTH)/ext/gmock-gyp/gmock.gyp:gmock_main"
+      ]
+    }
   ]
 
 , "conditions":
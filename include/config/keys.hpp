@@ -36,6 +36,9 @@ class KeyMap {
     void clear();
 
   private:
+    friend void read_from(sfz::ReadSource in, KeyMap& key_map);
+    friend void write_to(sfz::WriteTarget out, const KeyMap& key_map);
+
     typedef uint8_t Data[32];
     static const size_t kDataSize = sizeof(Data);
 
@@ -46,6 +49,8 @@ class KeyMap {
 
 bool operator==(const KeyMap& a, const KeyMap& b);
 bool operator!=(const KeyMap& a, const KeyMap& b);
+void read_from(sfz::ReadSource in, KeyMap& key_map);
+void write_to(sfz::WriteTarget out, const KeyMap& key_map);
 
 struct Keys {
     // USB Key codes.
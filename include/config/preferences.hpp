@@ -47,6 +47,8 @@ class Preferences {
     bool fullscreen() const;
     Size screen_size() const;
     sfz::StringSlice scenario_identifier() const;
+    int sync_interval() const;
+    int32_t space_object_limit() const;
 
     void set_key(size_t index, uint32_t key);
     void set_play_idle_music(bool on);
@@ -56,6 +58,8 @@ class Preferences {
     void set_fullscreen(bool fullscreen);
     void set_screen_size(Size size);
     void set_scenario_identifier(sfz::StringSlice id);
+    void set_sync_interval(int cycles);
+    void set_space_object_limit(int32_t limit);
 
   private:
     static std::unique_ptr<Preferences> _preferences;
@@ -68,6 +72,8 @@ class Preferences {
     bool                _fullscreen;
     Size                _screen_size;
     sfz::String         _scenario_identifier;
+    int32_t             _sync_interval;
+    int32_t             _space_object_limit;
 };
 
 class PrefsDriver {
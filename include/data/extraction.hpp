@@ -0,0 +1,119 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#ifndef ANTARES_DATA_EXTRACTION_HPP_
+#define ANTARES_DATA_EXTRACTION_HPP_
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <sfz/sfz.hpp>
+
+namespace antares {
+
+// A file that a conversion produces besides its main output, such as a sprite's images.  The path
+// is relative to the scenario directory.
+struct ExtraFile {
+    sfz::String path;
+    sfz::Bytes data;
+};
+typedef std::vector<std::unique_ptr<ExtraFile>> ExtraFiles;
+
+typedef bool (*Converter)(sfz::StringSlice dir, int16_t id, sfz::BytesSlice data,
+                          sfz::WriteTarget out, ExtraFiles& extra);
+
+// What was extracted into a scenario directory: for each resource, a digest of its input, and
+// the files it produced.  Re-extracting converts only the resources whose digest changed, and
+// deletes the files of resources which are gone.
+//
+// The record is kept in the scenario directory as text: the extractor's version, then a line per
+// resource with its digest, the path of its main output, and its files, each followed by a tab.
+// A line is appended as soon as a resource is written, so if extraction fails partway, the next
+// attempt picks up where it stopped.  If a resource has more than one line, the last one counts.
+// A record left by another version of the extractor is not used.
+class ExtractionRecord {
+  public:
+    ExtractionRecord(const sfz::StringSlice& scenario_dir, const sfz::StringSlice& version);
+
+    // Reads the record left by the last extraction, and starts a new one.  Without a usable
+    // record, nothing is known about the files in the scenario directory, so it is cleared.
+    void start();
+
+    // True if `key` was last extracted from input with `digest`, and its files are still there.
+    bool current(const sfz::StringSlice& key, const sfz::StringSlice& digest) const;
+
+    void keep(const sfz::StringSlice& key);
+
+    // Records that `key` was extracted from input with `digest` into `files`, and deletes any
+    // files it produced last time but doesn't now.
+    void update(const sfz::StringSlice& key, const sfz::StringSlice& digest,
+                const std::vector<sfz::String>& files);
+
+    // Deletes the files of resources which were neither kept nor updated since start(), and
+    // rewrites the record without them.
+    void finish();
+
+  private:
+    struct Entry {
+        Entry(): seen(false) { }
+        sfz::String digest;
+        std::vector<sfz::String> files;
+        bool seen;
+    };
+
+    bool load();
+    void rewrite() const;
+    static sfz::String line(const sfz::StringSlice& key, const Entry& entry);
+    void remove(const sfz::StringSlice& file) const;
+
+    const sfz::String _dir;
+    const sfz::String _path;
+    const sfz::String _version;
+    sfz::StringMap<Entry> _entries;
+
+    DISALLOW_COPY_AND_ASSIGN(ExtractionRecord);
+};
+
+// One resource to extract.  `input` points into an archive, which outlives the extraction.
+struct Extraction {
+    Extraction(const sfz::StringSlice& path, int16_t id, sfz::BytesSlice input,
+               Converter convert);
+
+    const sfz::String path;  // of the main output, relative to the scenario directory
+    const int16_t id;
+    const sfz::BytesSlice input;
+    const Converter convert;
+
+    sfz::String digest;
+    bool current;
+    bool converted;
+    sfz::Bytes data;
+    ExtraFiles extra;
+};
+
+// Converts `extractions` in parallel, and writes each one's files in order as it finishes.  The
+// files and the record come out the same however the conversions were scheduled.  Each file is
+// written beside its final path and renamed into place, so that a resource still mapped from
+// the old file keeps its old contents.
+void extract_all(
+        const sfz::StringSlice& scenario_dir, std::vector<std::unique_ptr<Extraction>>& extractions,
+        ExtractionRecord& record);
+
+}  // namespace antares
+
+#endif  // ANTARES_DATA_EXTRACTION_HPP_
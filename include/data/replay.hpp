@@ -40,13 +40,34 @@ struct ReplayData {
         std::vector<uint8_t> keys_up;
     };
 
+    // The state of the game (see game/snapshot.hpp) as of the start of decide cycle `at`, before
+    // that cycle's actions.
+    struct Snapshot {
+        uint64_t at;
+        sfz::Bytes data;
+    };
+
+    // A digest of the state of the game (see game/sync.hpp) after decide cycle `at`.
+    struct Sync {
+        uint64_t at;
+        sfz::Bytes data;
+    };
+
     Scenario scenario;
     int32_t chapter_id;
     int32_t global_seed;
+    // The space object limit the game was played with.  Only recorded if it isn't
+    // kDefaultSpaceObjectLimit, so replays from before it could be changed read as the default.
+    int32_t object_limit;
     uint64_t duration;
     std::vector<Action> actions;
+    std::vector<Snapshot> snapshots;
+    std::vector<Sync> syncs;
 
     ReplayData();
+
+    // Reads either format: the v2 container (see ReplayFile), or the original stream of tagged
+    // messages, which read_from() below decodes.
     ReplayData(sfz::BytesSlice in);
 
     void key_down(uint64_t at, uint32_t key);
@@ -55,9 +76,179 @@ struct ReplayData {
 void read_from(sfz::ReadSource in, ReplayData& replay);
 void read_from(sfz::ReadSource in, ReplayData::Scenario& scenario);
 void read_from(sfz::ReadSource in, ReplayData::Action& action);
+void read_from(sfz::ReadSource in, ReplayData::Snapshot& snapshot);
+void read_from(sfz::ReadSource in, ReplayData::Sync& sync);
 void write_to(sfz::WriteTarget out, const ReplayData& replay);
 void write_to(sfz::WriteTarget out, const ReplayData::Scenario& scenario);
 void write_to(sfz::WriteTarget out, const ReplayData::Action& action);
+void write_to(sfz::WriteTarget out, const ReplayData::Snapshot& snapshot);
+void write_to(sfz::WriteTarget out, const ReplayData::Sync& sync);
+
+// The v2 replay container.  The original format is a stream of tagged messages, one per action,
+// which has to be decoded all at once and allocates for every action.  The v2 container keeps
+// the same header, but stores actions, sync digests and snapshots in chunks:
+//
+//   * actions are stored as columns: the decide cycle of each action, delta-encoded, and the
+//     number of key events in it, both as varints; then the key events of every action, one byte
+//     each, in the order they happened.  A key event is the key number shifted left by one, with
+//     the low bit set if the key was released.
+//   * sync digests are stored as a column of delta-encoded decide cycles, a column of lengths,
+//     and the digests themselves.
+//   * each snapshot has a chunk of its own.
+//
+// Each chunk is compressed independently, and an index of chunks at the end of the file lets a
+// reader seek to a decide cycle without decoding anything before it.  A file whose index was
+// never written, because the game quit before finishing it, is read by walking the chunks.
+class ReplayFile {
+  public:
+    enum ChunkKind {
+        ACTION_CHUNK = 1,
+        SYNC_CHUNK = 2,
+        SNAPSHOT_CHUNK = 3,
+    };
+
+    struct Chunk {
+        ChunkKind kind;
+        uint64_t first_at;
+        uint64_t last_at;
+        uint32_t count;
+        uint32_t raw_size;
+        bool compressed;
+        sfz::BytesSlice stored;
+    };
+
+    // A row of an action chunk: the keys pressed and released in decide cycle `at`, as key
+    // events in the order they happened.
+    struct ActionRow {
+        uint64_t at;
+        sfz::BytesSlice events;
+    };
+
+    static uint8_t key_event(uint8_t key, bool up) { return (key << 1) | up; }
+    static uint8_t event_key(uint8_t event) { return event >> 1; }
+    static bool event_is_up(uint8_t event) { return event & 1; }
+
+    // Reads the actions of a file in order, decoding one chunk at a time into a buffer that is
+    // reused from chunk to chunk.  The events of a row stay valid until the cursor moves on to
+    // the next chunk; that is, until the row after it has been read.
+    class ActionCursor {
+      public:
+        explicit ActionCursor(const ReplayFile& file);
+
+        // Positions the cursor at the first action at or after decide cycle `at`.
+        void seek(uint64_t at);
+
+        // Returns false at the end of the file.
+        bool next(ActionRow* row);
+
+      private:
+        bool load(size_t chunk);
+
+        const ReplayFile& _file;
+        size_t _chunk;
+        sfz::Bytes _raw;
+        sfz::BytesSlice _at_column;
+        sfz::BytesSlice _count_column;
+        sfz::BytesSlice _event_column;
+        uint64_t _at;
+        uint32_t _remaining;
+    };
+
+    // A sync digest recorded after decide cycle `at`.
+    struct SyncRow {
+        uint64_t at;
+        sfz::BytesSlice data;
+    };
+
+    // Like ActionCursor, for sync digests.
+    class SyncCursor {
+      public:
+        explicit SyncCursor(const ReplayFile& file);
+
+        // Positions the cursor at the first digest at or after decide cycle `at`.
+        void seek(uint64_t at);
+
+        // Returns false at the end of the file.
+        bool next(SyncRow* row);
+
+      private:
+        bool load(size_t chunk);
+
+        const ReplayFile& _file;
+        size_t _chunk;
+        sfz::Bytes _raw;
+        sfz::BytesSlice _at_column;
+        sfz::BytesSlice _size_column;
+        sfz::BytesSlice _data_column;
+        uint64_t _at;
+        uint32_t _remaining;
+    };
+
+    // True if `data` starts like a v2 container.
+    static bool is_replay_file(sfz::BytesSlice data);
+
+    // `data` must outlive the ReplayFile.  Throws an exception if it is not a v2 container.
+    explicit ReplayFile(sfz::BytesSlice data);
+
+    const ReplayData::Scenario& scenario() const { return _scenario; }
+    int32_t chapter_id() const { return _chapter_id; }
+    int32_t global_seed() const { return _global_seed; }
+    int32_t object_limit() const { return _object_limit; }
+    uint64_t duration() const { return _duration; }
+    const std::vector<Chunk>& chunks() const { return _chunks; }
+
+    // Decompresses `chunk` into `*raw`, replacing its contents.
+    void decode(const Chunk& chunk, sfz::Bytes* raw) const;
+
+    // Decodes everything, for code that wants the whole of a replay at once.
+    void read_all(ReplayData* replay) const;
+
+  private:
+    // Returns the last chunk of kind `kind` that starts at or before decide cycle `at`.
+    size_t seek_chunk(ChunkKind kind, uint64_t at) const;
+
+    ReplayData::Scenario _scenario;
+    int32_t _chapter_id;
+    int32_t _global_seed;
+    int32_t _object_limit;
+    uint64_t _duration;
+    std::vector<Chunk> _chunks;
+};
+
+// Writes the v2 container to a file as a game is played.  Actions and sync digests are buffered
+// until a chunk's worth have been collected; finish() writes what remains, and the index.
+class ReplayWriter {
+  public:
+    ReplayWriter(
+            int fd, const ReplayData::Scenario& scenario, int32_t chapter_id,
+            int32_t global_seed, int32_t object_limit);
+
+    void key_down(uint64_t at, uint8_t key);
+    void key_up(uint64_t at, uint8_t key);
+    void add_sync(uint64_t at, sfz::BytesSlice data);
+    void add_snapshot(uint64_t at, sfz::BytesSlice data);
+    void finish(uint64_t duration);
+
+  private:
+    void add_key_event(uint64_t at, uint8_t event);
+    void flush_actions();
+    void flush_syncs();
+    void write_chunk(
+            ReplayFile::ChunkKind kind, uint64_t first_at, uint64_t last_at, uint32_t count,
+            const sfz::Bytes& raw);
+
+    sfz::ScopedFd _file;
+    uint64_t _offset;
+    std::vector<uint64_t> _index;
+    std::vector<uint64_t> _action_at;
+    std::vector<uint32_t> _action_count;
+    sfz::Bytes _action_events;
+    std::vector<uint64_t> _sync_at;
+    std::vector<uint32_t> _sync_size;
+    sfz::Bytes _sync_data;
+
+    DISALLOW_COPY_AND_ASSIGN(ReplayWriter);
+};
 
 class ReplayBuilder : public EventReceiver {
   public:
@@ -65,19 +256,31 @@ class ReplayBuilder : public EventReceiver {
 
     void init(
             sfz::StringSlice scenario_identifier, sfz::StringSlice scenario_version,
-            int32_t chapter_id, int32_t global_seed);
+            int32_t chapter_id, int32_t global_seed, int32_t object_limit);
     void start();
     virtual void key_down(const KeyDownEvent& key);
     virtual void key_up(const KeyUpEvent& key);
     void next();
     void finish();
 
+    // True once every kSnapshotInterval decide cycles while recording.  The caller is expected
+    // to respond by passing a snapshot of the game to add_snapshot().
+    bool wants_snapshot() const;
+    void add_snapshot(sfz::BytesSlice data);
+
+    // True once every Preferences::sync_interval() decide cycles while recording.  The caller
+    // is expected to respond by passing a digest of the game to add_sync().
+    bool wants_sync() const;
+    void add_sync(sfz::BytesSlice data);
+
   private:
-    std::unique_ptr<sfz::ScopedFd> _file;
+    std::unique_ptr<ReplayWriter> _writer;
     ReplayData::Scenario _scenario;
     int32_t _chapter_id;
     int32_t _global_seed;
+    int32_t _object_limit;
     uint64_t _at;
+    uint64_t _sync_interval;
 };
 
 }  // namespace antares
@@ -0,0 +1,78 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#ifndef ANTARES_DATA_RESOURCE_INDEX_HPP_
+#define ANTARES_DATA_RESOURCE_INDEX_HPP_
+
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sfz/sfz.hpp>
+
+#include "data/resource.hpp"
+
+namespace antares {
+
+// The files in the search directories, and which of them are mapped.  Paths are kept as UTF-8,
+// as the file system gives them.
+class ResourceIndex {
+  public:
+    // `search_dirs` returns the directories to search, in order of precedence.  It is called
+    // again for each walk, as the directories depend on the current scenario.
+    explicit ResourceIndex(std::vector<sfz::String> (*search_dirs)());
+    ~ResourceIndex();
+
+    // Maps the first of `resource_paths` found, and sets `*which` to its index.  Each directory
+    // is searched for all of them before the next, so that a scenario's own version of a
+    // resource wins, in whatever form.
+    std::shared_ptr<sfz::MappedFile> load_first(
+            const std::vector<sfz::String>& resource_paths, size_t* which);
+
+    // Finds `resource_path` as load_first() would, and sets `*stamp` from the file without
+    // mapping it.  Returns false if there is no such resource.
+    bool stamp(const sfz::StringSlice& resource_path, ResourceStamp* stamp);
+
+    void rescan();
+    ResourceStats stats();
+
+  private:
+    void scan();
+    std::string find_first(const std::vector<std::string>& paths, size_t* which);
+    void walk(size_t dir, const std::string& path, const std::string& prefix);
+    std::shared_ptr<sfz::MappedFile> map(const std::string& path);
+
+    std::vector<sfz::String> (*const _search_dirs)();
+    std::mutex _mutex;
+    bool _scanned;
+    sfz::String _scenario;
+    std::vector<std::string> _dirs;
+    // resource path -> index of the first directory with it
+    std::unordered_map<std::string, size_t> _manifest;
+    // full path -> mapping, while any Resource still holds it
+    std::unordered_map<std::string, std::weak_ptr<sfz::MappedFile>> _mappings;
+    ResourceStats _stats;
+
+    DISALLOW_COPY_AND_ASSIGN(ResourceIndex);
+};
+
+}  // namespace antares
+
+#endif // ANTARES_DATA_RESOURCE_INDEX_HPP_
@@ -20,6 +20,7 @@
 #define ANTARES_DATA_RESOURCE_HPP_
 
 #include <stdint.h>
+#include <vector>
 #include <sfz/sfz.hpp>
 
 namespace antares {
@@ -28,13 +29,44 @@ class Resource {
   public:
     Resource(const sfz::StringSlice& type, const sfz::StringSlice& extension, int id);
     Resource(const sfz::PrintItem& resource_path);
+
+    // Loads whichever of `resource_paths` is found first, and sets `*which` to its index.  A
+    // resource may be stored in more than one form; list the preferred form first.
+    Resource(const std::vector<sfz::String>& resource_paths, size_t* which);
     ~Resource();
 
     sfz::BytesSlice data() const;
 
   private:
-    std::unique_ptr<sfz::MappedFile> _file;
+    std::shared_ptr<sfz::MappedFile> _file;
+};
+
+// Counts of the work done to find and map resources since the program started.
+struct ResourceStats {
+    int64_t hits;       // resources loaded from a file that was already mapped
+    int64_t misses;     // resources for which a file was mapped
+    int64_t scans;      // walks of the search directories
+    int64_t dir_reads;  // directories opened by those walks
+    int64_t stats;      // files stat()ed, by walks or by lookups missing from the last walk
 };
+ResourceStats resource_stats();
+
+// The size and modification time of the file a resource is loaded from.  Comparing these is much
+// cheaper than reading the file, and still notices it being replaced.
+struct ResourceStamp {
+    int64_t size;
+    int64_t mtime;
+};
+
+// Finds `resource_path` as Resource does, without mapping it, and sets `*stamp`.  Returns false
+// if there is no such resource.
+bool resource_stamp(const sfz::PrintItem& resource_path, ResourceStamp* stamp);
+
+// Resources are found through a manifest of the search directories, built by walking them when
+// the first resource is loaded, and again whenever the scenario changes.  Call this after adding
+// or replacing files in the search directories, so that the next resource loaded walks them
+// again and maps the new files.
+void rescan_resources();
 
 }  // namespace antares
 
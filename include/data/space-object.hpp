@@ -29,7 +29,15 @@
 
 namespace antares {
 
-const int32_t kMaxSpaceObject           = 250;
+// The object pool starts with one chunk and grows a chunk at a time, up to the object limit.
+// The limit defaults to the 250 objects Ares had room for: a game that reaches it plays out
+// differently with more room, so replays record the limit they were played with.  It may be
+// raised as far as kMaxSpaceObject, with Preferences::set_space_object_limit().  There are
+// kSpritesPerObject sprites for each object.
+const int32_t kSpaceObjectChunkSize     = 256;
+const int32_t kDefaultSpaceObjectLimit  = 250;
+const int32_t kMaxSpaceObject           = 32768;
+const int32_t kSpritesPerObject         = 2;
 
 const int32_t kTimeToCheckHome          = 900;
 
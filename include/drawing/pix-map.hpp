@@ -231,6 +231,31 @@ class PixMap::View : public PixMap {
     // ALLOW_COPY_AND_ASSIGN(View);
 };
 
+// A read-only PixMap over pixels stored elsewhere, such as in a mapped file.
+//
+// The pixels are neither copied nor owned, and must outlive this object.  Rows are contiguous.
+// Since the pixels may not be writable, `mutable_bytes()` throws, and so do all of the utility
+// methods which modify pixels.
+class ConstPixMap : public PixMap {
+  public:
+    // @param [in] size     the size of the PixMap.
+    // @param [in] bytes    `size.width * size.height` pixels, row by row.
+    ConstPixMap(Size size, const RgbColor* bytes);
+
+    // Implementations of the core PixMap methods.
+    virtual const Size& size() const;
+    virtual const RgbColor* bytes() const;
+    virtual int row_bytes() const;
+
+    virtual RgbColor* mutable_bytes();
+
+  private:
+    const Size _size;
+    const RgbColor* const _bytes;
+
+    DISALLOW_COPY_AND_ASSIGN(ConstPixMap);
+};
+
 }  // namespace antares
 
 #endif  // ANTARES_DRAWING_PIX_MAP_HPP_
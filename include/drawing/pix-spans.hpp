@@ -0,0 +1,60 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#ifndef ANTARES_DRAWING_PIX_SPANS_HPP_
+#define ANTARES_DRAWING_PIX_SPANS_HPP_
+
+#include <stdint.h>
+
+#include "drawing/color.hpp"
+
+namespace antares {
+
+// Kernels for PixMap's bulk operations, each working on a span of `count` contiguous pixels
+// within a row.  They take plain pointers, so the per-pixel work makes no virtual calls.
+
+// Instruction sets for the span kernels.  Every one of them gives byte-for-byte the same
+// results as PIX_SPAN_SCALAR, which is the reference.
+enum PixSpanIsa {
+    PIX_SPAN_SCALAR,
+    PIX_SPAN_SSE2,
+    PIX_SPAN_AVX2,
+};
+
+bool pix_span_isa_supported(PixSpanIsa isa);
+// The fastest instruction set this CPU supports, which the kernels use by default.
+PixSpanIsa best_pix_span_isa();
+
+// Sets every pixel of `dst` to `color`.
+void fill_span(RgbColor* dst, const RgbColor& color, int32_t count);
+void fill_span(RgbColor* dst, const RgbColor& color, int32_t count, PixSpanIsa isa);
+
+// Composites `src` over `dst`, as PixMap::composite() does.
+void composite_span(RgbColor* dst, const RgbColor* src, int32_t count);
+void composite_span(RgbColor* dst, const RgbColor* src, int32_t count, PixSpanIsa isa);
+
+// Blends `overlay` over `dst`, as a sprite's overlay is: the overlay's red channel is the
+// brightness of RgbColor::tint(color, ...), and its alpha is the opacity.  The alpha of `dst` is
+// left alone.
+void tint_span(RgbColor* dst, const RgbColor* overlay, uint8_t color, int32_t count);
+void tint_span(
+        RgbColor* dst, const RgbColor* overlay, uint8_t color, int32_t count, PixSpanIsa isa);
+
+}  // namespace antares
+
+#endif  // ANTARES_DRAWING_PIX_SPANS_HPP_
@@ -19,6 +19,7 @@
 #ifndef ANTARES_DRAWING_PIX_TABLE_HPP_
 #define ANTARES_DRAWING_PIX_TABLE_HPP_
 
+#include <memory>
 #include <vector>
 #include <sfz/sfz.hpp>
 
@@ -26,20 +27,40 @@
 
 namespace antares {
 
+class Resource;
 class Sprite;
 
 class NatePixTable {
   public:
     class Frame;
 
+    // Loads sprite table `id`, tinted with `color` if it is non-zero.  If the table has been
+    // compiled into a sprite pack (see write_pack()), and the JSON and images it was compiled
+    // from haven't changed since, its frames point straight into the mapped pack; otherwise,
+    // they are read from `sprites/<id>.json` and its images.
     NatePixTable(int id, uint8_t color);
     ~NatePixTable();
 
     const Frame& at(size_t index) const;
     size_t size() const;
 
+    // Compiles sprite table `id`, from its JSON and images, into a sprite pack: the bounds of
+    // each frame, then its pixels, already tinted with every color it can be.  The pack records
+    // the size and modification time of its sources, so that it stops being used once they
+    // change.
+    static void write_pack(sfz::WriteTarget out, int id);
+
   private:
-    size_t _size;
+    NatePixTable();
+
+    // Returns true if the table has an overlay, and so can be tinted.
+    bool read_json(sfz::BytesSlice data, uint8_t color);
+    // Reads the frames of sprite pack `data`, where `in` is the rest of it after its sources.
+    void read_pack(sfz::BytesSlice data, sfz::BytesSlice in, uint8_t color);
+    void make_sprites(int id);
+
+    // The mapped sprite pack, if the frames were loaded from one.
+    std::unique_ptr<Resource> _pack;
     std::vector<Frame> _frames;
 
     DISALLOW_COPY_AND_ASSIGN(NatePixTable);
@@ -47,9 +68,9 @@ class NatePixTable {
 
 class NatePixTable::Frame {
   public:
-    Frame(Rect bounds, const PixMap& image, int16_t id, int frame);
-    Frame(Rect bounds, const PixMap& image, int16_t id, int frame,
-          const PixMap& overlay, uint8_t color);
+    Frame(Rect bounds, const PixMap& image);
+    Frame(Rect bounds, const PixMap& image, const PixMap& overlay, uint8_t color);
+    Frame(Rect bounds, std::unique_ptr<PixMap> pix_map);
     Frame(Frame&&) = default;
     ~Frame();
     
@@ -60,12 +81,14 @@ class NatePixTable::Frame {
     const Sprite& sprite() const;
 
   private:
+    // The table makes the sprites for all of its frames at once; see NatePixTable().
+    friend class NatePixTable;
+
     void load_image(const PixMap& pix);
     void load_overlay(const PixMap& pix, uint8_t color);
-    void build(int16_t id, int frame);
 
     Rect _bounds;
-    ArrayPixMap _pix_map;
+    std::unique_ptr<PixMap> _pix_map;
     std::unique_ptr<Sprite> _sprite;
 
     DISALLOW_COPY_AND_ASSIGN(Frame);
@@ -95,6 +95,8 @@ int32_t evil_scale_by(int32_t value, int32_t scale);
 
 void SpriteHandlingInit();
 void ResetAllSprites();
+// Sprites beyond `limit` are never handed out; SetSpaceObjectLimit() keeps it in step.
+void SetSpriteLimit(int32_t limit);
 Rect scale_sprite_rect(const NatePixTable::Frame& frame, Point where, int32_t scale);
 void ResetAllPixTables();
 void SetAllPixTablesNoKeep();
@@ -106,9 +108,15 @@ spriteType *AddSprite(
         Point where, NatePixTable* table, int16_t resID, int16_t whichShape, int32_t scale, int32_t size,
         int16_t layer, const RgbColor& color, int32_t *whichSprite);
 void RemoveSprite(spriteType *);
+spriteType* GetSprite(int32_t whichSprite);
 void draw_sprites();
 void CullSprites();
 
+// Write the sprite table to `out`, or replace it with what was written.  Used by SaveSnapshot()
+// and RestoreSnapshot().
+void SaveSprites(sfz::WriteTarget out);
+void RestoreSprites(sfz::ReadSource in);
+
 }  // namespace antares
 
 #endif // ANTARES_DRAWING_SPRITE_HANDLING_HPP_
@@ -182,6 +182,15 @@ void AddKillToAdmiral(spaceObjectType *anObject);
 int32_t GetAdmiralLoss(int32_t whichAdmiral);
 int32_t GetAdmiralKill(int32_t whichAdmiral);
 
+// Write all admirals and destination balances to `out`, or replace them with what was written.
+// Used by SaveSnapshot() and RestoreSnapshot().
+void SaveAdmirals(sfz::WriteTarget out);
+void RestoreAdmirals(sfz::ReadSource in);
+
+// The parts of SaveAdmirals(): one admiral, and the destination balances.
+void SaveAdmiral(sfz::WriteTarget out, int32_t whichAdmiral);
+void SaveDestBalances(sfz::WriteTarget out);
+
 }  // namespace antares
 
 #endif // ANTARES_GAME_ADMIRAL_HPP_
@@ -21,6 +21,7 @@
 
 #include <stdint.h>
 
+#include "game/space-object-handle.hpp"
 #include "math/geometry.hpp"
 
 namespace antares {
@@ -49,12 +50,8 @@ struct beamType {
     uint8_t             color;
     bool                killMe;
     bool                active;
-    int32_t             fromObjectNumber;
-    int32_t             fromObjectID;
-    spaceObjectType*    fromObject;
-    int32_t             toObjectNumber;
-    int32_t             toObjectID;
-    spaceObjectType*    toObject;
+    SpaceObjectHandle   fromObject;
+    SpaceObjectHandle   toObject;
     Point               toRelativeCoord;
     uint32_t            boltRandomSeed;
     uint32_t            lastBoldRandomSeed;
@@ -80,6 +77,13 @@ class Beams {
     static void draw();
     static void show_all();
     static void cull();
+
+    // Returns beam number `which`, as numbered by add().
+    static beamType* get(int32_t which);
+
+    // Write all beams to `out`, or replace them with what was written.
+    static void save(sfz::WriteTarget out);
+    static void restore(sfz::ReadSource in);
   private:
     static std::unique_ptr<beamType[]> _data;
 };
@@ -0,0 +1,171 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#ifndef ANTARES_GAME_DELAY_QUEUE_HPP_
+#define ANTARES_GAME_DELAY_QUEUE_HPP_
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include <sfz/sfz.hpp>
+
+namespace antares {
+
+// Values to be handled after a delay, in the order they fall due.  Of values due at the same
+// time, the one added last comes out first, as it did when delayed actions were kept in a sorted
+// list and new ones were inserted at the front of their time.
+//
+// Times are absolute, measured against a clock that advance() moves forward, so nothing is
+// touched while it waits.  Values live in slots that are reused once popped, and a heap of slot
+// numbers keeps the one due soonest on top.  There is no limit on how many may wait at once.
+template <typename T>
+class DelayQueue {
+  public:
+    DelayQueue(): _now(0), _sequence(0) { }
+
+    void clear() {
+        _slots.clear();
+        _free.clear();
+        _heap.clear();
+        _now = 0;
+        _sequence = 0;
+    }
+
+    bool empty() const { return _heap.empty(); }
+    size_t size() const { return _heap.size(); }
+
+    // Adds `value`, due `delay` after the current time.
+    void add(int64_t delay, const T& value) {
+        int32_t slot;
+        if (_free.empty()) {
+            slot = _slots.size();
+            _slots.push_back(Slot());
+        } else {
+            slot = _free.back();
+            _free.pop_back();
+        }
+        _slots[slot].value = value;
+        _slots[slot].due = _now + delay;
+        _slots[slot].sequence = _sequence++;
+        _heap.push_back(slot);
+        std::push_heap(_heap.begin(), _heap.end(), RunsAfter(_slots));
+    }
+
+    void advance(int64_t time) {
+        _now += time;
+    }
+
+    // If a value is due, removes the next one into `*value` and returns true.  The value's slot
+    // is free by the time this returns, so handling the value may add more.
+    bool pop(T* value) {
+        if (_heap.empty() || (_slots[_heap.front()].due > _now)) {
+            return false;
+        }
+        std::pop_heap(_heap.begin(), _heap.end(), RunsAfter(_slots));
+        const int32_t slot = _heap.back();
+        _heap.pop_back();
+        *value = _slots[slot].value;
+        _slots[slot] = Slot();
+        _free.push_back(slot);
+        return true;
+    }
+
+    // Writes the queue to `out` or replaces it with what was written, slot for slot, so that the
+    // restored queue hands out slots and breaks ties exactly as the saved one would have.
+    // `write_value(out, value)` and `read_value(in, &value)` handle the values.
+    template <typename WriteValue>
+    void save(sfz::WriteTarget out, WriteValue write_value) const {
+        sfz::write<uint32_t>(out, _slots.size());
+        for (const Slot& slot: _slots) {
+            sfz::write(out, slot.due);
+            sfz::write(out, slot.sequence);
+            write_value(out, slot.value);
+        }
+        write_numbers(out, _free);
+        write_numbers(out, _heap);
+        sfz::write(out, _now);
+        sfz::write(out, _sequence);
+    }
+
+    template <typename ReadValue>
+    void restore(sfz::ReadSource in, ReadValue read_value) {
+        _slots.resize(sfz::read<uint32_t>(in));
+        for (Slot& slot: _slots) {
+            sfz::read(in, slot.due);
+            sfz::read(in, slot.sequence);
+            read_value(in, &slot.value);
+        }
+        read_numbers(in, _free);
+        read_numbers(in, _heap);
+        sfz::read(in, _now);
+        sfz::read(in, _sequence);
+    }
+
+  private:
+    struct Slot {
+        Slot(): value(), due(0), sequence(0) { }
+
+        T           value;
+        int64_t     due;
+        uint64_t    sequence;   // order added in; breaks ties
+    };
+
+    // The heap functions put the greatest element on top, so this is "a runs after b".
+    class RunsAfter {
+      public:
+        explicit RunsAfter(const std::vector<Slot>& slots): _slots(slots) { }
+
+        bool operator()(int32_t a, int32_t b) const {
+            const Slot& x = _slots[a];
+            const Slot& y = _slots[b];
+            if (x.due != y.due) {
+                return x.due > y.due;
+            }
+            return x.sequence < y.sequence;
+        }
+
+      private:
+        const std::vector<Slot>& _slots;
+    };
+
+    static void write_numbers(sfz::WriteTarget out, const std::vector<int32_t>& numbers) {
+        sfz::write<uint32_t>(out, numbers.size());
+        for (int32_t number: numbers) {
+            sfz::write(out, number);
+        }
+    }
+
+    static void read_numbers(sfz::ReadSource in, std::vector<int32_t>& numbers) {
+        numbers.resize(sfz::read<uint32_t>(in));
+        for (int32_t& number: numbers) {
+            sfz::read(in, number);
+        }
+    }
+
+    std::vector<Slot>       _slots;
+    std::vector<int32_t>    _free;
+    std::vector<int32_t>    _heap;
+    int64_t                 _now;
+    uint64_t                _sequence;
+
+    DISALLOW_COPY_AND_ASSIGN(DelayQueue);
+};
+
+}  // namespace antares
+
+#endif  // ANTARES_GAME_DELAY_QUEUE_HPP_
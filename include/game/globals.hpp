@@ -78,7 +78,6 @@ struct hotKeyType {
 
 struct admiralType;
 struct destBalanceType;
-struct proximityUnitType;
 struct scrollStarType;
 class InputSource;
 class StringList;
@@ -23,36 +23,89 @@
 #include <sfz/sfz.hpp>
 
 #include "config/keys.hpp"
+#include "data/replay.hpp"
 #include "ui/event.hpp"
 
 namespace antares {
 
-struct ReplayData;
-
 class InputSource {
   public:
     virtual ~InputSource();
 
     virtual bool next(EventReceiver& key_map) = 0;
+
+    // Returns a snapshot (see game/snapshot.hpp) that play should resume from, or NULL if play
+    // should start from the beginning of the scenario.
+    virtual const sfz::Bytes* snapshot() const;
+
+    // Sets `*data` to the digest (see game/sync.hpp) recorded after the decide cycle that the
+    // last call to next() supplied input for.  Returns false if none was recorded.
+    virtual bool sync(sfz::BytesSlice* data);
+
+    // True if the game should pass add_snapshot() a snapshot as of the start of the decide cycle
+    // that the next call to next() supplies input for.
+    virtual bool wants_snapshot() const;
+    virtual void add_snapshot(sfz::BytesSlice data);
 };
 
 class ReplayInputSource : public InputSource {
   public:
-    explicit ReplayInputSource(ReplayData* data);
+    // If `start_at` is nonzero, play resumes from the last snapshot in `data` taken at or before
+    // that decide cycle, if there is one.  If `snapshot_at` is nonzero, the game's snapshot as of
+    // that decide cycle is added to `data`.
+    explicit ReplayInputSource(
+            ReplayData* data, uint64_t start_at = 0, uint64_t snapshot_at = 0);
 
     virtual bool next(EventReceiver& receiver);
+    virtual const sfz::Bytes* snapshot() const;
+    virtual bool sync(sfz::BytesSlice* data);
+    virtual bool wants_snapshot() const;
+    virtual void add_snapshot(sfz::BytesSlice data);
 
   private:
     bool advance(EventReceiver& receiver);
 
-    const ReplayData* _data;
+    ReplayData* _data;
+    int _snapshot_index;
+    const uint64_t _snapshot_at;
     size_t _data_index;
+    size_t _sync_index;
     uint64_t _at;
-    KeyMap _key_map;
+    int _key_codes[KEY_COUNT];
 
     DISALLOW_COPY_AND_ASSIGN(ReplayInputSource);
 };
 
+// Plays a v2 replay (see ReplayFile) straight from its bytes, usually a mapped file.  Chunks are
+// decoded one at a time into buffers that are reused, so once the first chunks have been read,
+// playing a decide cycle allocates nothing.
+class ReplayFileInputSource : public InputSource {
+  public:
+    // `file` must outlive the input source.  `start_at` is as for ReplayInputSource.
+    explicit ReplayFileInputSource(const ReplayFile& file, uint64_t start_at = 0);
+
+    virtual bool next(EventReceiver& receiver);
+    virtual const sfz::Bytes* snapshot() const;
+    virtual bool sync(sfz::BytesSlice* data);
+
+  private:
+    bool advance(EventReceiver& receiver);
+
+    const ReplayFile& _file;
+    ReplayFile::ActionCursor _actions;
+    ReplayFile::SyncCursor _syncs;
+    ReplayFile::ActionRow _action;
+    ReplayFile::SyncRow _sync;
+    bool _has_action;
+    bool _has_sync;
+    sfz::Bytes _snapshot;
+    bool _has_snapshot;
+    uint64_t _at;
+    int _key_codes[KEY_COUNT];
+
+    DISALLOW_COPY_AND_ASSIGN(ReplayFileInputSource);
+};
+
 }  // namespace antares
 
 #endif  // ANTARES_GAME_INPUT_SOURCE_HPP_
@@ -0,0 +1,124 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#ifndef ANTARES_GAME_KINEMATICS_HPP_
+#define ANTARES_GAME_KINEMATICS_HPP_
+
+#include <stdint.h>
+#include <sfz/sfz.hpp>
+#include <vector>
+
+#include "math/fixed.hpp"
+
+namespace antares {
+
+struct spaceObjectType;
+
+// The per-tick kinematic state of every object in use, held as parallel arrays so that the
+// motion loop can walk it linearly instead of chasing `nextObject` through ~700-byte objects.
+//
+// The arrays are a working copy: load() gathers them from the object list, in list order, at
+// the start of MoveSpaceObjects(), and store() writes the integrated state back at the end.
+// Between the two, the arrays and not the objects hold the current location, motion fraction,
+// velocity, direction, and turn fraction of every loaded object.
+class Kinematics {
+  public:
+    enum {
+        MOVES   = 0x01,  // has a max velocity or can turn
+        TURNS   = 0x02,  // kCanTurn
+        WARPS   = 0x04,  // thrust is scaled by presenceData rather than maxVelocity
+    };
+
+    Kinematics() { }
+
+    // Gathers every object in use from the list starting at `root`.
+    void load(spaceObjectType* root);
+    // Writes the mutable state back to the objects it was gathered from.
+    void store() const;
+    void clear();
+    // Resizes every array to `size`, leaving new entries zeroed.
+    void resize(size_t size);
+
+    size_t size() const { return object.size(); }
+
+    // Returns the index of `object`, or -1 if it was not loaded.
+    int32_t index_of(const spaceObjectType* object) const;
+
+    // Saves `location` into `last_location` for every entry.
+    void save_locations();
+
+    std::vector<spaceObjectType*>   object;
+    std::vector<uint8_t>            flags;
+    std::vector<int16_t>            active;
+
+    std::vector<uint32_t>           location_h;
+    std::vector<uint32_t>           location_v;
+    std::vector<uint32_t>           last_location_h;
+    std::vector<uint32_t>           last_location_v;
+    std::vector<Fixed>              fraction_h;
+    std::vector<Fixed>              fraction_v;
+    std::vector<Fixed>              velocity_h;
+    std::vector<Fixed>              velocity_v;
+
+    std::vector<int32_t>            direction;
+    std::vector<Fixed>              turn_fraction;
+    std::vector<Fixed>              turn_velocity;
+    std::vector<Fixed>              thrust;
+    std::vector<Fixed>              max_velocity;  // presenceData for WARPS entries
+
+    // Scratch space for one tick of MoveKinematics().  `moving` is -1 for entries that move
+    // this tick and 0 for the rest; `dv` is the velocity change thrust is aiming for, and
+    // `limit` is the most thrust can change the velocity by along that vector.
+    std::vector<int32_t>            moving;
+    std::vector<Fixed>              dv_h;
+    std::vector<Fixed>              dv_v;
+    std::vector<Fixed>              limit_h;
+    std::vector<Fixed>              limit_v;
+
+  private:
+    std::vector<int32_t>            _index;  // by entryNumber
+
+    DISALLOW_COPY_AND_ASSIGN(Kinematics);
+};
+
+// Instruction sets for the vectorized steps of MoveKinematics().  Every one of them gives
+// bit-for-bit the same results as KINEMATICS_SCALAR.
+enum KinematicsIsa {
+    KINEMATICS_SCALAR,
+    KINEMATICS_SSE2,
+    KINEMATICS_AVX2,
+};
+
+bool KinematicsIsaSupported(KinematicsIsa isa);
+// The fastest instruction set this CPU supports, which MoveKinematics() uses.
+KinematicsIsa BestKinematicsIsa();
+
+// Advances every entry that is in use and MOVES by one tick: turn, then thrust, then move.
+// Produces exactly the results the per-object loop in MoveSpaceObjects() used to.
+void MoveKinematics(Kinematics& k);
+void MoveKinematics(Kinematics& k, KinematicsIsa isa);
+
+// The vectorized steps of MoveKinematics(), exposed for testing.  ApplyThrust() clamps `dv` to
+// `limit` and adds it to `velocity`; IntegrateMotion() adds `velocity` to `fraction` for each
+// `moving` entry, and moves the rounded whole part of the result from `fraction` to `location`.
+void ApplyThrust(Kinematics& k, KinematicsIsa isa);
+void IntegrateMotion(Kinematics& k, KinematicsIsa isa);
+
+}  // namespace antares
+
+#endif  // ANTARES_GAME_KINEMATICS_HPP_
@@ -55,6 +55,10 @@ class Labels {
 
     static void recalc_size(int32_t);
 
+    // Write all labels to `out`, or replace them with what was written.
+    static void save(sfz::WriteTarget out);
+    static void restore(sfz::ReadSource in);
+
   private:
     struct screenLabelType;
     static void zero(screenLabelType& label);
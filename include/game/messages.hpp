@@ -50,6 +50,12 @@ class Messages {
     static void set_status(const sfz::StringSlice& status, uint8_t color);
     static int16_t current();
 
+    // Writes the message queue and the progress of the long message, which scenario conditions
+    // can observe.  The typeset text of a long message is not written, so restore() is only
+    // valid before the long message is next clipped, as at the start of a scenario.
+    static void save(sfz::WriteTarget out);
+    static void restore(sfz::ReadSource in);
+
     static void draw_long_message(int32_t time_pass);
     static void draw_message_screen(int32_t by_units);
     static void draw_message();
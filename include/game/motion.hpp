@@ -23,19 +23,6 @@
 
 namespace antares {
 
-const int32_t kUnitsToCheckNumber = 5;
-
-struct adjacentUnitType {
-    int32_t                 adjacentUnit;           // the normal adjacent unit
-    Point                   superOffset;            // the offset of the super unit (for wrap-around)
-};
-
-struct proximityUnitType {
-    spaceObjectType*        nearObject;                         // for collision checking
-    spaceObjectType*        farObject;                          // for distance checking
-    adjacentUnitType        unitsToCheck[kUnitsToCheckNumber];  // adjacent units to check
-};
-
 extern coordPointType gGlobalCorner;
 
 void InitMotion();
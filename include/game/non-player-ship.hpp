@@ -27,6 +27,9 @@ namespace antares {
 
 spaceObjectType *HackNewNonplayerShip(int32_t, int16_t, Rect *);
 void NonplayerShipThink(int32_t);
+// Thinking ahead in parallel is on by default.  With it off, every object thinks in the serial
+// pass, which must play out exactly the same; the replay binary turns it off to check that.
+void SetThinkAhead(bool enabled);
 void UpdateMyNonplayerShip( void);
 void HackShowShipID( void);
 void HitObject( spaceObjectType *, spaceObjectType *);
@@ -19,6 +19,8 @@
 #ifndef ANTARES_GAME_PLAYER_SHIP_HPP_
 #define ANTARES_GAME_PLAYER_SHIP_HPP_
 
+#include <sfz/sfz.hpp>
+
 #include "data/space-object.hpp"
 
 namespace antares {
@@ -46,6 +48,10 @@ class PlayerShip : public EventReceiver {
     bool show_right_stick() const;
     int32_t goal_direction() const;
 
+    // Write the player's controls to `out`, or replace them with what was written.
+    void save(sfz::WriteTarget out) const;
+    void restore(sfz::ReadSource in);
+
   private:
     bool active() const;
 
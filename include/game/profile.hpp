@@ -0,0 +1,84 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#ifndef ANTARES_GAME_PROFILE_HPP_
+#define ANTARES_GAME_PROFILE_HPP_
+
+#include <stdint.h>
+#include <sfz/sfz.hpp>
+
+namespace antares {
+
+// Phases of GamePlay::fire_timer() which are timed separately.  Phases up to and including
+// PROFILE_CONDITIONS run inside the per-tick loop; the rest run once per timer, in one piece each.
+enum ProfilePhase {
+    PROFILE_STARFIELD,
+    PROFILE_MOVE,
+    PROFILE_THINK,
+    PROFILE_ADMIRAL,
+    PROFILE_ACTIONS,
+    PROFILE_PLAYER,
+    PROFILE_COLLIDE,
+    PROFILE_CONDITIONS,
+    PROFILE_MINICOMPUTER,
+    PROFILE_LONG_MESSAGE,
+    PROFILE_SECTOR_LINES,
+    PROFILE_BEAMS,
+    PROFILE_LABELS,
+    PROFILE_SPRITES,
+    PROFILE_MESSAGES,
+    PROFILE_RADAR,
+
+    PROFILE_PHASE_COUNT,
+};
+
+// Profiling is off by default, and costs a single branch per phase while off.  Binaries that
+// want it (replay, offscreen) turn it on before the game starts and write the results out with
+// write_profile() once the game is over.
+void enable_profiling();
+bool profiling_enabled();
+
+// Records the number of active objects; called once per decide cycle.
+void profile_decide_cycle();
+
+// Records the number of draw calls made by a frame; called by the video driver after each.
+void profile_frame(int32_t draw_calls);
+
+// Writes the collected timings as JSON: for each phase, the number of calls and the min, mean,
+// and 99th percentile duration in nanoseconds (the percentile to within 1/8 of its value); plus
+// the min, mean, and max number of active objects seen over all decide cycles, and of draw calls
+// over all frames; plus the resource_stats(), which count the file system work of loading the
+// level.
+void write_profile(sfz::PrintTarget out);
+
+// Times the enclosing scope as one call of `phase`.
+class ProfileTimer {
+  public:
+    explicit ProfileTimer(ProfilePhase phase);
+    ~ProfileTimer();
+
+  private:
+    const ProfilePhase _phase;
+    int64_t _start;
+
+    DISALLOW_COPY_AND_ASSIGN(ProfileTimer);
+};
+
+}  // namespace antares
+
+#endif  // ANTARES_GAME_PROFILE_HPP_
@@ -43,6 +43,10 @@ enum {
 Scenario* mGetScenario(int32_t num);
 int32_t mGetRealAdmiralNum(int32_t mplayernum);
 
+// Enables the cache of the world the last scenario left behind when it had run up to its start
+// time.  Replays and tests leave the cache off, so every run simulates its warmup.
+void EnableWarmupCache();
+
 void ScenarioMakerInit();
 bool start_construct_scenario(const Scenario* scenario, int32_t* max);
 void construct_scenario(const Scenario* scenario, int32_t* current);
@@ -57,6 +61,11 @@ void GetScenarioFullScaleAndCorner(
 const Scenario* GetScenarioPtrFromChapter(int32_t chapter);
 coordPointType Translate_Coord_To_Scenario_Rotation(int32_t h, int32_t v);
 
+// Write the state of gThisScenario's conditions and initial objects to `out`, or replace it with
+// what was written.  Used by SaveSnapshot() and RestoreSnapshot().
+void SaveScenarioState(sfz::WriteTarget out);
+void RestoreScenarioState(sfz::ReadSource in);
+
 }  // namespace antares
 
 #endif // ANTARES_GAME_SCENARIO_MAKER_HPP_
@@ -0,0 +1,50 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#ifndef ANTARES_GAME_SNAPSHOT_HPP_
+#define ANTARES_GAME_SNAPSHOT_HPP_
+
+#include <stdint.h>
+#include <sfz/sfz.hpp>
+
+namespace antares {
+
+// Bump whenever anything written by SaveSnapshot() changes; snapshots from other versions are
+// refused rather than misread.
+const uint32_t kSnapshotVersion = 2;
+
+// Writes the state of the game in progress to `out`: objects, the action queue, admirals,
+// beams, sprites, labels, the starfield, scenario conditions, the random seed and game time.
+// Pointers are written as the numbers of what they point to.
+//
+// Messages, sounds, instruments and the minicomputer (beyond its screen and line) are not
+// written; they are presentation, and come back as they would after a scenario start.
+void SaveSnapshot(sfz::WriteTarget out);
+
+// Replaces the game in progress with one written by SaveSnapshot().  The scenario the snapshot
+// was taken in must already be constructed, as it is when play starts.  Throws an exception if
+// `in` was written by a different kSnapshotVersion.
+void RestoreSnapshot(sfz::ReadSource in);
+
+// Strings in snapshots are written as a byte count followed by their UTF-8 encoding.
+void write_snapshot_string(sfz::WriteTarget out, const sfz::StringSlice& string);
+sfz::String read_snapshot_string(sfz::ReadSource in);
+
+}  // namespace antares
+
+#endif  // ANTARES_GAME_SNAPSHOT_HPP_
@@ -0,0 +1,56 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#ifndef ANTARES_GAME_SPACE_OBJECT_HANDLE_HPP_
+#define ANTARES_GAME_SPACE_OBJECT_HANDLE_HPP_
+
+#include <stdint.h>
+#include <sfz/sfz.hpp>
+
+namespace antares {
+
+struct spaceObjectType;
+
+// Refers to one particular space object, not just to the slot it occupies.  Slots in the object
+// pool are reused once their object is freed; each reuse bumps the slot's generation, so a
+// handle taken before the reuse stops resolving instead of silently referring to the newcomer.
+class SpaceObjectHandle {
+  public:
+    SpaceObjectHandle(): _number(-1), _generation(0) { }
+    explicit SpaceObjectHandle(const spaceObjectType* object);
+
+    // True if the handle was made from NULL; says nothing about whether the object is alive.
+    bool empty() const { return _number < 0; }
+    int32_t number() const { return _number; }
+
+    // Returns the object, or NULL if it has been freed since the handle was taken.
+    spaceObjectType* get() const;
+
+  private:
+    friend void read_from(sfz::ReadSource in, SpaceObjectHandle& handle);
+    friend void write_to(sfz::WriteTarget out, const SpaceObjectHandle& handle);
+
+    int32_t _number;
+    uint32_t _generation;
+};
+void read_from(sfz::ReadSource in, SpaceObjectHandle& handle);
+void write_to(sfz::WriteTarget out, const SpaceObjectHandle& handle);
+
+}  // namespace antares
+
+#endif  // ANTARES_GAME_SPACE_OBJECT_HANDLE_HPP_
@@ -20,6 +20,7 @@
 #define ANTARES_GAME_SPACE_OBJECT_HPP_
 
 #include "data/space-object.hpp"
+#include "game/space-object-handle.hpp"
 
 namespace antares {
 
@@ -36,6 +37,7 @@ void ResetActionQueueData( void);
 int AddSpaceObject( spaceObjectType *);
 //int AddSpaceObject( spaceObjectType *, int32_t *, int16_t, int16_t);
 int AddNumberedSpaceObject( spaceObjectType *, int32_t);
+void FreeSpaceObject(spaceObjectType* object);
 void RemoveAllSpaceObjects( void);
 void CorrectAllBaseObjectColor( void);
 void ChangeObjectBaseType( spaceObjectType *, int32_t, int32_t, bool);
@@ -59,6 +61,19 @@ void CreateFloatingBodyOfPlayer( spaceObjectType *);
 
 baseObjectType* mGetBaseObjectPtr(int32_t whichObject);
 spaceObjectType* mGetSpaceObjectPtr(int32_t whichObject);
+
+// Returns the number of the first object after `whichObject` whose slot is not available (that
+// is, in use or to be freed), or -1 if there are none.  Pass -1 to start from the beginning:
+//
+//     for (int32_t i = NextSpaceObject(-1); i >= 0; i = NextSpaceObject(i)) { ... }
+//
+// Walks objects in slot order, as a loop over every slot would, but skips free slots in bulk.
+int32_t NextSpaceObject(int32_t whichObject);
+
+// The most objects that may exist at once; kDefaultSpaceObjectLimit unless set otherwise.
+// Setting it also sets the sprite limit to match.  It is saved and restored with the objects.
+int32_t SpaceObjectLimit();
+void SetSpaceObjectLimit(int32_t limit);
 objectActionType* mGetObjectActionPtr(int32_t whichAction);
 
 void mGetBaseObjectFromClassRace(
@@ -67,6 +82,37 @@ void mGetBaseObjectFromClassRace(
 sfz::StringSlice get_object_name(int16_t id);
 sfz::StringSlice get_object_short_name(int16_t id);
 
+// Write the object pool and the delayed-action queue to `out`, or replace them with what was
+// written.  Used by SaveSnapshot() and RestoreSnapshot().
+void SaveSpaceObjects(sfz::WriteTarget out);
+void RestoreSpaceObjects(sfz::ReadSource in);
+
+// The fields of a space object, grouped so that desync reports can say which part of an object
+// diverged.  SaveSpaceObjects() writes each object as all of its groups, in order.
+enum SpaceObjectFieldGroup {
+    kObjectIdentityFields = 0,
+    kObjectRotationFields,
+    kObjectLocationFields,
+    kObjectProximityFields,
+    kObjectDestinationFields,
+    kObjectStrengthFields,
+    kObjectMotionFields,
+    kObjectFrameFields,
+    kObjectConditionFields,
+    kObjectSpriteFields,
+    kObjectTargetFields,
+    kObjectPresenceFields,
+    kObjectWeaponFields,
+    kObjectFlagFields,
+    kObjectFieldGroupCount
+};
+sfz::StringSlice space_object_field_group_name(SpaceObjectFieldGroup group);
+void SaveSpaceObjectFields(
+        sfz::WriteTarget out, const spaceObjectType& object, SpaceObjectFieldGroup group);
+
+// Writes just the delayed-action queue, as SaveSpaceObjects() does after the objects.
+void SaveActionQueue(sfz::WriteTarget out);
+
 }  // namespace antares
 
 #endif // ANTARES_GAME_SPACE_OBJECT_HPP_
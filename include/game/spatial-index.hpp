@@ -0,0 +1,103 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#ifndef ANTARES_GAME_SPATIAL_INDEX_HPP_
+#define ANTARES_GAME_SPATIAL_INDEX_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <sfz/sfz.hpp>
+
+namespace antares {
+
+struct spaceObjectType;
+
+// Finds pairs of objects in the same or neighboring square cells of the universe, for the
+// collision and distance checks in CollideSpaceObjects().
+//
+// This used to be a 16x16 grid of cells which wrapped around, so that objects far apart could
+// land in the same cell; each candidate pair then had to be checked for whether the objects
+// were really close.  Here, objects are sorted by the cell they are actually in, and a cell's
+// objects are found by binary search, so only objects that are really close are visited.
+//
+// Pairs come out in exactly the order the grid produced them.  Objects are visited in order of
+// their cell modulo 16 (row by row), and then oldest first.  For each object, the candidates are
+// the newer objects in its own cell (neighbor 0), then all objects in the cells to its east,
+// southwest, south, and southeast (neighbors 1-4), each oldest first.  Later objects in the
+// chain may depend on the effects of earlier ones, so the order is part of the game's
+// behavior and must not change.
+//
+// The sorted orders are kept between frames and re-sorted by insertion, since from one frame
+// to the next few objects change cells and the relative order of objects in the list is stable.
+class SpatialIndex {
+  public:
+    enum {
+        NEIGHBOR_COUNT = 5,
+    };
+
+    struct Span {
+        spaceObjectType* const* begin;
+        spaceObjectType* const* end;
+    };
+
+    // `shift` converts a location into a cell: cells are (1 << shift) units on a side.
+    explicit SpatialIndex(int32_t shift);
+
+    // Builds the index afresh: call clear(), then add() each object in list order, then sort().
+    void clear();
+    void add(spaceObjectType* object);
+    void sort();
+
+    size_t size() const { return _visit.size(); }
+    // The object visited `index`th.
+    spaceObjectType* at(size_t index) const { return _visit[index].object; }
+    // The candidates to pair with the object visited `index`th, in `neighbor` (0-4).
+    Span candidates(size_t index, int neighbor) const;
+    // The object visited after the one visited `index`th, if they are in the same cell modulo
+    // 16, or NULL.  These are the chains of the old grid, which the admirals still walk.
+    spaceObjectType* next_in_wrapped_cell(size_t index) const;
+
+  private:
+    struct Entry {
+        int32_t             h;
+        int32_t             v;
+        int32_t             rank;   // position in list, newest first
+        int32_t             number; // entryNumber
+        spaceObjectType*    object;
+    };
+
+    template <typename Less>
+    void reorder(std::vector<Entry>& order, Less less);
+    Span cell(int32_t h, int32_t v) const;
+
+    const int32_t                   _shift;
+    std::vector<Entry>              _added;         // in list order
+    std::vector<int32_t>            _rank;          // by entryNumber
+    std::vector<uint8_t>            _taken;         // by rank
+    std::vector<Entry>              _visit;
+    std::vector<Entry>              _cells;
+    std::vector<spaceObjectType*>   _cell_objects;  // parallel to _cells
+    std::vector<int32_t>            _cell_position; // in _cells, by rank
+    std::vector<Entry>              _scratch;
+
+    DISALLOW_COPY_AND_ASSIGN(SpatialIndex);
+};
+
+}  // namespace antares
+
+#endif  // ANTARES_GAME_SPATIAL_INDEX_HPP_
@@ -65,6 +65,10 @@ class Starfield {
     void draw() const;
     void show();
 
+    // Write the stars and sparks to `out`, or replace them with what was written.
+    void save(sfz::WriteTarget out) const;
+    void restore(sfz::ReadSource in);
+
   private:
     scrollStarType _stars[kScrollStarNum + kSparkStarNum];
     int32_t _last_clip_bottom;
@@ -0,0 +1,106 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#ifndef ANTARES_GAME_SYNC_HPP_
+#define ANTARES_GAME_SYNC_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <sfz/sfz.hpp>
+
+#include "data/scenario.hpp"
+#include "game/space-object.hpp"
+
+namespace antares {
+
+// The hash of each SpaceObjectFieldGroup of an object, so that a mismatch can be traced to a
+// group of fields.  Every hash of an object in use is non-zero; a free slot's are all zero.
+// `base` and `id` are not part of the hash, but name the object in desync reports.
+struct ObjectFieldHashes {
+    int32_t     base;
+    int32_t     id;
+    uint64_t    group[kObjectFieldGroupCount];
+};
+
+void HashSpaceObjectFields(const spaceObjectType& object, ObjectFieldHashes* hashes);
+
+// A digest of the simulation state, taken after a decide cycle.  Replays record one every few
+// cycles, and playback compares its own against them, so that a game which diverges from its
+// recording is caught soon after it differs, not when the difference finally moves something on
+// screen.
+struct SyncDigest {
+    // One hash for each part of the game.  `scenario` covers the game time, the random seed, the
+    // winner, scenario conditions and beams.
+    uint64_t objects;
+    uint64_t actions;
+    uint64_t admirals;
+    uint64_t scenario;
+
+    uint32_t admiral[kMaxPlayerNum];
+
+    // One entry per object slot, up to the last in use.
+    std::vector<ObjectFieldHashes> object_fields;
+};
+
+void ComputeSyncDigest(SyncDigest* digest);
+
+// The sync log is off by default.  When on, the game logs every decide cycle's digest, whether
+// or not it is recording or checking a replay, so that two runs of a game can be compared cycle
+// by cycle; write_sync_log() writes one line per cycle, with the tick and each part's hash.
+void enable_sync_log();
+bool sync_log_enabled();
+void log_sync_digest(const SyncDigest& digest);
+void write_sync_log(sfz::PrintTarget out);
+
+// Encodes digests for a replay.  The object table is written in full only in the first digest
+// and after reset(); otherwise only the field groups that changed since the previous digest are.
+class SyncRecorder {
+  public:
+    SyncRecorder();
+
+    // Writes the next digest in full.  Called after each snapshot, so that playback resumed from
+    // a snapshot has a full table in the first digest it reads.
+    void reset();
+
+    void encode(const SyncDigest& digest, sfz::Bytes* out);
+
+  private:
+    bool _full;
+    std::vector<ObjectFieldHashes> _object_fields;
+};
+
+// Decodes digests written by SyncRecorder and compares them with the game being played.
+class SyncChecker {
+  public:
+    // `object_name` names the base objects of objects that differ.
+    explicit SyncChecker(sfz::StringSlice (*object_name)(int16_t base) = get_object_name);
+
+    // Returns true if `actual` matches `recorded`.  Otherwise, sets `*mismatch` to a description
+    // of the first part of the game that differs, naming objects and field groups when the
+    // object table is available.
+    bool check(sfz::BytesSlice recorded, const SyncDigest& actual, sfz::String* mismatch);
+
+  private:
+    sfz::StringSlice (*_object_name)(int16_t base);
+    bool _have_objects;
+    std::vector<ObjectFieldHashes> _object_fields;
+};
+
+}  // namespace antares
+
+#endif  // ANTARES_GAME_SYNC_HPP_
@@ -0,0 +1,78 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#ifndef ANTARES_LANG_WORKER_POOL_HPP_
+#define ANTARES_LANG_WORKER_POOL_HPP_
+
+#include <stdint.h>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sfz/sfz.hpp>
+
+namespace antares {
+
+// A fixed set of threads for running the iterations of a loop in parallel.
+//
+// The simulation must come out the same no matter how many threads there are, so work is only
+// ever split into contiguous ranges, handed out in order: range 0 covers the first iterations
+// and runs on the calling thread, range 1 the next ones, and so on.  Passes that gather
+// results per range and then apply them range by range see them in the original order.
+class WorkerPool {
+  public:
+    typedef std::function<void(int range, size_t begin, size_t end)> Job;
+
+    // The pool shared by the game loop, with one thread per core (up to a limit).
+    static WorkerPool* pool();
+
+    explicit WorkerPool(int threads);
+    ~WorkerPool();
+
+    // The most ranges run() will split a loop into.
+    int size() const { return _threads.size() + 1; }
+
+    // Splits [0, count) into at most size() ranges of at least `grain` iterations each, calls
+    // `job` once for each range, and returns when they have all finished.  If any call throws,
+    // the exception is rethrown here once all ranges are done.
+    void run(size_t count, size_t grain, const Job& job);
+
+  private:
+    void work(int range);
+    void run_range(int range);
+
+    std::vector<std::thread>    _threads;
+    std::mutex                  _mutex;
+    std::condition_variable     _start;
+    std::condition_variable     _done;
+    const Job*                  _job;
+    size_t                      _count;
+    int                         _ranges;
+    int                         _pending;
+    uint64_t                    _generation;
+    bool                        _stopping;
+    std::exception_ptr          _exception;
+
+    DISALLOW_COPY_AND_ASSIGN(WorkerPool);
+};
+
+}  // namespace antares
+
+#endif  // ANTARES_LANG_WORKER_POOL_HPP_
@@ -54,6 +54,7 @@ bool operator==(const Point& lhs, const Point& rhs);
 bool operator!=(const Point& lhs, const Point& rhs);
 
 void read_from(sfz::ReadSource in, Point& p);
+void write_to(sfz::WriteTarget out, const Point& p);
 
 // A size (width, height) in two-dimensional space.
 struct Size {
@@ -185,6 +186,7 @@ struct Rect {
 };
 
 void read_from(sfz::ReadSource in, Rect& r);
+void write_to(sfz::WriteTarget out, const Rect& r);
 void print_to(sfz::PrintTarget out, Rect r);
 
 struct coordPointType {
@@ -195,6 +197,9 @@ struct coordPointType {
 inline bool operator==(coordPointType x, coordPointType y) { return (x.h == y.h) && (x.v == y.v); }
 inline bool operator!=(coordPointType x, coordPointType y) { return !(x == y); }
 
+void read_from(sfz::ReadSource in, coordPointType& p);
+void write_to(sfz::WriteTarget out, const coordPointType& p);
+
 }  // namespace antares
 
 #endif // ANTARES_MATH_GEOMETRY_HPP_
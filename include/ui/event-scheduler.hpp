@@ -44,6 +44,13 @@ class EventScheduler {
     EventScheduler();
 
     void schedule_snapshot(int64_t at);
+
+    // Takes a snapshot at `start`, then every `interval` ticks, up to but not including `end`.
+    // Nothing is stored per snapshot, so `end` may be kForever.
+    void schedule_snapshots(int64_t start, int64_t interval, int64_t end);
+
+    static const int64_t kForever;
+
     void schedule_event(std::unique_ptr<Event> event);
     void schedule_key(int32_t key, int64_t down, int64_t up);
     void schedule_mouse(int button, const Point& where, int64_t down, int64_t up);
@@ -58,13 +65,21 @@ class EventScheduler {
     int64_t usecs() const { return ticks_to_usecs(_ticks); }
 
   private:
+    struct SnapshotSchedule {
+        int64_t next;
+        int64_t interval;
+        int64_t end;
+    };
+
     void advance_tick_count(MainLoop& loop, int64_t ticks);
-    bool have_snapshots_before(int64_t ticks) const;
+    bool next_snapshot_before(int64_t ticks, int64_t* at) const;
+    void pop_snapshot(int64_t at);
 
     static bool is_later(const std::unique_ptr<Event>& x, const std::unique_ptr<Event>& y);
 
     int64_t _ticks;
     std::vector<int64_t> _snapshot_times;
+    std::vector<SnapshotSchedule> _snapshot_schedules;
     std::vector<std::unique_ptr<Event>> _event_heap;
     EventTracker _event_tracker;
 
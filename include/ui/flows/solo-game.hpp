@@ -22,6 +22,7 @@
 #include <sfz/sfz.hpp>
 
 #include "game/main.hpp"
+#include "math/random.hpp"
 #include "ui/card.hpp"
 #include "ui/screens/play-again.hpp"
 
@@ -58,6 +59,10 @@ class SoloGame : public Card {
     GameResult _game_result;
     int32_t _seconds;
     PlayAgainScreen::Item _play_again;
+
+    // The seed the level was first started with.  Restarts reuse it, so that the level comes
+    // back as it was, and its warmup is restored from the cache instead of simulated again.
+    Random _random_seed;
 };
 
 }  // namespace antares
@@ -20,6 +20,7 @@
 #define ANTARES_VIDEO_DRIVER_HPP_
 
 #include <stdint.h>
+#include <vector>
 #include <sfz/sfz.hpp>
 
 #include "drawing/color.hpp"
@@ -59,6 +60,12 @@ class VideoDriver {
     virtual int64_t double_click_interval_usecs() const = 0;
 
     virtual std::unique_ptr<Sprite> new_sprite(sfz::PrintItem name, const PixMap& content) = 0;
+
+    // Creates a sprite named `names[i]` for each of `contents[i]`.  Drivers may pack them into
+    // a few shared textures, so that drawing them takes fewer texture bindings; by default, each
+    // is made with new_sprite().
+    virtual std::vector<std::unique_ptr<Sprite>> new_sprites(
+            const std::vector<sfz::String>& names, const std::vector<const PixMap*>& contents);
     virtual void fill_rect(const Rect& rect, const RgbColor& color) = 0;
     virtual void dither_rect(const Rect& rect, const RgbColor& color) = 0;
     virtual void draw_point(const Point& at, const RgbColor& color) = 0;
@@ -46,11 +46,18 @@ class OffscreenVideoDriver : public OpenGlVideoDriver {
     virtual int usecs() const { return _scheduler.usecs(); }
     virtual int64_t double_click_interval_usecs() const { return 0.5e6; }
 
+    // Instead of writing each snapshot to a PNG in `output_dir`, writes them all to `fd` as a
+    // YUV4MPEG2 stream.  Snapshots must be taken every `ticks_per_frame` ticks.  Takes
+    // ownership of `fd`.
+    void stream_y4m(int fd, int ticks_per_frame);
+
     void loop(Card* initial);
 
   private:
     const Size _screen_size;
     const sfz::Optional<sfz::String> _output_dir;
+    int _y4m_fd;
+    int _ticks_per_frame;
 
     EventScheduler& _scheduler;
 
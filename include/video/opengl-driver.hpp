@@ -20,6 +20,8 @@
 #define ANTARES_VIDEO_OPEN_GL_DRIVER_HPP_
 
 #include <stdint.h>
+#include <memory>
+#include <vector>
 #include <sfz/sfz.hpp>
 
 #include "drawing/color.hpp"
@@ -35,8 +37,11 @@ class Event;
 class OpenGlVideoDriver : public VideoDriver {
   public:
     OpenGlVideoDriver();
+    virtual ~OpenGlVideoDriver();
 
     virtual std::unique_ptr<Sprite> new_sprite(sfz::PrintItem name, const PixMap& content);
+    virtual std::vector<std::unique_ptr<Sprite>> new_sprites(
+            const std::vector<sfz::String>& names, const std::vector<const PixMap*>& contents);
     virtual void fill_rect(const Rect& rect, const RgbColor& color);
     virtual void dither_rect(const Rect& rect, const RgbColor& color);
     virtual void draw_point(const Point& at, const RgbColor& color);
@@ -55,6 +60,14 @@ class OpenGlVideoDriver : public VideoDriver {
         int seed;
     };
 
+    // Collects the frame's quads, lines and points into one vertex array, and draws each run of
+    // them that shares a texture and color mode with a single call.  Nothing is reordered, so
+    // painter's order is kept exactly.
+    class Batch;
+
+    // The number of GL draw calls made by the last frame drawn.
+    int draw_calls() const { return _draw_calls; }
+
   protected:
     class MainLoop {
       public:
@@ -81,6 +94,8 @@ class OpenGlVideoDriver : public VideoDriver {
     Random _static_seed;
 
     Uniforms _uniforms;
+    std::unique_ptr<Batch> _batch;
+    int _draw_calls;
 
     std::map<size_t, std::unique_ptr<Sprite>> _triangles;
     std::map<size_t, std::unique_ptr<Sprite>> _diamonds;
@@ -0,0 +1,91 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#ifndef ANTARES_VIDEO_SNAPSHOT_ENCODER_HPP_
+#define ANTARES_VIDEO_SNAPSHOT_ENCODER_HPP_
+
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sfz/sfz.hpp>
+
+#include "drawing/pix-map.hpp"
+#include "math/geometry.hpp"
+
+namespace antares {
+
+// Converts a frame read back from OpenGL, in bottom-up rows of BGRA pixels, to top-down rows of
+// opaque RgbColor pixels.  `out` must hold `size.width * size.height` pixels.
+void swizzle_bgra_frame(const uint8_t* bgra, Size size, RgbColor* out);
+
+// Encodes snapshots to PNG files on a set of background threads.
+//
+// Frames are encoded in parallel, but each file is written only after every frame added before
+// it has been written, so the files appear in the order the frames were taken.  At most
+// `capacity` frames are held at once; add() blocks while that many are waiting to be encoded or
+// written.
+class SnapshotEncoder {
+  public:
+    SnapshotEncoder(Size size, int threads, int capacity);
+
+    // Calls finish(), but drops any exception it would throw.
+    ~SnapshotEncoder();
+
+    // Copies `bgra`, a frame in the format swizzle_bgra_frame() takes, and queues it to be
+    // written as a PNG at `path`.  If encoding or writing an earlier frame failed, throws that
+    // exception instead.
+    void add(sfz::StringSlice path, const uint8_t* bgra);
+
+    // Waits until every frame added so far has been written.  If any failed, throws the first
+    // failure.
+    void finish();
+
+  private:
+    struct Frame {
+        uint64_t sequence;
+        sfz::String path;
+        std::unique_ptr<uint8_t[]> data;
+    };
+
+    void work();
+    void encode(Frame* frame, ArrayPixMap* pix, sfz::Bytes* png);
+    void check();
+
+    const Size _size;
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _queued;
+    std::condition_variable _written;
+    std::vector<std::unique_ptr<Frame>> _free;
+    std::deque<std::unique_ptr<Frame>> _queue;
+    uint64_t _next_sequence;
+    uint64_t _next_write;
+    bool _stopping;
+    std::exception_ptr _exception;
+
+    DISALLOW_COPY_AND_ASSIGN(SnapshotEncoder);
+};
+
+}  // namespace antares
+
+#endif  // ANTARES_VIDEO_SNAPSHOT_ENCODER_HPP_
@@ -0,0 +1,99 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#ifndef ANTARES_VIDEO_SOFTWARE_DRIVER_HPP_
+#define ANTARES_VIDEO_SOFTWARE_DRIVER_HPP_
+
+#include <stdint.h>
+#include <map>
+#include <memory>
+#include <sfz/sfz.hpp>
+
+#include "config/keys.hpp"
+#include "math/geometry.hpp"
+#include "math/random.hpp"
+#include "ui/event-scheduler.hpp"
+#include "video/driver.hpp"
+
+namespace antares {
+
+// Draws on the CPU, into a framebuffer in memory, so that screenshots and movies can be made on
+// machines without OpenGL.  Otherwise it behaves like OffscreenVideoDriver, and should draw the
+// same pixels, up to the exact shape of diagonal lines.
+class SoftwareVideoDriver : public VideoDriver {
+  public:
+    SoftwareVideoDriver(
+            Size screen_size, EventScheduler& scheduler,
+            const sfz::Optional<sfz::String>& output_dir);
+    virtual ~SoftwareVideoDriver();
+
+    virtual bool button(int which) { return _scheduler.button(which); }
+    virtual Point get_mouse() { return _scheduler.get_mouse(); }
+    virtual void get_keys(KeyMap* k) { _scheduler.get_keys(k); }
+    virtual InputMode input_mode() const { return _scheduler.input_mode(); }
+
+    virtual int ticks() const { return _scheduler.ticks(); }
+    virtual int usecs() const { return _scheduler.usecs(); }
+    virtual int64_t double_click_interval_usecs() const { return 0.5e6; }
+
+    virtual std::unique_ptr<antares::Sprite> new_sprite(sfz::PrintItem name, const PixMap& content);
+    virtual void fill_rect(const Rect& rect, const RgbColor& color);
+    virtual void dither_rect(const Rect& rect, const RgbColor& color);
+    virtual void draw_point(const Point& at, const RgbColor& color);
+    virtual void draw_line(const Point& from, const Point& to, const RgbColor& color);
+    virtual void draw_triangle(const Rect& rect, const RgbColor& color);
+    virtual void draw_diamond(const Rect& rect, const RgbColor& color);
+    virtual void draw_plus(const Rect& rect, const RgbColor& color);
+
+    // If true, each frame is rasterized in bands of rows on the threads of WorkerPool::pool().
+    // The result is the same either way.  Defaults to false.
+    void set_parallel(bool parallel) { _parallel = parallel; }
+
+    // As OffscreenVideoDriver::stream_y4m().
+    void stream_y4m(int fd, int ticks_per_frame);
+
+    void loop(Card* initial);
+
+  private:
+    class MainLoop;
+    class Sprite;
+
+    // Records the frame's drawing commands, and then rasterizes them all at the end of the
+    // frame, in order.
+    class Canvas;
+
+    const Size _size;
+    EventScheduler& _scheduler;
+    const sfz::Optional<sfz::String> _output_dir;
+    int _y4m_fd;
+    int _ticks_per_frame;
+    bool _parallel;
+
+    Random _static_seed;
+    std::unique_ptr<Canvas> _canvas;
+
+    std::map<size_t, std::unique_ptr<antares::Sprite>> _triangles;
+    std::map<size_t, std::unique_ptr<antares::Sprite>> _diamonds;
+    std::map<size_t, std::unique_ptr<antares::Sprite>> _pluses;
+
+    DISALLOW_COPY_AND_ASSIGN(SoftwareVideoDriver);
+};
+
+}  // namespace antares
+
+#endif  // ANTARES_VIDEO_SOFTWARE_DRIVER_HPP_
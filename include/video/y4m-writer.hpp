@@ -0,0 +1,57 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#ifndef ANTARES_VIDEO_Y4M_WRITER_HPP_
+#define ANTARES_VIDEO_Y4M_WRITER_HPP_
+
+#include <stdint.h>
+#include <memory>
+#include <sfz/sfz.hpp>
+
+#include "math/geometry.hpp"
+
+namespace antares {
+
+// Converts a frame read back from OpenGL, in bottom-up rows of BGRA pixels, to top-down planar
+// YUV 4:2:0 (BT.601, studio range).  `y` must hold `width * height` bytes, and `u` and `v` each
+// hold one byte for each 2x2 block of pixels, rounding up at odd edges.
+void convert_bgra_to_i420(const uint8_t* bgra, Size size, uint8_t* y, uint8_t* u, uint8_t* v);
+
+// Writes frames as a YUV4MPEG2 stream, which video encoders such as ffmpeg can read directly
+// from a file or pipe.
+class Y4mWriter {
+  public:
+    // Takes ownership of `fd`.  Frames are shown at `rate_num / rate_den` frames per second.
+    Y4mWriter(int fd, Size size, int rate_num, int rate_den);
+
+    // Appends a frame, in the format convert_bgra_to_i420() takes.
+    void add(const uint8_t* bgra);
+
+  private:
+    sfz::ScopedFd _file;
+    const Size _size;
+    const size_t _luma_size;
+    const size_t _chroma_size;
+    std::unique_ptr<uint8_t[]> _frame;
+
+    DISALLOW_COPY_AND_ASSIGN(Y4mWriter);
+};
+
+}  // namespace antares
+
+#endif  // ANTARES_VIDEO_Y4M_WRITER_HPP_
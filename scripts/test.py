@@ -18,6 +18,23 @@ def run(cmd):
         sys.stderr.write(output)
         sys.stderr.write("====================\n")
         sys.exit(test.returncode)
+    return output
+
+
+REPLAYS = [
+    "and-it-feels-so-good",
+    "blood-toil-tears-sweat",
+    "hand-over-fist",
+    "make-way",
+    "out-of-the-frying-pan",
+    "space-race",
+    "the-left-hand",
+    "the-mothership-connection",
+    "the-stars-have-ears",
+    "while-the-iron-is-hot",
+    "yo-ho-ho",
+    "you-should-have-seen-the-one-that-got-away",
+]
 
 
 def unit_test(name, args=[]):
@@ -44,6 +61,11 @@ def offscreen_test(name, args=[]):
     diff_test(cmd + args, expected)
 
 
+# The software driver draws what the OpenGL driver does, so it is held to the same fixtures.
+def software_test(name):
+    diff_test(["out/cur/offscreen", name, "--software"], "test/%s" % name)
+
+
 def replay_test(name, args=[]):
     cmd = ["out/cur/replay", "test/%s.NLRP" % name, "--text"]
     if bool(os.environ.get("SMOKE", "")):
@@ -54,6 +76,70 @@ def replay_test(name, args=[]):
     diff_test(cmd + args, expected)
 
 
+# Thinking ahead in parallel must not change the game: checks that every decide cycle ends with
+# the same digest of the world as when every object thinks serially.
+def think_ahead_test(name):
+    with NamedTemporaryDir() as d:
+        cmd = ["out/cur/replay", "test/%s.NLRP" % name, "--smoke", "--summary"]
+        run(cmd + ["--sync-log=%s/parallel" % d])
+        run(cmd + ["--sync-log=%s/serial" % d, "--no-think-ahead"])
+        run(["diff", "-u", "%s/serial" % d, "%s/parallel" % d])
+
+
+# A game resumed from a snapshot must play out as it did straight through: takes a snapshot at
+# `at`, resumes from it, and checks that every decide cycle from there on ends with the same
+# digest of the world, and that the outcome is the same.
+def snapshot_test(name, at=600):
+    with NamedTemporaryDir() as d:
+        straight = run([
+            "out/cur/replay", "test/%s.NLRP" % name, "--smoke", "--summary",
+            "--sync-log=%s/straight" % d,
+            "--save-snapshot=%s/snapshot.NLRP" % d, "--save-snapshot-at=%d" % at])
+        resumed = run([
+            "out/cur/replay", "%s/snapshot.NLRP" % d, "--smoke", "--summary",
+            "--sync-log=%s/resumed" % d, "--start-at=%d" % at])
+
+        # Ticks count from where play began, so they differ; everything else must not.
+        strip_ticks = lambda out: [l for l in out.splitlines() if not l.startswith("ticks:")]
+        if strip_ticks(straight) != strip_ticks(resumed):
+            sys.stderr.write("%s: resumed at %d with a different outcome:\n" % (name, at))
+            sys.stderr.write(straight + "====================\n" + resumed)
+            sys.exit(1)
+
+        straight = open("%s/straight" % d).read().splitlines()
+        resumed = open("%s/resumed" % d).read().splitlines()
+        if not (0 < len(resumed) < len(straight)):
+            sys.stderr.write("%s: resumed at %d for %d of %d cycles\n"
+                             % (name, at, len(resumed), len(straight)))
+            sys.exit(1)
+        for expected, actual in zip(straight[-len(resumed):], resumed):
+            if expected != actual:
+                sys.stderr.write("%s: resumed at %d, differs at tick %s\n"
+                                 % (name, at, actual.split("\t")[0]))
+                sys.exit(1)
+
+
+# replay-batch plays each replay in its own process, and must report what replay does for it.
+def batch_test():
+    with NamedTemporaryDir() as d:
+        for name in REPLAYS:
+            os.symlink(os.path.abspath("test/%s.NLRP" % name), "%s/%s.NLRP" % (d, name))
+        report = run(["out/cur/replay-batch", d, "--format=csv", "--jobs=4"]).splitlines()
+        if len(report) != len(REPLAYS) + 1:
+            sys.stderr.write("replay-batch: reported %d of %d replays\n"
+                             % (len(report) - 1, len(REPLAYS)))
+            sys.exit(1)
+        for name, line in zip(sorted(REPLAYS), report[1:]):
+            path, status, result, winner, sync, ticks, _ = line.split(",")
+            summary = run(["out/cur/replay", "test/%s.NLRP" % name, "--smoke", "--summary"])
+            expected = ["sync: %s" % sync, "winner: %s" % winner, "result: %s" % result,
+                        "ticks: %s" % ticks]
+            if (status != "ok") or (summary.splitlines() != expected):
+                sys.stderr.write("replay-batch: %s: %s, but replay says:\n%s"
+                                 % (name, line, summary))
+                sys.exit(1)
+
+
 def call(args):
     args[0](*args[1:])
 
@@ -64,7 +150,15 @@ def main():
 
     pool = multiprocessing.pool.ThreadPool()
     pool.map_async(call, [
+        (unit_test, "delay-queue-test"),
+        (unit_test, "event-scheduler-test"),
+        (unit_test, "extraction-test"),
         (unit_test, "fixed-test"),
+        (unit_test, "kinematics-test"),
+        (unit_test, "replay-test"),
+        (unit_test, "resource-index-test"),
+        (unit_test, "spatial-index-test"),
+        (unit_test, "sync-test"),
 
         (data_test, "build-pix"),
         (data_test, "object-data"),
@@ -76,19 +170,12 @@ def main():
         (offscreen_test, "options"),
         (offscreen_test, "pause", ["--text"]),
 
-        (replay_test, "and-it-feels-so-good"),
-        (replay_test, "blood-toil-tears-sweat"),
-        (replay_test, "hand-over-fist"),
-        (replay_test, "make-way"),
-        (replay_test, "out-of-the-frying-pan"),
-        (replay_test, "space-race"),
-        (replay_test, "the-left-hand"),
-        (replay_test, "the-mothership-connection"),
-        (replay_test, "the-stars-have-ears"),
-        (replay_test, "while-the-iron-is-hot"),
-        (replay_test, "yo-ho-ho"),
-        (replay_test, "you-should-have-seen-the-one-that-got-away"),
-    ])
+        (software_test, "main-screen"),
+        (software_test, "options"),
+    ] + [(replay_test, name) for name in REPLAYS]
+      + [(think_ahead_test, name) for name in REPLAYS]
+      + [(snapshot_test, name) for name in REPLAYS]
+      + [(batch_test,)])
     pool.close()
     pool.join()
     print "All tests passed!"
@@ -0,0 +1,270 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include <sys/time.h>
+#include <algorithm>
+#include <vector>
+#include <sfz/sfz.hpp>
+
+#include "data/space-object.hpp"
+#include "game/kinematics.hpp"
+#include "math/fixed.hpp"
+#include "math/random.hpp"
+#include "math/rotation.hpp"
+#include "math/special.hpp"
+#include "math/units.hpp"
+
+using sfz::Exception;
+using sfz::String;
+using sfz::args::help;
+using sfz::args::store;
+using sfz::format;
+using std::swap;
+using std::unique_ptr;
+using std::vector;
+
+namespace args = sfz::args;
+namespace io = sfz::io;
+
+namespace antares {
+namespace {
+
+const int kObjectCounts[] = {250, 2500, 25000};
+
+int64_t wall_usecs() {
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return (tv.tv_sec * 1000000ll) + tv.tv_usec;
+}
+
+// Fills `objects` with a plausible mix of movers, and links them into a list in shuffled order,
+// as the list ends up after objects have been freed and their slots reused.
+spaceObjectType* make_objects(spaceObjectType* objects, int count) {
+    Random random = {count};
+    vector<int> order(count);
+    for (int i = 0; i < count; ++i) {
+        order[i] = i;
+    }
+    for (int i = count - 1; i > 0; --i) {
+        swap(order[i], order[(random.next(16384) * 16384 + random.next(16384)) % (i + 1)]);
+    }
+
+    spaceObjectType* root = NULL;
+    for (int i: order) {
+        spaceObjectType* o = &objects[i];
+        o->entryNumber = i;
+        o->active = kObjectInUse;
+        o->attributes = (random.next(4) == 0) ? 0 : kCanTurn;
+        o->location.h = kUniversalCenter + random.next(16384) - 8192;
+        o->location.v = kUniversalCenter + random.next(16384) - 8192;
+        o->velocity.h = random.next(2048) - 1024;
+        o->velocity.v = random.next(2048) - 1024;
+        o->maxVelocity = (random.next(8) == 0) ? 0 : random.next(2048);
+        o->thrust = random.next(512) - 256;
+        o->direction = random.next(ROT_POS);
+        o->turnVelocity = random.next(1024) - 512;
+        o->presenceState = (random.next(16) == 0) ? kWarpingPresence : kNormalPresence;
+        o->presenceData = random.next(4096);
+        o->nextObject = root;
+        root = o;
+    }
+    return root;
+}
+
+// The per-object loop that MoveSpaceObjects() used before the kinematic state was packed.
+void move_linked(spaceObjectType* root) {
+    for (spaceObjectType* o = root; o != NULL; o = o->nextObject) {
+        if ((o->active != kObjectInUse) || ((o->maxVelocity == 0) && !(o->attributes & kCanTurn))) {
+            continue;
+        }
+        int32_t h, v;
+        if (o->attributes & kCanTurn) {
+            o->turnFraction += o->turnVelocity;
+            if (o->turnFraction >= 0) {
+                h = more_evil_fixed_to_long(o->turnFraction + mFloatToFixed(0.5));
+            } else {
+                h = more_evil_fixed_to_long(o->turnFraction - mFloatToFixed(0.5)) + 1;
+            }
+            o->direction += h;
+            o->turnFraction -= mLongToFixed(h);
+            while (o->direction >= ROT_POS) {
+                o->direction -= ROT_POS;
+            }
+            while (o->direction < 0) {
+                o->direction += ROT_POS;
+            }
+        }
+        if (o->thrust != 0) {
+            Fixed fa, fb, fh, fv, use_thrust;
+            if (o->thrust > 0) {
+                GetRotPoint(&fa, &fb, o->direction);
+                if ((o->presenceState == kWarpingPresence) || (o->presenceState == kWarpOutPresence)) {
+                    fa = mMultiplyFixed(fa, o->presenceData);
+                    fb = mMultiplyFixed(fb, o->presenceData);
+                } else {
+                    fa = mMultiplyFixed(o->maxVelocity, fa);
+                    fb = mMultiplyFixed(o->maxVelocity, fb);
+                }
+                fa = fa - o->velocity.h;
+                fb = fb - o->velocity.v;
+                use_thrust = o->thrust;
+            } else {
+                fa = -o->velocity.h;
+                fb = -o->velocity.v;
+                use_thrust = -o->thrust;
+            }
+            int16_t angle;
+            if (fa == 0) {
+                angle = (fb < 0) ? 180 : 0;
+            } else {
+                angle = AngleFromSlope(MyFixRatio(fa, fb));
+                if (fa > 0) {
+                    angle += 180;
+                }
+                if (angle >= 360) {
+                    angle -= 360;
+                }
+            }
+            GetRotPoint(&fh, &fv, angle);
+            fh = mMultiplyFixed(use_thrust, fh);
+            fv = mMultiplyFixed(use_thrust, fv);
+            if (fh < 0) {
+                if (fa < fh) {
+                    fa = fh;
+                }
+            } else if (fa > fh) {
+                fa = fh;
+            }
+            if (fv < 0) {
+                if (fb < fv) {
+                    fb = fv;
+                }
+            } else if (fb > fv) {
+                fb = fv;
+            }
+            o->velocity.h += fa;
+            o->velocity.v += fb;
+        }
+        o->motionFraction.h += o->velocity.h;
+        o->motionFraction.v += o->velocity.v;
+        if (o->motionFraction.h >= 0) {
+            h = more_evil_fixed_to_long(o->motionFraction.h + mFloatToFixed(0.5));
+        } else {
+            h = more_evil_fixed_to_long(o->motionFraction.h - mFloatToFixed(0.5)) + 1;
+        }
+        o->location.h -= h;
+        o->motionFraction.h -= mLongToFixed(h);
+        if (o->motionFraction.v >= 0) {
+            v = more_evil_fixed_to_long(o->motionFraction.v + mFloatToFixed(0.5));
+        } else {
+            v = more_evil_fixed_to_long(o->motionFraction.v - mFloatToFixed(0.5)) + 1;
+        }
+        o->location.v -= v;
+        o->motionFraction.v -= mLongToFixed(v);
+    }
+}
+
+bool same_motion(const spaceObjectType& a, const spaceObjectType& b) {
+    return (a.location.h == b.location.h) && (a.location.v == b.location.v)
+        && (a.motionFraction.h == b.motionFraction.h) && (a.motionFraction.v == b.motionFraction.v)
+        && (a.velocity.h == b.velocity.h) && (a.velocity.v == b.velocity.v)
+        && (a.direction == b.direction) && (a.turnFraction == b.turnFraction);
+}
+
+// Prints the time per object per tick for the linked loop, for the packed kernel alone (scalar,
+// then with the best instruction set available), and for the packed kernel including the load()
+// and store() that MoveSpaceObjects() pays per call.
+void bench(int count, int ticks) {
+    unique_ptr<spaceObjectType[]> linked(new spaceObjectType[count]());
+    unique_ptr<spaceObjectType[]> packed(new spaceObjectType[count]());
+    spaceObjectType* linked_root = make_objects(linked.get(), count);
+    spaceObjectType* packed_root = make_objects(packed.get(), count);
+    Kinematics kinematics;
+
+    int64_t start = wall_usecs();
+    for (int i = 0; i < ticks; ++i) {
+        move_linked(linked_root);
+    }
+    int64_t linked_usecs = wall_usecs() - start;
+
+    start = wall_usecs();
+    for (int i = 0; i < ticks; ++i) {
+        kinematics.load(packed_root);
+        MoveKinematics(kinematics);
+        kinematics.store();
+    }
+    int64_t call_usecs = wall_usecs() - start;
+
+    kinematics.load(packed_root);
+    start = wall_usecs();
+    for (int i = 0; i < ticks; ++i) {
+        MoveKinematics(kinematics, KINEMATICS_SCALAR);
+    }
+    int64_t scalar_usecs = wall_usecs() - start;
+    start = wall_usecs();
+    for (int i = 0; i < ticks; ++i) {
+        MoveKinematics(kinematics);
+    }
+    int64_t kernel_usecs = wall_usecs() - start;
+    kinematics.store();
+
+    for (int i = 0; i < (2 * ticks); ++i) {
+        move_linked(linked_root);
+    }
+    for (int i = 0; i < count; ++i) {
+        if (!same_motion(linked[i], packed[i])) {
+            throw Exception(format("object {0} diverged with {1} objects", i, count));
+        }
+    }
+
+    const int64_t units = int64_t(count) * ticks;
+    print(io::out, format("{0}\t{1}\t{2}\t{3}\t{4}\n", count,
+                linked_usecs * 1000000 / units, scalar_usecs * 1000000 / units,
+                kernel_usecs * 1000000 / units, call_usecs * 1000000 / units));
+}
+
+void main(int argc, char* const* argv) {
+    args::Parser parser(argv[0], "Times one tick of motion integration over many objects");
+
+    int ticks = 1000;
+    parser.add_argument("-t", "--ticks", store(ticks))
+        .help("number of ticks to time at each object count (default: 1000)");
+    parser.add_argument("-h", "--help", help(parser, 0))
+        .help("display this help screen");
+
+    String error;
+    if (!parser.parse_args(argc - 1, argv + 1, error)) {
+        print(io::err, format("{0}: {1}\n", parser.name(), error));
+        exit(1);
+    }
+
+    RotationInit();
+    // Times are in picoseconds per object per tick.
+    print(io::out, "objects\tlinked\tscalar\tkernel\tcall\n");
+    for (int count: kObjectCounts) {
+        bench(count, ticks);
+    }
+}
+
+}  // namespace
+}  // namespace antares
+
+int main(int argc, char* const* argv) {
+    antares::main(argc, argv);
+    return 0;
+}
@@ -17,29 +17,36 @@
 // License along with Antares.  If not, see http://www.gnu.org/licenses/
 
 #include <sys/time.h>
+#include <fcntl.h>
 #include <getopt.h>
 #include <queue>
 #include <sfz/sfz.hpp>
 
 #include "config/ledger.hpp"
 #include "config/preferences.hpp"
+#include "game/profile.hpp"
 #include "sound/driver.hpp"
 #include "ui/card.hpp"
 #include "ui/flows/master.hpp"
 #include "video/driver.hpp"
+#ifdef __APPLE__
 #include "video/offscreen-driver.hpp"
+#endif
+#include "video/software-driver.hpp"
 #include "video/text-driver.hpp"
 
 using sfz::Bytes;
 using sfz::Exception;
 using sfz::Optional;
 using sfz::Rune;
+using sfz::ScopedFd;
 using sfz::String;
 using sfz::StringSlice;
 using sfz::args::help;
 using sfz::args::store;
 using sfz::args::store_const;
 using sfz::makedirs;
+using sfz::open;
 using sfz::print;
 using sfz::quote;
 using sfz::string_to_int;
@@ -71,10 +78,16 @@ void main(int argc, char* const* argv) {
 
     Optional<String> output_dir;
     bool text = false;
+    Optional<String> profile_path;
     parser.add_argument("-o", "--output", store(output_dir))
         .help("place output in this directory");
     parser.add_argument("-t", "--text", store_const(text, true))
         .help("produce text output");
+    bool software = false;
+    parser.add_argument("--software", store_const(software, true))
+        .help("draw without OpenGL");
+    parser.add_argument("-p", "--profile", store(profile_path))
+        .help("time each phase of the game loop and write a JSON report here");
     parser.add_argument("-h", "--help", help(parser, 0))
         .help("display this help screen");
 
@@ -87,6 +100,10 @@ void main(int argc, char* const* argv) {
     if (output_dir.has()) {
         makedirs(*output_dir, 0755);
     }
+#ifndef __APPLE__
+    // The OpenGL driver needs CGL, so elsewhere the software driver is the only one.
+    software = true;
+#endif
 
     NullPrefsDriver prefs;
     EventScheduler scheduler;
@@ -112,12 +129,29 @@ void main(int argc, char* const* argv) {
         sound.reset(new NullSoundDriver);
     }
 
+    if (profile_path.has()) {
+        enable_profiling();
+    }
+
     if (text) {
         TextVideoDriver video(Preferences::preferences()->screen_size(), scheduler, output_dir);
         video.loop(new Master(14586));
+    } else if (software) {
+        SoftwareVideoDriver video(Preferences::preferences()->screen_size(), scheduler, output_dir);
+        video.set_parallel(true);
+        video.loop(new Master(14586));
+#ifdef __APPLE__
     } else {
         OffscreenVideoDriver video(Preferences::preferences()->screen_size(), scheduler, output_dir);
         video.loop(new Master(14586));
+#endif
+    }
+
+    if (profile_path.has()) {
+        String profile;
+        write_profile(profile);
+        ScopedFd file(open(*profile_path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+        sfz::write(file, utf8::encode(profile));
     }
 }
 
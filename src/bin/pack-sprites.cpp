@@ -0,0 +1,114 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <vector>
+#include <sfz/sfz.hpp>
+
+#include "config/dirs.hpp"
+#include "config/preferences.hpp"
+#include "drawing/pix-table.hpp"
+
+using sfz::Bytes;
+using sfz::CString;
+using sfz::Exception;
+using sfz::Optional;
+using sfz::ScopedFd;
+using sfz::String;
+using sfz::StringSlice;
+using sfz::args::help;
+using sfz::args::store;
+using sfz::format;
+using sfz::quote;
+using sfz::string_to_int;
+using sfz::write;
+using std::sort;
+using std::vector;
+
+namespace io = sfz::io;
+namespace utf8 = sfz::utf8;
+namespace args = sfz::args;
+
+namespace antares {
+namespace {
+
+// Returns the IDs of the sprite tables in `dir`, which have JSON files named by ID.
+vector<int> list_tables(const String& dir) {
+    vector<int> ids;
+    CString c_dir(dir);
+    DIR* d = opendir(c_dir.data());
+    if (!d) {
+        throw Exception(format("{0}: couldn't open directory", quote(dir)));
+    }
+    while (dirent* entry = readdir(d)) {
+        String name(utf8::decode(entry->d_name));
+        int id;
+        if ((name.size() > 5) && (name.slice(name.size() - 5) == ".json")
+                && string_to_int(name.slice(0, name.size() - 5), id)) {
+            ids.push_back(id);
+        }
+    }
+    closedir(d);
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+int main(int argc, char* const* argv) {
+    args::Parser parser(argv[0], "Compiles the sprite tables of a scenario into sprite packs");
+
+    Optional<String> output_dir;
+    parser.add_argument("-o", "--output", store(output_dir))
+        .help("place output in this directory (default: alongside the tables)");
+    parser.add_argument("-h", "--help", help(parser, 0))
+        .help("display this help screen");
+
+    String error;
+    if (!parser.parse_args(argc - 1, argv + 1, error)) {
+        print(io::err, format("{0}: {1}\n", parser.name(), error));
+        exit(1);
+    }
+
+    NullPrefsDriver prefs;
+    const String sprites_dir(format(
+                "{0}/{1}/sprites", dirs().scenarios,
+                Preferences::preferences()->scenario_identifier()));
+    String out_dir(sprites_dir);
+    if (output_dir.has()) {
+        out_dir.assign(*output_dir);
+    }
+    makedirs(out_dir, 0755);
+
+    for (int id: list_tables(sprites_dir)) {
+        Bytes pack;
+        NatePixTable::write_pack(pack, id);
+        const String path(format("{0}/{1}.pack", out_dir, id));
+        ScopedFd fd(open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+        write(fd, pack);
+    }
+
+    return 0;
+}
+
+}  // namespace
+}  // namespace antares
+
+int main(int argc, char** argv) {
+    return antares::main(argc, argv);
+}
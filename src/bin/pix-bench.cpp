@@ -0,0 +1,158 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include <sys/time.h>
+#include <sfz/sfz.hpp>
+
+#include "drawing/color.hpp"
+#include "drawing/pix-map.hpp"
+#include "drawing/pix-spans.hpp"
+#include "math/random.hpp"
+
+using sfz::Exception;
+using sfz::String;
+using sfz::args::help;
+using sfz::args::store;
+using sfz::format;
+
+namespace args = sfz::args;
+namespace io = sfz::io;
+
+namespace antares {
+namespace {
+
+// Square frames: a small sprite, a large sprite, and a full screen.
+const int kFrameSizes[] = {32, 128, 640};
+
+const char* const kIsaNames[] = {"scalar", "sse2", "avx2"};
+
+int64_t wall_usecs() {
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return (tv.tv_sec * 1000000ll) + tv.tv_usec;
+}
+
+// Fills `pix` with a sprite-like image: mostly opaque or clear, with partly-transparent edges,
+// and overlay-like values in the red channel.
+void make_frame(PixMap& pix, int32_t seed) {
+    Random random = {seed};
+    for (int y = 0; y < pix.size().height; ++y) {
+        RgbColor* row = pix.mutable_row(y);
+        for (int x = 0; x < pix.size().width; ++x) {
+            const int kind = random.next(16);
+            const uint8_t alpha = (kind < 10) ? 255 : (kind < 14) ? 0 : random.next(256);
+            row[x] = RgbColor(alpha, random.next(256), random.next(256), random.next(256));
+        }
+    }
+}
+
+bool same_pixels(const PixMap& a, const PixMap& b) {
+    for (int y = 0; y < a.size().height; ++y) {
+        if (memcmp(a.row(y), b.row(y), a.size().width * sizeof(RgbColor)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Applies one of the span operations to every row of `dst`, as PixMap and Frame do.
+enum Op { FILL, COMPOSITE, TINT };
+void apply(Op op, PixMap& dst, const PixMap& src, PixSpanIsa isa) {
+    const int32_t width = dst.size().width;
+    for (int y = 0; y < dst.size().height; ++y) {
+        switch (op) {
+          case FILL:
+            fill_span(dst.mutable_row(y), RgbColor(255, 32, 64, 128), width, isa);
+            break;
+          case COMPOSITE:
+            composite_span(dst.mutable_row(y), src.row(y), width, isa);
+            break;
+          case TINT:
+            tint_span(dst.mutable_row(y), src.row(y), TAN, width, isa);
+            break;
+        }
+    }
+}
+
+// Returns picoseconds per pixel for `op`, after checking that `isa` gives the same pixels as
+// the scalar reference.
+int64_t time_op(Op op, int size, PixSpanIsa isa, int reps) {
+    ArrayPixMap src(size, size);
+    ArrayPixMap under(size, size);
+    ArrayPixMap expected(size, size);
+    ArrayPixMap actual(size, size);
+    make_frame(src, size);
+    make_frame(under, size + 1);
+
+    expected.copy(under);
+    apply(op, expected, src, PIX_SPAN_SCALAR);
+    actual.copy(under);
+    apply(op, actual, src, isa);
+    if (!same_pixels(expected, actual)) {
+        throw Exception(format("{0} differs from scalar at {1}x{1}", kIsaNames[isa], size));
+    }
+
+    int64_t usecs = 0;
+    for (int i = 0; i < reps; ++i) {
+        actual.copy(under);
+        const int64_t start = wall_usecs();
+        apply(op, actual, src, isa);
+        usecs += wall_usecs() - start;
+    }
+    return usecs * 1000000 / (int64_t(size) * size * reps);
+}
+
+void bench(int size, PixSpanIsa isa, int reps) {
+    print(io::out, format("{0}\t{1}\t{2}\t{3}\t{4}\n", size, kIsaNames[isa],
+                time_op(FILL, size, isa, reps), time_op(COMPOSITE, size, isa, reps),
+                time_op(TINT, size, isa, reps)));
+}
+
+void main(int argc, char* const* argv) {
+    args::Parser parser(argv[0], "Times PixMap fill, composite, and overlay tinting");
+
+    int reps = 100;
+    parser.add_argument("-r", "--reps", store(reps))
+        .help("number of times to repeat each operation (default: 100)");
+    parser.add_argument("-h", "--help", help(parser, 0))
+        .help("display this help screen");
+
+    String error;
+    if (!parser.parse_args(argc - 1, argv + 1, error)) {
+        print(io::err, format("{0}: {1}\n", parser.name(), error));
+        exit(1);
+    }
+
+    // Times are in picoseconds per pixel.
+    print(io::out, "size\tisa\tfill\tcomposite\ttint\n");
+    for (int size: kFrameSizes) {
+        for (PixSpanIsa isa: {PIX_SPAN_SCALAR, PIX_SPAN_SSE2, PIX_SPAN_AVX2}) {
+            if (pix_span_isa_supported(isa)) {
+                bench(size, isa, reps);
+            }
+        }
+    }
+}
+
+}  // namespace
+}  // namespace antares
+
+int main(int argc, char* const* argv) {
+    antares::main(argc, argv);
+    return 0;
+}
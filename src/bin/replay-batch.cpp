@@ -0,0 +1,417 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <sfz/sfz.hpp>
+
+#include "config/ledger.hpp"
+#include "config/preferences.hpp"
+#include "data/replay.hpp"
+#include "game/globals.hpp"
+#include "game/input-source.hpp"
+#include "game/main.hpp"
+#include "game/scenario-maker.hpp"
+#include "game/space-object.hpp"
+#include "math/random.hpp"
+#include "sound/driver.hpp"
+#include "test/replay.hpp"
+#include "ui/card.hpp"
+#include "video/driver.hpp"
+#include "video/text-driver.hpp"
+
+using sfz::BytesSlice;
+using sfz::CString;
+using sfz::Exception;
+using sfz::MappedFile;
+using sfz::Optional;
+using sfz::PrintTarget;
+using sfz::ScopedFd;
+using sfz::String;
+using sfz::StringSlice;
+using sfz::args::help;
+using sfz::args::store;
+using sfz::dec;
+using sfz::format;
+using sfz::hex;
+using sfz::makedirs;
+using sfz::print;
+using sfz::quote;
+using std::map;
+using std::sort;
+using std::unique_ptr;
+using std::vector;
+
+namespace args = sfz::args;
+namespace io = sfz::io;
+namespace path = sfz::path;
+namespace utf8 = sfz::utf8;
+
+namespace antares {
+namespace {
+
+// Sent from a worker back to the parent through a pipe.  Small enough to be written atomically.
+struct ReplayOutcome {
+    int32_t     game_result;
+    int32_t     winner;
+    uint32_t    sync;
+    int64_t     ticks;
+    int64_t     usecs;
+};
+
+// A forked worker playing one replay.
+struct Worker {
+    size_t      index;      // into the reports
+    int         fd;         // read end of the worker's pipe
+    int64_t     deadline;   // in wall_usecs()
+    bool        timed_out;
+};
+
+// How often to check on workers while none has finished.
+const useconds_t kPollUsecs = 10000;
+
+struct ReplayReport {
+    String          path;
+    String          status;
+    ReplayOutcome   outcome;
+};
+
+int64_t wall_usecs() {
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return (tv.tv_sec * 1000000ll) + tv.tv_usec;
+}
+
+class BatchReplay : public Card {
+  public:
+    BatchReplay(BytesSlice data, ReplayOutcome* outcome):
+            _state(NEW),
+            _replay_file(ReplayFile::is_replay_file(data) ? new ReplayFile(data) : NULL),
+            _replay_data(_replay_file ? ReplayData() : ReplayData(data)),
+            _chapter_id(_replay_file ? _replay_file->chapter_id() : _replay_data.chapter_id),
+            _random_seed(
+                    _replay_file ? _replay_file->global_seed() : _replay_data.global_seed),
+            _object_limit(
+                    _replay_file ? _replay_file->object_limit() : _replay_data.object_limit),
+            _game_result(NO_GAME),
+            _outcome(outcome) { }
+
+    virtual void become_front() {
+        switch (_state) {
+          case NEW:
+            _state = REPLAY;
+            Randomize(4);  // For the decision to replay intro.
+            _game_result = NO_GAME;
+            gRandomSeed.seed = _random_seed;
+            SetSpaceObjectLimit(_object_limit);
+            if (_replay_file) {
+                globals()->gInputSource.reset(new ReplayFileInputSource(*_replay_file));
+            } else {
+                globals()->gInputSource.reset(new ReplayInputSource(&_replay_data));
+            }
+            stack()->push(new MainPlay(
+                        GetScenarioPtrFromChapter(_chapter_id), true, false,
+                        &_game_result, &_seconds));
+            break;
+
+          case REPLAY:
+            _outcome->game_result = _game_result;
+            _outcome->winner = globals()->gScenarioWinner.player;
+            _outcome->sync = globals()->gSynchValue;
+            _outcome->ticks = VideoDriver::driver()->ticks();
+            stack()->pop(this);
+            break;
+        }
+    }
+
+  private:
+    enum State {
+        NEW,
+        REPLAY,
+    };
+    State _state;
+
+    // v2 replays are played straight from `data`; older ones are decoded into _replay_data.
+    unique_ptr<ReplayFile> _replay_file;
+    ReplayData _replay_data;
+    const int32_t _chapter_id;
+    const int32_t _random_seed;
+    const int32_t _object_limit;
+    GameResult _game_result;
+    int32_t _seconds;
+    ReplayOutcome* const _outcome;
+
+    DISALLOW_COPY_AND_ASSIGN(BatchReplay);
+};
+
+// Runs in the forked worker.  Never returns.
+void run_worker(
+        int fd, const String& replay_path, EventScheduler& scheduler, TextVideoDriver& video) {
+    ReplayOutcome outcome = {};
+    int status = 0;
+    try {
+        int64_t start = wall_usecs();
+        MappedFile replay_file(replay_path);
+        scheduler.schedule_event(unique_ptr<Event>(new MouseMoveEvent(0, Point(320, 240))));
+        video.loop(new BatchReplay(replay_file.data(), &outcome));
+        outcome.usecs = wall_usecs() - start;
+        if (::write(fd, &outcome, sizeof(outcome)) != sizeof(outcome)) {
+            status = 1;
+        }
+    } catch (Exception& e) {
+        print(io::err, format("{0}: {1}\n", replay_path, e.message()));
+        status = 1;
+    }
+    close(fd);
+    _exit(status);
+}
+
+vector<String> list_replays(const String& dir) {
+    vector<String> replays;
+    CString c_dir(dir);
+    DIR* d = opendir(c_dir.data());
+    if (!d) {
+        throw Exception(format("{0}: couldn't open directory", quote(dir)));
+    }
+    while (dirent* entry = readdir(d)) {
+        String name(utf8::decode(entry->d_name));
+        if ((name.size() > 5) && (name.slice(name.size() - 5) == ".NLRP")) {
+            replays.push_back(String(format("{0}/{1}", dir, name)));
+        }
+    }
+    closedir(d);
+    sort(replays.begin(), replays.end());
+    return replays;
+}
+
+StringSlice result_name(int32_t game_result) {
+    switch (game_result) {
+      case WIN_GAME: return "win";
+      case LOSE_GAME: return "lose";
+      case QUIT_GAME: return "quit";
+      case RESTART_GAME: return "restart";
+      default: return "none";
+    }
+}
+
+void write_json(PrintTarget out, const vector<ReplayReport>& reports) {
+    print(out, "[\n");
+    for (size_t i = 0; i < reports.size(); ++i) {
+        const ReplayReport& r = reports[i];
+        print(out, format("  {{\"replay\": {0}", quote(r.path)));
+        print(out, format(", \"status\": \"{0}\"", r.status));
+        if (r.status == "ok") {
+            print(out, format(", \"result\": \"{0}\"", result_name(r.outcome.game_result)));
+            print(out, format(", \"winner\": {0}", r.outcome.winner));
+            print(out, format(", \"sync\": \"{0}\"", hex(r.outcome.sync, 8)));
+            print(out, format(", \"ticks\": {0}", r.outcome.ticks));
+            print(out, format(", \"usecs\": {0}", r.outcome.usecs));
+        }
+        print(out, (i + 1 < reports.size()) ? "},\n" : "}\n");
+    }
+    print(out, "]\n");
+}
+
+// Quotes `field` if it has a comma, quote, or line break, doubling any quotes inside (RFC 4180).
+String csv_field(const StringSlice& field) {
+    bool plain = true;
+    for (sfz::Rune r : field) {
+        if ((r == ',') || (r == '"') || (r == '\n') || (r == '\r')) {
+            plain = false;
+        }
+    }
+    if (plain) {
+        return String(field);
+    }
+    String result("\"");
+    for (sfz::Rune r : field) {
+        if (r == '"') {
+            result.append(1, '"');
+        }
+        result.append(1, r);
+    }
+    result.append(1, '"');
+    return result;
+}
+
+void write_csv(PrintTarget out, const vector<ReplayReport>& reports) {
+    print(out, "replay,status,result,winner,sync,ticks,usecs\n");
+    for (const ReplayReport& r : reports) {
+        if (r.status == "ok") {
+            print(out, format("{0},{1},{2},{3},{4},{5},{6}\n",
+                        csv_field(r.path), r.status, result_name(r.outcome.game_result),
+                        r.outcome.winner, hex(r.outcome.sync, 8), r.outcome.ticks,
+                        r.outcome.usecs));
+        } else {
+            print(out, format("{0},{1},,,,,\n", csv_field(r.path), csv_field(r.status)));
+        }
+    }
+}
+
+void main(int argc, char* const* argv) {
+    args::Parser parser(argv[0], "Plays a directory of replays in parallel and reports outcomes");
+
+    String replay_dir;
+    parser.add_argument("directory", store(replay_dir))
+        .help("a directory of Antares replay scripts (*.NLRP)")
+        .required();
+
+    Optional<String> output_path;
+    String report_format("json");
+    int jobs_arg = sysconf(_SC_NPROCESSORS_ONLN);
+    int timeout = 600;
+    parser.add_argument("-o", "--output", store(output_path))
+        .help("write the report to this file (default: stdout)");
+    parser.add_argument("-f", "--format", store(report_format))
+        .help("report format, json or csv (default: json)");
+    parser.add_argument("-j", "--jobs", store(jobs_arg))
+        .help("number of replays to play at once (default: number of cores)");
+    parser.add_argument("-t", "--timeout", store(timeout))
+        .help("kill a replay after this many seconds, or never if 0 (default: 600)");
+    parser.add_argument("-h", "--help", help(parser, 0))
+        .help("display this help screen");
+
+    String error;
+    if (!parser.parse_args(argc - 1, argv + 1, error)) {
+        print(io::err, format("{0}: {1}\n", parser.name(), error));
+        exit(1);
+    }
+    if ((report_format != "json") && (report_format != "csv")) {
+        print(io::err, format("{0}: unknown format {1}\n", parser.name(), quote(report_format)));
+        exit(1);
+    }
+    const size_t jobs = std::max(jobs_arg, 1);
+
+    vector<ReplayReport> reports;
+    for (const String& replay : list_replays(replay_dir)) {
+        reports.emplace_back();
+        reports.back().path.assign(replay);
+    }
+
+    Preferences preferences;
+    preferences.set_screen_size(Size(640, 480));
+    preferences.set_play_music_in_game(true);
+    NullPrefsDriver prefs(preferences);
+    NullSoundDriver sound;
+    NullLedger ledger;
+    EventScheduler scheduler;
+    TextVideoDriver video(preferences.screen_size(), scheduler, Optional<String>());
+    init_replay();
+
+    // Workers that have not yet been reaped, by pid.
+    map<pid_t, Worker> running;
+    size_t next = 0;
+    bool failed = false;
+    while ((next < reports.size()) || !running.empty()) {
+        while ((next < reports.size()) && (running.size() < jobs)) {
+            int fds[2];
+            if (pipe(fds) < 0) {
+                throw Exception("pipe() failed");
+            }
+            pid_t pid = fork();
+            if (pid < 0) {
+                throw Exception("fork() failed");
+            } else if (pid == 0) {
+                close(fds[0]);
+                for (const auto& kv : running) {
+                    close(kv.second.fd);
+                }
+                run_worker(fds[1], reports[next].path, scheduler, video);
+            }
+            close(fds[1]);
+            Worker worker = {next, fds[0], wall_usecs() + (timeout * 1000000ll), false};
+            running[pid] = worker;
+            ++next;
+        }
+
+        int status;
+        pid_t pid = waitpid(-1, &status, WNOHANG);
+        if (pid < 0) {
+            throw Exception("waitpid() failed");
+        } else if (pid == 0) {
+            // Nothing has finished; kill anything that has run too long, and check again soon.
+            const int64_t now = wall_usecs();
+            for (auto& kv : running) {
+                if ((timeout > 0) && !kv.second.timed_out && (now > kv.second.deadline)) {
+                    kill(kv.first, SIGKILL);
+                    kv.second.timed_out = true;
+                }
+            }
+            usleep(kPollUsecs);
+            continue;
+        }
+        auto it = running.find(pid);
+        if (it == running.end()) {
+            continue;
+        }
+        ReplayReport& report = reports[it->second.index];
+        const Worker worker = it->second;
+        running.erase(it);
+
+        if (worker.timed_out) {
+            print(report.status, "timeout");
+        } else if (WIFSIGNALED(status)) {
+            print(report.status, format("signal {0}", WTERMSIG(status)));
+        } else if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+            print(report.status, "error");
+        } else if (::read(worker.fd, &report.outcome, sizeof(report.outcome))
+                   != sizeof(report.outcome)) {
+            print(report.status, "error");
+        } else {
+            print(report.status, "ok");
+        }
+        close(worker.fd);
+        failed = failed || (report.status != "ok");
+    }
+
+    unique_ptr<ScopedFd> file;
+    if (output_path.has()) {
+        makedirs(path::dirname(*output_path), 0755);
+        file.reset(new ScopedFd(sfz::open(*output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644)));
+    }
+    String report;
+    if (report_format == "csv") {
+        write_csv(report, reports);
+    } else {
+        write_json(report, reports);
+    }
+    if (file) {
+        sfz::write(*file, utf8::encode(report));
+    } else {
+        print(io::out, report);
+    }
+
+    if (failed) {
+        exit(1);
+    }
+}
+
+}  // namespace
+}  // namespace antares
+
+int main(int argc, char* const* argv) {
+    antares::main(argc, argv);
+    return 0;
+}
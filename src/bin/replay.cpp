@@ -19,10 +19,12 @@
 #include <sfz/sfz.hpp>
 #include <getopt.h>
 #include <fcntl.h>
+#include <unistd.h>
 
 #include "config/ledger.hpp"
 #include "config/preferences.hpp"
 #include "data/replay.hpp"
+#include "data/space-object.hpp"
 #include "drawing/color.hpp"
 #include "drawing/pix-map.hpp"
 #include "drawing/text.hpp"
@@ -36,19 +38,29 @@
 #include "game/main.hpp"
 #include "game/messages.hpp"
 #include "game/motion.hpp"
+#include "game/non-player-ship.hpp"
+#include "game/profile.hpp"
 #include "game/scenario-maker.hpp"
+#include "game/space-object.hpp"
+#include "game/sync.hpp"
 #include "math/random.hpp"
 #include "math/rotation.hpp"
 #include "sound/driver.hpp"
 #include "sound/music.hpp"
+#include "test/replay.hpp"
 #include "ui/card.hpp"
 #include "ui/interface-handling.hpp"
 #include "ui/screens/debriefing.hpp"
 #include "video/driver.hpp"
+#ifdef __APPLE__
 #include "video/offscreen-driver.hpp"
+#endif
+#include "video/software-driver.hpp"
 #include "video/text-driver.hpp"
 
+using sfz::Bytes;
 using sfz::BytesSlice;
+using sfz::Exception;
 using sfz::MappedFile;
 using sfz::Optional;
 using sfz::ScopedFd;
@@ -57,8 +69,10 @@ using sfz::StringSlice;
 using sfz::args::store;
 using sfz::args::store_const;
 using sfz::format;
+using sfz::hex;
 using sfz::mkdir;
 using sfz::open;
+using sfz::quote;
 using std::unique_ptr;
 
 namespace args = sfz::args;
@@ -70,24 +84,45 @@ namespace antares {
 
 class ReplayMaster : public Card {
   public:
-    ReplayMaster(BytesSlice data, Optional<String> output_path):
+    ReplayMaster(
+            BytesSlice data, Optional<String> output_path, bool print_summary,
+            int64_t start_at, int64_t snapshot_at, Optional<String> snapshot_path,
+            int32_t max_objects):
             _state(NEW),
             _output_path(output_path),
-            _replay_data(data),
-            _random_seed(_replay_data.global_seed),
+            _print_summary(print_summary),
+            _start_at(start_at),
+            _snapshot_at(snapshot_at),
+            _snapshot_path(snapshot_path),
+            _replay_file(
+                    (ReplayFile::is_replay_file(data) && !snapshot_path.has())
+                    ? new ReplayFile(data) : NULL),
+            _replay_data(_replay_file ? ReplayData() : ReplayData(data)),
+            _chapter_id(_replay_file ? _replay_file->chapter_id() : _replay_data.chapter_id),
+            _random_seed(
+                    _replay_file ? _replay_file->global_seed() : _replay_data.global_seed),
+            _object_limit(max_objects ? max_objects : (
+                    _replay_file ? _replay_file->object_limit() : _replay_data.object_limit)),
             _game_result(NO_GAME) { }
 
     virtual void become_front() {
         switch (_state) {
           case NEW:
             _state = REPLAY;
-            init();
+            init_replay();
             Randomize(4);  // For the decision to replay intro.
             _game_result = NO_GAME;
             gRandomSeed.seed = _random_seed;
-            globals()->gInputSource.reset(new ReplayInputSource(&_replay_data));
+            SetSpaceObjectLimit(_object_limit);
+            if (_replay_file) {
+                globals()->gInputSource.reset(
+                        new ReplayFileInputSource(*_replay_file, _start_at));
+            } else {
+                globals()->gInputSource.reset(
+                        new ReplayInputSource(&_replay_data, _start_at, _snapshot_at));
+            }
             stack()->push(new MainPlay(
-                        GetScenarioPtrFromChapter(_replay_data.chapter_id), true, false,
+                        GetScenarioPtrFromChapter(_chapter_id), true, false,
                         &_game_result, &_seconds));
             break;
 
@@ -110,13 +145,20 @@ class ReplayMaster : public Card {
                     sfz::write(outcome, "\n");
                 }
             }
+            if (_print_summary) {
+                print_summary();
+            }
+            if (_snapshot_path.has()) {
+                save_snapshot();
+            }
             stack()->pop(this);
             break;
         }
     }
 
   private:
-    void init();
+    void print_summary() const;
+    void save_snapshot() const;
 
     enum State {
         NEW,
@@ -125,39 +167,54 @@ class ReplayMaster : public Card {
     State _state;
 
     Optional<String> _output_path;
+    const bool _print_summary;
+    const int64_t _start_at;
+    const int64_t _snapshot_at;
+    Optional<String> _snapshot_path;
+    // v2 replays are played straight from `data`, unless a snapshot is to be added to them;
+    // older ones are decoded into _replay_data.
+    unique_ptr<ReplayFile> _replay_file;
     ReplayData _replay_data;
+    const int32_t _chapter_id;
     const int32_t _random_seed;
+    const int32_t _object_limit;
     GameResult _game_result;
     int32_t _seconds;
 
     DISALLOW_COPY_AND_ASSIGN(ReplayMaster);
 };
 
-void ReplayMaster::init() {
-    init_globals();
-
-    SoundDriver::driver()->set_global_volume(8);  // Max volume.
-
-    world = Rect(Point(0, 0), Preferences::preferences()->screen_size());
-    play_screen = Rect(
-        world.left + kLeftPanelWidth, world.top,
-        world.right - kRightPanelWidth, world.bottom);
-    viewport = play_screen;
-
-    RotationInit();
-    InitDirectText();
-    Labels::init();
-    Messages::init();
-    InstrumentInit();
-    SpriteHandlingInit();
-    AresCheatInit();
-    ScenarioMakerInit();
-    SpaceObjectHandlingInit();  // MUST be after ScenarioMakerInit()
-    InitSoundFX();
-    MusicInit();
-    InitMotion();
-    AdmiralInit();
-    Beams::init();
+// Prints the outcome of the replay in a form that is easy to diff across builds: the final
+// synchronization value, the winning admiral, and the number of ticks that elapsed.
+void ReplayMaster::print_summary() const {
+    const char* result;
+    switch (_game_result) {
+      case WIN_GAME: result = "win"; break;
+      case LOSE_GAME: result = "lose"; break;
+      case QUIT_GAME: result = "quit"; break;
+      default: result = "none"; break;
+    }
+    print(io::out, format("sync: {0}\n", hex(globals()->gSynchValue, 8)));
+    print(io::out, format("winner: {0}\n", globals()->gScenarioWinner.player));
+    print(io::out, format("result: {0}\n", result));
+    print(io::out, format("ticks: {0}\n", VideoDriver::driver()->ticks()));
+}
+
+// Writes the replay, with the snapshot taken at _snapshot_at added, to _snapshot_path.  Playing
+// that from --start-at=_snapshot_at should give the same game as playing this one straight
+// through.
+void ReplayMaster::save_snapshot() const {
+    bool found = false;
+    for (const ReplayData::Snapshot& snapshot: _replay_data.snapshots) {
+        found = found || (snapshot.at == _snapshot_at);
+    }
+    if (!found) {
+        throw Exception(format("replay ended before decide cycle {0}", _snapshot_at));
+    }
+    Bytes data;
+    sfz::write(data, _replay_data);
+    ScopedFd file(open(*_snapshot_path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    sfz::write(file, data);
 }
 
 void usage(StringSlice program_name) {
@@ -165,6 +222,15 @@ void usage(StringSlice program_name) {
     exit(1);
 }
 
+// Opens the file to stream --y4m output to; "-" is stdout.
+int open_y4m(const String& path) {
+    int fd = (path == "-") ? dup(1) : open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw Exception(format("{0}: couldn't open", quote(path)));
+    }
+    return fd;
+}
+
 void main(int argc, char** argv) {
     args::Parser parser(argv[0], "Plays a replay into a set of images and a log of sounds");
 
@@ -181,7 +247,9 @@ void main(int argc, char** argv) {
     int width = 640;
     int height = 480;
     bool text = false;
+    bool software = false;
     bool smoke = false;
+    bool summary = false;
     parser.add_argument("-i", "--interval", store(interval))
         .help("take one screenshot per this many ticks (default: 60)");
     parser.add_argument("-w", "--width", store(width))
@@ -190,8 +258,44 @@ void main(int argc, char** argv) {
         .help("screen height (default: 480)");
     parser.add_argument("-t", "--text", store_const(text, true))
         .help("produce text output");
+    parser.add_argument("--software", store_const(software, true))
+        .help("draw without OpenGL");
     parser.add_argument("-s", "--smoke", store_const(smoke, true))
         .help("run as smoke text");
+    parser.add_argument("--summary", store_const(summary, true))
+        .help("print the outcome when the replay ends");
+
+    Optional<String> y4m_path;
+    parser.add_argument("--y4m", store(y4m_path))
+        .help("write screenshots to this file as a YUV4MPEG2 stream (\"-\" for stdout)");
+
+    int start_at = 0;
+    parser.add_argument("--start-at", store(start_at))
+        .help("resume from the last snapshot at or before this decide cycle");
+
+    int max_objects = 0;
+    parser.add_argument("--max-objects", store(max_objects))
+        .help("allow this many space objects at once (default: as the replay was recorded)");
+
+    Optional<String> profile_path;
+    parser.add_argument("-p", "--profile", store(profile_path))
+        .help("time each phase of the game loop and write a JSON report here");
+
+    Optional<String> snapshot_path;
+    parser.add_argument("--save-snapshot", store(snapshot_path))
+        .help("write the replay here, with a snapshot added at --save-snapshot-at");
+
+    int snapshot_at = 0;
+    parser.add_argument("--save-snapshot-at", store(snapshot_at))
+        .help("take the snapshot for --save-snapshot as of this decide cycle");
+
+    Optional<String> sync_log_path;
+    parser.add_argument("--sync-log", store(sync_log_path))
+        .help("write a digest of the game after every decide cycle here");
+
+    bool think_ahead = true;
+    parser.add_argument("--no-think-ahead", store_const(think_ahead, false))
+        .help("think for every object serially, as a check on thinking ahead in parallel");
 
     parser.add_argument("--help", help(parser, 0))
         .help("display this help screen");
@@ -202,6 +306,20 @@ void main(int argc, char** argv) {
         exit(1);
     }
 
+    if (y4m_path.has() && (smoke || text)) {
+        print(io::err, format("{0}: --y4m needs offscreen output\n", parser.name()));
+        exit(1);
+    }
+    if (snapshot_path.has() != (snapshot_at > 0)) {
+        print(io::err, format(
+                    "{0}: --save-snapshot and --save-snapshot-at go together\n", parser.name()));
+        exit(1);
+    }
+    if ((max_objects < 0) || (max_objects > kMaxSpaceObject)) {
+        print(io::err, format("{0}: --max-objects must be from 1 to {1}\n",
+                    parser.name(), kMaxSpaceObject));
+        exit(1);
+    }
     if (output_dir.has()) {
         makedirs(*output_dir, 0755);
     }
@@ -213,10 +331,7 @@ void main(int argc, char** argv) {
 
     EventScheduler scheduler;
     scheduler.schedule_event(unique_ptr<Event>(new MouseMoveEvent(0, Point(320, 240))));
-    // TODO(sfiera): add recurring snapshots to OffscreenVideoDriver.
-    for (int64_t i = 1; i < 72000; i += interval) {
-        scheduler.schedule_snapshot(i);
-    }
+    scheduler.schedule_snapshots(1, interval, EventScheduler::kForever);
 
     unique_ptr<SoundDriver> sound;
     if (!smoke && output_dir.has()) {
@@ -227,17 +342,64 @@ void main(int argc, char** argv) {
     }
     NullLedger ledger;
 
+    if (profile_path.has()) {
+        enable_profiling();
+    }
+    if (sync_log_path.has()) {
+        enable_sync_log();
+    }
+    SetThinkAhead(think_ahead);
+#ifndef __APPLE__
+    // The OpenGL driver needs CGL, so elsewhere the software driver is the only one.
+    software = true;
+#endif
+
     Size screen_size = Preferences::preferences()->screen_size();
     MappedFile replay_file(replay_path);
     if (smoke) {
+        // Without an output directory, the text driver never takes snapshots, so the card
+        // stack is never asked to draw; only the timers fire.
         TextVideoDriver video(screen_size, scheduler, Optional<String>());
-        video.loop(new ReplayMaster(replay_file.data(), output_dir));
+        video.loop(new ReplayMaster(
+                    replay_file.data(), output_dir, summary, start_at, snapshot_at, snapshot_path,
+                    max_objects));
     } else if (text) {
         TextVideoDriver video(screen_size, scheduler, output_dir);
-        video.loop(new ReplayMaster(replay_file.data(), output_dir));
+        video.loop(new ReplayMaster(
+                    replay_file.data(), output_dir, summary, start_at, snapshot_at, snapshot_path,
+                    max_objects));
+    } else if (software) {
+        SoftwareVideoDriver video(screen_size, scheduler, output_dir);
+        video.set_parallel(true);
+        if (y4m_path.has()) {
+            video.stream_y4m(open_y4m(*y4m_path), interval);
+        }
+        video.loop(new ReplayMaster(
+                    replay_file.data(), output_dir, summary, start_at, snapshot_at, snapshot_path,
+                    max_objects));
+#ifdef __APPLE__
     } else {
         OffscreenVideoDriver video(screen_size, scheduler, output_dir);
-        video.loop(new ReplayMaster(replay_file.data(), output_dir));
+        if (y4m_path.has()) {
+            video.stream_y4m(open_y4m(*y4m_path), interval);
+        }
+        video.loop(new ReplayMaster(
+                    replay_file.data(), output_dir, summary, start_at, snapshot_at, snapshot_path,
+                    max_objects));
+#endif
+    }
+
+    if (profile_path.has()) {
+        String profile;
+        write_profile(profile);
+        ScopedFd file(open(*profile_path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+        sfz::write(file, utf8::encode(profile));
+    }
+    if (sync_log_path.has()) {
+        String sync_log;
+        write_sync_log(sync_log);
+        ScopedFd file(open(*sync_log_path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+        sfz::write(file, utf8::encode(sync_log));
     }
 }
 
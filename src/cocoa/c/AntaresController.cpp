@@ -27,6 +27,7 @@
 #include "config/ledger.hpp"
 #include "config/preferences.hpp"
 #include "game/globals.hpp"
+#include "game/scenario-maker.hpp"
 #include "sound/openal-driver.hpp"
 #include "ui/card.hpp"
 #include "ui/flows/master.hpp"
@@ -76,6 +77,7 @@ extern "C" void antares_controller_destroy_drivers(AntaresDrivers* drivers) {
 
 extern "C" bool antares_controller_loop(AntaresDrivers* drivers, CFStringRef* error_message) {
     try {
+        EnableWarmupCache();
         drivers->video.loop(new Master(time(NULL)));
     } catch (Exception& e) {
         *error_message = cf::wrap(e.message()).release();
@@ -44,6 +44,8 @@ static const char kFullscreenPreference[]      = "Fullscreen";
 static const char kScreenWidthPreference[]     = "ScreenWidth";
 static const char kScreenHeightPreference[]    = "ScreenHeight";
 static const char kScenarioPreference[]        = "Scenario";
+static const char kSyncIntervalPreference[]    = "SyncInterval";
+static const char kSpaceObjectLimitPreference[] = "SpaceObjectLimit";
 
 template <typename T>
 T clamp(T value, T min, T max) {
@@ -140,6 +142,17 @@ void CoreFoundationPrefsDriver::load(Preferences* preferences) {
         preferences->set_screen_size(screen_size);
     }
 
+    {
+        cf::Number cfnum;
+        int32_t val;
+        if (cf::get_preference(kSyncIntervalPreference, cfnum) && cf::unwrap(cfnum, val)) {
+            preferences->set_sync_interval(val);
+        }
+        if (cf::get_preference(kSpaceObjectLimitPreference, cfnum) && cf::unwrap(cfnum, val)) {
+            preferences->set_space_object_limit(val);
+        }
+    }
+
     cf::String cfstr;
     String id;
     if (cf::get_preference(kScenarioPreference, cfstr) && cf::unwrap(cfstr, id)) {
@@ -164,6 +177,9 @@ void CoreFoundationPrefsDriver::save(const Preferences& preferences) {
     cf::set_preference(kScreenWidthPreference, cf::wrap(screen_size.width));
     cf::set_preference(kScreenHeightPreference, cf::wrap(screen_size.height));
     cf::set_preference(kScenarioPreference, cf::wrap(preferences.scenario_identifier()));
+    cf::set_preference(kSyncIntervalPreference, cf::wrap(preferences.sync_interval()));
+    cf::set_preference(
+            kSpaceObjectLimitPreference, cf::wrap(preferences.space_object_limit()));
     CFPreferencesAppSynchronize(kCFPreferencesCurrentApplication);
 }
 
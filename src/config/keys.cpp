@@ -63,6 +63,14 @@ bool operator!=(const KeyMap& a, const KeyMap& b) {
     return !a.equals(b);
 }
 
+void read_from(sfz::ReadSource in, KeyMap& key_map) {
+    in.shift(key_map._data, KeyMap::kDataSize);
+}
+
+void write_to(sfz::WriteTarget out, const KeyMap& key_map) {
+    out.push(sfz::BytesSlice(key_map._data, KeyMap::kDataSize));
+}
+
 void GetKeyMapFromKeyNum(int key_num, KeyMap* key_map) {
     key_map->clear();
     key_map->set(key_num, true);
@@ -23,6 +23,7 @@
 
 #include "config/keys.hpp"
 #include "data/resource.hpp"
+#include "data/space-object.hpp"
 #include "game/globals.hpp"
 
 using sfz::BytesSlice;
@@ -119,6 +120,12 @@ Preferences::Preferences() {
     set_screen_size(Size(640, 480));
 
     _scenario_identifier.assign("com.biggerplanet.ares");
+
+    // Recorded replays carry a digest of the game once a second.
+    set_sync_interval(30);
+
+    // Ares had room for 250 objects; see data/space-object.hpp.
+    set_space_object_limit(kDefaultSpaceObjectLimit);
 }
 
 Preferences::Preferences(const Preferences& other) {
@@ -147,6 +154,8 @@ void Preferences::copy(const Preferences& preferences) {
     set_fullscreen(preferences.fullscreen());
     set_screen_size(preferences.screen_size());
     set_scenario_identifier(preferences.scenario_identifier());
+    set_sync_interval(preferences.sync_interval());
+    set_space_object_limit(preferences.space_object_limit());
 }
 
 uint32_t Preferences::key(size_t index) const {
@@ -181,6 +190,14 @@ StringSlice Preferences::scenario_identifier() const {
     return _scenario_identifier;
 }
 
+int Preferences::sync_interval() const {
+    return _sync_interval;
+}
+
+int32_t Preferences::space_object_limit() const {
+    return _space_object_limit;
+}
+
 void Preferences::set_key(size_t index, uint32_t key) {
     _key_map[index] = key;
 }
@@ -213,6 +230,14 @@ void Preferences::set_scenario_identifier(StringSlice id) {
     _scenario_identifier.assign(id);
 }
 
+void Preferences::set_sync_interval(int cycles) {
+    _sync_interval = max(cycles, 1);
+}
+
+void Preferences::set_space_object_limit(int32_t limit) {
+    _space_object_limit = clamp(limit, 1, kMaxSpaceObject);
+}
+
 PrefsDriver::PrefsDriver() {
     if (antares::prefs_driver) {
         throw Exception("PrefsDriver is a singleton");
@@ -0,0 +1,272 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "data/extraction.hpp"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <sfz/sfz.hpp>
+
+#include "lang/worker-pool.hpp"
+
+using sfz::Bytes;
+using sfz::BytesSlice;
+using sfz::CString;
+using sfz::Exception;
+using sfz::MappedFile;
+using sfz::ScopedFd;
+using sfz::Sha1;
+using sfz::String;
+using sfz::StringSlice;
+using sfz::format;
+using sfz::makedirs;
+using sfz::quote;
+using sfz::write;
+using std::atomic;
+using std::max;
+using std::min;
+using std::thread;
+using std::unique_ptr;
+using std::vector;
+
+namespace path = sfz::path;
+namespace utf8 = sfz::utf8;
+
+namespace antares {
+
+namespace {
+
+// Run on a worker thread: nothing here touches the file system but to check the record.
+void convert(Extraction& extraction, const ExtractionRecord& record) {
+    Sha1 sha;
+    write(sha, utf8::encode(extraction.path));
+    write(sha, extraction.input);
+    extraction.digest.assign(String(format("{0}", sha.digest())));
+    extraction.current = record.current(extraction.path, extraction.digest);
+    if (!extraction.current) {
+        extraction.converted = extraction.convert(
+                path::dirname(extraction.path), extraction.id, extraction.input,
+                extraction.data, extraction.extra);
+    }
+}
+
+void write_file(const StringSlice& scenario_dir, const StringSlice& file, const Bytes& data) {
+    const String full_path(format("{0}/{1}", scenario_dir, file));
+    makedirs(path::dirname(full_path), 0755);
+
+    // As with the record, the file is written beside its final path and renamed into place.  A
+    // resource may still be mapped from the old file; truncating that would pull the pages out
+    // from under it, but replacing it leaves the mapping with the old contents.
+    const String tmp_path(format("{0}.tmp", full_path));
+    {
+        ScopedFd fd(open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+        write(fd, data.data(), data.size());
+    }
+    if (rename(CString(tmp_path).data(), CString(full_path).data()) < 0) {
+        throw Exception(format("couldn't write {0}", quote(full_path)));
+    }
+}
+
+void write_extraction(
+        const StringSlice& scenario_dir, const Extraction& extraction, ExtractionRecord& record) {
+    if (extraction.current) {
+        record.keep(extraction.path);
+        return;
+    }
+    vector<String> files;
+    for (const auto& file: extraction.extra) {
+        write_file(scenario_dir, file->path, file->data);
+        files.emplace_back(file->path);
+    }
+    if (extraction.converted) {
+        write_file(scenario_dir, extraction.path, extraction.data);
+        files.emplace_back(extraction.path);
+    }
+    record.update(extraction.path, extraction.digest, files);
+}
+
+// Converted resources are held in memory until written, so they are done in batches of this
+// many per thread.
+const size_t kExtractionBatch = 8;
+
+}  // namespace
+
+ExtractionRecord::ExtractionRecord(const StringSlice& scenario_dir, const StringSlice& version):
+        _dir(scenario_dir),
+        _path(format("{0}/extracted", scenario_dir)),
+        _version(version) { }
+
+void ExtractionRecord::start() {
+    if (!load()) {
+        rmtree(_dir);
+        _entries.clear();
+    }
+    rewrite();
+}
+
+bool ExtractionRecord::current(const StringSlice& key, const StringSlice& digest) const {
+    auto it = _entries.find(key);
+    if ((it == _entries.end()) || (it->second.digest != digest)) {
+        return false;
+    }
+    for (const String& file: it->second.files) {
+        if (!path::isfile(String(format("{0}/{1}", _dir, file)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ExtractionRecord::keep(const StringSlice& key) {
+    _entries[key].seen = true;
+}
+
+void ExtractionRecord::update(
+        const StringSlice& key, const StringSlice& digest, const vector<String>& files) {
+    Entry& entry = _entries[key];
+    for (const String& file: entry.files) {
+        if (std::find(files.begin(), files.end(), file) == files.end()) {
+            remove(file);
+        }
+    }
+    entry.digest.assign(digest);
+    entry.files = files;
+    entry.seen = true;
+
+    ScopedFd fd(open(_path, O_WRONLY | O_CREAT | O_APPEND, 0644));
+    write(fd, utf8::encode(line(key, entry)));
+}
+
+void ExtractionRecord::finish() {
+    vector<String> gone;
+    for (const auto& kv: _entries) {
+        if (!kv.second.seen) {
+            for (const String& file: kv.second.files) {
+                remove(file);
+            }
+            gone.emplace_back(kv.first);
+        }
+    }
+    for (const String& key: gone) {
+        _entries.erase(key);
+    }
+    rewrite();
+}
+
+bool ExtractionRecord::load() {
+    unique_ptr<MappedFile> file;
+    try {
+        file.reset(new MappedFile(_path));
+    } catch (Exception& e) {
+        return false;
+    }
+    String contents(utf8::decode(file->data()));
+    StringSlice rest(contents);
+    const StringSlice version(_version);
+    if ((rest.size() < version.size()) || (rest.slice(0, version.size()) != version)) {
+        return false;
+    }
+    rest = rest.slice(version.size());
+
+    // A line without its newline was cut short, and is ignored.
+    StringSlice line;
+    while (partition(line, "\n", rest)) {
+        vector<String> fields;
+        StringSlice field;
+        while (partition(field, "\t", line)) {
+            fields.emplace_back(field);
+        }
+        if (fields.size() < 2) {
+            return false;
+        }
+        Entry& entry = _entries[fields[1]];
+        entry.digest.assign(fields[0]);
+        entry.files.assign(fields.begin() + 2, fields.end());
+    }
+    return true;
+}
+
+// The file is written beside its final path and renamed into place, so that a crash leaves
+// either the old record or the new one.
+void ExtractionRecord::rewrite() const {
+    makedirs(_dir, 0755);
+    const String tmp_path(format("{0}.tmp", _path));
+    {
+        ScopedFd fd(open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+        write(fd, utf8::encode(_version));
+        for (const auto& kv: _entries) {
+            write(fd, utf8::encode(line(kv.first, kv.second)));
+        }
+    }
+    if (rename(CString(tmp_path).data(), CString(_path).data()) < 0) {
+        throw Exception(format("couldn't write {0}", quote(_path)));
+    }
+}
+
+String ExtractionRecord::line(const StringSlice& key, const Entry& entry) {
+    String result(format("{0}\t{1}\t", entry.digest, key));
+    for (const String& file: entry.files) {
+        result.append(file);
+        result.append("\t");
+    }
+    result.append("\n");
+    return result;
+}
+
+void ExtractionRecord::remove(const StringSlice& file) const {
+    const String full_path(format("{0}/{1}", _dir, file));
+    if (path::exists(full_path)) {
+        rmtree(full_path);
+    }
+}
+
+Extraction::Extraction(
+        const StringSlice& path, int16_t id, BytesSlice input, Converter convert):
+        path(path),
+        id(id),
+        input(input),
+        convert(convert),
+        current(false),
+        converted(false) { }
+
+void extract_all(
+        const StringSlice& scenario_dir, vector<unique_ptr<Extraction>>& extractions,
+        ExtractionRecord& record) {
+    WorkerPool pool(max<int>(thread::hardware_concurrency(), 1));
+    const size_t batch = kExtractionBatch * pool.size();
+    for (size_t begin = 0; begin < extractions.size(); begin += batch) {
+        const size_t end = min(begin + batch, extractions.size());
+        // Conversions vary widely in cost, so threads take them one at a time rather than in
+        // the contiguous ranges run() hands out.
+        atomic<size_t> next(begin);
+        pool.run(pool.size(), 1, [&extractions, &next, end, &record](int, size_t, size_t) {
+            for (size_t i = next++; i < end; i = next++) {
+                convert(*extractions[i], record);
+            }
+        });
+        for (size_t i = begin; i < end; ++i) {
+            write_extraction(scenario_dir, *extractions[i], record);
+            extractions[i].reset();
+        }
+    }
+}
+
+}  // namespace antares
@@ -0,0 +1,153 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "data/extraction.hpp"
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <gmock/gmock.h>
+
+using sfz::BytesSlice;
+using sfz::CString;
+using sfz::MappedFile;
+using sfz::String;
+using sfz::StringSlice;
+using sfz::WriteTarget;
+using sfz::format;
+using sfz::write;
+using std::atomic;
+using std::unique_ptr;
+using std::vector;
+
+namespace path = sfz::path;
+namespace utf8 = sfz::utf8;
+
+namespace antares {
+namespace {
+
+const char kVersion[] = "1\n";
+
+atomic<int> conversions;
+
+// Copies its input, and for resource 3, gives it an extra file as well.
+bool convert_thing(StringSlice dir, int16_t id, BytesSlice data, WriteTarget out,
+                   ExtraFiles& extra) {
+    ++conversions;
+    write(out, data);
+    if (id == 3) {
+        unique_ptr<ExtraFile> file(new ExtraFile);
+        file->path.assign(String(format("{0}/{1}/extra.txt", dir, id)));
+        write(file->data, data);
+        extra.push_back(std::move(file));
+    }
+    return true;
+}
+
+struct Input {
+    int16_t id;
+    const char* data;
+};
+
+class ExtractionTest : public testing::Test {
+  public:
+    virtual void SetUp() {
+        char tmp[] = "/tmp/extraction-test-XXXXXX";
+        _dir.assign(utf8::decode(mkdtemp(tmp)));
+    }
+
+    virtual void TearDown() {
+        rmtree(_dir);
+    }
+
+  protected:
+    // Extracts `inputs` into things/<id>.txt, and returns how many were converted.
+    int extract(const vector<Input>& inputs, StringSlice version = kVersion) {
+        conversions = 0;
+        ExtractionRecord record(_dir, version);
+        record.start();
+        vector<unique_ptr<Extraction>> extractions;
+        for (const Input& input: inputs) {
+            extractions.emplace_back(new Extraction(
+                        String(format("things/{0}.txt", input.id)), input.id,
+                        BytesSlice(input.data), convert_thing));
+        }
+        extract_all(_dir, extractions, record);
+        record.finish();
+        return conversions;
+    }
+
+    String file(StringSlice name) const {
+        return String(format("{0}/{1}", _dir, name));
+    }
+
+    String contents(StringSlice name) const {
+        MappedFile mapped(file(name));
+        return String(utf8::decode(mapped.data()));
+    }
+
+    ino_t inode(StringSlice name) const {
+        struct stat st;
+        EXPECT_EQ(0, stat(CString(file(name)).data(), &st));
+        return st.st_ino;
+    }
+
+  private:
+    String _dir;
+};
+
+TEST_F(ExtractionTest, Incremental) {
+    EXPECT_EQ(3, extract({{1, "one"}, {2, "two"}, {3, "three"}}));
+    EXPECT_EQ("one", contents("things/1.txt"));
+    EXPECT_EQ("two", contents("things/2.txt"));
+    EXPECT_EQ("three", contents("things/3.txt"));
+    EXPECT_EQ("three", contents("things/3/extra.txt"));
+
+    // Nothing changed, so nothing is converted or written.
+    const ino_t one = inode("things/1.txt");
+    const ino_t two = inode("things/2.txt");
+    EXPECT_EQ(0, extract({{1, "one"}, {2, "two"}, {3, "three"}}));
+    EXPECT_EQ(one, inode("things/1.txt"));
+    EXPECT_EQ(two, inode("things/2.txt"));
+
+    // Only the changed resource is rewritten.  It is replaced, not overwritten, so a mapping of
+    // the old file still reads the old contents.
+    MappedFile old_two(file("things/2.txt"));
+    EXPECT_EQ(1, extract({{1, "one"}, {2, "TWO"}, {3, "three"}}));
+    EXPECT_EQ("TWO", contents("things/2.txt"));
+    EXPECT_EQ("two", String(utf8::decode(old_two.data())));
+    EXPECT_EQ(one, inode("things/1.txt"));
+    EXPECT_NE(two, inode("things/2.txt"));
+
+    // The files of a resource that is gone are deleted, extra files and all.
+    EXPECT_EQ(0, extract({{1, "one"}, {2, "TWO"}}));
+    EXPECT_FALSE(path::exists(file("things/3.txt")));
+    EXPECT_FALSE(path::exists(file("things/3/extra.txt")));
+    EXPECT_EQ("one", contents("things/1.txt"));
+    EXPECT_EQ("TWO", contents("things/2.txt"));
+}
+
+// A record left by another version of the extractor isn't trusted, so everything is redone.
+TEST_F(ExtractionTest, Version) {
+    EXPECT_EQ(2, extract({{1, "one"}, {2, "two"}}));
+    EXPECT_EQ(2, extract({{1, "one"}, {2, "two"}}, "2\n"));
+    EXPECT_EQ(0, extract({{1, "one"}, {2, "two"}}, "2\n"));
+}
+
+}  // namespace
+}  // namespace antares
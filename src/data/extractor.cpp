@@ -25,7 +25,9 @@
 #include <sfz/sfz.hpp>
 #include <zipxx/zipxx.hpp>
 
+#include "data/extraction.hpp"
 #include "data/replay.hpp"
+#include "data/resource.hpp"
 #include "drawing/pix-map.hpp"
 #include "math/geometry.hpp"
 #include "net/http.hpp"
@@ -69,7 +71,7 @@ namespace antares {
 
 namespace {
 
-bool verbatim(StringSlice, int16_t, BytesSlice data, WriteTarget out) {
+bool verbatim(StringSlice, int16_t, BytesSlice data, WriteTarget out, ExtraFiles&) {
     write(out, data);
     return true;
 }
@@ -92,7 +94,7 @@ int32_t nlrp_chapter(int16_t id) {
     throw Exception(format("invalid replay ID {0}", id));
 }
 
-bool convert_nlrp(StringSlice, int16_t id, BytesSlice data, WriteTarget out) {
+bool convert_nlrp(StringSlice, int16_t id, BytesSlice data, WriteTarget out, ExtraFiles&) {
     ReplayData replay;
     replay.scenario.identifier.assign("com.biggerplanet.ares");
     replay.scenario.version.assign("1.1.1");
@@ -125,7 +127,7 @@ bool convert_nlrp(StringSlice, int16_t id, BytesSlice data, WriteTarget out) {
     return true;
 }
 
-bool convert_pict(StringSlice, int16_t, BytesSlice data, WriteTarget out) {
+bool convert_pict(StringSlice, int16_t, BytesSlice data, WriteTarget out, ExtraFiles&) {
     rezin::Picture pict(data);
     if ((pict.version() == 2) && (pict.is_raster())) {
         write(out, png(pict));
@@ -134,7 +136,7 @@ bool convert_pict(StringSlice, int16_t, BytesSlice data, WriteTarget out) {
     return false;
 }
 
-bool convert_str(StringSlice, int16_t, BytesSlice data, WriteTarget out) {
+bool convert_str(StringSlice, int16_t, BytesSlice data, WriteTarget out, ExtraFiles&) {
     Options options;
     StringList list(data, options);
     String string(pretty_print(json(list)));
@@ -142,14 +144,14 @@ bool convert_str(StringSlice, int16_t, BytesSlice data, WriteTarget out) {
     return true;
 }
 
-bool convert_text(StringSlice, int16_t, BytesSlice data, WriteTarget out) {
+bool convert_text(StringSlice, int16_t, BytesSlice data, WriteTarget out, ExtraFiles&) {
     Options options;
     String string(options.decode(data));
     write(out, utf8::encode(string));
     return true;
 }
 
-bool convert_snd(StringSlice, int16_t, BytesSlice data, WriteTarget out) {
+bool convert_snd(StringSlice, int16_t, BytesSlice data, WriteTarget out, ExtraFiles&) {
     Sound snd(data);
     write(out, aiff(snd));
     return true;
@@ -220,7 +222,8 @@ static Json json(const Point& p) {
     return Json::object(json);
 }
 
-bool convert_smiv(StringSlice dir, int16_t id, BytesSlice data, WriteTarget out) {
+bool convert_smiv(
+        StringSlice dir, int16_t id, BytesSlice data, WriteTarget out, ExtraFiles& extra) {
     BytesSlice header = data;
     header.shift(4);
     uint32_t size = read<uint32_t>(header);
@@ -288,20 +291,19 @@ bool convert_smiv(StringSlice dir, int16_t id, BytesSlice data, WriteTarget out)
         convert_overlay(dir, id, frame_data.slice(0, r.area()), overlay.view(r));
     }
 
-    String sprite_dir(format("{0}/{1}", dir, id));
-    makedirs(sprite_dir, 0755);
-
     {
-        String output(format("{0}/{1}/image.png", dir, id));
-        ScopedFd fd(open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644));
-        write(fd, Bytes(image));
+        unique_ptr<ExtraFile> file(new ExtraFile);
+        file->path.assign(String(format("{0}/{1}/image.png", dir, id)));
+        write(file->data, Bytes(image));
+        extra.push_back(std::move(file));
         object["image"] = Json::string(format("sprites/{0}/image.png", id));
     }
 
     {
-        String output(format("{0}/{1}/overlay.png", dir, id));
-        ScopedFd fd(open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644));
-        write(fd, Bytes(overlay));
+        unique_ptr<ExtraFile> file(new ExtraFile);
+        file->path.assign(String(format("{0}/{1}/overlay.png", dir, id)));
+        write(file->data, Bytes(overlay));
+        extra.push_back(std::move(file));
         object["overlay"] = Json::string(format("sprites/{0}/overlay.png", id));
     }
 
@@ -316,7 +318,7 @@ struct ResourceFile {
         const char* resource;
         const char* output_directory;
         const char* output_extension;
-        bool (*convert)(StringSlice dir, int16_t id, BytesSlice data, WriteTarget out);
+        Converter convert;
     } resources[16];
 };
 
@@ -440,9 +442,11 @@ void DataExtractor::set_plugin_file(StringSlice path) {
         ScopedFd fd(open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
         write(fd, file.data());
     }
-    String scenario_dir(format("{0}/{1}", _output_dir, found_scenario));
-    if (path::exists(scenario_dir)) {
-        rmtree(scenario_dir);
+    // Mark the scenario out of date, but keep what was extracted from the old version of the
+    // plugin, so that only resources which changed are extracted again.
+    String version_path(format("{0}/{1}/version", _output_dir, found_scenario));
+    if (path::exists(version_path)) {
+        rmtree(version_path);
     }
 
     swap(_scenario, found_scenario);
@@ -456,6 +460,8 @@ bool DataExtractor::current() const {
 void DataExtractor::extract(Observer* observer) const {
     extract_factory_scenario(observer);
     extract_plugin_scenario(observer);
+    // Any resources found before now may have been replaced.
+    rescan_resources();
 }
 
 void DataExtractor::extract_factory_scenario(Observer* observer) const {
@@ -463,8 +469,6 @@ void DataExtractor::extract_factory_scenario(Observer* observer) const {
         download(observer, kDownloadBase, "Ares", "1.2.0",
                 (Sha1::Digest){{0x246c393c, 0xa598af68, 0xa58cfdd1, 0x8e1601c1, 0xf4f30931}});
 
-        String scenario_dir(format("{0}/{1}", _output_dir, kFactoryScenario));
-        rmtree(scenario_dir);
         extract_original(observer, "Ares-1.2.0.zip");
         write_version(kFactoryScenario);
     }
@@ -472,8 +476,6 @@ void DataExtractor::extract_factory_scenario(Observer* observer) const {
 
 void DataExtractor::extract_plugin_scenario(Observer* observer) const {
     if ((_scenario != kFactoryScenario) && !scenario_current(_scenario)) {
-        String scenario_dir(format("{0}/{1}", _output_dir, _scenario));
-        rmtree(scenario_dir);
         extract_plugin(observer);
         write_version(_scenario);
     }
@@ -549,12 +551,17 @@ void DataExtractor::extract_original(Observer* observer, const StringSlice& file
     rezin::Options options;
     options.line_ending = rezin::Options::CR;
 
+    String scenario_dir(format("{0}/{1}", _output_dir, kFactoryScenario));
+    ExtractionRecord record(scenario_dir, kVersion);
+    record.start();
+
     for (const ResourceFile& resource_file: kResourceFiles) {
         String path(utf8::decode(resource_file.path));
         ZipFileReader file(archive, path);
         AppleDouble apple_double(file.data());
         ResourceFork rsrc(apple_double.at(AppleDouble::RESOURCE_FORK), options);
 
+        vector<unique_ptr<Extraction>> extractions;
         for (const ResourceFile::ExtractedResource& conversion: resource_file.resources) {
             if (!conversion.resource) {
                 continue;
@@ -562,18 +569,17 @@ void DataExtractor::extract_original(Observer* observer, const StringSlice& file
 
             const ResourceType& type = rsrc.at(conversion.resource);
             for (const ResourceEntry& entry: type) {
-                Bytes data;
-                String output(format("{0}/com.biggerplanet.ares/{1}/{2}.{3}",
-                            _output_dir, conversion.output_directory, entry.id(),
+                String output(format("{0}/{1}.{2}",
+                            conversion.output_directory, entry.id(),
                             conversion.output_extension));
-                if (conversion.convert(path::dirname(output), entry.id(), entry.data(), data)) {
-                    makedirs(path::dirname(output), 0755);
-                    ScopedFd fd(open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644));
-                    write(fd, data.data(), data.size());
-                }
+                extractions.emplace_back(
+                        new Extraction(output, entry.id(), entry.data(), conversion.convert));
             }
         }
+        extract_all(scenario_dir, extractions, record);
     }
+
+    record.finish();
 }
 
 void DataExtractor::extract_plugin(Observer* observer) const {
@@ -589,9 +595,16 @@ void DataExtractor::extract_plugin(Observer* observer) const {
     check_version(archive, kPluginVersion);
     check_identifier(archive, _scenario);
 
+    String scenario_dir(format("{0}/{1}", _output_dir, _scenario));
+    ExtractionRecord record(scenario_dir, kVersion);
+    record.start();
+
+    // The files are all read before any are converted, and kept until all are done.
+    vector<unique_ptr<ZipFileReader>> files;
+    vector<unique_ptr<Extraction>> extractions;
     for (size_t i: range(archive.size())) {
-        ZipFileReader file(archive, i);
-        StringSlice path = file.path();
+        unique_ptr<ZipFileReader> file(new ZipFileReader(archive, i));
+        StringSlice path = file->path();
 
         // Skip directories and special files.
         if ((path.rfind("/") == (path.size() - 1))
@@ -610,7 +623,7 @@ void DataExtractor::extract_plugin(Observer* observer) const {
                 || !partition(id_slice, " ", path)
                 || !string_to_int(id_slice, id)
                 || (path.find('/') != StringSlice::npos)) {
-            throw Exception(format("bad plugin file {0}", quote(file.path())));
+            throw Exception(format("bad plugin file {0}", quote(file->path())));
         }
 
         String resource_type(resource_type_slice);
@@ -620,15 +633,11 @@ void DataExtractor::extract_plugin(Observer* observer) const {
 
         for (const ResourceFile::ExtractedResource& conversion: kPluginFiles) {
             if (conversion.resource == resource_type) {
-                Bytes data;
-                String output(format("{0}/{1}/{2}/{3}.{4}",
-                            _output_dir, _scenario, conversion.output_directory, id,
-                            conversion.output_extension));
-                if (conversion.convert(path::dirname(output), id, file.data(), data)) {
-                    makedirs(path::dirname(output), 0755);
-                    ScopedFd fd(open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644));
-                    write(fd, data.data(), data.size());
-                }
+                String output(format("{0}/{1}.{2}",
+                            conversion.output_directory, id, conversion.output_extension));
+                extractions.emplace_back(
+                        new Extraction(output, id, file->data(), conversion.convert));
+                files.push_back(std::move(file));
                 goto next;
             }
         }
@@ -637,6 +646,9 @@ void DataExtractor::extract_plugin(Observer* observer) const {
 
 next:   ;  // labeled continue.
     }
+    extract_all(scenario_dir, extractions, record);
+
+    record.finish();
 }
 
 }  // namespace antares
@@ -21,11 +21,14 @@
 #include <fcntl.h>
 #include <glob.h>
 #include <unistd.h>
+#include <zlib.h>
+#include <algorithm>
 #include <sfz/sfz.hpp>
 
 #include "config/dirs.hpp"
 #include "config/keys.hpp"
 #include "config/preferences.hpp"
+#include "data/space-object.hpp"
 
 using sfz::Bytes;
 using sfz::BytesSlice;
@@ -47,15 +50,22 @@ namespace utf8 = sfz::utf8;
 
 namespace antares {
 
-ReplayData::ReplayData() {
-}
+ReplayData::ReplayData():
+        object_limit(kDefaultSpaceObjectLimit) { }
 
-ReplayData::ReplayData(sfz::BytesSlice in) {
-    read(in, *this);
+ReplayData::ReplayData(sfz::BytesSlice in):
+        object_limit(kDefaultSpaceObjectLimit) {
+    if (ReplayFile::is_replay_file(in)) {
+        ReplayFile(in).read_all(this);
+    } else {
+        read(in, *this);
+    }
 }
 
+// Within an action, keys pressed are played back before keys released, so a key pressed after
+// one was released in the same cycle starts a new action.
 void ReplayData::key_down(uint64_t at, uint32_t key) {
-    if (actions.empty() || (actions.back().at != at)) {
+    if (actions.empty() || (actions.back().at != at) || !actions.back().keys_up.empty()) {
         actions.emplace_back();
         actions.back().at = at;
     }
@@ -85,6 +95,9 @@ enum {
     GLOBAL_SEED          = (0x03 << 3) | VARINT,
     DURATION             = (0x04 << 3) | VARINT,
     ACTION               = (0x05 << 3) | LENGTH_DELIMITED,
+    SNAPSHOT             = (0x06 << 3) | LENGTH_DELIMITED,
+    SYNC                 = (0x07 << 3) | LENGTH_DELIMITED,
+    OBJECT_LIMIT         = (0x08 << 3) | VARINT,
 
     SCENARIO_IDENTIFIER  = (0x01 << 3) | LENGTH_DELIMITED,
     SCENARIO_VERSION     = (0x02 << 3) | LENGTH_DELIMITED,
@@ -92,8 +105,17 @@ enum {
     ACTION_AT            = (0x01 << 3) | VARINT,
     ACTION_KEY_DOWN      = (0x02 << 3) | VARINT,
     ACTION_KEY_UP        = (0x03 << 3) | VARINT,
+
+    SNAPSHOT_AT          = (0x01 << 3) | VARINT,
+    SNAPSHOT_DATA        = (0x02 << 3) | LENGTH_DELIMITED,
+
+    SYNC_AT              = (0x01 << 3) | VARINT,
+    SYNC_DATA            = (0x02 << 3) | LENGTH_DELIMITED,
 };
 
+// One snapshot a game minute (kDecideEveryCycles is three ticks).
+static const uint64_t kSnapshotInterval = 1200;
+
 static void write_varint(WriteTarget out, uint64_t value) {
     if (value == 0) {
         out.push(1, '\0');
@@ -185,9 +207,38 @@ static T read_message(ReadSource in) {
     return message;
 }
 
+// Skips a field that this version doesn't know, so that later versions can add fields to any
+// message without breaking older readers.
+static void skip_field(ReadSource in, uint64_t tag) {
+    switch (tag & 0x7) {
+      case VARINT:
+        read_varint<uint64_t>(in);
+        break;
+      case FIXED64:
+        read<uint64_t>(in);
+        break;
+      case LENGTH_DELIMITED:
+        {
+            uint8_t buffer[256];
+            for (size_t size = read_varint<size_t>(in); size > 0; ) {
+                const size_t n = std::min(size, sizeof(buffer));
+                in.shift(buffer, n);
+                size -= n;
+            }
+        }
+        break;
+      case FIXED32:
+        read<uint32_t>(in);
+        break;
+      default:
+        throw Exception(format("invalid replay field {0}", tag));
+    }
+}
+
 void read_from(ReadSource in, ReplayData& replay) {
     while (!in.empty()) {
-        switch (read_varint<uint64_t>(in)) {
+        const uint64_t tag = read_varint<uint64_t>(in);
+        switch (tag) {
           case SCENARIO:
             replay.scenario = read_message<ReplayData::Scenario>(in);
             break;
@@ -197,32 +248,49 @@ void read_from(ReadSource in, ReplayData& replay) {
           case GLOBAL_SEED:
             replay.global_seed = read_varint<int32_t>(in);
             break;
+          case OBJECT_LIMIT:
+            replay.object_limit = read_varint<int32_t>(in);
+            break;
           case DURATION:
             replay.duration = read_varint<uint64_t>(in);
             break;
           case ACTION:
             replay.actions.push_back(read_message<ReplayData::Action>(in));
             break;
+          case SNAPSHOT:
+            replay.snapshots.push_back(read_message<ReplayData::Snapshot>(in));
+            break;
+          case SYNC:
+            replay.syncs.push_back(read_message<ReplayData::Sync>(in));
+            break;
+          default:
+            skip_field(in, tag);
+            break;
         }
     }
 }
 
 void read_from(ReadSource in, ReplayData::Scenario& scenario) {
     while (!in.empty()) {
-        switch (read_varint<uint64_t>(in)) {
+        const uint64_t tag = read_varint<uint64_t>(in);
+        switch (tag) {
           case SCENARIO_IDENTIFIER:
             scenario.identifier = read_string(in);
             break;
           case SCENARIO_VERSION:
             scenario.version = read_string(in);
             break;
+          default:
+            skip_field(in, tag);
+            break;
         }
     }
 }
 
 void read_from(ReadSource in, ReplayData::Action& action) {
     while (!in.empty()) {
-        switch (read_varint<uint64_t>(in)) {
+        const uint64_t tag = read_varint<uint64_t>(in);
+        switch (tag) {
           case ACTION_AT:
             action.at = read_varint<uint64_t>(in);
             break;
@@ -232,6 +300,51 @@ void read_from(ReadSource in, ReplayData::Action& action) {
           case ACTION_KEY_UP:
             action.keys_up.push_back(read_varint<uint8_t>(in));
             break;
+          default:
+            skip_field(in, tag);
+            break;
+        }
+    }
+}
+
+void read_from(ReadSource in, ReplayData::Snapshot& snapshot) {
+    while (!in.empty()) {
+        const uint64_t tag = read_varint<uint64_t>(in);
+        switch (tag) {
+          case SNAPSHOT_AT:
+            snapshot.at = read_varint<uint64_t>(in);
+            break;
+          case SNAPSHOT_DATA:
+            {
+                Bytes data(read_varint<size_t>(in), '\0');
+                in.shift(data.data(), data.size());
+                snapshot.data.assign(data);
+            }
+            break;
+          default:
+            skip_field(in, tag);
+            break;
+        }
+    }
+}
+
+void read_from(ReadSource in, ReplayData::Sync& sync) {
+    while (!in.empty()) {
+        const uint64_t tag = read_varint<uint64_t>(in);
+        switch (tag) {
+          case SYNC_AT:
+            sync.at = read_varint<uint64_t>(in);
+            break;
+          case SYNC_DATA:
+            {
+                Bytes data(read_varint<size_t>(in), '\0');
+                in.shift(data.data(), data.size());
+                sync.data.assign(data);
+            }
+            break;
+          default:
+            skip_field(in, tag);
+            break;
         }
     }
 }
@@ -240,10 +353,19 @@ void write_to(WriteTarget out, const ReplayData& replay) {
     tag_message(out, SCENARIO, replay.scenario);
     tag_varint(out, CHAPTER, replay.chapter_id);
     tag_varint(out, GLOBAL_SEED, replay.global_seed);
+    if (replay.object_limit != kDefaultSpaceObjectLimit) {
+        tag_varint(out, OBJECT_LIMIT, replay.object_limit);
+    }
     tag_varint(out, DURATION, replay.duration);
     for (const ReplayData::Action& action: replay.actions) {
         tag_message(out, ACTION, action);
     }
+    for (const ReplayData::Snapshot& snapshot: replay.snapshots) {
+        tag_message(out, SNAPSHOT, snapshot);
+    }
+    for (const ReplayData::Sync& sync: replay.syncs) {
+        tag_message(out, SYNC, sync);
+    }
 }
 
 void write_to(WriteTarget out, const ReplayData::Scenario& scenario) {
@@ -261,6 +383,503 @@ void write_to(WriteTarget out, const ReplayData::Action& action) {
     }
 }
 
+void write_to(WriteTarget out, const ReplayData::Snapshot& snapshot) {
+    tag_varint(out, SNAPSHOT_AT, snapshot.at);
+    write_varint(out, SNAPSHOT_DATA);
+    write_varint(out, snapshot.data.size());
+    write(out, snapshot.data);
+}
+
+void write_to(WriteTarget out, const ReplayData::Sync& sync) {
+    tag_varint(out, SYNC_AT, sync.at);
+    write_varint(out, SYNC_DATA);
+    write_varint(out, sync.data.size());
+    write(out, sync.data);
+}
+
+// The v2 container: the magic number; a header of tagged SCENARIO, CHAPTER, GLOBAL_SEED and
+// OBJECT_LIMIT fields, preceded by its size; the chunks; and, once the replay is finished, the
+// index.
+//
+// A chunk is a fixed-size header (kind, first and last decide cycle, row count, raw size,
+// whether it is compressed, and stored size) followed by the stored bytes.  The index is a count
+// and the file offset of each chunk, then a trailer: the offset of the index, the duration, and
+// kIndexMagic.
+static const uint8_t kReplayMagic[8] = {'N', 'L', 'R', 'P', 'v', '2', '\r', '\n'};
+static const uint8_t kIndexMagic[8] = {'N', 'L', 'R', 'P', 'i', 'd', 'x', '\n'};
+static const size_t kChunkHeaderSize = 30;
+static const size_t kTrailerSize = 24;
+
+// Deflate never inflates by more than about 1032 to 1.
+static const uint32_t kMaxDeflateRatio = 1032;
+
+// Sync digests are recorded at most once per decide cycle, so a sync chunk holds at least a minute
+// of play.  Actions are only recorded in cycles where a key changes, and are much smaller.
+static const size_t kActionsPerChunk = 1024;
+static const size_t kSyncsPerChunk = 1200;
+
+static bool compress_chunk(const Bytes& raw, Bytes* stored) {
+    uLongf size = compressBound(raw.size());
+    Bytes compressed(size, '\0');
+    if ((compress2(compressed.data(), &size, raw.data(), raw.size(), Z_DEFAULT_COMPRESSION)
+                != Z_OK)
+            || (size >= raw.size())) {
+        return false;
+    }
+    stored->assign(BytesSlice(compressed.data(), size));
+    return true;
+}
+
+// Splits the raw contents of a chunk into `count` columns, each preceded by its size.
+static void read_columns(BytesSlice raw, BytesSlice* columns, size_t count) {
+    uint32_t sizes[3];
+    for (size_t i = 0; i < count; ++i) {
+        read(raw, sizes[i]);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (raw.size() < sizes[i]) {
+            throw Exception("invalid replay chunk");
+        }
+        columns[i] = raw.slice(0, sizes[i]);
+        raw.shift(sizes[i]);
+    }
+}
+
+static void write_columns(WriteTarget out, const Bytes* columns, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        write<uint32_t>(out, columns[i].size());
+    }
+    for (size_t i = 0; i < count; ++i) {
+        write(out, columns[i]);
+    }
+}
+
+// Reads the header of the chunk at the start of `in`, and advances past the chunk.  Returns
+// false if `in` is too short to hold it, as the last chunk of an unfinished file may be.
+static bool read_chunk(BytesSlice& in, ReplayFile::Chunk* chunk) {
+    if (in.size() < kChunkHeaderSize) {
+        return false;
+    }
+    BytesSlice header = in.slice(0, kChunkHeaderSize);
+    chunk->kind = static_cast<ReplayFile::ChunkKind>(read<uint8_t>(header));
+    read(header, chunk->first_at);
+    read(header, chunk->last_at);
+    read(header, chunk->count);
+    read(header, chunk->raw_size);
+    chunk->compressed = read<uint8_t>(header);
+    const uint32_t stored_size = read<uint32_t>(header);
+    if ((in.size() - kChunkHeaderSize) < stored_size) {
+        return false;
+    }
+    chunk->stored = in.slice(kChunkHeaderSize, stored_size);
+    in.shift(kChunkHeaderSize + stored_size);
+    return true;
+}
+
+bool ReplayFile::is_replay_file(BytesSlice data) {
+    return (data.size() >= sizeof(kReplayMagic))
+        && (data.slice(0, sizeof(kReplayMagic)) == BytesSlice(kReplayMagic, sizeof(kReplayMagic)));
+}
+
+ReplayFile::ReplayFile(BytesSlice data):
+        _chapter_id(0),
+        _global_seed(0),
+        _object_limit(kDefaultSpaceObjectLimit),
+        _duration(0) {
+    if (!is_replay_file(data)) {
+        throw Exception("not a replay file");
+    }
+    BytesSlice in = data;
+    in.shift(sizeof(kReplayMagic));
+    const uint32_t header_size = read<uint32_t>(in);
+    if (in.size() < header_size) {
+        throw Exception("invalid replay header");
+    }
+    BytesSlice header = in.slice(0, header_size);
+    in.shift(header_size);
+    while (!header.empty()) {
+        const uint64_t tag = read_varint<uint64_t>(header);
+        switch (tag) {
+          case SCENARIO:
+            _scenario = read_message<ReplayData::Scenario>(header);
+            break;
+          case CHAPTER:
+            _chapter_id = read_varint<int32_t>(header);
+            break;
+          case GLOBAL_SEED:
+            _global_seed = read_varint<int32_t>(header);
+            break;
+          case OBJECT_LIMIT:
+            _object_limit = read_varint<int32_t>(header);
+            break;
+          default:
+            skip_field(header, tag);
+            break;
+        }
+    }
+
+    const size_t chunks_start = data.size() - in.size();
+    BytesSlice trailer;
+    if (in.size() >= kTrailerSize) {
+        trailer = data.slice(data.size() - kTrailerSize);
+    }
+    if (!trailer.empty()
+            && (trailer.slice(16) == BytesSlice(kIndexMagic, sizeof(kIndexMagic)))) {
+        const uint64_t index_offset = read<uint64_t>(trailer);
+        read(trailer, _duration);
+        if ((index_offset < chunks_start) || (index_offset > (data.size() - kTrailerSize))) {
+            throw Exception("invalid replay index");
+        }
+        BytesSlice index = data.slice(index_offset);
+        _chunks.resize(read<uint32_t>(index));
+        for (Chunk& chunk: _chunks) {
+            const uint64_t offset = read<uint64_t>(index);
+            if ((offset < chunks_start) || (offset >= index_offset)) {
+                throw Exception("invalid replay index");
+            }
+            BytesSlice chunk_data = data.slice(offset, index_offset - offset);
+            if (!read_chunk(chunk_data, &chunk)) {
+                throw Exception("invalid replay chunk");
+            }
+        }
+    } else {
+        // The game quit without finishing the replay.  Keep every chunk that was written whole,
+        // and play up to the last decide cycle in them.
+        Chunk chunk;
+        while (read_chunk(in, &chunk)) {
+            _chunks.push_back(chunk);
+            _duration = std::max(_duration, chunk.last_at);
+        }
+    }
+}
+
+void ReplayFile::decode(const Chunk& chunk, Bytes* raw) const {
+    if (!chunk.compressed) {
+        raw->assign(chunk.stored);
+        return;
+    }
+    // The size comes from the file, so check it is one that `stored` could inflate to before
+    // allocating that much.
+    if (chunk.raw_size > (uint64_t(kMaxDeflateRatio) * chunk.stored.size())) {
+        throw Exception("invalid replay chunk");
+    }
+    raw->resize(chunk.raw_size);
+    uLongf size = chunk.raw_size;
+    if ((uncompress(raw->data(), &size, chunk.stored.data(), chunk.stored.size()) != Z_OK)
+            || (size != chunk.raw_size)) {
+        throw Exception("invalid replay chunk");
+    }
+}
+
+void ReplayFile::read_all(ReplayData* replay) const {
+    replay->scenario = _scenario;
+    replay->chapter_id = _chapter_id;
+    replay->global_seed = _global_seed;
+    replay->object_limit = _object_limit;
+    replay->duration = _duration;
+    replay->actions.clear();
+    replay->snapshots.clear();
+    replay->syncs.clear();
+
+    ActionCursor cursor(*this);
+    ActionRow row;
+    while (cursor.next(&row)) {
+        for (uint8_t event: row.events) {
+            if (event_is_up(event)) {
+                replay->key_up(row.at, event_key(event));
+            } else {
+                replay->key_down(row.at, event_key(event));
+            }
+        }
+    }
+
+    SyncCursor syncs(*this);
+    SyncRow sync;
+    while (syncs.next(&sync)) {
+        replay->syncs.emplace_back();
+        replay->syncs.back().at = sync.at;
+        replay->syncs.back().data.assign(sync.data);
+    }
+
+    Bytes raw;
+    for (const Chunk& chunk: _chunks) {
+        if (chunk.kind == SNAPSHOT_CHUNK) {
+            decode(chunk, &raw);
+            replay->snapshots.emplace_back();
+            replay->snapshots.back().at = chunk.first_at;
+            replay->snapshots.back().data.assign(raw);
+        }
+    }
+}
+
+size_t ReplayFile::seek_chunk(ChunkKind kind, uint64_t at) const {
+    // Chunks of each kind are written in order, so nothing before this one can hold anything at
+    // or after `at`.
+    size_t result = 0;
+    for (size_t i = 0; i < _chunks.size(); ++i) {
+        if ((_chunks[i].kind == kind) && (_chunks[i].first_at <= at)) {
+            result = i;
+        }
+    }
+    return result;
+}
+
+ReplayFile::ActionCursor::ActionCursor(const ReplayFile& file):
+        _file(file),
+        _chunk(0),
+        _at(0),
+        _remaining(0) { }
+
+void ReplayFile::ActionCursor::seek(uint64_t at) {
+    _remaining = 0;
+    if (!load(_file.seek_chunk(ACTION_CHUNK, at))) {
+        return;
+    }
+    while (_remaining > 0) {
+        BytesSlice at_column = _at_column;
+        if ((_at + read_varint<uint64_t>(at_column)) >= at) {
+            break;
+        }
+        ActionRow row;
+        next(&row);
+    }
+}
+
+bool ReplayFile::ActionCursor::next(ActionRow* row) {
+    while (_remaining == 0) {
+        if (!load(_chunk)) {
+            return false;
+        }
+    }
+    _at += read_varint<uint64_t>(_at_column);
+    const size_t count = read_varint<size_t>(_count_column);
+    if (_event_column.size() < count) {
+        throw Exception("invalid replay chunk");
+    }
+    row->at = _at;
+    row->events = _event_column.slice(0, count);
+    _event_column.shift(count);
+    --_remaining;
+    return true;
+}
+
+// Loads the first action chunk at or after chunk number `chunk`.
+bool ReplayFile::ActionCursor::load(size_t chunk) {
+    const std::vector<Chunk>& chunks = _file._chunks;
+    while ((chunk < chunks.size()) && (chunks[chunk].kind != ACTION_CHUNK)) {
+        ++chunk;
+    }
+    if (chunk >= chunks.size()) {
+        _chunk = chunks.size();
+        return false;
+    }
+    _file.decode(chunks[chunk], &_raw);
+    BytesSlice columns[3];
+    read_columns(_raw, columns, 3);
+    _at_column = columns[0];
+    _count_column = columns[1];
+    _event_column = columns[2];
+    _at = chunks[chunk].first_at;
+    _remaining = chunks[chunk].count;
+    _chunk = chunk + 1;
+    return true;
+}
+
+ReplayFile::SyncCursor::SyncCursor(const ReplayFile& file):
+        _file(file),
+        _chunk(0),
+        _at(0),
+        _remaining(0) { }
+
+void ReplayFile::SyncCursor::seek(uint64_t at) {
+    _remaining = 0;
+    if (!load(_file.seek_chunk(SYNC_CHUNK, at))) {
+        return;
+    }
+    while (_remaining > 0) {
+        BytesSlice at_column = _at_column;
+        if ((_at + read_varint<uint64_t>(at_column)) >= at) {
+            break;
+        }
+        SyncRow row;
+        next(&row);
+    }
+}
+
+bool ReplayFile::SyncCursor::next(SyncRow* row) {
+    while (_remaining == 0) {
+        if (!load(_chunk)) {
+            return false;
+        }
+    }
+    _at += read_varint<uint64_t>(_at_column);
+    const size_t size = read_varint<size_t>(_size_column);
+    if (_data_column.size() < size) {
+        throw Exception("invalid replay chunk");
+    }
+    row->at = _at;
+    row->data = _data_column.slice(0, size);
+    _data_column.shift(size);
+    --_remaining;
+    return true;
+}
+
+// Loads the first sync chunk at or after chunk number `chunk`.
+bool ReplayFile::SyncCursor::load(size_t chunk) {
+    const std::vector<Chunk>& chunks = _file._chunks;
+    while ((chunk < chunks.size()) && (chunks[chunk].kind != SYNC_CHUNK)) {
+        ++chunk;
+    }
+    if (chunk >= chunks.size()) {
+        _chunk = chunks.size();
+        return false;
+    }
+    _file.decode(chunks[chunk], &_raw);
+    BytesSlice columns[3];
+    read_columns(_raw, columns, 3);
+    _at_column = columns[0];
+    _size_column = columns[1];
+    _data_column = columns[2];
+    _at = chunks[chunk].first_at;
+    _remaining = chunks[chunk].count;
+    _chunk = chunk + 1;
+    return true;
+}
+
+ReplayWriter::ReplayWriter(
+        int fd, const ReplayData::Scenario& scenario, int32_t chapter_id, int32_t global_seed,
+        int32_t object_limit):
+        _file(fd),
+        _offset(0) {
+    Bytes header;
+    tag_message(header, SCENARIO, scenario);
+    tag_varint(header, CHAPTER, chapter_id);
+    tag_varint(header, GLOBAL_SEED, global_seed);
+    if (object_limit != kDefaultSpaceObjectLimit) {
+        tag_varint(header, OBJECT_LIMIT, object_limit);
+    }
+
+    Bytes out;
+    out.push(BytesSlice(kReplayMagic, sizeof(kReplayMagic)));
+    write<uint32_t>(out, header.size());
+    write(out, header);
+    write(_file, out);
+    _offset += out.size();
+}
+
+void ReplayWriter::add_key_event(uint64_t at, uint8_t event) {
+    if (_action_at.empty() || (_action_at.back() != at)) {
+        if (_action_at.size() >= kActionsPerChunk) {
+            flush_actions();
+        }
+        _action_at.push_back(at);
+        _action_count.push_back(0);
+    }
+    ++_action_count.back();
+    _action_events.push(1, event);
+}
+
+void ReplayWriter::key_down(uint64_t at, uint8_t key) {
+    add_key_event(at, ReplayFile::key_event(key, false));
+}
+
+void ReplayWriter::key_up(uint64_t at, uint8_t key) {
+    add_key_event(at, ReplayFile::key_event(key, true));
+}
+
+void ReplayWriter::add_sync(uint64_t at, BytesSlice data) {
+    if (_sync_at.size() >= kSyncsPerChunk) {
+        flush_syncs();
+    }
+    _sync_at.push_back(at);
+    _sync_size.push_back(data.size());
+    _sync_data.push(data);
+}
+
+void ReplayWriter::add_snapshot(uint64_t at, BytesSlice data) {
+    write_chunk(ReplayFile::SNAPSHOT_CHUNK, at, at, 1, Bytes(data));
+}
+
+void ReplayWriter::finish(uint64_t duration) {
+    flush_actions();
+    flush_syncs();
+
+    Bytes index;
+    write<uint32_t>(index, _index.size());
+    for (uint64_t offset: _index) {
+        write(index, offset);
+    }
+    write(index, _offset);
+    write(index, duration);
+    index.push(BytesSlice(kIndexMagic, sizeof(kIndexMagic)));
+    write(_file, index);
+    _offset += index.size();
+}
+
+void ReplayWriter::flush_actions() {
+    if (_action_at.empty()) {
+        return;
+    }
+    Bytes columns[3];
+    uint64_t at = _action_at.front();
+    for (size_t i = 0; i < _action_at.size(); ++i) {
+        write_varint(columns[0], _action_at[i] - at);
+        write_varint(columns[1], _action_count[i]);
+        at = _action_at[i];
+    }
+    columns[2].assign(_action_events);
+    Bytes raw;
+    write_columns(raw, columns, 3);
+    write_chunk(
+            ReplayFile::ACTION_CHUNK, _action_at.front(), _action_at.back(), _action_at.size(),
+            raw);
+    _action_at.clear();
+    _action_count.clear();
+    _action_events.clear();
+}
+
+void ReplayWriter::flush_syncs() {
+    if (_sync_at.empty()) {
+        return;
+    }
+    Bytes columns[3];
+    uint64_t at = _sync_at.front();
+    for (size_t i = 0; i < _sync_at.size(); ++i) {
+        write_varint(columns[0], _sync_at[i] - at);
+        write_varint(columns[1], _sync_size[i]);
+        at = _sync_at[i];
+    }
+    columns[2].assign(_sync_data);
+    Bytes raw;
+    write_columns(raw, columns, 3);
+    write_chunk(ReplayFile::SYNC_CHUNK, _sync_at.front(), _sync_at.back(), _sync_at.size(), raw);
+    _sync_at.clear();
+    _sync_size.clear();
+    _sync_data.clear();
+}
+
+void ReplayWriter::write_chunk(
+        ReplayFile::ChunkKind kind, uint64_t first_at, uint64_t last_at, uint32_t count,
+        const Bytes& raw) {
+    Bytes compressed;
+    const bool is_compressed = compress_chunk(raw, &compressed);
+    const Bytes& stored = is_compressed ? compressed : raw;
+
+    Bytes header;
+    write<uint8_t>(header, kind);
+    write(header, first_at);
+    write(header, last_at);
+    write(header, count);
+    write<uint32_t>(header, raw.size());
+    write<uint8_t>(header, is_compressed);
+    write<uint32_t>(header, stored.size());
+    write(_file, header);
+    write(_file, stored);
+
+    _index.push_back(_offset);
+    _offset += header.size() + stored.size();
+}
+
 ReplayBuilder::ReplayBuilder() { }
 
 namespace {
@@ -302,15 +921,17 @@ static void cull_replays(size_t count) {
 
 void ReplayBuilder::init(
         StringSlice scenario_identifier, StringSlice scenario_version,
-        int32_t chapter_id, int32_t global_seed) {
+        int32_t chapter_id, int32_t global_seed, int32_t object_limit) {
     _scenario.identifier.assign(scenario_identifier);
     _scenario.version.assign(scenario_version);
     _chapter_id = chapter_id;
     _global_seed = global_seed;
+    _object_limit = object_limit;
 }
 
 void ReplayBuilder::start() {
     _at = 1;
+    _sync_interval = Preferences::preferences()->sync_interval();
     cull_replays(10);
     time_t t;
     struct tm tm;
@@ -323,37 +944,29 @@ void ReplayBuilder::start() {
     sfz::String path(format("{0}/Replay {1}.nlrp", dirs().replays, utf8::decode(buffer)));
     int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
     if (fd >= 0) {
-        _file.reset(new ScopedFd(fd));
-        tag_message(*_file, SCENARIO, _scenario);
-        tag_varint(*_file, CHAPTER, _chapter_id);
-        tag_varint(*_file, GLOBAL_SEED, _global_seed);
+        _writer.reset(new ReplayWriter(
+                    fd, _scenario, _chapter_id, _global_seed, _object_limit));
     }
 }
 
 void ReplayBuilder::key_down(const KeyDownEvent& event) {
-    if (!_file) {
+    if (!_writer) {
         return;
     }
     for (auto i: range<int>(KEY_COUNT)) {
         if (event.key() == Preferences::preferences()->key(i) - 1) {
-            ReplayData::Action action = {};
-            action.at = _at;
-            action.keys_down.push_back(i);
-            tag_message(*_file, ACTION, action);
+            _writer->key_down(_at, i);
         }
     }
 }
 
 void ReplayBuilder::key_up(const KeyUpEvent& event) {
-    if (!_file) {
+    if (!_writer) {
         return;
     }
     for (auto i: range<int>(KEY_COUNT)) {
         if (event.key() == Preferences::preferences()->key(i) - 1) {
-            ReplayData::Action action = {};
-            action.at = _at;
-            action.keys_up.push_back(i);
-            tag_message(*_file, ACTION, action);
+            _writer->key_up(_at, i);
             break;
         }
     }
@@ -363,11 +976,34 @@ void ReplayBuilder::next() {
     ++_at;
 }
 
+bool ReplayBuilder::wants_snapshot() const {
+    return _writer && ((_at % kSnapshotInterval) == 0);
+}
+
+void ReplayBuilder::add_snapshot(BytesSlice data) {
+    if (!_writer) {
+        return;
+    }
+    _writer->add_snapshot(_at, data);
+}
+
+bool ReplayBuilder::wants_sync() const {
+    return _writer && ((_at % _sync_interval) == 0);
+}
+
+void ReplayBuilder::add_sync(BytesSlice data) {
+    if (!_writer) {
+        return;
+    }
+    _writer->add_sync(_at, data);
+}
+
 void ReplayBuilder::finish() {
-    if (!_file) {
+    if (!_writer) {
         return;
     }
-    tag_varint(*_file, DURATION, _at);
+    _writer->finish(_at);
+    _writer.reset();
 }
 
 }  // namespace antares
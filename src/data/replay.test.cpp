@@ -0,0 +1,242 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "data/replay.hpp"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+#include <gmock/gmock.h>
+
+#include "data/space-object.hpp"
+
+using sfz::Bytes;
+using sfz::BytesSlice;
+using sfz::MappedFile;
+using sfz::write;
+using std::vector;
+
+namespace utf8 = sfz::utf8;
+
+namespace antares {
+namespace {
+
+typedef testing::Test ReplayFileTest;
+
+const uint8_t kSync[] = {'s', 'y', 'n', 'c'};
+const uint8_t kSnapshot[] = {'s', 'n', 'a', 'p'};
+
+struct Action {
+    uint64_t at;
+    vector<uint8_t> events;
+};
+
+// Three chunks' worth of actions, one every other cycle.  Some cycles press and release the same
+// key, or press it again, so that the order of events within a cycle matters.
+vector<Action> make_actions() {
+    vector<Action> actions;
+    for (int i = 0; i < 3000; ++i) {
+        Action action = {uint64_t(1 + (2 * i)), {}};
+        const uint8_t key = i % 44;
+        switch (i % 3) {
+          case 0:
+            action.events = {
+                ReplayFile::key_event(key, false), ReplayFile::key_event(key, true),
+                ReplayFile::key_event(key, false),
+            };
+            break;
+          case 1:
+            action.events = {
+                ReplayFile::key_event(key, true), ReplayFile::key_event((key + 1) % 44, false),
+            };
+            break;
+          case 2:
+            action.events = {ReplayFile::key_event(key, false)};
+            break;
+        }
+        actions.push_back(action);
+    }
+    return actions;
+}
+
+// Writes `actions` through ReplayWriter, with sync digests and snapshots between them, as the
+// game would.
+Bytes write_replay(
+        const vector<Action>& actions, int32_t object_limit = kDefaultSpaceObjectLimit) {
+    char path[] = "/tmp/replay-test-XXXXXX";
+    const int fd = mkstemp(path);
+    EXPECT_GE(fd, 0);
+    {
+        ReplayData::Scenario scenario;
+        scenario.identifier.assign("com.example.test");
+        scenario.version.assign("1.0");
+        ReplayWriter writer(fd, scenario, 1, 0, object_limit);
+        for (const Action& action: actions) {
+            for (uint8_t event: action.events) {
+                if (ReplayFile::event_is_up(event)) {
+                    writer.key_up(action.at, ReplayFile::event_key(event));
+                } else {
+                    writer.key_down(action.at, ReplayFile::event_key(event));
+                }
+            }
+            writer.add_sync(action.at, BytesSlice(kSync, sizeof(kSync)));
+            if ((action.at % 1200) == 1) {
+                writer.add_snapshot(action.at, BytesSlice(kSnapshot, sizeof(kSnapshot)));
+            }
+        }
+        writer.finish(actions.back().at + 1);
+    }
+    Bytes data;
+    {
+        MappedFile file(utf8::decode(path));
+        data.assign(file.data());
+    }
+    unlink(path);
+    return data;
+}
+
+vector<uint8_t> events_of(const ReplayFile::ActionRow& row) {
+    return vector<uint8_t>(row.events.begin(), row.events.end());
+}
+
+TEST_F(ReplayFileTest, RoundTrip) {
+    const vector<Action> actions = make_actions();
+    const Bytes data = write_replay(actions);
+    ReplayFile file(data);
+    EXPECT_EQ(actions.back().at + 1, file.duration());
+
+    ReplayFile::ActionCursor cursor(file);
+    ReplayFile::ActionRow row;
+    for (const Action& action: actions) {
+        ASSERT_TRUE(cursor.next(&row));
+        EXPECT_EQ(action.at, row.at);
+        EXPECT_EQ(action.events, events_of(row));
+    }
+    EXPECT_FALSE(cursor.next(&row));
+}
+
+// Seeking lands on the first action at or after the given cycle, whether that is in the first
+// chunk, at the start of a later one, or between actions.
+TEST_F(ReplayFileTest, Seek) {
+    const vector<Action> actions = make_actions();
+    const Bytes data = write_replay(actions);
+    ReplayFile file(data);
+
+    for (size_t i: {0, 1, 500, 1023, 1024, 1025, 2047, 2048, 2999}) {
+        for (uint64_t at: {actions[i].at - 1, actions[i].at}) {
+            ReplayFile::ActionCursor cursor(file);
+            ReplayFile::ActionRow row;
+            cursor.seek(at);
+            ASSERT_TRUE(cursor.next(&row)) << at;
+            EXPECT_EQ(actions[i].at, row.at) << at;
+            EXPECT_EQ(actions[i].events, events_of(row)) << at;
+        }
+    }
+
+    ReplayFile::ActionCursor cursor(file);
+    ReplayFile::ActionRow row;
+    cursor.seek(actions.back().at + 1);
+    EXPECT_FALSE(cursor.next(&row));
+}
+
+// ReplayData plays an action's keys down before its keys up, so an action is split wherever a
+// key goes down after one went up.
+TEST_F(ReplayFileTest, ReadAllKeepsOrder) {
+    const vector<Action> actions = make_actions();
+    const Bytes data = write_replay(actions);
+    ReplayFile file(data);
+    ReplayData replay;
+    file.read_all(&replay);
+
+    vector<Action> read;
+    for (const ReplayData::Action& action: replay.actions) {
+        if (read.empty() || (read.back().at != action.at)) {
+            read.push_back(Action{action.at, {}});
+        }
+        for (uint8_t key: action.keys_down) {
+            read.back().events.push_back(ReplayFile::key_event(key, false));
+        }
+        for (uint8_t key: action.keys_up) {
+            read.back().events.push_back(ReplayFile::key_event(key, true));
+        }
+    }
+    ASSERT_EQ(actions.size(), read.size());
+    for (size_t i = 0; i < actions.size(); ++i) {
+        EXPECT_EQ(actions[i].at, read[i].at);
+        EXPECT_EQ(actions[i].events, read[i].events);
+    }
+}
+
+// Replays record the object limit only if it was raised; older ones, which never recorded it,
+// were all played with the default.
+TEST_F(ReplayFileTest, ObjectLimit) {
+    const vector<Action> actions = make_actions();
+    EXPECT_EQ(kDefaultSpaceObjectLimit, ReplayFile(write_replay(actions)).object_limit());
+
+    const Bytes data = write_replay(actions, 1000);
+    ReplayFile file(data);
+    EXPECT_EQ(1000, file.object_limit());
+    ReplayData replay;
+    file.read_all(&replay);
+    EXPECT_EQ(1000, replay.object_limit);
+
+    Bytes v1;
+    write(v1, replay);
+    EXPECT_EQ(1000, ReplayData(v1).object_limit);
+    replay.object_limit = kDefaultSpaceObjectLimit;
+    v1.clear();
+    write(v1, replay);
+    EXPECT_EQ(kDefaultSpaceObjectLimit, ReplayData(v1).object_limit);
+}
+
+// Fields from a later version are skipped, whatever their wire type.
+TEST_F(ReplayFileTest, SkipsUnknownFields) {
+    const uint8_t unknown[] = {
+        (0x0c << 3) | 0, 0x96, 0x01,
+        (0x0d << 3) | 1, 1, 2, 3, 4, 5, 6, 7, 8,
+        (0x0e << 3) | 2, 3, 'a', 'b', 'c',
+        (0x0f << 3) | 5, 1, 2, 3, 4,
+    };
+    ReplayData replay;
+    replay.scenario.identifier.assign("com.example.test");
+    replay.chapter_id = 3;
+    replay.global_seed = 5;
+    replay.duration = 7;
+    Bytes data;
+    data.push(BytesSlice(unknown, sizeof(unknown)));
+    write(data, replay);
+
+    ReplayData parsed(data);
+    EXPECT_EQ(3, parsed.chapter_id);
+    EXPECT_EQ(5, parsed.global_seed);
+    EXPECT_EQ(7u, parsed.duration);
+}
+
+// A compressed chunk can't claim to inflate to more than deflate could produce.
+TEST_F(ReplayFileTest, RawSizeIsBounded) {
+    const Bytes data = write_replay(make_actions());
+    ReplayFile file(data);
+    ReplayFile::Chunk chunk = file.chunks()[0];
+    ASSERT_TRUE(chunk.compressed);
+    chunk.raw_size = 0xffffffff;
+    Bytes raw;
+    EXPECT_THROW(file.decode(chunk, &raw), sfz::Exception);
+}
+
+}  // namespace
+}  // namespace antares
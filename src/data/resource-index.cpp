@@ -0,0 +1,211 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "data/resource-index.hpp"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <sfz/sfz.hpp>
+
+#include "config/preferences.hpp"
+
+using sfz::CString;
+using sfz::Exception;
+using sfz::MappedFile;
+using sfz::String;
+using sfz::StringSlice;
+using sfz::format;
+using sfz::quote;
+using std::lock_guard;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+using std::weak_ptr;
+
+namespace utf8 = sfz::utf8;
+
+namespace antares {
+
+ResourceIndex::ResourceIndex(vector<String> (*search_dirs)()):
+        _search_dirs(search_dirs),
+        _scanned(false),
+        _stats() { }
+
+ResourceIndex::~ResourceIndex() { }
+
+shared_ptr<MappedFile> ResourceIndex::load_first(
+        const vector<String>& resource_paths, size_t* which) {
+    lock_guard<mutex> lock(_mutex);
+    if (!_scanned || (_scenario != Preferences::preferences()->scenario_identifier())) {
+        scan();
+    }
+
+    vector<string> paths;
+    for (const String& resource_path: resource_paths) {
+        paths.emplace_back(CString(resource_path).data());
+    }
+    const string path = find_first(paths, which);
+    if (path.empty()) {
+        throw Exception(format("couldn't find resource {0}", quote(resource_paths.front())));
+    }
+    return map(path);
+}
+
+bool ResourceIndex::stamp(const StringSlice& resource_path, ResourceStamp* stamp) {
+    lock_guard<mutex> lock(_mutex);
+    if (!_scanned || (_scenario != Preferences::preferences()->scenario_identifier())) {
+        scan();
+    }
+
+    size_t which;
+    const string path = find_first(vector<string>(1, CString(resource_path).data()), &which);
+    if (path.empty()) {
+        return false;
+    }
+    struct stat st;
+    ++_stats.stats;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    stamp->size = st.st_size;
+    stamp->mtime = st.st_mtime;
+    return true;
+}
+
+void ResourceIndex::rescan() {
+    lock_guard<mutex> lock(_mutex);
+    _scanned = false;
+}
+
+ResourceStats ResourceIndex::stats() {
+    lock_guard<mutex> lock(_mutex);
+    return _stats;
+}
+
+// Returns the full path of the first of `paths` found, and sets `*which` to its index, or
+// returns an empty string if none is.
+string ResourceIndex::find_first(const vector<string>& paths, size_t* which) {
+    size_t best_dir = _dirs.size();
+    for (size_t i = 0; i < paths.size(); ++i) {
+        auto it = _manifest.find(paths[i]);
+        if ((it != _manifest.end()) && (it->second < best_dir)) {
+            best_dir = it->second;
+            *which = i;
+        }
+    }
+    if (best_dir < _dirs.size()) {
+        return _dirs[best_dir] + "/" + paths[*which];
+    }
+
+    // The walk only finds files by the plain paths it builds, and not files behind symbolic
+    // links to directories, so look for the file directly before giving up.
+    for (const string& dir: _dirs) {
+        for (size_t i = 0; i < paths.size(); ++i) {
+            string path = dir + "/" + paths[i];
+            struct stat st;
+            ++_stats.stats;
+            if ((stat(path.c_str(), &st) == 0) && S_ISREG(st.st_mode)) {
+                *which = i;
+                return path;
+            }
+        }
+    }
+    return "";
+}
+
+void ResourceIndex::scan() {
+    _scenario.assign(Preferences::preferences()->scenario_identifier());
+    _dirs.clear();
+    _manifest.clear();
+    _mappings.clear();
+    for (const String& dir: _search_dirs()) {
+        _dirs.emplace_back(CString(dir).data());
+    }
+    for (size_t i = 0; i < _dirs.size(); ++i) {
+        // Walking in order, the first directory to have a file claims it.
+        if (std::find(_dirs.begin(), _dirs.begin() + i, _dirs[i]) == (_dirs.begin() + i)) {
+            walk(i, _dirs[i], "");
+        }
+    }
+    _scanned = true;
+    ++_stats.scans;
+}
+
+void ResourceIndex::walk(size_t dir, const string& path, const string& prefix) {
+    ++_stats.dir_reads;
+    DIR* d = opendir(path.c_str());
+    if (!d) {
+        return;
+    }
+    while (dirent* entry = readdir(d)) {
+        const string name(entry->d_name);
+        if ((name == ".") || (name == "..")) {
+            continue;
+        }
+        const string child = path + "/" + name;
+        const string resource_path = prefix.empty() ? name : (prefix + "/" + name);
+        bool is_dir = (entry->d_type == DT_DIR);
+        bool is_file = (entry->d_type == DT_REG);
+        if (!is_dir && !is_file) {
+            // Follows symbolic links to files, but not to directories, which might loop.
+            struct stat st;
+            ++_stats.stats;
+            if (stat(child.c_str(), &st) != 0) {
+                continue;
+            }
+            is_file = S_ISREG(st.st_mode);
+            is_dir = (entry->d_type == DT_UNKNOWN) && S_ISDIR(st.st_mode);
+        }
+        if (is_dir) {
+            walk(dir, child, resource_path);
+        } else if (is_file) {
+            _manifest.emplace(resource_path, dir);
+        }
+    }
+    closedir(d);
+}
+
+// Live mappings are shared; a file is unmapped once the last Resource using it is gone.  Entries
+// for files that have been unmapped are dropped whenever a file is mapped, so that they don't
+// pile up over a long session.
+shared_ptr<MappedFile> ResourceIndex::map(const string& path) {
+    auto it = _mappings.find(path);
+    if (it != _mappings.end()) {
+        shared_ptr<MappedFile> file = it->second.lock();
+        if (file) {
+            ++_stats.hits;
+            return file;
+        }
+    }
+    ++_stats.misses;
+    for (it = _mappings.begin(); it != _mappings.end(); ) {
+        if (it->second.expired()) {
+            it = _mappings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    shared_ptr<MappedFile> file = std::make_shared<MappedFile>(
+            String(utf8::decode(path.c_str())));
+    _mappings[path] = file;
+    return file;
+}
+
+}  // namespace antares
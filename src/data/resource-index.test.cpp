@@ -0,0 +1,177 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "data/resource-index.hpp"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <gmock/gmock.h>
+
+#include "config/preferences.hpp"
+
+using sfz::CString;
+using sfz::Exception;
+using sfz::MappedFile;
+using sfz::ScopedFd;
+using sfz::String;
+using sfz::StringSlice;
+using sfz::format;
+using sfz::makedirs;
+using std::shared_ptr;
+using std::vector;
+
+namespace path = sfz::path;
+namespace utf8 = sfz::utf8;
+
+namespace antares {
+namespace {
+
+String root;
+
+// A scenario, the factory scenario, and the application, as the game searches them.
+vector<String> test_dirs() {
+    vector<String> dirs;
+    dirs.emplace_back(format("{0}/scenario", root));
+    dirs.emplace_back(format("{0}/factory", root));
+    dirs.emplace_back(format("{0}/application", root));
+    return dirs;
+}
+
+void write_file(StringSlice dir, StringSlice path, StringSlice content) {
+    const String full_path(format("{0}/{1}/{2}", root, dir, path));
+    makedirs(path::dirname(full_path), 0755);
+    ScopedFd fd(open(full_path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    write(fd, utf8::encode(content));
+}
+
+String content(const shared_ptr<MappedFile>& file) {
+    return String(utf8::decode(file->data()));
+}
+
+vector<String> paths(StringSlice first, StringSlice second) {
+    vector<String> result;
+    result.emplace_back(first);
+    result.emplace_back(second);
+    return result;
+}
+
+class ResourceIndexTest : public testing::Test {
+  public:
+    static void SetUpTestCase() {
+        prefs = new NullPrefsDriver;
+        char tmp[] = "/tmp/resource-index-test-XXXXXX";
+        root.assign(utf8::decode(mkdtemp(tmp)));
+
+        write_file("scenario", "sprites/1.json", "scenario");
+        write_file("factory", "sprites/1.json", "factory");
+        write_file("application", "sprites/1.json", "application");
+        write_file("factory", "sprites/2.json", "factory");
+        write_file("application", "sprites/2.json", "application");
+        write_file("application", "sprites/3.json", "application");
+
+        // A preferred form in a later directory loses to another form in an earlier one.
+        write_file("scenario", "sprites/4.json", "scenario json");
+        write_file("factory", "sprites/4.pack", "factory pack");
+
+        // The walk doesn't follow symbolic links to directories.
+        write_file("elsewhere", "linked/5.json", "linked");
+        const String target(format("{0}/elsewhere/linked", root));
+        const String link(format("{0}/scenario/linked", root));
+        symlink(CString(target).data(), CString(link).data());
+    }
+
+    static void TearDownTestCase() {
+        rmtree(root);
+        delete prefs;
+    }
+
+  private:
+    static NullPrefsDriver* prefs;
+};
+
+NullPrefsDriver* ResourceIndexTest::prefs;
+
+TEST_F(ResourceIndexTest, Precedence) {
+    ResourceIndex index(test_dirs);
+    size_t which;
+    EXPECT_EQ("scenario", content(index.load_first(paths("sprites/1.json", "x"), &which)));
+    EXPECT_EQ(0u, which);
+    const int64_t walk_stats = index.stats().stats;
+
+    // Found in the manifest, without looking at the file system again.
+    EXPECT_EQ("factory", content(index.load_first(paths("sprites/2.json", "x"), &which)));
+    EXPECT_EQ("application", content(index.load_first(paths("sprites/3.json", "x"), &which)));
+    EXPECT_EQ(walk_stats, index.stats().stats);
+}
+
+TEST_F(ResourceIndexTest, DirectoryBeforeForm) {
+    ResourceIndex index(test_dirs);
+    size_t which;
+    EXPECT_EQ("scenario json",
+              content(index.load_first(paths("sprites/4.pack", "sprites/4.json"), &which)));
+    EXPECT_EQ(1u, which);
+}
+
+TEST_F(ResourceIndexTest, StatFallback) {
+    ResourceIndex index(test_dirs);
+    size_t which;
+    index.load_first(paths("sprites/1.json", "x"), &which);
+    const int64_t walk_stats = index.stats().stats;
+
+    EXPECT_EQ("linked", content(index.load_first(paths("x", "linked/5.json"), &which)));
+    EXPECT_EQ(1u, which);
+    const ResourceStats stats = index.stats();
+    EXPECT_EQ(1, stats.scans);
+    EXPECT_LT(walk_stats, stats.stats);
+
+    EXPECT_THROW(index.load_first(paths("x", "linked/6.json"), &which), Exception);
+    EXPECT_EQ(1, index.stats().scans);
+}
+
+// A file is mapped once while it is in use, and again after it has been let go.
+TEST_F(ResourceIndexTest, Mappings) {
+    ResourceIndex index(test_dirs);
+    size_t which;
+    {
+        shared_ptr<MappedFile> first = index.load_first(paths("sprites/1.json", "x"), &which);
+        shared_ptr<MappedFile> second = index.load_first(paths("sprites/1.json", "x"), &which);
+        EXPECT_EQ(first, second);
+    }
+    index.load_first(paths("sprites/1.json", "x"), &which);
+    const ResourceStats stats = index.stats();
+    EXPECT_EQ(1, stats.hits);
+    EXPECT_EQ(2, stats.misses);
+}
+
+// Stamps come from the file that would be mapped, which isn't.
+TEST_F(ResourceIndexTest, Stamp) {
+    ResourceIndex index(test_dirs);
+    ResourceStamp stamp;
+    ASSERT_TRUE(index.stamp("sprites/2.json", &stamp));
+    EXPECT_EQ(7, stamp.size);  // "factory"
+    ASSERT_TRUE(index.stamp("sprites/4.json", &stamp));
+    EXPECT_EQ(13, stamp.size);  // "scenario json"
+    ASSERT_TRUE(index.stamp("linked/5.json", &stamp));
+    EXPECT_EQ(6, stamp.size);  // "linked"
+    EXPECT_FALSE(index.stamp("sprites/6.json", &stamp));
+    EXPECT_EQ(0, index.stats().misses);
+}
+
+}  // namespace
+}  // namespace antares
@@ -19,21 +19,17 @@
 #include "data/resource.hpp"
 
 #include <stdio.h>
+#include <vector>
 #include <sfz/sfz.hpp>
 #include "config/dirs.hpp"
 #include "config/preferences.hpp"
+#include "data/resource-index.hpp"
 
 using sfz::BytesSlice;
-using sfz::Exception;
-using sfz::MappedFile;
-using sfz::PrintItem;
 using sfz::String;
 using sfz::StringSlice;
 using sfz::format;
-using std::unique_ptr;
-
-namespace path = sfz::path;
-namespace utf8 = sfz::utf8;
+using std::vector;
 
 namespace antares {
 
@@ -41,30 +37,36 @@ static const char kFactoryScenarioIdentifier[] = "com.biggerplanet.ares";
 
 const sfz::String application_path();
 
-static unique_ptr<MappedFile> load_first(sfz::StringSlice resource_path,
-                                         const std::initializer_list<PrintItem>& dirs) {
-    for (const auto& dir: dirs) {
-        String path(sfz::format("{0}/{1}", dir, resource_path));
-        if (path::isfile(path)) {
-            return unique_ptr<MappedFile>(new MappedFile(path));
-        }
-    }
-    throw Exception(format("couldn't find resource {0}", quote(resource_path)));
+// Resources are looked for in the current scenario, then the factory scenario, then the
+// application.
+static vector<String> search_dirs() {
+    vector<String> result;
+    result.emplace_back(format(
+                "{0}/{1}", dirs().scenarios, Preferences::preferences()->scenario_identifier()));
+    result.emplace_back(format("{0}/{1}", dirs().scenarios, kFactoryScenarioIdentifier));
+    result.emplace_back(application_path());
+    return result;
 }
 
-static unique_ptr<MappedFile> load(sfz::StringSlice resource_path) {
-    return load_first(resource_path, {
-        format("{0}/{1}", dirs().scenarios, Preferences::preferences()->scenario_identifier()),
-        format("{0}/{1}", dirs().scenarios, kFactoryScenarioIdentifier),
-        application_path(),
-    });
+namespace {
+
+ResourceIndex& resource_index() {
+    static ResourceIndex index(search_dirs);
+    return index;
 }
 
+}  // namespace
+
 Resource::Resource(const StringSlice& type, const StringSlice& extension, int id):
         Resource(format("{0}/{1}.{2}", type, id, extension)) { }
 
-Resource::Resource(const sfz::PrintItem& resource_path):
-        _file(load(String(resource_path))) { }
+Resource::Resource(const sfz::PrintItem& resource_path) {
+    size_t which;
+    _file = resource_index().load_first(vector<String>(1, String(resource_path)), &which);
+}
+
+Resource::Resource(const vector<String>& resource_paths, size_t* which):
+        _file(resource_index().load_first(resource_paths, which)) { }
 
 Resource::~Resource() { }
 
@@ -72,4 +74,16 @@ BytesSlice Resource::data() const {
     return _file->data();
 }
 
+ResourceStats resource_stats() {
+    return resource_index().stats();
+}
+
+bool resource_stamp(const sfz::PrintItem& resource_path, ResourceStamp* stamp) {
+    return resource_index().stamp(String(resource_path), stamp);
+}
+
+void rescan_resources() {
+    resource_index().rescan();
+}
+
 }  // namespace antares
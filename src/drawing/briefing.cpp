@@ -341,12 +341,13 @@ static void render_briefing_with(
         delete[] gBriefingSpriteBounds;
     }
 
-    gBriefingSpriteBounds = new briefingSpriteBoundsType[kMaxSpaceObject];
+    // One for each object, plus one for the terminator.
+    gBriefingSpriteBounds = new briefingSpriteBoundsType[CountObjectsOfBaseType(-1, -1) + 1];
 
     if ( gBriefingSpriteBounds == NULL) return;
     sBounds = gBriefingSpriteBounds;
 
-    for ( count = 0; count < kMaxSpaceObject; count++)
+    for ( count = NextSpaceObject(-1); count >= 0; count = NextSpaceObject(count))
     {
         spaceObjectType *anObject = mGetSpaceObjectPtr(count);
         if (( anObject->active == kObjectInUse) && ( anObject->sprite != NULL))
@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <sfz/sfz.hpp>
 
+#include "drawing/pix-spans.hpp"
 #include "lang/casts.hpp"
 
 using sfz::Exception;
@@ -49,13 +50,8 @@ void PixMap::set(int x, int y, const RgbColor& color) {
 }
 
 void PixMap::fill(const RgbColor& color) {
-    if (size().height > 0) {
-        for (int x = 0; x < size().width; ++x) {
-            set(x, 0, color);
-        }
-        for (int y = 1; y < size().height; ++y) {
-            memcpy(mutable_row(y), row(y - 1), size().width * sizeof(RgbColor));
-        }
+    for (int y = 0; y < size().height; ++y) {
+        fill_span(mutable_row(y), color, size().width);
     }
 }
 
@@ -73,21 +69,7 @@ void PixMap::composite(const PixMap& pix) {
         throw Exception("Mismatch in PixMap sizes");
     }
     for (int y = 0; y < size().height; ++y) {
-        for (int x = 0; x < size().width; ++x) {
-            const RgbColor& over = pix.get(x, y);
-            const double oa = over.alpha / 255.0;
-            const RgbColor& under = get(x, y);
-            const double ua = under.alpha / 255.0;
-
-            // TODO(sfiera): if we're going to do anything like this in the long run, we should
-            // require that alpha be pre-multiplied with the color components.  We should probably
-            // also use integral arithmetic.
-            double red   = (over.red   * oa) + ((under.red   * ua) * (1.0 - oa));
-            double green = (over.green * oa) + ((under.green * ua) * (1.0 - oa));
-            double blue  = (over.blue  * oa) + ((under.blue  * ua) * (1.0 - oa));
-            double alpha = oa + (ua * (1.0 - oa));
-            set(x, y, RgbColor(alpha * 255, red / alpha, green / alpha, blue / alpha));
-        }
+        composite_span(mutable_row(y), pix.row(y), size().width);
     }
 }
 
@@ -167,4 +149,24 @@ PixMap::View PixMap::view(const Rect& bounds) {
     return View(this, bounds);
 }
 
+ConstPixMap::ConstPixMap(Size size, const RgbColor* bytes):
+        _size(size),
+        _bytes(bytes) { }
+
+const Size& ConstPixMap::size() const {
+    return _size;
+}
+
+int ConstPixMap::row_bytes() const {
+    return _size.width;
+}
+
+const RgbColor* ConstPixMap::bytes() const {
+    return _bytes;
+}
+
+RgbColor* ConstPixMap::mutable_bytes() {
+    throw Exception("can't modify a ConstPixMap");
+}
+
 }  // namespace antares
@@ -0,0 +1,378 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "drawing/pix-spans.hpp"
+
+#include <string.h>
+#include <algorithm>
+
+#if defined(__i386__) || defined(__x86_64__)
+#define ANTARES_PIX_SPANS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace antares {
+
+static_assert(sizeof(RgbColor) == 4, "RgbColor must be packed ARGB");
+
+namespace {
+
+void fill_span_scalar(RgbColor* dst, const RgbColor& color, int32_t count) {
+    std::fill(dst, dst + count, color);
+}
+
+// The reference: exactly what PixMap::composite() has always done, in double precision.
+inline void composite_pixel(RgbColor* dst, const RgbColor& over) {
+    const double oa = over.alpha / 255.0;
+    const RgbColor& under = *dst;
+    const double ua = under.alpha / 255.0;
+
+    // TODO(sfiera): if we're going to do anything like this in the long run, we should
+    // require that alpha be pre-multiplied with the color components.  We should probably
+    // also use integral arithmetic.
+    double red   = (over.red   * oa) + ((under.red   * ua) * (1.0 - oa));
+    double green = (over.green * oa) + ((under.green * ua) * (1.0 - oa));
+    double blue  = (over.blue  * oa) + ((under.blue  * ua) * (1.0 - oa));
+    double alpha = oa + (ua * (1.0 - oa));
+    *dst = RgbColor(alpha * 255, red / alpha, green / alpha, blue / alpha);
+}
+
+void composite_span_scalar(RgbColor* dst, const RgbColor* src, int32_t count) {
+    for (int32_t i = 0; i < count; ++i) {
+        composite_pixel(dst + i, src[i]);
+    }
+}
+
+void tint_span_scalar(RgbColor* dst, const RgbColor* overlay, uint8_t color, int32_t count) {
+    for (int32_t i = 0; i < count; ++i) {
+        const uint8_t value = overlay[i].red;
+        const uint8_t frac = overlay[i].alpha;
+        const RgbColor over = RgbColor::tint(color, value);
+        const RgbColor& under = dst[i];
+        RgbColor composite;
+        composite.red = ((over.red * frac) + (under.red * (255 - frac))) / 255;
+        composite.green = ((over.green * frac) + (under.green * (255 - frac))) / 255;
+        composite.blue = ((over.blue * frac) + (under.blue * (255 - frac))) / 255;
+        composite.alpha = under.alpha;
+        dst[i] = composite;
+    }
+}
+
+#ifdef ANTARES_PIX_SPANS_X86
+
+// The vector kernels load pixels as 32-bit lanes, in which alpha is the low byte (RgbColor is
+// laid out alpha, red, green, blue).  For arithmetic, each pixel is unpacked to four 16-bit
+// lanes in the same order.
+//
+// composite_span() is done in double precision, and can't be vectorized without changing its
+// rounding.  But most pixels composited are opaque, which just replaces the pixel beneath, or
+// clear over opaque, which leaves it alone; the exact arithmetic gives the same results in both
+// cases.  So the vector kernels find runs where every pixel is one or the other, and leave the
+// rest to composite_mixed(), which checks for the same cases pixel by pixel.
+//
+// tint_span() is all integers: its divisions by 255 are floor((x + 1) * 257 / 65536), which is
+// exact for x up to 255 * 255.
+
+void composite_mixed(RgbColor* dst, const RgbColor* src, int32_t count) {
+    for (int32_t i = 0; i < count; ++i) {
+        if (src[i].alpha == 0xff) {
+            dst[i] = src[i];
+        } else if ((src[i].alpha != 0x00) || (dst[i].alpha != 0xff)) {
+            composite_pixel(dst + i, src[i]);
+        }
+    }
+}
+
+inline uint32_t bits(const RgbColor& color) {
+    uint32_t result;
+    memcpy(&result, &color, sizeof(result));
+    return result;
+}
+
+size_t fill_span_sse2(RgbColor* dst, const RgbColor& color, int32_t count) {
+    const __m128i c = _mm_set1_epi32(bits(color));
+    int32_t i = 0;
+    for ( ; (i + 4) <= count; i += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), c);
+    }
+    return i;
+}
+
+size_t composite_span_sse2(RgbColor* dst, const RgbColor* src, int32_t count) {
+    const __m128i alpha = _mm_set1_epi32(0xff);
+    const __m128i zero = _mm_setzero_si128();
+    int32_t i = 0;
+    for ( ; (i + 4) <= count; i += 4) {
+        const __m128i over = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i over_alpha = _mm_and_si128(over, alpha);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(over_alpha, alpha)) == 0xffff) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), over);
+            continue;
+        }
+        const __m128i under = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        const __m128i under_alpha = _mm_and_si128(under, alpha);
+        if ((_mm_movemask_epi8(_mm_cmpeq_epi32(over_alpha, zero)) != 0xffff)
+                || (_mm_movemask_epi8(_mm_cmpeq_epi32(under_alpha, alpha)) != 0xffff)) {
+            composite_mixed(dst + i, src + i, 4);
+        }
+    }
+    return i;
+}
+
+inline __m128i div255_sse2(__m128i x) {
+    return _mm_mulhi_epu16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_set1_epi16(257));
+}
+
+inline __m128i tint_pixels_sse2(__m128i over, __m128i under, __m128i diffuse, __m128i ambient) {
+    const __m128i value = _mm_shufflehi_epi16(
+            _mm_shufflelo_epi16(over, _MM_SHUFFLE(1, 1, 1, 1)), _MM_SHUFFLE(1, 1, 1, 1));
+    const __m128i frac = _mm_shufflehi_epi16(
+            _mm_shufflelo_epi16(over, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(0, 0, 0, 0));
+    const __m128i tinted = _mm_add_epi16(div255_sse2(_mm_mullo_epi16(diffuse, value)), ambient);
+    const __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), frac);
+    return div255_sse2(
+            _mm_add_epi16(_mm_mullo_epi16(tinted, frac), _mm_mullo_epi16(under, inverse)));
+}
+
+// Lanes for RgbColor::tint(color, value) = (diffuse * value / 255) + ambient.
+void tint_factors(uint8_t color, int16_t* diffuse, int16_t* ambient) {
+    const RgbColor low = RgbColor::tint(color, 0);
+    const RgbColor high = RgbColor::tint(color, 255);
+    const int16_t d[4] = {0, int16_t(high.red - low.red), int16_t(high.green - low.green),
+                          int16_t(high.blue - low.blue)};
+    const int16_t a[4] = {0, low.red, low.green, low.blue};
+    for (int i = 0; i < 8; ++i) {
+        diffuse[i] = d[i % 4];
+        ambient[i] = a[i % 4];
+    }
+}
+
+size_t tint_span_sse2(RgbColor* dst, const RgbColor* overlay, uint8_t color, int32_t count) {
+    int16_t d[8], a[8];
+    tint_factors(color, d, a);
+    const __m128i diffuse = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d));
+    const __m128i ambient = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+    const __m128i alpha = _mm_set1_epi32(0xff);
+    const __m128i zero = _mm_setzero_si128();
+    int32_t i = 0;
+    for ( ; (i + 4) <= count; i += 4) {
+        const __m128i over = _mm_loadu_si128(reinterpret_cast<const __m128i*>(overlay + i));
+        const __m128i under = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        const __m128i lo = tint_pixels_sse2(
+                _mm_unpacklo_epi8(over, zero), _mm_unpacklo_epi8(under, zero), diffuse, ambient);
+        const __m128i hi = tint_pixels_sse2(
+                _mm_unpackhi_epi8(over, zero), _mm_unpackhi_epi8(under, zero), diffuse, ambient);
+        const __m128i result = _mm_or_si128(
+                _mm_andnot_si128(alpha, _mm_packus_epi16(lo, hi)), _mm_and_si128(alpha, under));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), result);
+    }
+    return i;
+}
+
+#define ANTARES_AVX2 __attribute__((target("avx2")))
+
+ANTARES_AVX2 size_t fill_span_avx2(RgbColor* dst, const RgbColor& color, int32_t count) {
+    const __m256i c = _mm256_set1_epi32(bits(color));
+    int32_t i = 0;
+    for ( ; (i + 8) <= count; i += 8) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), c);
+    }
+    return i;
+}
+
+ANTARES_AVX2 size_t composite_span_avx2(RgbColor* dst, const RgbColor* src, int32_t count) {
+    const __m256i alpha = _mm256_set1_epi32(0xff);
+    const __m256i zero = _mm256_setzero_si256();
+    int32_t i = 0;
+    for ( ; (i + 8) <= count; i += 8) {
+        const __m256i over = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        const __m256i over_alpha = _mm256_and_si256(over, alpha);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(over_alpha, alpha)) == -1) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), over);
+            continue;
+        }
+        const __m256i under = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        const __m256i under_alpha = _mm256_and_si256(under, alpha);
+        if ((_mm256_movemask_epi8(_mm256_cmpeq_epi32(over_alpha, zero)) != -1)
+                || (_mm256_movemask_epi8(_mm256_cmpeq_epi32(under_alpha, alpha)) != -1)) {
+            composite_mixed(dst + i, src + i, 8);
+        }
+    }
+    return i;
+}
+
+ANTARES_AVX2 inline __m256i div255_avx2(__m256i x) {
+    return _mm256_mulhi_epu16(
+            _mm256_add_epi16(x, _mm256_set1_epi16(1)), _mm256_set1_epi16(257));
+}
+
+ANTARES_AVX2 inline __m256i tint_pixels_avx2(
+        __m256i over, __m256i under, __m256i diffuse, __m256i ambient) {
+    const __m256i value = _mm256_shufflehi_epi16(
+            _mm256_shufflelo_epi16(over, _MM_SHUFFLE(1, 1, 1, 1)), _MM_SHUFFLE(1, 1, 1, 1));
+    const __m256i frac = _mm256_shufflehi_epi16(
+            _mm256_shufflelo_epi16(over, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(0, 0, 0, 0));
+    const __m256i tinted = _mm256_add_epi16(
+            div255_avx2(_mm256_mullo_epi16(diffuse, value)), ambient);
+    const __m256i inverse = _mm256_sub_epi16(_mm256_set1_epi16(255), frac);
+    return div255_avx2(_mm256_add_epi16(
+                _mm256_mullo_epi16(tinted, frac), _mm256_mullo_epi16(under, inverse)));
+}
+
+// Unpacking and packing work within each 128-bit half, so the pixels come back in order.
+ANTARES_AVX2 size_t tint_span_avx2(
+        RgbColor* dst, const RgbColor* overlay, uint8_t color, int32_t count) {
+    int16_t d[8], a[8];
+    tint_factors(color, d, a);
+    const __m256i diffuse = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(d)));
+    const __m256i ambient = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(a)));
+    const __m256i alpha = _mm256_set1_epi32(0xff);
+    const __m256i zero = _mm256_setzero_si256();
+    int32_t i = 0;
+    for ( ; (i + 8) <= count; i += 8) {
+        const __m256i over = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(overlay + i));
+        const __m256i under = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        const __m256i lo = tint_pixels_avx2(
+                _mm256_unpacklo_epi8(over, zero), _mm256_unpacklo_epi8(under, zero),
+                diffuse, ambient);
+        const __m256i hi = tint_pixels_avx2(
+                _mm256_unpackhi_epi8(over, zero), _mm256_unpackhi_epi8(under, zero),
+                diffuse, ambient);
+        const __m256i result = _mm256_or_si256(
+                _mm256_andnot_si256(alpha, _mm256_packus_epi16(lo, hi)),
+                _mm256_and_si256(alpha, under));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), result);
+    }
+    return i;
+}
+
+#undef ANTARES_AVX2
+
+#endif  // ANTARES_PIX_SPANS_X86
+
+}  // namespace
+
+bool pix_span_isa_supported(PixSpanIsa isa) {
+    switch (isa) {
+      case PIX_SPAN_SCALAR:
+        return true;
+#ifdef ANTARES_PIX_SPANS_X86
+      case PIX_SPAN_SSE2:
+        return __builtin_cpu_supports("sse2");
+      case PIX_SPAN_AVX2:
+        return __builtin_cpu_supports("avx2");
+#else
+      case PIX_SPAN_SSE2:
+      case PIX_SPAN_AVX2:
+        return false;
+#endif
+    }
+    return false;
+}
+
+PixSpanIsa best_pix_span_isa() {
+    if (pix_span_isa_supported(PIX_SPAN_AVX2)) {
+        return PIX_SPAN_AVX2;
+    } else if (pix_span_isa_supported(PIX_SPAN_SSE2)) {
+        return PIX_SPAN_SSE2;
+    }
+    return PIX_SPAN_SCALAR;
+}
+
+void fill_span(RgbColor* dst, const RgbColor& color, int32_t count) {
+    static const PixSpanIsa isa = best_pix_span_isa();
+    fill_span(dst, color, count, isa);
+}
+
+void fill_span(RgbColor* dst, const RgbColor& color, int32_t count, PixSpanIsa isa) {
+    size_t done = 0;
+    switch (isa) {
+      case PIX_SPAN_SCALAR:
+        break;
+#ifdef ANTARES_PIX_SPANS_X86
+      case PIX_SPAN_SSE2:
+        done = fill_span_sse2(dst, color, count);
+        break;
+      case PIX_SPAN_AVX2:
+        done = fill_span_avx2(dst, color, count);
+        break;
+#else
+      case PIX_SPAN_SSE2:
+      case PIX_SPAN_AVX2:
+        break;
+#endif
+    }
+    fill_span_scalar(dst + done, color, count - done);
+}
+
+void composite_span(RgbColor* dst, const RgbColor* src, int32_t count) {
+    static const PixSpanIsa isa = best_pix_span_isa();
+    composite_span(dst, src, count, isa);
+}
+
+void composite_span(RgbColor* dst, const RgbColor* src, int32_t count, PixSpanIsa isa) {
+    size_t done = 0;
+    switch (isa) {
+      case PIX_SPAN_SCALAR:
+        break;
+#ifdef ANTARES_PIX_SPANS_X86
+      case PIX_SPAN_SSE2:
+        done = composite_span_sse2(dst, src, count);
+        break;
+      case PIX_SPAN_AVX2:
+        done = composite_span_avx2(dst, src, count);
+        break;
+#else
+      case PIX_SPAN_SSE2:
+      case PIX_SPAN_AVX2:
+        break;
+#endif
+    }
+    composite_span_scalar(dst + done, src + done, count - done);
+}
+
+void tint_span(RgbColor* dst, const RgbColor* overlay, uint8_t color, int32_t count) {
+    static const PixSpanIsa isa = best_pix_span_isa();
+    tint_span(dst, overlay, color, count, isa);
+}
+
+void tint_span(
+        RgbColor* dst, const RgbColor* overlay, uint8_t color, int32_t count, PixSpanIsa isa) {
+    size_t done = 0;
+    switch (isa) {
+      case PIX_SPAN_SCALAR:
+        break;
+#ifdef ANTARES_PIX_SPANS_X86
+      case PIX_SPAN_SSE2:
+        done = tint_span_sse2(dst, overlay, color, count);
+        break;
+      case PIX_SPAN_AVX2:
+        done = tint_span_avx2(dst, overlay, color, count);
+        break;
+#else
+      case PIX_SPAN_SSE2:
+      case PIX_SPAN_AVX2:
+        break;
+#endif
+    }
+    tint_span_scalar(dst + done, overlay + done, color, count - done);
+}
+
+}  // namespace antares
@@ -22,8 +22,10 @@
 
 #include "data/resource.hpp"
 #include "drawing/color.hpp"
+#include "drawing/pix-spans.hpp"
 #include "video/driver.hpp"
 
+using sfz::Bytes;
 using sfz::BytesSlice;
 using sfz::Exception;
 using sfz::Json;
@@ -32,10 +34,13 @@ using sfz::ReadSource;
 using sfz::String;
 using sfz::StringMap;
 using sfz::StringSlice;
+using sfz::WriteTarget;
 using sfz::format;
+using sfz::quote;
 using sfz::range;
 using sfz::read;
 using sfz::string_to_json;
+using sfz::write;
 using std::unique_ptr;
 using std::vector;
 
@@ -59,18 +64,16 @@ struct PixTableVisitor : public JsonDefaultVisitor {
         Point center;
         Rect frame;
         StateEnum state;
+        bool has_overlay;
         ArrayPixMap image, overlay;
-        State(): state(NEW), image(0, 0), overlay(0, 0) { }
+        State(): state(NEW), has_overlay(false), image(0, 0), overlay(0, 0) { }
     };
     State& state;
-    int16_t id;
     uint8_t color;
     vector<NatePixTable::Frame>& frames;
 
-    PixTableVisitor(State& state, int16_t id, uint8_t color,
-                    vector<NatePixTable::Frame>& frames):
+    PixTableVisitor(State& state, uint8_t color, vector<NatePixTable::Frame>& frames):
             state(state),
-            id(id),
             color(color),
             frames(frames) { }
 
@@ -89,6 +92,7 @@ struct PixTableVisitor : public JsonDefaultVisitor {
     virtual void visit_object(const StringMap<Json>& value) const {
         switch (state.state) {
           case NEW:
+            state.has_overlay = (value.find("overlay") != value.end());
             state.center = Point(0, 0);
             descend(CENTER, value, "center");
 
@@ -147,9 +151,9 @@ struct PixTableVisitor : public JsonDefaultVisitor {
                 bounds.offset(2 * -bounds.left, 2 * -bounds.top);
                 if (color) {
                     auto overlay = state.overlay.view(cell).view(sprite);
-                    frames.emplace_back(bounds, image, id, frame, overlay, color);
+                    frames.emplace_back(bounds, image, overlay, color);
                 } else {
-                    frames.emplace_back(bounds, image, id, frame);
+                    frames.emplace_back(bounds, image);
                 }
             } else {
                 throw Exception("bad frame rect");
@@ -216,17 +220,114 @@ struct PixTableVisitor : public JsonDefaultVisitor {
     }
 };
 
+// Collects the paths of the images a sprite table's JSON names, without reading them.
+struct ImagePathVisitor : public JsonDefaultVisitor {
+    vector<String>& paths;
+
+    explicit ImagePathVisitor(vector<String>& paths): paths(paths) { }
+
+    void visit_key(const StringMap<Json>& value, StringSlice key) const {
+        auto it = value.find(key);
+        if (it != value.end()) {
+            it->second.accept(*this);
+        }
+    }
+
+    virtual void visit_object(const StringMap<Json>& value) const {
+        visit_key(value, "image");
+        visit_key(value, "overlay");
+    }
+
+    virtual void visit_string(const StringSlice& value) const {
+        paths.push_back(String(value));
+    }
+
+    virtual void visit_default(const char* type) const {
+        throw Exception(format("unexpected {0} in sprite json", type));
+    }
+};
+
+// Returns the resource paths a sprite pack is compiled from: the table's JSON, then each image
+// it names.
+vector<String> pack_sources(int id, BytesSlice json) {
+    String text(utf8::decode(json));
+    Json value;
+    if (!string_to_json(text, value)) {
+        throw Exception("invalid sprite json");
+    }
+    vector<String> paths;
+    paths.emplace_back(format("sprites/{0}.json", id));
+    value.accept(ImagePathVisitor(paths));
+    return paths;
+}
+
+// A sprite pack starts with a header: the magic number, then its sources (see pack_sources()),
+// as a uint32 count followed by each one's path, as a uint32 length and UTF-8, and its stamp
+// (see ResourceStamp), as two int64s.  Then come the number of frames, the number of hues, and
+// the size of each hue's pixels, as uint32s.  For each frame follow its bounds, as four int32s
+// (left, top, right, bottom), and the uint32 offset of its pixels in the first hue.  Then come
+// the pixels, row by row, of every frame, for each hue in turn.
+//
+// Pixels are stored as RgbColor is in memory, so that frames can point straight into the mapped
+// file.  Hue 0 is untinted; if the table has an overlay, hue N is tinted with color N.
+const uint8_t kPackMagic[8] = {'N', 'L', 'S', 'P', 'p', 'k', '3', '\n'};
+const size_t kPackCountsSize = 12;
+const size_t kPackFrameSize = 20;
+const int kPackHues = 16;
+
+// Reads the magic number and sources of sprite pack `in`, leaving it at the number of frames.
+// Returns true if every source is still as it was when the pack was compiled.  Sources are only
+// stat()ed, so this doesn't touch the JSON or images that the pack saves reading.
+bool read_pack_sources(BytesSlice& in) {
+    if ((in.size() < sizeof(kPackMagic))
+            || (in.slice(0, sizeof(kPackMagic)) != BytesSlice(kPackMagic, sizeof(kPackMagic)))) {
+        return false;
+    }
+    in.shift(sizeof(kPackMagic));
+    bool current = true;
+    const uint32_t count = read<uint32_t>(in);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t size = read<uint32_t>(in);
+        if (in.size() < size) {
+            throw Exception("truncated sprite pack");
+        }
+        const String path(utf8::decode(in.slice(0, size)));
+        in.shift(size);
+        ResourceStamp recorded;
+        recorded.size = read<int64_t>(in);
+        recorded.mtime = read<int64_t>(in);
+        ResourceStamp stamp;
+        current = current
+            && resource_stamp(path, &stamp)
+            && (stamp.size == recorded.size)
+            && (stamp.mtime == recorded.mtime);
+    }
+    return current;
+}
+
 }  // namespace
 
+NatePixTable::NatePixTable() { }
+
 NatePixTable::NatePixTable(int id, uint8_t color) {
-    Resource rsrc("sprites", "json", id);
-    String data(utf8::decode(rsrc.data()));
-    Json json;
-    if (!string_to_json(data, json)) {
-        throw Exception("invalid sprite json");
+    vector<String> paths;
+    paths.push_back(String(format("sprites/{0}.pack", id)));
+    paths.push_back(String(format("sprites/{0}.json", id)));
+    size_t which;
+    unique_ptr<Resource> rsrc(new Resource(paths, &which));
+    if (which == 0) {
+        // A pack left behind when its JSON or images were replaced is ignored, not trusted.
+        BytesSlice in = rsrc->data();
+        if (read_pack_sources(in)) {
+            read_pack(rsrc->data(), in, color);
+            _pack = std::move(rsrc);
+        } else {
+            read_json(Resource("sprites", "json", id).data(), color);
+        }
+    } else {
+        read_json(rsrc->data(), color);
     }
-    PixTableVisitor::State state;
-    json.accept(PixTableVisitor(state, id, color, _frames));
+    make_sprites(id);
 }
 
 NatePixTable::~NatePixTable() { }
@@ -236,60 +337,157 @@ const NatePixTable::Frame& NatePixTable::at(size_t index) const {
 }
 
 size_t NatePixTable::size() const {
-    return _size;
+    return _frames.size();
+}
+
+bool NatePixTable::read_json(BytesSlice data, uint8_t color) {
+    String text(utf8::decode(data));
+    Json json;
+    if (!string_to_json(text, json)) {
+        throw Exception("invalid sprite json");
+    }
+    PixTableVisitor::State state;
+    json.accept(PixTableVisitor(state, color, _frames));
+    return state.has_overlay;
+}
+
+void NatePixTable::read_pack(BytesSlice data, BytesSlice in, uint8_t color) {
+    if (in.size() < kPackCountsSize) {
+        throw Exception("truncated sprite pack");
+    }
+    const uint32_t count = read<uint32_t>(in);
+    const uint32_t hues = read<uint32_t>(in);
+    const uint32_t hue_size = read<uint32_t>(in);
+    if (color >= hues) {
+        throw Exception("missing overlay in sprite pack");
+    }
+    if (in.size() < (uint64_t(count) * kPackFrameSize)) {
+        throw Exception("truncated sprite pack");
+    }
+
+    _frames.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const int32_t left = read<int32_t>(in);
+        const int32_t top = read<int32_t>(in);
+        const int32_t right = read<int32_t>(in);
+        const int32_t bottom = read<int32_t>(in);
+        const Rect bounds(left, top, right, bottom);
+        const uint64_t offset = read<uint32_t>(in) + (uint64_t(color) * hue_size);
+        const uint64_t size = uint64_t(bounds.area()) * sizeof(RgbColor);
+        if ((bounds.width() < 0) || (bounds.height() < 0) || ((offset + size) > data.size())) {
+            throw Exception("bad frame in sprite pack");
+        }
+        const RgbColor* pixels = reinterpret_cast<const RgbColor*>(data.data() + offset);
+        _frames.emplace_back(bounds, unique_ptr<PixMap>(new ConstPixMap(bounds.size(), pixels)));
+    }
+}
+
+void NatePixTable::write_pack(WriteTarget out, int id) {
+    Resource rsrc("sprites", "json", id);
+    vector<unique_ptr<NatePixTable>> hues;
+    hues.emplace_back(new NatePixTable);
+    if (hues[0]->read_json(rsrc.data(), 0)) {
+        for (int color = 1; color < kPackHues; ++color) {
+            hues.emplace_back(new NatePixTable);
+            hues.back()->read_json(rsrc.data(), color);
+        }
+    }
+
+    const vector<Frame>& frames = hues[0]->_frames;
+    uint32_t hue_size = 0;
+    for (const Frame& frame: frames) {
+        hue_size += frame._bounds.area() * sizeof(RgbColor);
+    }
+    Bytes sources;
+    const vector<String> paths = pack_sources(id, rsrc.data());
+    write<uint32_t>(sources, paths.size());
+    for (const String& path: paths) {
+        ResourceStamp stamp;
+        if (!resource_stamp(path, &stamp)) {
+            throw Exception(format("couldn't find resource {0}", quote(path)));
+        }
+        const Bytes encoded(utf8::encode(path));
+        write<uint32_t>(sources, encoded.size());
+        sources.push(encoded);
+        write<int64_t>(sources, stamp.size);
+        write<int64_t>(sources, stamp.mtime);
+    }
+
+    out.push(BytesSlice(kPackMagic, sizeof(kPackMagic)));
+    out.push(sources);
+    write<uint32_t>(out, frames.size());
+    write<uint32_t>(out, hues.size());
+    write<uint32_t>(out, hue_size);
+
+    uint32_t offset = sizeof(kPackMagic) + sources.size() + kPackCountsSize
+        + (frames.size() * kPackFrameSize);
+    for (const Frame& frame: frames) {
+        write<int32_t>(out, frame._bounds.left);
+        write<int32_t>(out, frame._bounds.top);
+        write<int32_t>(out, frame._bounds.right);
+        write<int32_t>(out, frame._bounds.bottom);
+        write<uint32_t>(out, offset);
+        offset += frame._bounds.area() * sizeof(RgbColor);
+    }
+
+    for (const unique_ptr<NatePixTable>& hue: hues) {
+        for (const Frame& frame: hue->_frames) {
+            for (int32_t y = 0; y < frame.height(); ++y) {
+                const uint8_t* row = reinterpret_cast<const uint8_t*>(frame.pix_map().row(y));
+                out.push(BytesSlice(row, frame.width() * sizeof(RgbColor)));
+            }
+        }
+    }
+}
+
+// Making the sprites together lets the video driver pack them into a shared texture.
+void NatePixTable::make_sprites(int id) {
+    vector<String> names;
+    vector<const PixMap*> contents;
+    for (size_t i = 0; i < _frames.size(); ++i) {
+        names.push_back(String(format("/sprites/{0}.SMIV/{1}", id, i)));
+        contents.push_back(_frames[i]._pix_map.get());
+    }
+    vector<unique_ptr<Sprite>> sprites = VideoDriver::driver()->new_sprites(names, contents);
+    for (size_t i = 0; i < _frames.size(); ++i) {
+        _frames[i]._sprite = std::move(sprites[i]);
+    }
 }
 
 NatePixTable::Frame::Frame(
-        Rect bounds, const PixMap& image, int16_t id, int frame,
-        const PixMap& overlay, uint8_t color):
+        Rect bounds, const PixMap& image, const PixMap& overlay, uint8_t color):
         _bounds(bounds),
-        _pix_map(bounds.width(), bounds.height()) {
+        _pix_map(new ArrayPixMap(bounds.width(), bounds.height())) {
     load_image(image);
     load_overlay(overlay, color);
-    build(id, frame);
 }
 
-NatePixTable::Frame::Frame(
-        Rect bounds, const PixMap& image, int16_t id, int frame):
+NatePixTable::Frame::Frame(Rect bounds, const PixMap& image):
         _bounds(bounds),
-        _pix_map(bounds.width(), bounds.height()) {
+        _pix_map(new ArrayPixMap(bounds.width(), bounds.height())) {
     load_image(image);
-    build(id, frame);
 }
 
+NatePixTable::Frame::Frame(Rect bounds, unique_ptr<PixMap> pix_map):
+        _bounds(bounds),
+        _pix_map(std::move(pix_map)) { }
+
 NatePixTable::Frame::~Frame() { }
 
 void NatePixTable::Frame::load_image(const PixMap& pix) {
-    _pix_map.copy(pix);
+    _pix_map->copy(pix);
 }
 
 void NatePixTable::Frame::load_overlay(const PixMap& pix, uint8_t color) {
-    for (auto x: range(width())) {
-        for (auto y: range(height())) {
-            RgbColor over = pix.get(x, y);
-            uint8_t value = over.red;
-            uint8_t frac = over.alpha;
-            over = RgbColor::tint(color, value);
-            RgbColor under = _pix_map.get(x, y);
-            RgbColor composite;
-            composite.red = ((over.red * frac) + (under.red * (255 - frac))) / 255;
-            composite.green = ((over.green * frac) + (under.green * (255 - frac))) / 255;
-            composite.blue = ((over.blue * frac) + (under.blue * (255 - frac))) / 255;
-            composite.alpha = under.alpha;
-            _pix_map.set(x, y, composite);
-        }
+    for (auto y: range(height())) {
+        tint_span(_pix_map->mutable_row(y), pix.row(y), color, width());
     }
 }
 
 uint16_t NatePixTable::Frame::width() const { return _bounds.width(); }
 uint16_t NatePixTable::Frame::height() const { return _bounds.height(); }
 Point NatePixTable::Frame::center() const { return _bounds.origin(); }
-const PixMap& NatePixTable::Frame::pix_map() const { return _pix_map; }
+const PixMap& NatePixTable::Frame::pix_map() const { return *_pix_map; }
 const Sprite& NatePixTable::Frame::sprite() const { return *_sprite; }
 
-void NatePixTable::Frame::build(int16_t id, int frame) {
-    _sprite = VideoDriver::driver()->new_sprite(
-            format("/sprites/{0}.SMIV/{1}", id, frame), _pix_map);
-}
-
 }  // namespace antares
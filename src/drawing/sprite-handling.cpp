@@ -19,7 +19,9 @@
 #include "drawing/sprite-handling.hpp"
 
 #include <numeric>
+#include <vector>
 
+#include "data/space-object.hpp"
 #include "drawing/color.hpp"
 #include "drawing/pix-table.hpp"
 #include "drawing/shapes.hpp"
@@ -31,17 +33,23 @@
 
 using sfz::Exception;
 using sfz::Range;
+using sfz::ReadSource;
 using sfz::StringSlice;
+using sfz::WriteTarget;
 using sfz::format;
 using sfz::range;
+using sfz::read;
+using sfz::write;
 using std::map;
 using std::unique_ptr;
+using std::vector;
 
 namespace antares {
 
 namespace {
 
-const size_t kMaxSpriteNum = 500;
+// Like the object pool, the sprite table grows a chunk at a time, so sprites never move.
+const int32_t kSpriteChunkSize = kSpritesPerObject * kSpaceObjectChunkSize;
 
 const size_t kMinVolatilePixTable = 1;  // sound 0 is always there; 1+ is volatile
 
@@ -108,13 +116,30 @@ struct pixTableType {
 static pixTableType gPixTable[kMaxPixTableEntry];
 
 int32_t gAbsoluteScale = MIN_SCALE;
-static unique_ptr<spriteType[]> gSpriteTable;
+static vector<unique_ptr<spriteType[]>> gSpriteChunks;
+static int32_t gSpriteLimit = kSpritesPerObject * kDefaultSpaceObjectLimit;
+
+static int32_t SpriteCapacity() {
+    return gSpriteChunks.size() * kSpriteChunkSize;
+}
+
+static spriteType* SpriteAt(int32_t whichSprite) {
+    return gSpriteChunks[whichSprite / kSpriteChunkSize].get() + (whichSprite % kSpriteChunkSize);
+}
+
+static void AddSpriteChunk() {
+    spriteType* chunk = new spriteType[kSpriteChunkSize];
+    for (int32_t i = 0; i < kSpriteChunkSize; ++i) {
+        zero(&chunk[i]);
+    }
+    gSpriteChunks.emplace_back(chunk);
+}
 
 void SpriteHandlingInit() {
     ResetAllPixTables();
 
-    gSpriteTable.reset(new spriteType[kMaxSpriteNum]);
-    ResetAllSprites();
+    gSpriteChunks.clear();
+    AddSpriteChunk();
 
     for (int i = 0; i < 4000; ++i) {
         Randomize(256);
@@ -132,11 +157,15 @@ spriteType::spriteType()
           draw_tiny(NULL) { }
 
 void ResetAllSprites() {
-    for (int i: range(kMaxSpriteNum)) {
-        zero(&gSpriteTable[i]);
+    for (int32_t i: range(SpriteCapacity())) {
+        zero(SpriteAt(i));
     }
 }
 
+void SetSpriteLimit(int32_t limit) {
+    gSpriteLimit = limit;
+}
+
 void ResetAllPixTables() {
     for (pixTableType* entry: range(gPixTable, gPixTable + kMaxPixTableEntry)) {
         entry->resource.reset();
@@ -202,9 +231,13 @@ NatePixTable* GetPixTable(int16_t resource_id) {
 spriteType *AddSprite(
         Point where, NatePixTable* table, int16_t resID, int16_t whichShape, int32_t scale, int32_t size,
         int16_t layer, const RgbColor& color, int32_t *whichSprite) {
-    for (spriteType* sprite: range(gSpriteTable.get(), gSpriteTable.get() + kMaxSpriteNum)) {
+    for (int32_t i: range(gSpriteLimit)) {
+        if (i == SpriteCapacity()) {
+            AddSpriteChunk();
+        }
+        spriteType* sprite = SpriteAt(i);
         if (sprite->table == NULL) {
-            *whichSprite = sprite - gSpriteTable.get();
+            *whichSprite = i;
 
             sprite->where = where;
             sprite->table = table;
@@ -234,6 +267,72 @@ void RemoveSprite(spriteType *aSprite) {
     aSprite->resID = -1;
 }
 
+spriteType* GetSprite(int32_t whichSprite) {
+    if ((whichSprite < 0) || (whichSprite >= SpriteCapacity())) {
+        return NULL;
+    }
+    return SpriteAt(whichSprite);
+}
+
+// Only sprites in use are written.  The table pointer is written as the resource ID it was
+// loaded from, and draw_tiny is recomputed from the tiny size, as AddSprite() would.
+void SaveSprites(WriteTarget out) {
+    write(out, SpriteCapacity());
+    for (int32_t i: range(SpriteCapacity())) {
+        const spriteType& sprite = *SpriteAt(i);
+        write(out, sprite.table != NULL);
+        if (sprite.table == NULL) {
+            continue;
+        }
+        write(out, sprite.where);
+        write(out, sprite.resID);
+        write<int32_t>(out, sprite.whichShape);
+        write(out, sprite.scale);
+        write<int32_t>(out, sprite.style);
+        write(out, sprite.styleColor.alpha);
+        write(out, sprite.styleColor);
+        write(out, sprite.styleData);
+        write(out, sprite.tinySize);
+        write(out, sprite.whichLayer);
+        write(out, sprite.tinyColor.alpha);
+        write(out, sprite.tinyColor);
+        write(out, sprite.killMe);
+    }
+}
+
+void RestoreSprites(ReadSource in) {
+    const int32_t capacity = read<int32_t>(in);
+    if ((capacity < 0) || (capacity > (kSpritesPerObject * kMaxSpaceObject))
+            || (capacity % kSpriteChunkSize)) {
+        throw Exception(format("invalid sprite capacity {0}", capacity));
+    }
+    ResetAllSprites();
+    while (SpriteCapacity() < capacity) {
+        AddSpriteChunk();
+    }
+    for (int32_t i: range(capacity)) {
+        spriteType& sprite = *SpriteAt(i);
+        if (!read<bool>(in)) {
+            continue;
+        }
+        read(in, sprite.where);
+        read(in, sprite.resID);
+        sprite.table = AddPixTable(sprite.resID);
+        sprite.whichShape = read<int32_t>(in);
+        read(in, sprite.scale);
+        sprite.style = static_cast<spriteStyleType>(read<int32_t>(in));
+        read(in, sprite.styleColor.alpha);
+        read(in, sprite.styleColor);
+        read(in, sprite.styleData);
+        read(in, sprite.tinySize);
+        read(in, sprite.whichLayer);
+        read(in, sprite.tinyColor.alpha);
+        read(in, sprite.tinyColor);
+        read(in, sprite.killMe);
+        sprite.draw_tiny = draw_tiny_function(sprite.tinySize);
+    }
+}
+
 int32_t scale_by(int32_t value, int32_t scale) {
     return (value * scale) / SCALE_SCALE;
 }
@@ -254,8 +353,8 @@ Rect scale_sprite_rect(const NatePixTable::Frame& frame, Point where, int32_t sc
 void draw_sprites() {
     if (gAbsoluteScale >= kBlipThreshhold) {
         for (int layer: range<int>(kFirstSpriteLayer, kLastSpriteLayer + 1)) {
-            for (int i: range(kMaxSpriteNum)) {
-                spriteType* aSprite = &gSpriteTable[i];
+            for (int32_t i: range(SpriteCapacity())) {
+                spriteType* aSprite = SpriteAt(i);
                 if ((aSprite->table != NULL)
                         && !aSprite->killMe
                         && (aSprite->whichLayer == layer)) {
@@ -287,8 +386,8 @@ void draw_sprites() {
         }
     } else {
         for (int layer: range<int>(kFirstSpriteLayer, kLastSpriteLayer + 1)) {
-            for (int i: range(kMaxSpriteNum)) {
-                spriteType* aSprite = &gSpriteTable[i];
+            for (int32_t i: range(SpriteCapacity())) {
+                spriteType* aSprite = SpriteAt(i);
                 int tinySize = aSprite->tinySize & kBlipSizeMask;
                 if ((aSprite->table != NULL)
                         && !aSprite->killMe
@@ -309,8 +408,8 @@ void draw_sprites() {
 // Asteroids before the player actually starts.
 
 void CullSprites() {
-    for (int i: range(kMaxSpriteNum)) {
-        spriteType* aSprite = &gSpriteTable[i];
+    for (int32_t i: range(SpriteCapacity())) {
+        spriteType* aSprite = SpriteAt(i);
         if (aSprite->table != NULL) {
             if (aSprite->killMe) {
                 RemoveSprite(aSprite);
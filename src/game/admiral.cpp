@@ -22,6 +22,7 @@
 #include "data/string-list.hpp"
 #include "game/cheat.hpp"
 #include "game/globals.hpp"
+#include "game/snapshot.hpp"
 #include "game/space-object.hpp"
 #include "lang/casts.hpp"
 #include "math/macros.hpp"
@@ -31,8 +32,12 @@
 
 using sfz::Bytes;
 using sfz::Exception;
+using sfz::ReadSource;
 using sfz::String;
 using sfz::StringSlice;
+using sfz::WriteTarget;
+using sfz::read;
+using sfz::write;
 using std::min;
 using std::unique_ptr;
 
@@ -839,7 +844,7 @@ void AdmiralThink() {
                 if (a->blitzkrieg <= 0) {
                     // Really 48:
                     a->blitzkrieg = 0 - (gRandomSeed.next(1200) + 1200);
-                    for (int j = 0; j < kMaxSpaceObject; j++) {
+                    for (int j = NextSpaceObject(-1); j >= 0; j = NextSpaceObject(j)) {
                         anObject = mGetSpaceObjectPtr(j);
                         if (anObject->owner == i) {
                             anObject->currentTargetValue = 0x00000000;
@@ -851,7 +856,7 @@ void AdmiralThink() {
                 if (a->blitzkrieg >= 0) {
                     // Really 48:
                     a->blitzkrieg = gRandomSeed.next(1200) + 1200;
-                    for (int j = 0; j < kMaxSpaceObject; j++) {
+                    for (int j = NextSpaceObject(-1); j >= 0; j = NextSpaceObject(j)) {
                         anObject = mGetSpaceObjectPtr(j);
                         if (anObject->owner == i) {
                             anObject->currentTargetValue = 0x00000000;
@@ -1211,7 +1216,8 @@ void AdmiralThink() {
                                     mGetBaseObjectFromClassRace(
                                             baseObject, baseNum, a->hopeToBuild, a->race);
                                     if (baseObject->buildFlags & kSufficientEscortsExist) {
-                                        for (int j = 0; j < kMaxSpaceObject; ++j) {
+                                        for (int j = NextSpaceObject(-1); j >= 0;
+                                                j = NextSpaceObject(j)) {
                                             anObject = mGetSpaceObjectPtr(j);
                                             if ((anObject->active)
                                                     && (anObject->owner == i)
@@ -1219,14 +1225,15 @@ void AdmiralThink() {
                                                     && (anObject->escortStrength <
                                                         baseObject->friendDefecit)) {
                                                 a->hopeToBuild = -1;
-                                                j = kMaxSpaceObject;
+                                                break;
                                             }
                                         }
                                     }
 
                                     if (baseObject->buildFlags & kMatchingFoeExists) {
                                         thisValue = 0;
-                                        for (int j = 0; j < kMaxSpaceObject; j++) {
+                                        for (int j = NextSpaceObject(-1); j >= 0;
+                                                j = NextSpaceObject(j)) {
                                             anObject = mGetSpaceObjectPtr(j);
                                             if ((anObject->active)
                                                     && (anObject->owner != i)
@@ -1456,4 +1463,124 @@ int32_t GetAdmiralKill(int32_t whichAdmiral) {
     }
 }
 
+void SaveAdmiral(WriteTarget out, int32_t whichAdmiral) {
+    const baseObjectType* const first_base = mGetBaseObjectPtr(0);
+    const admiralType& a = *mGetAdmiralPtr(whichAdmiral);
+    write(out, a.attributes);
+    write(out, a.destinationObject);
+    write(out, a.destinationObjectID);
+    write(out, a.flagship);
+    write(out, a.flagshipID);
+    write(out, a.considerShip);
+    write(out, a.considerShipID);
+    write(out, a.considerDestination);
+    write(out, a.buildAtObject);
+    write(out, a.race);
+    write<int32_t>(out, a.destType);
+    write(out, a.cash);
+    write(out, a.saveGoal);
+    write(out, a.earningPower);
+    write(out, a.kills);
+    write(out, a.losses);
+    write(out, a.shipsLeft);
+    for (int j = 0; j < kAdmiralScoreNum; ++j) {
+        write(out, a.score[j]);
+    }
+    write(out, a.blitzkrieg);
+    write(out, a.lastFreeEscortStrength);
+    write(out, a.thisFreeEscortStrength);
+    for (int j = 0; j < kMaxNumAdmiralCanBuild; ++j) {
+        const admiralBuildType& build = a.canBuildType[j];
+        write<int32_t>(out, build.base ? (build.base - first_base) : -1);
+        write(out, build.baseNum);
+        write(out, build.chanceRange);
+    }
+    write(out, a.totalBuildChance);
+    write(out, a.hopeToBuild);
+    write(out, a.color);
+    write(out, a.active);
+    write_snapshot_string(out, a.name);
+}
+
+void SaveDestBalances(WriteTarget out) {
+    for (int i = 0; i < kMaxDestObject; ++i) {
+        const destBalanceType& d = *mGetDestObjectBalancePtr(i);
+        write(out, d.whichObject);
+        for (int j = 0; j < kMaxTypeBaseCanBuild; ++j) {
+            write(out, d.canBuildType[j]);
+        }
+        for (int j = 0; j < kMaxPlayerNum; ++j) {
+            write(out, d.occupied[j]);
+        }
+        write(out, d.earn);
+        write(out, d.buildTime);
+        write(out, d.totalBuildTime);
+        write(out, d.buildObjectBaseNum);
+        write_snapshot_string(out, d.name);
+    }
+}
+
+void SaveAdmirals(WriteTarget out) {
+    for (int i = 0; i < kMaxPlayerNum; ++i) {
+        SaveAdmiral(out, i);
+    }
+    SaveDestBalances(out);
+}
+
+void RestoreAdmirals(ReadSource in) {
+    for (int i = 0; i < kMaxPlayerNum; ++i) {
+        admiralType& a = *mGetAdmiralPtr(i);
+        read(in, a.attributes);
+        read(in, a.destinationObject);
+        read(in, a.destinationObjectID);
+        read(in, a.flagship);
+        read(in, a.flagshipID);
+        read(in, a.considerShip);
+        read(in, a.considerShipID);
+        read(in, a.considerDestination);
+        read(in, a.buildAtObject);
+        read(in, a.race);
+        a.destType = static_cast<destinationType>(read<int32_t>(in));
+        read(in, a.cash);
+        read(in, a.saveGoal);
+        read(in, a.earningPower);
+        read(in, a.kills);
+        read(in, a.losses);
+        read(in, a.shipsLeft);
+        for (int j = 0; j < kAdmiralScoreNum; ++j) {
+            read(in, a.score[j]);
+        }
+        read(in, a.blitzkrieg);
+        read(in, a.lastFreeEscortStrength);
+        read(in, a.thisFreeEscortStrength);
+        for (int j = 0; j < kMaxNumAdmiralCanBuild; ++j) {
+            admiralBuildType& build = a.canBuildType[j];
+            build.base = mGetBaseObjectPtr(read<int32_t>(in));
+            read(in, build.baseNum);
+            read(in, build.chanceRange);
+        }
+        read(in, a.totalBuildChance);
+        read(in, a.hopeToBuild);
+        read(in, a.color);
+        read(in, a.active);
+        a.name.assign(read_snapshot_string(in));
+    }
+
+    for (int i = 0; i < kMaxDestObject; ++i) {
+        destBalanceType& d = *mGetDestObjectBalancePtr(i);
+        read(in, d.whichObject);
+        for (int j = 0; j < kMaxTypeBaseCanBuild; ++j) {
+            read(in, d.canBuildType[j]);
+        }
+        for (int j = 0; j < kMaxPlayerNum; ++j) {
+            read(in, d.occupied[j]);
+        }
+        read(in, d.earn);
+        read(in, d.buildTime);
+        read(in, d.totalBuildTime);
+        read(in, d.buildObjectBaseNum);
+        d.name.assign(read_snapshot_string(in));
+    }
+}
+
 }  // namespace antares
@@ -32,7 +32,11 @@
 #include "math/units.hpp"
 #include "video/driver.hpp"
 
+using sfz::ReadSource;
+using sfz::WriteTarget;
 using sfz::range;
+using sfz::read;
+using sfz::write;
 using std::abs;
 using std::max;
 
@@ -108,10 +112,8 @@ beamType* Beams::add(
             beam->beamKind = kind;
             beam->accuracy = accuracy;
             beam->range = beam_range;
-            beam->fromObjectNumber = beam->fromObjectID = -1;
-            beam->fromObject = NULL;
-            beam->toObjectNumber = beam->toObjectID = -1;
-            beam->toObject = NULL;
+            beam->fromObject = SpaceObjectHandle();
+            beam->toObject = SpaceObjectHandle();
             beam->toRelativeCoord = Point(0, 0);
             beam->boltRandomSeed = 0;
             beam->boltCycleTime = 0;
@@ -126,11 +128,83 @@ beamType* Beams::add(
     return NULL;
 }
 
+beamType* Beams::get(int32_t which) {
+    if ((which < 0) || (which >= kBeamNum)) {
+        return NULL;
+    }
+    return _data.get() + which;
+}
+
+// Inactive beams are cleared on restore rather than written: add() sets up everything about a
+// beam that anything reads before drawing it.
+void Beams::save(WriteTarget out) {
+    const beamType* const beams = _data.get();
+    for (const beamType* beam: range(beams, beams + kBeamNum)) {
+        write(out, beam->active);
+        if (!beam->active) {
+            continue;
+        }
+        write(out, beam->beamKind);
+        write(out, beam->thisLocation);
+        write(out, beam->lastLocation);
+        write(out, beam->lastGlobalLocation);
+        write(out, beam->objectLocation);
+        write(out, beam->lastApparentLocation);
+        write(out, beam->endLocation);
+        write(out, beam->color);
+        write(out, beam->killMe);
+        write(out, beam->fromObject);
+        write(out, beam->toObject);
+        write(out, beam->toRelativeCoord);
+        write(out, beam->boltRandomSeed);
+        write(out, beam->lastBoldRandomSeed);
+        write(out, beam->boltCycleTime);
+        write(out, beam->boltState);
+        write(out, beam->accuracy);
+        write(out, beam->range);
+        for (int i: range(kBoltPointNum)) {
+            write(out, beam->thisBoltPoint[i]);
+            write(out, beam->lastBoltPoint[i]);
+        }
+    }
+}
+
+void Beams::restore(ReadSource in) {
+    reset();
+    beamType* const beams = _data.get();
+    for (beamType* beam: range(beams, beams + kBeamNum)) {
+        read(in, beam->active);
+        if (!beam->active) {
+            continue;
+        }
+        read(in, beam->beamKind);
+        read(in, beam->thisLocation);
+        read(in, beam->lastLocation);
+        read(in, beam->lastGlobalLocation);
+        read(in, beam->objectLocation);
+        read(in, beam->lastApparentLocation);
+        read(in, beam->endLocation);
+        read(in, beam->color);
+        read(in, beam->killMe);
+        read(in, beam->fromObject);
+        read(in, beam->toObject);
+        read(in, beam->toRelativeCoord);
+        read(in, beam->boltRandomSeed);
+        read(in, beam->lastBoldRandomSeed);
+        read(in, beam->boltCycleTime);
+        read(in, beam->boltState);
+        read(in, beam->accuracy);
+        read(in, beam->range);
+        for (int i: range(kBoltPointNum)) {
+            read(in, beam->thisBoltPoint[i]);
+            read(in, beam->lastBoltPoint[i]);
+        }
+    }
+}
+
 void Beams::set_attributes(spaceObjectType* beamObject, spaceObjectType* sourceObject) {
     beamType& beam = *beamObject->frame.beam.beam;
-    beam.fromObjectNumber = sourceObject->entryNumber;
-    beam.fromObjectID = sourceObject->id;
-    beam.fromObject = sourceObject;
+    beam.fromObject = SpaceObjectHandle(sourceObject);
 
     if (sourceObject->targetObjectNumber >= 0) {
         spaceObjectType* target = mGetSpaceObjectPtr(sourceObject->targetObjectNumber);
@@ -160,9 +234,7 @@ void Beams::set_attributes(spaceObjectType* beamObject, spaceObjectType* sourceO
                         - beam.accuracy
                         + beamObject->randomSeed.next(beam.accuracy << 1);
                 } else {
-                    beam.toObjectNumber = target->entryNumber;
-                    beam.toObjectID = target->id;
-                    beam.toObject = target;
+                    beam.toObject = SpaceObjectHandle(target);
                 }
             }
         } else { // target not valid
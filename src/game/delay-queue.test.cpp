@@ -0,0 +1,201 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "game/delay-queue.hpp"
+
+#include <random>
+#include <utility>
+#include <vector>
+#include <gmock/gmock.h>
+
+using sfz::Bytes;
+using sfz::BytesSlice;
+using sfz::ReadSource;
+using sfz::WriteTarget;
+using std::pair;
+using std::vector;
+using testing::ElementsAre;
+
+namespace antares {
+namespace {
+
+typedef testing::Test DelayQueueTest;
+
+vector<int> pop_all(DelayQueue<int>& queue) {
+    vector<int> result;
+    int value;
+    while (queue.pop(&value)) {
+        result.push_back(value);
+    }
+    return result;
+}
+
+// The queue delayed actions were kept in before DelayQueue: a list sorted by time remaining,
+// where a new entry goes in front of the first entry with as much time or more remaining, and
+// every entry's time is counted down as the clock advances.
+class OldList {
+  public:
+    void add(int64_t delay, int value) {
+        auto it = _list.begin();
+        while ((it != _list.end()) && (it->first < delay)) {
+            ++it;
+        }
+        _list.insert(it, std::make_pair(delay, value));
+    }
+
+    void advance(int64_t time) {
+        for (pair<int64_t, int>& entry: _list) {
+            entry.first -= time;
+        }
+    }
+
+    bool pop(int* value) {
+        if (_list.empty() || (_list.front().first > 0)) {
+            return false;
+        }
+        *value = _list.front().second;
+        _list.erase(_list.begin());
+        return true;
+    }
+
+  private:
+    vector<pair<int64_t, int>> _list;
+};
+
+TEST_F(DelayQueueTest, DueTime) {
+    DelayQueue<int> queue;
+    queue.add(5, 5);
+    queue.add(1, 1);
+    queue.add(3, 3);
+    EXPECT_THAT(pop_all(queue), ElementsAre());
+    queue.advance(1);
+    EXPECT_THAT(pop_all(queue), ElementsAre(1));
+    queue.advance(1);
+    EXPECT_THAT(pop_all(queue), ElementsAre());
+    queue.advance(10);
+    EXPECT_THAT(pop_all(queue), ElementsAre(3, 5));
+    EXPECT_TRUE(queue.empty());
+}
+
+// Actions falling due at the same time run last-queued first, however they got there: queued
+// in the same cycle with the same delay, or in different cycles with delays that end together.
+TEST_F(DelayQueueTest, TiesLastInFirstOut) {
+    DelayQueue<int> queue;
+    queue.add(10, 1);
+    queue.add(10, 2);
+    queue.advance(4);
+    queue.add(6, 3);
+    queue.add(7, 4);
+    queue.advance(3);
+    queue.add(3, 5);
+    queue.add(4, 6);
+    queue.advance(3);
+    EXPECT_THAT(pop_all(queue), ElementsAre(5, 3, 2, 1));
+    queue.advance(1);
+    EXPECT_THAT(pop_all(queue), ElementsAre(6, 4));
+}
+
+// Actions that are overdue run before ones that are only just due, in the order they fell due.
+TEST_F(DelayQueueTest, Overdue) {
+    DelayQueue<int> queue;
+    queue.add(1, 1);
+    queue.add(3, 3);
+    queue.add(2, 2);
+    queue.advance(5);
+    queue.add(0, 0);
+    EXPECT_THAT(pop_all(queue), ElementsAre(1, 2, 3, 0));
+}
+
+// Values added while handling a popped value reuse its slot, and still wait their turn.
+TEST_F(DelayQueueTest, AddWhilePopping) {
+    DelayQueue<int> queue;
+    queue.add(1, 1);
+    queue.add(1, 2);
+    queue.advance(1);
+    int value;
+    ASSERT_TRUE(queue.pop(&value));
+    EXPECT_EQ(2, value);
+    queue.add(0, 3);
+    queue.add(1, 4);
+    EXPECT_THAT(pop_all(queue), ElementsAre(3, 1));
+    queue.advance(1);
+    EXPECT_THAT(pop_all(queue), ElementsAre(4));
+}
+
+// Randomized schedules, with many ties, give the same order as the old list.
+TEST_F(DelayQueueTest, MatchesOldList) {
+    for (uint32_t seed = 1; seed <= 100; ++seed) {
+        std::mt19937 random(seed);
+        DelayQueue<int> queue;
+        OldList list;
+        int next = 0;
+        for (int step = 0; step < 1000; ++step) {
+            for (int i = random() % 4; i > 0; --i) {
+                const int64_t delay = random() % 8;
+                queue.add(delay, next);
+                list.add(delay, next);
+                ++next;
+            }
+            const int64_t time = random() % 3;
+            queue.advance(time);
+            list.advance(time);
+            int expected, actual;
+            while (list.pop(&expected)) {
+                ASSERT_TRUE(queue.pop(&actual)) << "seed " << seed << ", step " << step;
+                ASSERT_EQ(expected, actual) << "seed " << seed << ", step " << step;
+            }
+            ASSERT_FALSE(queue.pop(&actual)) << "seed " << seed << ", step " << step;
+        }
+    }
+}
+
+// A restored queue carries on exactly as the saved one does, ties included.
+TEST_F(DelayQueueTest, SaveRestore) {
+    std::mt19937 random(1);
+    DelayQueue<int> queue;
+    for (int i = 0; i < 100; ++i) {
+        queue.add(random() % 8, i);
+        if ((i % 10) == 0) {
+            queue.advance(1);
+            pop_all(queue);
+        }
+    }
+
+    Bytes saved;
+    queue.save(saved, [](WriteTarget out, int value) {
+        write(out, value);
+    });
+    DelayQueue<int> restored;
+    BytesSlice in(saved);
+    restored.restore(in, [](ReadSource in, int* value) {
+        read(in, *value);
+    });
+    EXPECT_TRUE(in.empty());
+
+    for (int i = 100; i < 200; ++i) {
+        const int64_t delay = random() % 8;
+        queue.add(delay, i);
+        restored.add(delay, i);
+        queue.advance(1);
+        restored.advance(1);
+        ASSERT_EQ(pop_all(queue), pop_all(restored));
+    }
+}
+
+}  // namespace
+}  // namespace antares
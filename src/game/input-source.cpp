@@ -30,14 +30,69 @@ using sfz::read;
 
 namespace antares {
 
+namespace {
+
+// Key codes are looked up once, when play starts, rather than for every key event.
+void resolve_key_codes(int* codes) {
+    for (int key = 0; key < KEY_COUNT; ++key) {
+        codes[key] = Preferences::preferences()->key(key) - 1;
+    }
+}
+
+// Sends the key events of an action row, in the order they were recorded.
+void send_keys(EventReceiver& receiver, const int* codes, BytesSlice events) {
+    for (uint8_t event: events) {
+        const int code = codes[ReplayFile::event_key(event)];
+        if (ReplayFile::event_is_up(event)) {
+            receiver.key_up(KeyUpEvent(now_usecs(), code));
+        } else {
+            receiver.key_down(KeyDownEvent(now_usecs(), code));
+        }
+    }
+}
+
+}  // namespace
+
 InputSource::~InputSource() { }
 
-ReplayInputSource::ReplayInputSource(ReplayData* data):
+const sfz::Bytes* InputSource::snapshot() const {
+    return NULL;
+}
+
+bool InputSource::sync(BytesSlice* data) {
+    return false;
+}
+
+bool InputSource::wants_snapshot() const {
+    return false;
+}
+
+void InputSource::add_snapshot(BytesSlice data) { }
+
+ReplayInputSource::ReplayInputSource(ReplayData* data, uint64_t start_at, uint64_t snapshot_at):
         _data(data),
+        _snapshot_index(-1),
+        _snapshot_at(snapshot_at),
         _data_index(0),
+        _sync_index(0),
         _at(0) {
-    EventReceiver receiver;
-    advance(receiver);
+    resolve_key_codes(_key_codes);
+    for (size_t i = 0; i < _data->snapshots.size(); ++i) {
+        if ((start_at > 0) && (_data->snapshots[i].at <= start_at)) {
+            _snapshot_index = i;
+            _at = _data->snapshots[i].at;
+        }
+    }
+    if (_snapshot_index >= 0) {
+        // Actions before the snapshot are already part of it.
+        while ((_data_index < _data->actions.size())
+                && (_data->actions[_data_index].at < _at)) {
+            ++_data_index;
+        }
+    } else {
+        EventReceiver receiver;
+        advance(receiver);
+    }
 }
 
 bool ReplayInputSource::next(EventReceiver& receiver) {
@@ -47,6 +102,33 @@ bool ReplayInputSource::next(EventReceiver& receiver) {
     return true;
 }
 
+// An index, not a pointer, since add_snapshot() may move the snapshots.
+const sfz::Bytes* ReplayInputSource::snapshot() const {
+    return (_snapshot_index >= 0) ? &_data->snapshots[_snapshot_index].data : NULL;
+}
+
+bool ReplayInputSource::sync(BytesSlice* data) {
+    const std::vector<ReplayData::Sync>& syncs = _data->syncs;
+    while ((_sync_index < syncs.size()) && (syncs[_sync_index].at < _at)) {
+        ++_sync_index;
+    }
+    if ((_sync_index < syncs.size()) && (syncs[_sync_index].at == _at)) {
+        *data = syncs[_sync_index].data;
+        return true;
+    }
+    return false;
+}
+
+bool ReplayInputSource::wants_snapshot() const {
+    return (_snapshot_at > 0) && (_at == _snapshot_at);
+}
+
+void ReplayInputSource::add_snapshot(BytesSlice data) {
+    _data->snapshots.emplace_back();
+    _data->snapshots.back().at = _at;
+    _data->snapshots.back().data.assign(data);
+}
+
 bool ReplayInputSource::advance(EventReceiver& receiver) {
     if (_at >= _data->duration) {
         return false;
@@ -56,12 +138,10 @@ bool ReplayInputSource::advance(EventReceiver& receiver) {
         const ReplayData::Action& action = _data->actions[_data_index];
         if (_at == action.at) {
             for (uint8_t key: action.keys_down) {
-                int code = Preferences::preferences()->key(key) - 1;
-                receiver.key_down(KeyDownEvent(now_usecs(), code));
+                receiver.key_down(KeyDownEvent(now_usecs(), _key_codes[key]));
             }
             for (uint8_t key: action.keys_up) {
-                int code = Preferences::preferences()->key(key) - 1;
-                receiver.key_up(KeyUpEvent(now_usecs(), code));
+                receiver.key_up(KeyUpEvent(now_usecs(), _key_codes[key]));
             }
         }
         ++_data_index;
@@ -70,4 +150,70 @@ bool ReplayInputSource::advance(EventReceiver& receiver) {
     return true;
 }
 
+ReplayFileInputSource::ReplayFileInputSource(const ReplayFile& file, uint64_t start_at):
+        _file(file),
+        _actions(file),
+        _syncs(file),
+        _has_action(false),
+        _has_sync(false),
+        _has_snapshot(false),
+        _at(0) {
+    resolve_key_codes(_key_codes);
+    const ReplayFile::Chunk* snapshot = NULL;
+    if (start_at > 0) {
+        for (const ReplayFile::Chunk& chunk: _file.chunks()) {
+            if ((chunk.kind == ReplayFile::SNAPSHOT_CHUNK) && (chunk.first_at <= start_at)) {
+                snapshot = &chunk;
+            }
+        }
+    }
+    if (snapshot) {
+        // Actions before the snapshot are already part of it.
+        _file.decode(*snapshot, &_snapshot);
+        _has_snapshot = true;
+        _at = snapshot->first_at;
+        _actions.seek(_at);
+        _syncs.seek(_at);
+    }
+    _has_action = _actions.next(&_action);
+    _has_sync = _syncs.next(&_sync);
+    if (!_has_snapshot) {
+        EventReceiver receiver;
+        advance(receiver);
+    }
+}
+
+bool ReplayFileInputSource::next(EventReceiver& receiver) {
+    return advance(receiver);
+}
+
+const sfz::Bytes* ReplayFileInputSource::snapshot() const {
+    return _has_snapshot ? &_snapshot : NULL;
+}
+
+bool ReplayFileInputSource::sync(BytesSlice* data) {
+    while (_has_sync && (_sync.at < _at)) {
+        _has_sync = _syncs.next(&_sync);
+    }
+    if (_has_sync && (_sync.at == _at)) {
+        *data = _sync.data;
+        return true;
+    }
+    return false;
+}
+
+bool ReplayFileInputSource::advance(EventReceiver& receiver) {
+    if (_at >= _file.duration()) {
+        return false;
+    }
+    while (_has_action && (_at >= _action.at)) {
+        if (_at == _action.at) {
+            send_keys(receiver, _key_codes, _action.events);
+        }
+        _has_action = _actions.next(&_action);
+    }
+    ++_at;
+    return true;
+}
+
 }  // namespace antares
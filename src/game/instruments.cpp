@@ -294,7 +294,7 @@ void UpdateRadar(int32_t unitsDone) {
             globals()->gRadarCount = globals()->gRadarSpeed;
 
             const int32_t rrange = globals()->gRadarRange >> 1L;
-            for (int oCount = 0; oCount < kMaxSpaceObject; oCount++) {
+            for (int oCount = NextSpaceObject(-1); oCount >= 0; oCount = NextSpaceObject(oCount)) {
                 spaceObjectType *anObject = mGetSpaceObjectPtr(oCount);
                 if (!anObject->active || (anObject == gScrollStarObject)) {
                     continue;
@@ -0,0 +1,455 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "game/kinematics.hpp"
+
+#include <algorithm>
+
+#if defined(__i386__) || defined(__x86_64__)
+#define ANTARES_KINEMATICS_X86 1
+#include <immintrin.h>
+#endif
+
+#include "data/space-object.hpp"
+#include "math/rotation.hpp"
+#include "math/special.hpp"
+
+using std::copy;
+
+namespace antares {
+
+namespace {
+
+// Signed overflow is undefined, so the scalar code does its arithmetic in uint32_t.  That wraps
+// as the vector kernels do; in a game, none of it comes near overflowing anyway.
+inline Fixed wrapping_add(Fixed a, Fixed b) {
+    return static_cast<Fixed>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b));
+}
+
+// Splits off the whole part of `fraction`, rounding halves away from zero on the positive side
+// and toward zero on the negative side, and returns it.
+inline int32_t take_whole(Fixed& fraction) {
+    int32_t whole;
+    if (fraction >= 0) {
+        whole = more_evil_fixed_to_long(wrapping_add(fraction, mFloatToFixed(0.5)));
+    } else {
+        whole = more_evil_fixed_to_long(wrapping_add(fraction, -mFloatToFixed(0.5))) + 1;
+    }
+    fraction = static_cast<Fixed>(
+            static_cast<uint32_t>(fraction) - (static_cast<uint32_t>(whole) << 8));
+    return whole;
+}
+
+inline Fixed clamp_thrust(Fixed dv, Fixed limit) {
+    if (limit < 0) {
+        return (dv < limit) ? limit : dv;
+    } else {
+        return (dv > limit) ? limit : dv;
+    }
+}
+
+void apply_thrust_scalar(size_t begin, size_t end, Kinematics& k) {
+    for (size_t i = begin; i < end; ++i) {
+        k.velocity_h[i] = wrapping_add(k.velocity_h[i], clamp_thrust(k.dv_h[i], k.limit_h[i]));
+        k.velocity_v[i] = wrapping_add(k.velocity_v[i], clamp_thrust(k.dv_v[i], k.limit_v[i]));
+    }
+}
+
+void integrate_motion_scalar(size_t begin, size_t end, Kinematics& k) {
+    for (size_t i = begin; i < end; ++i) {
+        if (k.moving[i]) {
+            k.fraction_h[i] = wrapping_add(k.fraction_h[i], k.velocity_h[i]);
+            k.fraction_v[i] = wrapping_add(k.fraction_v[i], k.velocity_v[i]);
+            k.location_h[i] -= take_whole(k.fraction_h[i]);
+            k.location_v[i] -= take_whole(k.fraction_v[i]);
+        }
+    }
+}
+
+#ifdef ANTARES_KINEMATICS_X86
+
+// The vector kernels work on 32-bit lanes throughout.  Neither SSE2 nor AVX2 has a blend that
+// is cheaper than and/andnot/or for integer lanes, so every branch of the scalar code becomes a
+// mask.  Integer overflow wraps, as wrapping_add() makes it do in the scalar code.
+
+inline __m128i select_sse2(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+inline __m128i clamp_thrust_sse2(__m128i dv, __m128i limit) {
+    const __m128i negative = _mm_srai_epi32(limit, 31);
+    const __m128i below = _mm_cmplt_epi32(dv, limit);
+    const __m128i above = _mm_cmpgt_epi32(dv, limit);
+    return select_sse2(select_sse2(negative, below, above), limit, dv);
+}
+
+// take_whole(): for non-negative `f`, (f + 128) >> 8; otherwise ((f - 128) >> 8) + 1.
+inline __m128i whole_sse2(__m128i f) {
+    const __m128i negative = _mm_srai_epi32(f, 31);
+    const __m128i biased = _mm_sub_epi32(
+            _mm_add_epi32(f, _mm_set1_epi32(128)), _mm_and_si128(negative, _mm_set1_epi32(256)));
+    return _mm_sub_epi32(_mm_srai_epi32(biased, 8), negative);
+}
+
+inline void integrate_sse2(__m128i moving, Fixed* velocity, Fixed* fraction, uint32_t* location) {
+    const __m128i v = _mm_and_si128(moving, _mm_loadu_si128(reinterpret_cast<__m128i*>(velocity)));
+    __m128i f = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<__m128i*>(fraction)), v);
+    const __m128i whole = _mm_and_si128(moving, whole_sse2(f));
+    f = _mm_sub_epi32(f, _mm_slli_epi32(whole, 8));
+    const __m128i l = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<__m128i*>(location)), whole);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(fraction), f);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(location), l);
+}
+
+size_t apply_thrust_sse2(Kinematics& k) {
+    const size_t end = k.size() & ~size_t(3);
+    for (size_t i = 0; i < end; i += 4) {
+        __m128i* vh = reinterpret_cast<__m128i*>(&k.velocity_h[i]);
+        __m128i* vv = reinterpret_cast<__m128i*>(&k.velocity_v[i]);
+        const __m128i dh = clamp_thrust_sse2(
+                _mm_loadu_si128(reinterpret_cast<__m128i*>(&k.dv_h[i])),
+                _mm_loadu_si128(reinterpret_cast<__m128i*>(&k.limit_h[i])));
+        const __m128i dv = clamp_thrust_sse2(
+                _mm_loadu_si128(reinterpret_cast<__m128i*>(&k.dv_v[i])),
+                _mm_loadu_si128(reinterpret_cast<__m128i*>(&k.limit_v[i])));
+        _mm_storeu_si128(vh, _mm_add_epi32(_mm_loadu_si128(vh), dh));
+        _mm_storeu_si128(vv, _mm_add_epi32(_mm_loadu_si128(vv), dv));
+    }
+    return end;
+}
+
+size_t integrate_motion_sse2(Kinematics& k) {
+    const size_t end = k.size() & ~size_t(3);
+    for (size_t i = 0; i < end; i += 4) {
+        const __m128i moving = _mm_loadu_si128(reinterpret_cast<__m128i*>(&k.moving[i]));
+        integrate_sse2(moving, &k.velocity_h[i], &k.fraction_h[i], &k.location_h[i]);
+        integrate_sse2(moving, &k.velocity_v[i], &k.fraction_v[i], &k.location_v[i]);
+    }
+    return end;
+}
+
+#define ANTARES_AVX2 __attribute__((target("avx2")))
+
+ANTARES_AVX2 inline __m256i select_avx2(__m256i mask, __m256i a, __m256i b) {
+    return _mm256_or_si256(_mm256_and_si256(mask, a), _mm256_andnot_si256(mask, b));
+}
+
+ANTARES_AVX2 inline __m256i clamp_thrust_avx2(__m256i dv, __m256i limit) {
+    const __m256i negative = _mm256_srai_epi32(limit, 31);
+    const __m256i below = _mm256_cmpgt_epi32(limit, dv);
+    const __m256i above = _mm256_cmpgt_epi32(dv, limit);
+    return select_avx2(select_avx2(negative, below, above), limit, dv);
+}
+
+ANTARES_AVX2 inline __m256i whole_avx2(__m256i f) {
+    const __m256i negative = _mm256_srai_epi32(f, 31);
+    const __m256i biased = _mm256_sub_epi32(
+            _mm256_add_epi32(f, _mm256_set1_epi32(128)),
+            _mm256_and_si256(negative, _mm256_set1_epi32(256)));
+    return _mm256_sub_epi32(_mm256_srai_epi32(biased, 8), negative);
+}
+
+ANTARES_AVX2 inline void integrate_avx2(
+        __m256i moving, Fixed* velocity, Fixed* fraction, uint32_t* location) {
+    const __m256i v = _mm256_and_si256(
+            moving, _mm256_loadu_si256(reinterpret_cast<__m256i*>(velocity)));
+    __m256i f = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<__m256i*>(fraction)), v);
+    const __m256i whole = _mm256_and_si256(moving, whole_avx2(f));
+    f = _mm256_sub_epi32(f, _mm256_slli_epi32(whole, 8));
+    const __m256i l = _mm256_sub_epi32(
+            _mm256_loadu_si256(reinterpret_cast<__m256i*>(location)), whole);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(fraction), f);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(location), l);
+}
+
+ANTARES_AVX2 size_t apply_thrust_avx2(Kinematics& k) {
+    const size_t end = k.size() & ~size_t(7);
+    for (size_t i = 0; i < end; i += 8) {
+        __m256i* vh = reinterpret_cast<__m256i*>(&k.velocity_h[i]);
+        __m256i* vv = reinterpret_cast<__m256i*>(&k.velocity_v[i]);
+        const __m256i dh = clamp_thrust_avx2(
+                _mm256_loadu_si256(reinterpret_cast<__m256i*>(&k.dv_h[i])),
+                _mm256_loadu_si256(reinterpret_cast<__m256i*>(&k.limit_h[i])));
+        const __m256i dv = clamp_thrust_avx2(
+                _mm256_loadu_si256(reinterpret_cast<__m256i*>(&k.dv_v[i])),
+                _mm256_loadu_si256(reinterpret_cast<__m256i*>(&k.limit_v[i])));
+        _mm256_storeu_si256(vh, _mm256_add_epi32(_mm256_loadu_si256(vh), dh));
+        _mm256_storeu_si256(vv, _mm256_add_epi32(_mm256_loadu_si256(vv), dv));
+    }
+    return end;
+}
+
+ANTARES_AVX2 size_t integrate_motion_avx2(Kinematics& k) {
+    const size_t end = k.size() & ~size_t(7);
+    for (size_t i = 0; i < end; i += 8) {
+        const __m256i moving = _mm256_loadu_si256(reinterpret_cast<__m256i*>(&k.moving[i]));
+        integrate_avx2(moving, &k.velocity_h[i], &k.fraction_h[i], &k.location_h[i]);
+        integrate_avx2(moving, &k.velocity_v[i], &k.fraction_v[i], &k.location_v[i]);
+    }
+    return end;
+}
+
+#undef ANTARES_AVX2
+
+#endif  // ANTARES_KINEMATICS_X86
+
+// Sets up `dv` and `limit` for one entry which is thrusting.
+void aim_thrust(Kinematics& k, size_t i) {
+    Fixed fa, fb, fh, fv, use_thrust;
+    if (k.thrust[i] > 0) {
+        // The difference between the goal vector (at max velocity, along our heading) and our
+        // actual vector is the vector we want to thrust along.
+        GetRotPoint(&fa, &fb, k.direction[i]);
+        fa = mMultiplyFixed(k.max_velocity[i], fa) - k.velocity_h[i];
+        fb = mMultiplyFixed(k.max_velocity[i], fb) - k.velocity_v[i];
+        use_thrust = k.thrust[i];
+    } else {
+        fa = -k.velocity_h[i];
+        fb = -k.velocity_v[i];
+        use_thrust = -k.thrust[i];
+    }
+
+    int16_t angle;
+    if (fa == 0) {
+        angle = (fb < 0) ? 180 : 0;
+    } else {
+        angle = AngleFromSlope(MyFixRatio(fa, fb));
+        if (fa > 0) {
+            angle += 180;
+        }
+        if (angle >= 360) {
+            angle -= 360;
+        }
+    }
+
+    // The most thrust can do along that vector.
+    GetRotPoint(&fh, &fv, angle);
+    k.dv_h[i] = fa;
+    k.dv_v[i] = fb;
+    k.limit_h[i] = mMultiplyFixed(use_thrust, fh);
+    k.limit_v[i] = mMultiplyFixed(use_thrust, fv);
+}
+
+}  // namespace
+
+void Kinematics::load(spaceObjectType* root) {
+    clear();
+    for (spaceObjectType* o = root; o != NULL; o = o->nextObject) {
+        if (o->active != kObjectInUse) {
+            continue;
+        }
+        if (o->entryNumber >= _index.size()) {
+            _index.resize(o->entryNumber + 1, -1);
+        }
+        _index[o->entryNumber] = object.size();
+
+        uint8_t f = 0;
+        if ((o->maxVelocity != 0) || (o->attributes & kCanTurn)) {
+            f |= MOVES;
+        }
+        if (o->attributes & kCanTurn) {
+            f |= TURNS;
+        }
+        if ((o->presenceState == kWarpingPresence) || (o->presenceState == kWarpOutPresence)) {
+            f |= WARPS;
+        }
+
+        object.push_back(o);
+        flags.push_back(f);
+        active.push_back(o->active);
+        location_h.push_back(o->location.h);
+        location_v.push_back(o->location.v);
+        fraction_h.push_back(o->motionFraction.h);
+        fraction_v.push_back(o->motionFraction.v);
+        velocity_h.push_back(o->velocity.h);
+        velocity_v.push_back(o->velocity.v);
+        direction.push_back(o->direction);
+        turn_fraction.push_back(o->turnFraction);
+        turn_velocity.push_back(o->turnVelocity);
+        thrust.push_back(o->thrust);
+        max_velocity.push_back((f & WARPS) ? o->presenceData : o->maxVelocity);
+    }
+    resize(object.size());
+}
+
+void Kinematics::store() const {
+    for (size_t i = 0; i < size(); ++i) {
+        spaceObjectType* o = object[i];
+        o->location.h = location_h[i];
+        o->location.v = location_v[i];
+        o->motionFraction.h = fraction_h[i];
+        o->motionFraction.v = fraction_v[i];
+        o->velocity.h = velocity_h[i];
+        o->velocity.v = velocity_v[i];
+        o->direction = direction[i];
+        o->turnFraction = turn_fraction[i];
+    }
+}
+
+void Kinematics::clear() {
+    resize(0);
+}
+
+void Kinematics::resize(size_t size) {
+    object.resize(size);
+    flags.resize(size);
+    active.resize(size);
+    location_h.resize(size);
+    location_v.resize(size);
+    last_location_h.resize(size);
+    last_location_v.resize(size);
+    fraction_h.resize(size);
+    fraction_v.resize(size);
+    velocity_h.resize(size);
+    velocity_v.resize(size);
+    direction.resize(size);
+    turn_fraction.resize(size);
+    turn_velocity.resize(size);
+    thrust.resize(size);
+    max_velocity.resize(size);
+    moving.resize(size);
+    dv_h.resize(size);
+    dv_v.resize(size);
+    limit_h.resize(size);
+    limit_v.resize(size);
+}
+
+int32_t Kinematics::index_of(const spaceObjectType* o) const {
+    if ((o->entryNumber < 0) || (o->entryNumber >= _index.size())) {
+        return -1;
+    }
+    // Entries are not reset by clear(), so a stale one may point past the end, or at a
+    // different object that has since taken the same slot in the list.
+    int32_t i = _index[o->entryNumber];
+    if ((i < 0) || (i >= size()) || (object[i] != o)) {
+        return -1;
+    }
+    return i;
+}
+
+void Kinematics::save_locations() {
+    copy(location_h.begin(), location_h.end(), last_location_h.begin());
+    copy(location_v.begin(), location_v.end(), last_location_v.begin());
+}
+
+bool KinematicsIsaSupported(KinematicsIsa isa) {
+    switch (isa) {
+      case KINEMATICS_SCALAR:
+        return true;
+#ifdef ANTARES_KINEMATICS_X86
+      case KINEMATICS_SSE2:
+        return __builtin_cpu_supports("sse2");
+      case KINEMATICS_AVX2:
+        return __builtin_cpu_supports("avx2");
+#else
+      case KINEMATICS_SSE2:
+      case KINEMATICS_AVX2:
+        return false;
+#endif
+    }
+    return false;
+}
+
+KinematicsIsa BestKinematicsIsa() {
+    if (KinematicsIsaSupported(KINEMATICS_AVX2)) {
+        return KINEMATICS_AVX2;
+    } else if (KinematicsIsaSupported(KINEMATICS_SSE2)) {
+        return KINEMATICS_SSE2;
+    }
+    return KINEMATICS_SCALAR;
+}
+
+void ApplyThrust(Kinematics& k, KinematicsIsa isa) {
+    size_t done = 0;
+    switch (isa) {
+      case KINEMATICS_SCALAR:
+        break;
+#ifdef ANTARES_KINEMATICS_X86
+      case KINEMATICS_SSE2:
+        done = apply_thrust_sse2(k);
+        break;
+      case KINEMATICS_AVX2:
+        done = apply_thrust_avx2(k);
+        break;
+#else
+      case KINEMATICS_SSE2:
+      case KINEMATICS_AVX2:
+        break;
+#endif
+    }
+    apply_thrust_scalar(done, k.size(), k);
+}
+
+void IntegrateMotion(Kinematics& k, KinematicsIsa isa) {
+    size_t done = 0;
+    switch (isa) {
+      case KINEMATICS_SCALAR:
+        break;
+#ifdef ANTARES_KINEMATICS_X86
+      case KINEMATICS_SSE2:
+        done = integrate_motion_sse2(k);
+        break;
+      case KINEMATICS_AVX2:
+        done = integrate_motion_avx2(k);
+        break;
+#else
+      case KINEMATICS_SSE2:
+      case KINEMATICS_AVX2:
+        break;
+#endif
+    }
+    integrate_motion_scalar(done, k.size(), k);
+}
+
+void MoveKinematics(Kinematics& k) {
+    static const KinematicsIsa isa = BestKinematicsIsa();
+    MoveKinematics(k, isa);
+}
+
+void MoveKinematics(Kinematics& k, KinematicsIsa isa) {
+    // Turning and aiming thrust go through lookup tables, so they stay scalar.  Entries that
+    // are not thrusting get a zero `dv`, which ApplyThrust() leaves at zero.
+    const size_t count = k.size();
+    for (size_t i = 0; i < count; ++i) {
+        k.dv_h[i] = k.dv_v[i] = k.limit_h[i] = k.limit_v[i] = 0;
+        if ((k.active[i] != kObjectInUse) || !(k.flags[i] & Kinematics::MOVES)) {
+            k.moving[i] = 0;
+            continue;
+        }
+        k.moving[i] = -1;
+
+        if (k.flags[i] & Kinematics::TURNS) {
+            k.direction[i] += take_whole(k.turn_fraction[i] += k.turn_velocity[i]);
+            while (k.direction[i] >= ROT_POS) {
+                k.direction[i] -= ROT_POS;
+            }
+            while (k.direction[i] < 0) {
+                k.direction[i] += ROT_POS;
+            }
+        }
+
+        if (k.thrust[i] != 0) {
+            aim_thrust(k, i);
+        }
+    }
+
+    ApplyThrust(k, isa);
+    IntegrateMotion(k, isa);
+}
+
+}  // namespace antares
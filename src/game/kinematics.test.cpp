@@ -0,0 +1,136 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "game/kinematics.hpp"
+
+#include <limits>
+#include <random>
+#include <gmock/gmock.h>
+
+using std::numeric_limits;
+using testing::ElementsAre;
+
+namespace antares {
+namespace {
+
+typedef testing::Test KinematicsTest;
+
+const KinematicsIsa kVectorIsas[] = {KINEMATICS_SSE2, KINEMATICS_AVX2};
+
+// Random values, weighted towards the edge cases of the fixed-point rounding: exact halves,
+// whole numbers, and values near the limits of `Fixed`, where every kernel has to wrap alike.
+class RandomFixed {
+  public:
+    explicit RandomFixed(uint32_t seed): _engine(seed) { }
+
+    Fixed operator()() {
+        switch (_engine() % 5) {
+          case 0: return _engine();
+          case 1: return static_cast<int32_t>(_engine() % 4096) - 2048;
+          case 2: return (static_cast<int32_t>(_engine() % 9) - 4) * 128;
+          case 3: return numeric_limits<Fixed>::max() - (_engine() % 512);
+          default: return numeric_limits<Fixed>::min() + (_engine() % 512);
+        }
+    }
+
+    uint32_t bits() { return _engine(); }
+
+  private:
+    std::mt19937 _engine;
+};
+
+void fill(Kinematics& k, size_t size, uint32_t seed) {
+    RandomFixed random(seed);
+    k.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        k.moving[i] = (random.bits() % 4) ? -1 : 0;
+        k.dv_h[i] = random();
+        k.dv_v[i] = random();
+        k.limit_h[i] = random();
+        k.limit_v[i] = random();
+        k.velocity_h[i] = random();
+        k.velocity_v[i] = random();
+        k.fraction_h[i] = random();
+        k.fraction_v[i] = random();
+        k.location_h[i] = random.bits();
+        k.location_v[i] = random.bits();
+    }
+}
+
+void expect_same(const Kinematics& expected, const Kinematics& actual) {
+    EXPECT_EQ(expected.velocity_h, actual.velocity_h);
+    EXPECT_EQ(expected.velocity_v, actual.velocity_v);
+    EXPECT_EQ(expected.fraction_h, actual.fraction_h);
+    EXPECT_EQ(expected.fraction_v, actual.fraction_v);
+    EXPECT_EQ(expected.location_h, actual.location_h);
+    EXPECT_EQ(expected.location_v, actual.location_v);
+}
+
+TEST_F(KinematicsTest, Rounding) {
+    // Halves round up on both sides of zero.
+    Kinematics k;
+    k.resize(6);
+    const Fixed velocities[] = {127, 128, 384, -128, -129, -384};
+    for (size_t i = 0; i < 6; ++i) {
+        k.moving[i] = -1;
+        k.velocity_h[i] = velocities[i];
+        k.location_h[i] = 100;
+    }
+    IntegrateMotion(k, KINEMATICS_SCALAR);
+    EXPECT_THAT(k.location_h, ElementsAre(100, 99, 98, 100, 101, 101));
+    EXPECT_THAT(k.fraction_h, ElementsAre(127, -128, -128, -128, 127, -128));
+}
+
+TEST_F(KinematicsTest, Clamp) {
+    Kinematics k;
+    k.resize(4);
+    const Fixed dv[] = {500, -500, -500, 500};
+    const Fixed limit[] = {300, -300, 300, -300};
+    for (size_t i = 0; i < 4; ++i) {
+        k.dv_h[i] = dv[i];
+        k.limit_h[i] = limit[i];
+    }
+    ApplyThrust(k, KINEMATICS_SCALAR);
+    EXPECT_THAT(k.velocity_h, ElementsAre(300, -300, -500, 500));
+}
+
+TEST_F(KinematicsTest, VectorMatchesScalar) {
+    for (KinematicsIsa isa: kVectorIsas) {
+        if (!KinematicsIsaSupported(isa)) {
+            continue;
+        }
+        for (uint32_t seed = 0; seed < 1000; ++seed) {
+            // Sizes that are not a multiple of the vector width exercise the scalar tail.
+            const size_t size = seed % 67;
+            Kinematics expected, actual;
+            fill(expected, size, seed);
+            fill(actual, size, seed);
+
+            ApplyThrust(expected, KINEMATICS_SCALAR);
+            ApplyThrust(actual, isa);
+            IntegrateMotion(expected, KINEMATICS_SCALAR);
+            IntegrateMotion(actual, isa);
+
+            SCOPED_TRACE(testing::Message() << "isa " << isa << ", seed " << seed);
+            expect_same(expected, actual);
+        }
+    }
+}
+
+}  // namespace
+}  // namespace antares
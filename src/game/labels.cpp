@@ -26,13 +26,19 @@
 #include "drawing/text.hpp"
 #include "game/cursor.hpp"
 #include "game/globals.hpp"
+#include "game/snapshot.hpp"
+#include "game/space-object.hpp"
 #include "video/driver.hpp"
 
+using sfz::ReadSource;
 using sfz::Rune;
 using sfz::String;
 using sfz::StringSlice;
+using sfz::WriteTarget;
 using sfz::format;
 using sfz::quote;
+using sfz::read;
+using sfz::write;
 using std::max;
 using std::min;
 using std::unique_ptr;
@@ -460,6 +466,65 @@ void Labels::recalc_size(int32_t which) {
     }
 }
 
+void Labels::save(WriteTarget out) {
+    for (int i = 0; i < kMaxLabelNum; ++i) {
+        const screenLabelType& label = data[i];
+        write(out, label.active);
+        if (!label.active) {
+            continue;
+        }
+        write(out, label.where);
+        write(out, label.offset);
+        write(out, label.thisRect);
+        write(out, label.width);
+        write(out, label.height);
+        write(out, label.age);
+        write_snapshot_string(out, label.text);
+        write(out, label.color);
+        write(out, label.killMe);
+        write(out, label.visible);
+        write(out, label.whichObject);
+        write<int32_t>(out, label.object ? label.object->entryNumber : -1);
+        write(out, label.objectLink);
+        write(out, label.lineNum);
+        write(out, label.lineHeight);
+        write(out, label.keepOnScreenAnyway);
+        write(out, label.attachedHintLine);
+        write(out, label.attachedToWhere);
+        write(out, label.retroCount);
+    }
+}
+
+void Labels::restore(ReadSource in) {
+    reset();
+    for (int i = 0; i < kMaxLabelNum; ++i) {
+        screenLabelType& label = data[i];
+        read(in, label.active);
+        if (!label.active) {
+            continue;
+        }
+        read(in, label.where);
+        read(in, label.offset);
+        read(in, label.thisRect);
+        read(in, label.width);
+        read(in, label.height);
+        read(in, label.age);
+        label.text.assign(read_snapshot_string(in));
+        read(in, label.color);
+        read(in, label.killMe);
+        read(in, label.visible);
+        read(in, label.whichObject);
+        label.object = mGetSpaceObjectPtr(read<int32_t>(in));
+        read(in, label.objectLink);
+        read(in, label.lineNum);
+        read(in, label.lineHeight);
+        read(in, label.keepOnScreenAnyway);
+        read(in, label.attachedHintLine);
+        read(in, label.attachedToWhere);
+        read(in, label.retroCount);
+    }
+}
+
 static int32_t String_Count_Lines(const StringSlice& s) {
     static const Rune kCarriageReturn = '\n';
     return 1 + std::count(s.begin(), s.end(), kCarriageReturn);
@@ -44,8 +44,12 @@
 #include "game/motion.hpp"
 #include "game/non-player-ship.hpp"
 #include "game/player-ship.hpp"
+#include "game/profile.hpp"
 #include "game/scenario-maker.hpp"
+#include "game/snapshot.hpp"
+#include "game/space-object.hpp"
 #include "game/starfield.hpp"
+#include "game/sync.hpp"
 #include "game/time.hpp"
 #include "math/units.hpp"
 #include "sound/driver.hpp"
@@ -61,6 +65,8 @@
 #include "ui/screens/play-again.hpp"
 #include "video/driver.hpp"
 
+using sfz::Bytes;
+using sfz::BytesSlice;
 using sfz::Exception;
 using sfz::ScopedFd;
 using sfz::String;
@@ -68,10 +74,14 @@ using sfz::StringSlice;
 using sfz::format;
 using sfz::makedirs;
 using sfz::open;
+using sfz::print;
+using sfz::read;
+using sfz::write;
 using std::max;
 using std::min;
 using std::unique_ptr;
 
+namespace io = sfz::io;
 namespace path = sfz::path;
 
 namespace antares {
@@ -106,6 +116,10 @@ class GamePlay : public Card {
     virtual void gamepad_stick(const GamepadStickEvent& event);
 
   private:
+    void save_snapshot();
+    void resume(BytesSlice snapshot);
+    void check_sync();
+
     enum State {
         PLAYING,
         PAUSED,
@@ -135,6 +149,10 @@ class GamePlay : public Card {
     PlayAgainScreen::Item _play_again;
     PlayerShip _player_ship;
     ReplayBuilder& _replay_builder;
+    SyncDigest _sync_digest;
+    SyncRecorder _sync_recorder;
+    SyncChecker _sync_checker;
+    bool _desynced;
 };
 
 MainPlay::MainPlay(
@@ -160,7 +178,8 @@ void MainPlay::become_front() {
                     Preferences::preferences()->scenario_identifier(),
                     String(u32_to_version(globals()->scenarioFileInfo.version)),
                     _scenario->chapter_number(),
-                    gRandomSeed.seed);
+                    gRandomSeed.seed,
+                    SpaceObjectLimit());
 
             if (Preferences::preferences()->play_idle_music()) {
                 LoadSong(3000);
@@ -270,7 +289,8 @@ GamePlay::GamePlay(
         _decide_cycle(0),
         _last_click_time(0),
         _scenario_check_time(0),
-        _replay_builder(replay_builder) { }
+        _replay_builder(replay_builder),
+        _desynced(false) { }
 
 class PauseScreen : public Card {
   public:
@@ -374,7 +394,11 @@ void GamePlay::become_front() {
         }
         HintLine::reset();
 
-        CheckScenarioConditions(0);
+        if (globals()->gInputSource && globals()->gInputSource->snapshot()) {
+            resume(*globals()->gInputSource->snapshot());
+        } else {
+            CheckScenarioConditions(0);
+        }
         break;
 
       case PAUSED:
@@ -434,6 +458,61 @@ void GamePlay::become_front() {
     }
 }
 
+// Snapshots are taken between decide cycles, so _decide_cycle is always 0 in them.  They go to
+// the replay being recorded, or to the input source, when it asks for one.
+void GamePlay::save_snapshot() {
+    Bytes snapshot;
+    SaveSnapshot(snapshot);
+    _player_ship.save(snapshot);
+    write(snapshot, _scenario_check_time);
+    if (_replay_builder.wants_snapshot()) {
+        _replay_builder.add_snapshot(snapshot);
+        _sync_recorder.reset();
+    }
+    if (globals()->gInputSource && globals()->gInputSource->wants_snapshot()) {
+        globals()->gInputSource->add_snapshot(snapshot);
+    }
+}
+
+// Picks up play from a snapshot, with the clock set as though the game had run up to it.
+void GamePlay::resume(BytesSlice snapshot) {
+    RestoreSnapshot(snapshot);
+    _player_ship.restore(snapshot);
+    read(snapshot, _scenario_check_time);
+    globals()->gLastTime = now_usecs() - (globals()->gGameTime - _scenario_start_time);
+}
+
+// Takes a digest of the game after a decide cycle when the replay being recorded wants one, the
+// sync log is on, or the replay being played has one to check it against.  Only the first
+// mismatch is reported; after that, everything differs.
+void GamePlay::check_sync() {
+    BytesSlice recorded;
+    const bool has_recorded =
+        globals()->gInputSource && globals()->gInputSource->sync(&recorded);
+    if (!_replay_builder.wants_sync() && !sync_log_enabled() && (!has_recorded || _desynced)) {
+        return;
+    }
+
+    ComputeSyncDigest(&_sync_digest);
+    if (sync_log_enabled()) {
+        log_sync_digest(_sync_digest);
+    }
+    if (_replay_builder.wants_sync()) {
+        Bytes data;
+        _sync_recorder.encode(_sync_digest, &data);
+        _replay_builder.add_sync(data);
+    }
+    if (has_recorded && !_desynced) {
+        String mismatch;
+        if (!_sync_checker.check(recorded, _sync_digest, &mismatch)) {
+            print(io::err, format(
+                        "desync at tick {0}: {1}\n",
+                        usecs_to_ticks(globals()->gGameTime), mismatch));
+            _desynced = true;
+        }
+    }
+}
+
 void GamePlay::resign_front() {
     minicomputer_cancel();
 }
@@ -518,8 +597,14 @@ void GamePlay::fire_timer() {
 
         if (unitsToDo > 0) {
             // executed arbitrarily, but at least once every kDecideEveryCycles
-            globals()->starfield.move(unitsToDo);
-            MoveSpaceObjects(unitsToDo);
+            {
+                ProfileTimer timer(PROFILE_STARFIELD);
+                globals()->starfield.move(unitsToDo);
+            }
+            {
+                ProfileTimer timer(PROFILE_MOVE);
+                MoveSpaceObjects(unitsToDo);
+            }
         }
 
         globals()->gGameTime = add_ticks(globals()->gGameTime, unitsToDo);
@@ -528,15 +613,28 @@ void GamePlay::fire_timer() {
             // everything in here gets executed once every kDecideEveryCycles
             _player_paused = false;
 
-            NonplayerShipThink( kDecideEveryCycles);
-            AdmiralThink();
-            ExecuteActionQueue( kDecideEveryCycles);
+            profile_decide_cycle();
+            {
+                ProfileTimer timer(PROFILE_THINK);
+                NonplayerShipThink( kDecideEveryCycles);
+            }
+            {
+                ProfileTimer timer(PROFILE_ADMIRAL);
+                AdmiralThink();
+            }
+            {
+                ProfileTimer timer(PROFILE_ACTIONS);
+                ExecuteActionQueue( kDecideEveryCycles);
+            }
 
-            if (globals()->gInputSource && !globals()->gInputSource->next(_player_ship)) {
-                globals()->gGameOver = 1;
+            {
+                ProfileTimer timer(PROFILE_PLAYER);
+                if (globals()->gInputSource && !globals()->gInputSource->next(_player_ship)) {
+                    globals()->gGameOver = 1;
+                }
+                _replay_builder.next();
+                _player_ship.update(kDecideEveryCycles, _cursor, _entering_message);
             }
-            _replay_builder.next();
-            _player_ship.update(kDecideEveryCycles, _cursor, _entering_message);
 
             if (VideoDriver::driver()->button(0)) {
                 if (_replay) {
@@ -577,13 +675,22 @@ void GamePlay::fire_timer() {
                 _right_mouse_down = false;
             }
 
-            CollideSpaceObjects();
+            {
+                ProfileTimer timer(PROFILE_COLLIDE);
+                CollideSpaceObjects();
+            }
             _decide_cycle = 0;
             _scenario_check_time++;
             if (_scenario_check_time == 30) {
+                ProfileTimer timer(PROFILE_CONDITIONS);
                 _scenario_check_time = 0;
                 CheckScenarioConditions( 0);
             }
+            check_sync();
+            if (_replay_builder.wants_snapshot()
+                    || (globals()->gInputSource && globals()->gInputSource->wants_snapshot())) {
+                save_snapshot();
+            }
         }
         unitsPassed -= unitsToDo;
     }
@@ -609,24 +716,47 @@ void GamePlay::fire_timer() {
         }
     }
 
-    MiniComputerHandleNull(unitsDone);
-
-    Messages::clip();
-    Messages::draw_long_message( unitsDone);
+    {
+        ProfileTimer timer(PROFILE_MINICOMPUTER);
+        MiniComputerHandleNull(unitsDone);
+    }
 
-    update_sector_lines();
-    Beams::update();
-    Labels::update_positions(unitsDone);
-    Labels::update_contents(unitsDone);
-    update_site(_replay);
+    {
+        ProfileTimer timer(PROFILE_LONG_MESSAGE);
+        Messages::clip();
+        Messages::draw_long_message( unitsDone);
+    }
 
-    CullSprites();
+    {
+        ProfileTimer timer(PROFILE_SECTOR_LINES);
+        update_sector_lines();
+    }
+    {
+        ProfileTimer timer(PROFILE_BEAMS);
+        Beams::update();
+    }
+    {
+        ProfileTimer timer(PROFILE_LABELS);
+        Labels::update_positions(unitsDone);
+        Labels::update_contents(unitsDone);
+    }
+    {
+        ProfileTimer timer(PROFILE_SPRITES);
+        update_site(_replay);
+        CullSprites();
+    }
     Labels::show_all();
     Beams::show_all();
     globals()->starfield.show();
 
-    Messages::draw_message_screen(unitsDone);
-    UpdateRadar(unitsDone);
+    {
+        ProfileTimer timer(PROFILE_MESSAGES);
+        Messages::draw_message_screen(unitsDone);
+    }
+    {
+        ProfileTimer timer(PROFILE_RADAR);
+        UpdateRadar(unitsDone);
+    }
     globals()->transitions.update_boolean(unitsDone);
 
     if (globals()->gGameOver > 0) {
@@ -28,14 +28,19 @@
 #include "game/globals.hpp"
 #include "game/labels.hpp"
 #include "game/scenario-maker.hpp"
+#include "game/snapshot.hpp"
 #include "ui/interface-handling.hpp"
 #include "video/driver.hpp"
 
 using sfz::Bytes;
 using sfz::BytesSlice;
 using sfz::Exception;
+using sfz::ReadSource;
 using sfz::String;
 using sfz::StringSlice;
+using sfz::WriteTarget;
+using sfz::read;
+using sfz::write;
 using std::unique_ptr;
 
 namespace utf8 = sfz::utf8;
@@ -484,6 +489,59 @@ int16_t Messages::current() {
     return long_message_data->currentResID;
 }
 
+void Messages::save(WriteTarget out) {
+    std::queue<sfz::String> queued(message_data);
+    write<uint32_t>(out, queued.size());
+    while (!queued.empty()) {
+        write_snapshot_string(out, queued.front());
+        queued.pop();
+    }
+    write(out, time_count);
+
+    const longMessageType& m = *long_message_data;
+    write<int32_t>(out, m.stage);
+    write(out, m.charDelayCount);
+    write(out, m.time);
+    write(out, m.startResID);
+    write(out, m.endResID);
+    write(out, m.currentResID);
+    write(out, m.lastResID);
+    write(out, m.previousStartResID);
+    write(out, m.previousEndResID);
+    write_snapshot_string(out, m.stringMessage);
+    write_snapshot_string(out, m.lastStringMessage);
+    write(out, m.newStringMessage);
+    write(out, m.labelMessage);
+    write(out, m.lastLabelMessage);
+    write(out, m.labelMessageID);
+}
+
+void Messages::restore(ReadSource in) {
+    antares::clear(message_data);
+    for (uint32_t i = read<uint32_t>(in); i > 0; --i) {
+        message_data.push(read_snapshot_string(in));
+    }
+    read(in, time_count);
+
+    longMessageType& m = *long_message_data;
+    m.stage = static_cast<longMessageStageType>(read<int32_t>(in));
+    read(in, m.charDelayCount);
+    read(in, m.time);
+    read(in, m.startResID);
+    read(in, m.endResID);
+    read(in, m.currentResID);
+    read(in, m.lastResID);
+    read(in, m.previousStartResID);
+    read(in, m.previousEndResID);
+    m.stringMessage.assign(read_snapshot_string(in));
+    m.lastStringMessage.assign(read_snapshot_string(in));
+    read(in, m.newStringMessage);
+    read(in, m.labelMessage);
+    read(in, m.lastLabelMessage);
+    read(in, m.labelMessageID);
+    m.retro_text.reset();
+}
+
 //
 // MessageLabel_Set_Special
 //  for ambrosia emergency tutorial; Sets screen label given specially formatted
@@ -1089,7 +1089,7 @@ void MiniComputerExecute( int32_t whichPage, int32_t whichLine, int32_t whichAdm
             if ( whichLine != kMiniScreenNoLineSelected)
             {
                 if ( CountObjectsOfBaseType( -1, -1) <
-                    (kMaxSpaceObject - kMaxShipBuffer))
+                    (SpaceObjectLimit() - kMaxShipBuffer))
                 {
                     if (AdmiralScheduleBuild( whichAdmiral,
                         whichLine - kBuildScreenFirstTypeLine) == false)
@@ -25,9 +25,12 @@
 #include "drawing/pix-table.hpp"
 #include "drawing/sprite-handling.hpp"
 #include "game/globals.hpp"
+#include "game/kinematics.hpp"
 #include "game/non-player-ship.hpp"
 #include "game/player-ship.hpp"
 #include "game/space-object.hpp"
+#include "game/spatial-index.hpp"
+#include "lang/worker-pool.hpp"
 #include "math/macros.hpp"
 #include "math/random.hpp"
 #include "math/rotation.hpp"
@@ -36,23 +39,15 @@
 #include "sound/fx.hpp"
 
 using sfz::Exception;
-using std::unique_ptr;
+using std::vector;
 
 namespace antares {
 
-const int32_t kProximitySuperSize           = 16;   // number of cUnits in cSuperUnits
-const int32_t kProximityGridDataLength      = kProximitySuperSize * kProximitySuperSize;
-const int32_t kProximityUnitAndModulo       = kProximitySuperSize - 1;  // & a int32_t with this and get modulo kCollisionSuperSize
-const int32_t kProximityWidthMultiply       = 4;    // for speed = * kCollisionSuperSize
-
 const int32_t kCollisionUnitBitShift        = 7;    // >> 7 = / 128
 const int32_t kCollisionSuperUnitBitShift   = 11;   // >> 11 = / 2048
-const int32_t kCollisionSuperExtraShift     = kCollisionSuperUnitBitShift - kCollisionUnitBitShift;
 
 const int32_t kDistanceUnitBitShift         = 11;   // >> 14L = / 2048
 const int32_t kDistanceSuperUnitBitShift    = 15;   // >> 18L = / 262144
-const int32_t kDistanceSuperExtraShift      = kDistanceSuperUnitBitShift - kDistanceUnitBitShift;
-const int32_t kDistanceUnitExtraShift       = 0;    // speed from kCollisionSuperUnitBitShift to kDistanceUnitBitShift
 
 const int32_t kNoDir = -1;
 
@@ -63,16 +58,29 @@ const int32_t kConsiderDistanceAttributes = (
 const uint32_t kThinkiverseTopLeft       = (kUniversalCenter - (2 * 65534)); // universe for thinking or owned objects
 const uint32_t kThinkiverseBottomRight   = (kUniversalCenter + (2 * 65534));
 
-static Point            cAdjacentUnits[] = {
-    Point(0, 0),
-    Point(1, 0),
-    Point(-1, 1),
-    Point(0, 1),
-    Point(1, 1)
-};
-
 coordPointType          gGlobalCorner;
-static unique_ptr<proximityUnitType[]> gProximityGrid;
+static Kinematics       gKinematics;
+static SpatialIndex     gCollisionIndex(kCollisionUnitBitShift);
+static SpatialIndex     gDistanceIndex(kDistanceUnitBitShift);
+
+// Below this many objects per thread, the distance pass isn't worth splitting.
+const size_t kMinObjectsPerRange = 128;
+
+struct DistancePair {
+    enum {
+        ENEMIES             = 0x01,
+        A_TARGETS_B         = 0x02,
+        B_TARGETS_A         = 0x04,
+        SAME_CELL_FOES      = 0x08,
+        SAME_CELL_FRIENDS   = 0x10,
+    };
+
+    spaceObjectType*    a;
+    spaceObjectType*    b;
+    uint32_t            distance;
+    uint32_t            flags;
+};
+static vector<vector<DistancePair>> gDistancePairs;
 
 // for the macro mRanged, time is assumed to be a int32_t game ticks, velocity a fixed, result int32_t, scratch fixed
 inline void mRange(int32_t& result, int32_t time, Fixed velocity, Fixed& scratch) {
@@ -82,89 +90,47 @@ inline void mRange(int32_t& result, int32_t time, Fixed velocity, Fixed& scratch
 }
 
 void InitMotion() {
-    int16_t                 x, y, i;
-    proximityUnitType       *p;
-    int32_t                    adjacentAdd = 0, ux, uy, sx, sy;
-
     globals()->gCenterScaleH = (play_screen.width() / 2) * SCALE_SCALE;
     globals()->gCenterScaleV = (play_screen.height() / 2) * SCALE_SCALE;
-
-    gProximityGrid.reset(new proximityUnitType[kProximityGridDataLength]);
-
-    // initialize the proximityGrid & set up the needed lookups (see Notebook 2 p.34)
-    p = gProximityGrid.get();
-    for ( y = 0; y < kProximitySuperSize; y++)
-    {
-        for ( x = 0; x < kProximitySuperSize; x++)
-        {
-            p->nearObject = p->farObject = NULL;
-            adjacentAdd = 0;
-            for ( i = 0; i < kUnitsToCheckNumber; i++)
-            {
-                ux = x;
-                uy = y;
-                sx = sy = 0;
-
-                ux += cAdjacentUnits[i].h;
-                if ( ux < 0)
-                {
-                    ux += kProximitySuperSize;
-                    sx--;
-                } else if ( ux >= kProximitySuperSize)
-                {
-                    ux -= kProximitySuperSize;
-                    sx++;
-                }
-
-                uy += cAdjacentUnits[i].v;
-                if ( uy < 0)
-                {
-                    uy += kProximitySuperSize;
-                    sy--;
-                } else if ( uy >= kProximitySuperSize)
-                {
-                    uy -= kProximitySuperSize;
-                    sy++;
-                }
-                p->unitsToCheck[i].adjacentUnit = (uy << kProximityWidthMultiply) + ux;
-                p->unitsToCheck[i].adjacentUnit -= adjacentAdd;
-
-
-                adjacentAdd += p->unitsToCheck[i].adjacentUnit;
-
-                p->unitsToCheck[i].superOffset.h = sx;
-                p->unitsToCheck[i].superOffset.v = sy;
-            }
-            p++;
-        }
-    }
 }
 
 void ResetMotionGlobals( void)
 {
-    proximityUnitType   *proximityObject;
-    int32_t                i;
-
     gGlobalCorner.h = gGlobalCorner.v = 0;
     globals()->gClosestObject = 0;
     globals()->gFarthestObject = 0;
 
-    proximityObject = gProximityGrid.get();
-    for ( i = 0; i < kProximityGridDataLength; i++)
-    {
-        proximityObject->nearObject = proximityObject->farObject = NULL;
-        proximityObject++;
-    }
+    gCollisionIndex.clear();
+    gDistanceIndex.clear();
 }
 
 void MotionCleanup() {
-    gProximityGrid.reset();
+    gCollisionIndex.clear();
+    gDistanceIndex.clear();
+}
+
+// Where `target` was when the per-object loop of MoveSpaceObjects() reached the object at
+// `index`.  MoveKinematics() has already moved every object for this tick, but objects later
+// in the list used to be moved only after the one at `index` had looked at them, so for those
+// it's their location as of the previous tick.
+static coordPointType KinematicLocation(const spaceObjectType* target, int32_t index) {
+    int32_t i = gKinematics.index_of(target);
+    coordPointType result;
+    if (i < 0) {
+        return target->location;
+    } else if (i > index) {
+        result.h = gKinematics.last_location_h[i];
+        result.v = gKinematics.last_location_v[i];
+    } else {
+        result.h = gKinematics.location_h[i];
+        result.v = gKinematics.location_v[i];
+    }
+    return result;
 }
 
 void MoveSpaceObjects(const int32_t unitsToDo) {
-    int32_t                    i, h, v, jl;
-    Fixed                   fh, fv, fa, fb, useThrust;
-    Fixed                   aFixed;
+    int32_t                    i, h, jl;
+    size_t                  k;
     int16_t                 angle;
     uint32_t                shortDist, thisDist, longDist;
     spaceObjectType         *anObject;
@@ -172,145 +138,28 @@ void MoveSpaceObjects(const int32_t unitsToDo) {
 
     if ( unitsToDo == 0) return;
 
+    gKinematics.load(gRootObject);
     for ( jl = 0; jl < unitsToDo; jl++)
     {
-        anObject = gRootObject;
-        while ( anObject != NULL)
+        gKinematics.save_locations();
+        MoveKinematics(gKinematics);
+
+        for ( k = 0; k < gKinematics.size(); k++)
         {
-            if ( anObject->active == kObjectInUse)
+            if ( gKinematics.active[k] == kObjectInUse)
             {
+                anObject = gKinematics.object[k];
                 baseObject = anObject->baseType;
-
-//              if  ( !( anObject->attributes & kIsStationary))
-                if (( anObject->maxVelocity != 0) || ( anObject->attributes & kCanTurn))
-                {
-                    if ( anObject->attributes & kCanTurn)
-                    {
-                        anObject->turnFraction += anObject->turnVelocity;
-
-                        if ( anObject->turnFraction >= 0)
-                            h = more_evil_fixed_to_long(anObject->turnFraction + mFloatToFixed(0.5));
-                        else
-                            h = more_evil_fixed_to_long(anObject->turnFraction - mFloatToFixed(0.5)) + 1;
-                        anObject->direction += h;
-                        anObject->turnFraction -= mLongToFixed(h);
-
-                        while ( anObject->direction >= ROT_POS)
-                            anObject->direction -= ROT_POS;
-                        while ( anObject->direction < 0)
-                            anObject->direction += ROT_POS;
-                    }
-
-                    if ( anObject->thrust != 0)
-                    {
-                        if ( anObject->thrust > 0)
-                        {
-                            // get the goal dh & dv
-
-                            GetRotPoint(&fa, &fb, anObject->direction);
-
-                            // multiply by max velocity
-
-                            if (/*( anObject->presenceState == kWarpInPresence) ||*/
-                                ( anObject->presenceState == kWarpingPresence) ||
-                                ( anObject->presenceState == kWarpOutPresence))
-                            {
-                                fa = mMultiplyFixed( fa, anObject->presenceData);
-                                fb = mMultiplyFixed( fb, anObject->presenceData);
-                            } else
-                            {
-                                fa = mMultiplyFixed( anObject->maxVelocity, fa);
-                                fb = mMultiplyFixed( anObject->maxVelocity, fb);
-                            }
-
-                            // the difference between our actual vector and our goal vector is our new vector
-
-                            fa = fa - anObject->velocity.h;
-                            fb = fb - anObject->velocity.v;
-
-                            useThrust = anObject->thrust;
-                        } else
-                        {
-                            fa = -anObject->velocity.h;
-                            fb = -anObject->velocity.v;
-//                              useThrust = -(anObject->thrust>>1L);
-                            useThrust = -anObject->thrust;
-                        }
-
-                        // get the angle of our new vector
-
-                        if ( fa == 0)
-                        {
-                            if ( fb < 0)
-                                angle = 180;
-                            else angle = 0;
-                        } else
-                        {
-                            aFixed = MyFixRatio(fa, fb);
-
-                            angle = AngleFromSlope( aFixed);
-                            if ( fa > 0) angle += 180;
-                            if ( angle >= 360) angle -= 360;
-                        }
-
-                        // get the maxthrust of new vector
-
-                        GetRotPoint(&fh, &fv, angle);
-
-                        fh = mMultiplyFixed( useThrust, fh);
-                        fv = mMultiplyFixed( useThrust, fv);
-
-                        // if our new vector excedes our max thrust, it must be limited
-
-                        if ( fh < 0)
-                        {
-                            if ( fa < fh)
-                                fa = fh;
-                        } else
-                        {
-                            if ( fa > fh)
-                                fa = fh;
-                        }
-
-                        if ( fv < 0)
-                        {
-                            if ( fb < fv)
-                                fb = fv;
-                        } else
-                        {
-                            if ( fb > fv)
-                                fb = fv;
-                        }
-
-                        anObject->velocity.h += fa;
-                        anObject->velocity.v += fb;
-
-                    }
-
-                    anObject->motionFraction.h += anObject->velocity.h;
-                    anObject->motionFraction.v += anObject->velocity.v;
-
-                    if ( anObject->motionFraction.h >= 0)
-                        h = more_evil_fixed_to_long(anObject->motionFraction.h + mFloatToFixed(0.5));
-                    else
-                        h = more_evil_fixed_to_long(anObject->motionFraction.h - mFloatToFixed(0.5)) + 1;
-                    anObject->location.h -= h;
-                    anObject->motionFraction.h -= mLongToFixed(h);
-
-                    if ( anObject->motionFraction.v >= 0)
-                        v = more_evil_fixed_to_long(anObject->motionFraction.v + mFloatToFixed(0.5));
-                    else
-                        v = more_evil_fixed_to_long(anObject->motionFraction.v - mFloatToFixed(0.5)) + 1;
-                    anObject->location.v -= v;
-                    anObject->motionFraction.v -= mLongToFixed(v);
-
-                } // if ( object is not stationary)
+                uint32_t& locationH = gKinematics.location_h[k];
+                uint32_t& locationV = gKinematics.location_v[k];
+                Fixed& velocityH = gKinematics.velocity_h[k];
+                Fixed& velocityV = gKinematics.velocity_v[k];
 
 //              if ( anObject->attributes & kIsPlayerShip)
                 if ( anObject == gScrollStarObject)
                 {
-                    gGlobalCorner.h = anObject->location.h - (globals()->gCenterScaleH / gAbsoluteScale);
-                    gGlobalCorner.v = anObject->location.v - (globals()->gCenterScaleV / gAbsoluteScale);
+                    gGlobalCorner.h = locationH - (globals()->gCenterScaleH / gAbsoluteScale);
+                    gGlobalCorner.v = locationV - (globals()->gCenterScaleV / gAbsoluteScale);
                 }
 
                 // check to see if it's out of bounds
@@ -318,32 +167,32 @@ void MoveSpaceObjects(const int32_t unitsToDo) {
                 {
                     if ( !(anObject->attributes & kDoesBounce))
                     {
-                        if (( anObject->location.h < kThinkiverseTopLeft) ||
-                            ( anObject->location.v < kThinkiverseTopLeft) ||
-                            ( anObject->location.h > kThinkiverseBottomRight) ||
-                            ( anObject->location.v > kThinkiverseBottomRight))
+                        if (( locationH < kThinkiverseTopLeft) ||
+                            ( locationV < kThinkiverseTopLeft) ||
+                            ( locationH > kThinkiverseBottomRight) ||
+                            ( locationV > kThinkiverseBottomRight))
                         {
                             anObject->active = kObjectToBeFreed;
                         }
                     } else
                     {
-                        if ( anObject->location.h < kThinkiverseTopLeft)
+                        if ( locationH < kThinkiverseTopLeft)
                         {
-                            anObject->location.h = kThinkiverseTopLeft;
-                            anObject->velocity.h = -anObject->velocity.h;
-                        } else if ( anObject->location.h > kThinkiverseBottomRight)
+                            locationH = kThinkiverseTopLeft;
+                            velocityH = -velocityH;
+                        } else if ( locationH > kThinkiverseBottomRight)
                         {
-                            anObject->location.h = kThinkiverseBottomRight;
-                            anObject->velocity.h = -anObject->velocity.h;
+                            locationH = kThinkiverseBottomRight;
+                            velocityH = -velocityH;
                         }
-                        if ( anObject->location.v < kThinkiverseTopLeft)
+                        if ( locationV < kThinkiverseTopLeft)
                         {
-                            anObject->location.v = kThinkiverseTopLeft;
-                            anObject->velocity.v = -anObject->velocity.v;
-                        } else if ( anObject->location.v > kThinkiverseBottomRight)
+                            locationV = kThinkiverseTopLeft;
+                            velocityV = -velocityV;
+                        } else if ( locationV > kThinkiverseBottomRight)
                         {
-                            anObject->location.v = kThinkiverseBottomRight;
-                            anObject->velocity.v = -anObject->velocity.v;
+                            locationV = kThinkiverseBottomRight;
+                            velocityV = -velocityV;
                         }
 
                     }
@@ -403,42 +252,40 @@ void MoveSpaceObjects(const int32_t unitsToDo) {
                 {
                     if ( anObject->frame.beam.beam != NULL)
                     {
-                        anObject->frame.beam.beam->objectLocation =
-                            anObject->location;
+                        anObject->frame.beam.beam->objectLocation.h = locationH;
+                        anObject->frame.beam.beam->objectLocation.v = locationV;
                         if (( anObject->frame.beam.beam->beamKind ==
                                 eStaticObjectToObjectKind) ||
                                 ( anObject->frame.beam.beam->beamKind ==
                                 eBoltObjectToObjectKind))
                         {
-                            if ( anObject->frame.beam.beam->toObject != NULL)
+                            if (!anObject->frame.beam.beam->toObject.empty())
                             {
                                 spaceObjectType *target =
-                                    anObject->frame.beam.beam->toObject;
+                                    anObject->frame.beam.beam->toObject.get();
 
-                                if ((target->active) &&
-                                    (target->id == anObject->frame.beam.beam->toObjectID))
+                                if ( target != NULL)
                                 {
-                                    anObject->location =
-                                        anObject->frame.beam.beam->objectLocation =
-                                            target->location;
+                                    anObject->frame.beam.beam->objectLocation =
+                                        KinematicLocation(target, k);
+                                    locationH = anObject->frame.beam.beam->objectLocation.h;
+                                    locationV = anObject->frame.beam.beam->objectLocation.v;
                                 } else
                                 {
                                     anObject->active = kObjectToBeFreed;
                                 }
                             }
 
-                            if ( anObject->frame.beam.beam->fromObject != NULL)
+                            if (!anObject->frame.beam.beam->fromObject.empty())
                             {
                                 spaceObjectType *target =
-                                    anObject->frame.beam.beam->fromObject;
-
-                                if ((target->active) &&
-                                    ( target->id == anObject->frame.beam.beam->fromObjectID))
+                                    anObject->frame.beam.beam->fromObject.get();
 
+                                if ( target != NULL)
                                 {
                                     anObject->frame.beam.beam->lastGlobalLocation =
                                         anObject->frame.beam.beam->lastApparentLocation =
-                                            target->location;
+                                            KinematicLocation(target, k);
                                 } else
                                 {
                                     anObject->active = kObjectToBeFreed;
@@ -449,26 +296,26 @@ void MoveSpaceObjects(const int32_t unitsToDo) {
                                 ( anObject->frame.beam.beam->beamKind ==
                                 eBoltObjectToRelativeCoordKind))
                         {
-                            if ( anObject->frame.beam.beam->fromObject != NULL)
+                            if (!anObject->frame.beam.beam->fromObject.empty())
                             {
                                 spaceObjectType *target =
-                                    anObject->frame.beam.beam->fromObject;
+                                    anObject->frame.beam.beam->fromObject.get();
 
-                                if (( target->active) &&
-                                    ( target->id == anObject->frame.beam.beam->fromObjectID))
+                                if ( target != NULL)
                                 {
+                                    coordPointType targetLocation = KinematicLocation(target, k);
                                     anObject->frame.beam.beam->lastGlobalLocation =
                                         anObject->frame.beam.beam->lastApparentLocation =
-                                            target->location;
+                                            targetLocation;
 
-                                    anObject->location.h =
+                                    locationH =
                                         anObject->frame.beam.beam->objectLocation.h =
-                                        target->location.h +
+                                        targetLocation.h +
                                         anObject->frame.beam.beam->toRelativeCoord.h;
 
-                                    anObject->location.v =
+                                    locationV =
                                         anObject->frame.beam.beam->objectLocation.v =
-                                        target->location.v +
+                                        targetLocation.v +
                                         anObject->frame.beam.beam->toRelativeCoord.v;
                                 } else
                                 {
@@ -483,10 +330,11 @@ void MoveSpaceObjects(const int32_t unitsToDo) {
                         throw Exception( "Unexpected error: a beam appears to be missing.");
                     }
                 }
+                gKinematics.active[k] = anObject->active;
             } // if (anObject->active)
-            anObject = anObject->nextObject;
         }
     }
+    gKinematics.store();
 
 // !!!!!!!!
 // nothing below can effect any object actions (expire actions get executed)
@@ -592,15 +440,106 @@ void MoveSpaceObjects(const int32_t unitsToDo) {
     }
 }
 
+static bool CanEngage(const spaceObjectType* a, const spaceObjectType* b) {
+    return !(((a->baseType->buildFlags & kCanOnlyEngage) || (b->baseType->buildFlags & kOnlyEngagedBy))
+            && (((a->baseType->buildFlags & kEngageKeyTagMask) << kEngageKeyTagShift)
+                != (b->baseType->buildFlags & kLevelKeyTagMask)));
+}
+
+static bool ConsidersDistance(const spaceObjectType* o) {
+    return (o->attributes & kCanThink) || (o->attributes & kRemoteOrHuman)
+        || (o->attributes & kHated);
+}
+
+// Works out how each pair of objects in the distance pass affects each other.  Nothing in the
+// distance pass changes what this reads, so it's split across threads.
+static void GatherDistancePairs() {
+    WorkerPool* pool = WorkerPool::pool();
+    gDistancePairs.resize(pool->size());
+    for (vector<DistancePair>& range: gDistancePairs) {
+        range.clear();
+    }
+    pool->run(gDistanceIndex.size(), kMinObjectsPerRange, [](int range, size_t begin, size_t end) {
+        vector<DistancePair>& out = gDistancePairs[range];
+        for (size_t n = begin; n < end; ++n) {
+            spaceObjectType* a = gDistanceIndex.at(n);
+            for (int k = 0; k < SpatialIndex::NEIGHBOR_COUNT; ++k) {
+                SpatialIndex::Span span = gDistanceIndex.candidates(n, k);
+                for (spaceObjectType* const* it = span.begin; it != span.end; ++it) {
+                    spaceObjectType* b = *it;
+                    DistancePair pair = {a, b, 0, 0};
+                    if ((b->owner != a->owner) && ConsidersDistance(a) && ConsidersDistance(b)) {
+                        const uint32_t dh = ABS<int>(b->location.h - a->location.h);
+                        const uint32_t dv = ABS<int>(b->location.v - a->location.v);
+                        if ((dh > kMaximumRelevantDistance) || (dv > kMaximumRelevantDistance)) {
+                            pair.distance = kMaximumRelevantDistanceSquared;
+                        } else {
+                            pair.distance = (dv * dv) + (dh * dh);
+                        }
+                        pair.flags = DistancePair::ENEMIES;
+                        if (CanEngage(a, b) && (b->attributes & kPotentialTarget)) {
+                            pair.flags |= DistancePair::A_TARGETS_B;
+                        }
+                        if (CanEngage(b, a) && (a->attributes & kPotentialTarget)) {
+                            pair.flags |= DistancePair::B_TARGETS_A;
+                        }
+                    } else if (k == 0) {
+                        pair.flags = (a->owner != b->owner) ? DistancePair::SAME_CELL_FOES
+                                                            : DistancePair::SAME_CELL_FRIENDS;
+                    } else {
+                        continue;
+                    }
+                    out.push_back(pair);
+                }
+            }
+        }
+    });
+}
+
+// Applies one pair from GatherDistancePairs().  Pairs must be applied in order: strength
+// accumulates along the chain of pairs, and the first of several equally-close targets wins.
+static void ApplyDistancePair(const DistancePair& pair) {
+    spaceObjectType* a = pair.a;
+    spaceObjectType* b = pair.b;
+    if (pair.flags & DistancePair::ENEMIES) {
+        if (pair.distance < kMaximumRelevantDistanceSquared) {
+            a->seenByPlayerFlags |= b->myPlayerFlag;
+            b->seenByPlayerFlags |= a->myPlayerFlag;
+            if (b->attributes & kHideEffect) {
+                a->runTimeFlags |= kIsHidden;
+            }
+            if (a->attributes & kHideEffect) {
+                b->runTimeFlags |= kIsHidden;
+            }
+        }
+        if ((pair.flags & DistancePair::A_TARGETS_B) && (pair.distance < a->closestDistance)) {
+            a->closestDistance = pair.distance;
+            a->closestObject = b->entryNumber;
+        }
+        if ((pair.flags & DistancePair::B_TARGETS_A) && (pair.distance < b->closestDistance)) {
+            b->closestDistance = pair.distance;
+            b->closestObject = a->entryNumber;
+        }
+        b->localFoeStrength += a->localFriendStrength;
+        b->localFriendStrength += a->localFoeStrength;
+    } else if (pair.flags & DistancePair::SAME_CELL_FOES) {
+        b->localFoeStrength += a->localFriendStrength;
+        b->localFriendStrength += a->localFoeStrength;
+    } else {
+        b->localFoeStrength += a->localFoeStrength;
+        b->localFriendStrength += a->localFriendStrength;
+    }
+}
+
 void CollideSpaceObjects() {
     spaceObjectType         *sObject = NULL, *dObject = NULL, *aObject = NULL, *bObject = NULL,
-                            *player = NULL, *taObject, *tbObject;
-    int32_t                    i = 0, j = 0, k, xs, xe, ys, ye, xd, yd, superx, supery, scaleCalc, difference;
+                            *player = NULL;
+    size_t                  n;
+    int32_t                    i = 0, xs, xe, ys, ye, xd, yd, scaleCalc, difference;
     int16_t                 cs, ce;
     bool                 beamHit;
     uint32_t                distance, dcalc/*,
                             closestDist = kMaximumRelevantDistanceSquared + kMaximumRelevantDistanceSquared*/;
-    proximityUnitType       *proximityObject, *currentProximity;
 
     int32_t                    magicHack1 = 0, magicHack2 = 0, magicHack3 = 0;
     uint64_t                farthestDist, hugeDistance, wideScrap, closestDist;
@@ -614,13 +553,8 @@ void CollideSpaceObjects() {
     globals()->gClosestObject = 0;
     globals()->gFarthestObject = 0;
 
-    // reset the collision grid
-    proximityObject = gProximityGrid.get();
-    for ( i = 0; i < kProximityGridDataLength; i++)
-    {
-        proximityObject->nearObject = proximityObject->farObject = NULL;
-        proximityObject++;
-    }
+    gCollisionIndex.clear();
+    gDistanceIndex.clear();
 
     aObject = gRootObject;
     if ( aObject == NULL) {
@@ -728,36 +662,17 @@ void CollideSpaceObjects() {
             aObject->closestDistance = kMaximumRelevantDistanceSquared;
             aObject->absoluteBounds.right = aObject->absoluteBounds.left = 0;
 
-            // xs = collision unit, xe = super unit
-            xs = aObject->location.h;
-            xs >>= kCollisionUnitBitShift;
-            xe = xs >> kCollisionSuperExtraShift;
-            xs &= kProximityUnitAndModulo;
+            gCollisionIndex.add(aObject);
+            gDistanceIndex.add(aObject);
 
+            // Which repetition of the old 16x16 grid the object's cells fell in.  The admirals
+            // still compare distanceGrid to find objects in the same distance cell.
+            xs = aObject->location.h;
             ys = aObject->location.v;
-            ys >>= kCollisionUnitBitShift;
-            ye = ys >> kCollisionSuperExtraShift;
-            ys &= kProximityUnitAndModulo;
-
-            proximityObject = gProximityGrid.get() + (ys << kProximityWidthMultiply) + xs;
-            aObject->nextNearObject = proximityObject->nearObject;
-            proximityObject->nearObject = aObject;
-            aObject->collisionGrid.h = xe;
-            aObject->collisionGrid.v = ye;
-
-            xe >>= kDistanceUnitExtraShift;
-            xs = xe >> kDistanceSuperExtraShift;
-            xe &= kProximityUnitAndModulo;
-
-            ye >>= kDistanceUnitExtraShift;
-            ys = ye >> kDistanceSuperExtraShift;
-            ye &= kProximityUnitAndModulo;
-
-            proximityObject = gProximityGrid.get() + (ye << kProximityWidthMultiply) + xe;
-            aObject->nextFarObject = proximityObject->farObject;
-            proximityObject->farObject = aObject;
-            aObject->distanceGrid.h = xs;
-            aObject->distanceGrid.v = ys;
+            aObject->collisionGrid.h = xs >> kCollisionSuperUnitBitShift;
+            aObject->collisionGrid.v = ys >> kCollisionSuperUnitBitShift;
+            aObject->distanceGrid.h = xs >> kDistanceSuperUnitBitShift;
+            aObject->distanceGrid.v = ys >> kDistanceSuperUnitBitShift;
 
             if ( !(aObject->attributes & kIsDestination))
                 aObject->seenByPlayerFlags = 0x80000000;
@@ -786,406 +701,236 @@ void CollideSpaceObjects() {
         aObject = aObject->nextObject;
     }
 
-    proximityObject = gProximityGrid.get();
-    for ( j = 0; j < kProximitySuperSize; j++)
+    gCollisionIndex.sort();
+    gDistanceIndex.sort();
+    for ( n = 0; n < gCollisionIndex.size(); n++)
+        gCollisionIndex.at(n)->nextNearObject = gCollisionIndex.next_in_wrapped_cell(n);
+    for ( n = 0; n < gDistanceIndex.size(); n++)
+        gDistanceIndex.at(n)->nextFarObject = gDistanceIndex.next_in_wrapped_cell(n);
+
+    for ( n = 0; n < gCollisionIndex.size(); n++)
     {
-        for ( i = 0; i < kProximitySuperSize; i++)
+        aObject = gCollisionIndex.at(n);
+
+        // this hack is to get the current bounds of the object in question
+        // it could be sped up by accessing the sprite table directly
+        if ((aObject->absoluteBounds.left >= aObject->absoluteBounds.right)
+                && (aObject->sprite != NULL)) {
+            const NatePixTable::Frame& frame
+                = aObject->sprite->table->at(aObject->sprite->whichShape);
+
+            scaleCalc = (frame.width() * aObject->naturalScale);
+            scaleCalc >>= SHIFT_SCALE;
+            aObject->scaledSize.h = scaleCalc;
+            scaleCalc = (frame.height() * aObject->naturalScale);
+            scaleCalc >>= SHIFT_SCALE;
+            aObject->scaledSize.v = scaleCalc;
+
+            scaleCalc = frame.center().h * aObject->naturalScale;
+            scaleCalc >>= SHIFT_SCALE;
+            aObject->scaledCornerOffset.h = -scaleCalc;
+            scaleCalc = frame.center().v * aObject->naturalScale;
+            scaleCalc >>= SHIFT_SCALE;
+            aObject->scaledCornerOffset.v = -scaleCalc;
+
+            aObject->absoluteBounds.left = aObject->location.h +
+                                        aObject->scaledCornerOffset.h;
+            aObject->absoluteBounds.right = aObject->absoluteBounds.left +
+                                        aObject->scaledSize.h;
+            aObject->absoluteBounds.top = aObject->location.v +
+                                        aObject->scaledCornerOffset.v;
+            aObject->absoluteBounds.bottom = aObject->absoluteBounds.top +
+                                        aObject->scaledSize.v;
+        }
+
+        for (int k = 0; k < SpatialIndex::NEIGHBOR_COUNT; ++k)
         {
-            aObject = proximityObject->nearObject;
-            while ( aObject != NULL)
+            SpatialIndex::Span span = gCollisionIndex.candidates(n, k);
+            for (spaceObjectType* const* it = span.begin; it != span.end; ++it)
             {
-                taObject = aObject->nextNearObject;
-
-                // this hack is to get the current bounds of the object in question
-                // it could be sped up by accessing the sprite table directly
-                if ((aObject->absoluteBounds.left >= aObject->absoluteBounds.right)
-                        && (aObject->sprite != NULL)) {
-                    const NatePixTable::Frame& frame
-                        = aObject->sprite->table->at(aObject->sprite->whichShape);
-
-                    scaleCalc = (frame.width() * aObject->naturalScale);
-                    scaleCalc >>= SHIFT_SCALE;
-                    aObject->scaledSize.h = scaleCalc;
-                    scaleCalc = (frame.height() * aObject->naturalScale);
-                    scaleCalc >>= SHIFT_SCALE;
-                    aObject->scaledSize.v = scaleCalc;
-
-                    scaleCalc = frame.center().h * aObject->naturalScale;
-                    scaleCalc >>= SHIFT_SCALE;
-                    aObject->scaledCornerOffset.h = -scaleCalc;
-                    scaleCalc = frame.center().v * aObject->naturalScale;
-                    scaleCalc >>= SHIFT_SCALE;
-                    aObject->scaledCornerOffset.v = -scaleCalc;
-
-                    aObject->absoluteBounds.left = aObject->location.h +
-                                                aObject->scaledCornerOffset.h;
-                    aObject->absoluteBounds.right = aObject->absoluteBounds.left +
-                                                aObject->scaledSize.h;
-                    aObject->absoluteBounds.top = aObject->location.v +
-                                                aObject->scaledCornerOffset.v;
-                    aObject->absoluteBounds.bottom = aObject->absoluteBounds.top +
-                                                aObject->scaledSize.v;
-                }
-
-                currentProximity = proximityObject;
-                for ( k = 0; k < kUnitsToCheckNumber; k++)
+                bObject = *it;
+                // this'll be true even ONLY if BOTH objects are not non-physical dest object
+                if ((( (bObject->attributes | aObject->attributes) & kCanCollide) &&
+                    (( bObject->attributes | aObject->attributes) & kCanBeHit))
+                    /*&& ( bObject->owner != aObject->owner)*/)
                 {
-                    if ( k == 0)
-                    {
-                        bObject = aObject->nextNearObject;
-                        superx = aObject->collisionGrid.h;
-                        supery = aObject->collisionGrid.v;
+                    // this hack is to get the current bounds of the object in question
+                    // it could be sped up by accessing the sprite table directly
+                    if ((bObject->absoluteBounds.left >= bObject->absoluteBounds.right)
+                            && (bObject->sprite != NULL)) {
+                        const NatePixTable::Frame& frame
+                            = bObject->sprite->table->at(bObject->sprite->whichShape);
+
+                        scaleCalc = (frame.width() * bObject->naturalScale);
+                        scaleCalc >>= SHIFT_SCALE;
+                        bObject->scaledSize.h = scaleCalc;
+                        scaleCalc = (frame.height() * bObject->naturalScale);
+                        scaleCalc >>= SHIFT_SCALE;
+                        bObject->scaledSize.v = scaleCalc;
+
+                        scaleCalc = frame.center().h * bObject->naturalScale;
+                        scaleCalc >>= SHIFT_SCALE;
+                        bObject->scaledCornerOffset.h = -scaleCalc;
+                        scaleCalc = frame.center().v * bObject->naturalScale;
+                        scaleCalc >>= SHIFT_SCALE;
+                        bObject->scaledCornerOffset.v = -scaleCalc;
+
+                        bObject->absoluteBounds.left = bObject->location.h +
+                                                    bObject->scaledCornerOffset.h;
+                        bObject->absoluteBounds.right = bObject->absoluteBounds.left +
+                                                    bObject->scaledSize.h;
+                        bObject->absoluteBounds.top = bObject->location.v +
+                                                    bObject->scaledCornerOffset.v;
+                        bObject->absoluteBounds.bottom = bObject->absoluteBounds.top +
+                                                    bObject->scaledSize.v;
                     }
-                    else
+                    if ( aObject->owner != bObject->owner)
                     {
-                        if (( proximityObject->unitsToCheck[k].adjacentUnit > 256) ||
-                            ( proximityObject->unitsToCheck[k].adjacentUnit < -256))
+//                                  bObject->foeStrength  += aObject->baseType->offenseValue;
+                        if  (!(( bObject->attributes | aObject->attributes) & kIsBeam))
                         {
-                            throw Exception(
-                                    "Internal error occurred during processing of adjacent "
-                                    "proximity units");
-                        }
-                        currentProximity += proximityObject->unitsToCheck[k].adjacentUnit;
-                        bObject = currentProximity->nearObject;
-                        superx = aObject->collisionGrid.h + proximityObject->unitsToCheck[k].superOffset.h;
-                        supery = aObject->collisionGrid.v + proximityObject->unitsToCheck[k].superOffset.v;
-                    }
-                    if (( superx >= 0) && ( supery >= 0))
-                    {
-                        while ( bObject != NULL)
+                            dObject = aObject;
+                            sObject = bObject;
+                            if (!(( sObject->absoluteBounds.right < dObject->absoluteBounds.left) ||
+                                ( sObject->absoluteBounds.left > dObject->absoluteBounds.right) ||
+                                ( sObject->absoluteBounds.bottom < dObject->absoluteBounds.top) ||
+                                ( sObject->absoluteBounds.top > dObject->absoluteBounds.bottom)))
+//                                  if ( aObject->entryNumber != 0)
+                            {
+                                if (( dObject->attributes & kCanBeHit) && ( sObject->attributes & kCanCollide))
+                                    HitObject( dObject, sObject);
+                                if (( sObject->attributes & kCanBeHit) && ( dObject->attributes & kCanCollide))
+                                    HitObject( sObject, dObject);
+                            }
+                        } else
                         {
+                            if ( bObject->attributes & kIsBeam)
+                            {
+                                sObject = bObject;
+                                dObject = aObject;
+                            } else
+                            {
+                                sObject = aObject;
+                                dObject = bObject;
+                            }
 
-                            tbObject = bObject->nextNearObject;
-                            // this'll be true even ONLY if BOTH objects are not non-physical dest object
-                            if ((( (bObject->attributes | aObject->attributes) & kCanCollide) &&
-                                (( bObject->attributes | aObject->attributes) & kCanBeHit)) &&
-                                /*( bObject->owner != aObject->owner) &&*/ ( bObject->collisionGrid.h ==
-                                superx) && ( bObject->collisionGrid.v == supery))
+                            xs = sObject->location.h;
+                            ys = sObject->location.v;
+                            xe = sObject->frame.beam.beam->lastGlobalLocation.h;
+                            ye = sObject->frame.beam.beam->lastGlobalLocation.v;
+
+                            cs = mClipCode( xs, ys, dObject->absoluteBounds);
+                            ce = mClipCode( xe, ye, dObject->absoluteBounds);
+                            beamHit = true;
+                            if ( sObject->active == kObjectToBeFreed)
+                            {
+                                cs = ce = 1;
+                                beamHit = false;
+                            }
+
+                            while ( cs | ce)
                             {
-                                // this hack is to get the current bounds of the object in question
-                                // it could be sped up by accessing the sprite table directly
-                                if ((bObject->absoluteBounds.left >= bObject->absoluteBounds.right)
-                                        && (bObject->sprite != NULL)) {
-                                    const NatePixTable::Frame& frame
-                                        = bObject->sprite->table->at(bObject->sprite->whichShape);
-
-                                    scaleCalc = (frame.width() * bObject->naturalScale);
-                                    scaleCalc >>= SHIFT_SCALE;
-                                    bObject->scaledSize.h = scaleCalc;
-                                    scaleCalc = (frame.height() * bObject->naturalScale);
-                                    scaleCalc >>= SHIFT_SCALE;
-                                    bObject->scaledSize.v = scaleCalc;
-
-                                    scaleCalc = frame.center().h * bObject->naturalScale;
-                                    scaleCalc >>= SHIFT_SCALE;
-                                    bObject->scaledCornerOffset.h = -scaleCalc;
-                                    scaleCalc = frame.center().v * bObject->naturalScale;
-                                    scaleCalc >>= SHIFT_SCALE;
-                                    bObject->scaledCornerOffset.v = -scaleCalc;
-
-                                    bObject->absoluteBounds.left = bObject->location.h +
-                                                                bObject->scaledCornerOffset.h;
-                                    bObject->absoluteBounds.right = bObject->absoluteBounds.left +
-                                                                bObject->scaledSize.h;
-                                    bObject->absoluteBounds.top = bObject->location.v +
-                                                                bObject->scaledCornerOffset.v;
-                                    bObject->absoluteBounds.bottom = bObject->absoluteBounds.top +
-                                                                bObject->scaledSize.v;
+                                if ( cs & ce)
+                                {
+                                    beamHit = false;
+                                    break;
                                 }
-                                if ( aObject->owner != bObject->owner)
+                                xd = xe - xs;
+                                yd = ye - ys;
+                                if ( cs)
                                 {
-//                                  bObject->foeStrength  += aObject->baseType->offenseValue;
-                                    if  (!(( bObject->attributes | aObject->attributes) & kIsBeam))
+                                    if ( cs & 8)
                                     {
-                                        dObject = aObject;
-                                        sObject = bObject;
-                                        if (!(( sObject->absoluteBounds.right < dObject->absoluteBounds.left) ||
-                                            ( sObject->absoluteBounds.left > dObject->absoluteBounds.right) ||
-                                            ( sObject->absoluteBounds.bottom < dObject->absoluteBounds.top) ||
-                                            ( sObject->absoluteBounds.top > dObject->absoluteBounds.bottom)))
-    //                                  if ( aObject->entryNumber != 0)
-                                        {
-                                            if (( dObject->attributes & kCanBeHit) && ( sObject->attributes & kCanCollide))
-                                                HitObject( dObject, sObject);
-                                            if (( sObject->attributes & kCanBeHit) && ( dObject->attributes & kCanCollide))
-                                                HitObject( sObject, dObject);
-                                        }
+                                        ys += yd * ( dObject->absoluteBounds.left - xs) / xd;
+                                        xs = dObject->absoluteBounds.left;
                                     } else
+                                    if ( cs & 4)
                                     {
-                                        if ( bObject->attributes & kIsBeam)
-                                        {
-                                            sObject = bObject;
-                                            dObject = aObject;
-                                        } else
-                                        {
-                                            sObject = aObject;
-                                            dObject = bObject;
-                                        }
-
-                                        xs = sObject->location.h;
-                                        ys = sObject->location.v;
-                                        xe = sObject->frame.beam.beam->lastGlobalLocation.h;
-                                        ye = sObject->frame.beam.beam->lastGlobalLocation.v;
-
-                                        cs = mClipCode( xs, ys, dObject->absoluteBounds);
-                                        ce = mClipCode( xe, ye, dObject->absoluteBounds);
-                                        beamHit = true;
-                                        if ( sObject->active == kObjectToBeFreed)
-                                        {
-                                            cs = ce = 1;
-                                            beamHit = false;
-                                        }
-
-                                        while ( cs | ce)
-                                        {
-                                            if ( cs & ce)
-                                            {
-                                                beamHit = false;
-                                                break;
-                                            }
-                                            xd = xe - xs;
-                                            yd = ye - ys;
-                                            if ( cs)
-                                            {
-                                                if ( cs & 8)
-                                                {
-                                                    ys += yd * ( dObject->absoluteBounds.left - xs) / xd;
-                                                    xs = dObject->absoluteBounds.left;
-                                                } else
-                                                if ( cs & 4)
-                                                {
-                                                    ys += yd * ( dObject->absoluteBounds.right - 1 - xs) / xd;
-                                                    xs = dObject->absoluteBounds.right - 1;
-                                                } else
-                                                if ( cs & 2)
-                                                {
-                                                    xs += xd * ( dObject->absoluteBounds.top - ys) / yd;
-                                                    ys = dObject->absoluteBounds.top;
-                                                } else
-                                                if ( cs & 1)
-                                                {
-                                                    xs += xd * ( dObject->absoluteBounds.bottom - 1 - ys) / yd;
-                                                    ys = dObject->absoluteBounds.bottom - 1;
-                                                }
-                                                cs = mClipCode( xs, ys, dObject->absoluteBounds);
-                                            } else if ( ce)
-                                            {
-                                                if ( ce & 8)
-                                                {
-                                                    ye += yd * ( dObject->absoluteBounds.left - xe) / xd;
-                                                    xe = dObject->absoluteBounds.left;
-                                                } else
-                                                if ( ce & 4)
-                                                {
-                                                    ye += yd * ( dObject->absoluteBounds.right - 1 - xe) / xd;
-                                                    xe = dObject->absoluteBounds.right - 1;
-                                                } else
-                                                if ( ce & 2)
-                                                {
-                                                    xe += xd * ( dObject->absoluteBounds.top - ye) / yd;
-                                                    ye = dObject->absoluteBounds.top;
-                                                } else
-                                                if ( ce & 1)
-                                                {
-                                                    xe += xd * ( dObject->absoluteBounds.bottom - 1 - ye) / yd;
-                                                    ye = dObject->absoluteBounds.bottom - 1;
-                                                }
-                                                ce = mClipCode( xe, ye, dObject->absoluteBounds);
-                                            }
-                                        }
-                                        if ( beamHit)
-                                        {
-                                            HitObject( dObject, sObject);
-                                        }
+                                        ys += yd * ( dObject->absoluteBounds.right - 1 - xs) / xd;
+                                        xs = dObject->absoluteBounds.right - 1;
+                                    } else
+                                    if ( cs & 2)
+                                    {
+                                        xs += xd * ( dObject->absoluteBounds.top - ys) / yd;
+                                        ys = dObject->absoluteBounds.top;
+                                    } else
+                                    if ( cs & 1)
+                                    {
+                                        xs += xd * ( dObject->absoluteBounds.bottom - 1 - ys) / yd;
+                                        ys = dObject->absoluteBounds.bottom - 1;
                                     }
-                                } else
+                                    cs = mClipCode( xs, ys, dObject->absoluteBounds);
+                                } else if ( ce)
                                 {
-//                                  bObject->friendStrength += aObject->baseType->offenseValue;
-//                                  bObject->friendStrength += kFixedOne;
-                                }
-
-                                // check to see if the 2 objects occupy same physical space
-                                if  (((bObject->attributes & aObject->attributes) & kOccupiesSpace) &&
-                                    ( bObject->owner != aObject->owner))
-                                {
-                                    dObject = aObject;
-                                    sObject = bObject;
-                                    if (!(( sObject->absoluteBounds.right < dObject->absoluteBounds.left) ||
-                                        ( sObject->absoluteBounds.left > dObject->absoluteBounds.right) ||
-                                        ( sObject->absoluteBounds.bottom < dObject->absoluteBounds.top) ||
-                                        ( sObject->absoluteBounds.top > dObject->absoluteBounds.bottom)))
+                                    if ( ce & 8)
+                                    {
+                                        ye += yd * ( dObject->absoluteBounds.left - xe) / xd;
+                                        xe = dObject->absoluteBounds.left;
+                                    } else
+                                    if ( ce & 4)
+                                    {
+                                        ye += yd * ( dObject->absoluteBounds.right - 1 - xe) / xd;
+                                        xe = dObject->absoluteBounds.right - 1;
+                                    } else
+                                    if ( ce & 2)
                                     {
-                                        CorrectPhysicalSpace( aObject, bObject); // move them back till they don't touch
+                                        xe += xd * ( dObject->absoluteBounds.top - ye) / yd;
+                                        ye = dObject->absoluteBounds.top;
                                     } else
+                                    if ( ce & 1)
                                     {
-                                        aObject->collideObject = bObject->collideObject = NULL;
+                                        xe += xd * ( dObject->absoluteBounds.bottom - 1 - ye) / yd;
+                                        ye = dObject->absoluteBounds.bottom - 1;
                                     }
+                                    ce = mClipCode( xe, ye, dObject->absoluteBounds);
                                 }
-                            // one or both objects is non-physical
-                            } else if (( bObject->collisionGrid.h ==
-                                superx) && ( bObject->collisionGrid.v == supery))
+                            }
+                            if ( beamHit)
                             {
-                                if ( aObject->owner != bObject->owner)
-                                {
-//                                  bObject->foeStrength  += aObject->baseType->offenseValue;
-                                } else
-                                {
+                                HitObject( dObject, sObject);
+                            }
+                        }
+                    } else
+                    {
 //                                  bObject->friendStrength += aObject->baseType->offenseValue;
 //                                  bObject->friendStrength += kFixedOne;
-                                }
-                            }
-                            bObject = tbObject;
+                    }
+
+                    // check to see if the 2 objects occupy same physical space
+                    if  (((bObject->attributes & aObject->attributes) & kOccupiesSpace) &&
+                        ( bObject->owner != aObject->owner))
+                    {
+                        dObject = aObject;
+                        sObject = bObject;
+                        if (!(( sObject->absoluteBounds.right < dObject->absoluteBounds.left) ||
+                            ( sObject->absoluteBounds.left > dObject->absoluteBounds.right) ||
+                            ( sObject->absoluteBounds.bottom < dObject->absoluteBounds.top) ||
+                            ( sObject->absoluteBounds.top > dObject->absoluteBounds.bottom)))
+                        {
+                            CorrectPhysicalSpace( aObject, bObject); // move them back till they don't touch
+                        } else
+                        {
+                            aObject->collideObject = bObject->collideObject = NULL;
                         }
                     }
                 }
-                aObject = taObject;
             }
-            proximityObject++;
         }
     }
 
-    proximityObject = gProximityGrid.get();
-    for ( j = 0; j < kProximitySuperSize; j++)
+    GatherDistancePairs();
+    for ( i = 0; i < gDistancePairs.size(); i++)
     {
-        for ( i = 0; i < kProximitySuperSize; i++)
+        for ( const DistancePair& pair: gDistancePairs[i])
         {
-            aObject = proximityObject->farObject;
-            while ( aObject != NULL)
-            {
-//              aObject->friendStrength += aObject->baseType->offenseValue;
-//              aObject->friendStrength += kFixedOne;
-                taObject = aObject->nextFarObject;
-                currentProximity = proximityObject;
-                for ( k = 0; k < kUnitsToCheckNumber; k++)
-                {
-                    if ( k == 0)
-                    {
-                        bObject = aObject->nextFarObject;
-                        superx = aObject->distanceGrid.h;
-                        supery = aObject->distanceGrid.v;
-                    }
-                    else
-                    {
-                        currentProximity += proximityObject->unitsToCheck[k].adjacentUnit;
-                        bObject = currentProximity->farObject;
-                        superx = aObject->distanceGrid.h + proximityObject->unitsToCheck[k].superOffset.h;
-                        supery = aObject->distanceGrid.v + proximityObject->unitsToCheck[k].superOffset.v;
-                    }
-                    if (( superx >= 0) && ( supery >= 0))
-                    {
-                        while ( bObject != NULL)
-                        {
-                            tbObject = bObject->nextFarObject;
-                            if (( bObject->owner != aObject->owner) && ( bObject->distanceGrid.h ==
-                                superx) && ( bObject->distanceGrid.v == supery) &&
-                                (( bObject->attributes & kCanThink) ||
-                                ( bObject->attributes & kRemoteOrHuman) ||
-                                ( bObject->attributes & kHated)) &&
-                                (( aObject->attributes & kCanThink) ||
-                                ( aObject->attributes & kRemoteOrHuman) ||
-                                ( aObject->attributes & kHated)) /*&&
-                                ( !(( aObject->attributes & bObject->attributes) & kIsGuided))*/)
-                            {
-                                difference = ABS<int>( bObject->location.h - aObject->location.h);
-                                dcalc = difference;
-                                difference =  ABS<int>( bObject->location.v - aObject->location.v);
-                                distance = difference;
-                                if (( dcalc > kMaximumRelevantDistance) ||
-                                    ( distance > kMaximumRelevantDistance))
-                                    distance = kMaximumRelevantDistanceSquared;
-                                else distance = distance * distance + dcalc * dcalc;
-
-                                if ( distance < kMaximumRelevantDistanceSquared)
-                                {
-                                    aObject->seenByPlayerFlags |= bObject->myPlayerFlag;
-                                    bObject->seenByPlayerFlags |= aObject->myPlayerFlag;
-
-                                    if ( bObject->attributes & kHideEffect)
-                                    {
-                                        aObject->runTimeFlags |= kIsHidden;
-                                    }
-
-                                    if ( aObject->attributes & kHideEffect)
-                                    {
-                                        bObject->runTimeFlags |= kIsHidden;
-                                    }
-                                }
-
-                                if  (
-                                        (
-                                            (aObject->baseType->buildFlags & kCanOnlyEngage) ||
-                                            (bObject->baseType->buildFlags & kOnlyEngagedBy)
-                                        ) &&
-                                        (
-                                            (
-                                                (aObject->baseType->buildFlags & kEngageKeyTagMask)
-                                                << kEngageKeyTagShift
-                                            ) !=
-                                            (
-                                                bObject->baseType->buildFlags & kLevelKeyTagMask
-                                            )
-                                        )
-                                    ) goto hackANoEngageMatch;
-
-                                if (( distance < aObject->closestDistance) && (bObject->attributes & kPotentialTarget))
-                                {
-                                    aObject->closestDistance = distance;
-                                    aObject->closestObject = bObject->entryNumber;
-                                }
-
-                            hackANoEngageMatch:
-                                if  (
-                                        (
-                                            (bObject->baseType->buildFlags & kCanOnlyEngage) ||
-                                            (aObject->baseType->buildFlags & kOnlyEngagedBy)
-                                        ) &&
-                                        (
-                                            (
-                                                (bObject->baseType->buildFlags & kEngageKeyTagMask)
-                                                << kEngageKeyTagShift
-                                            ) !=
-                                            (
-                                                aObject->baseType->buildFlags & kLevelKeyTagMask
-                                            )
-                                        )
-                                    ) goto hackBNoEngageMatch;
-
-                                if (( distance < bObject->closestDistance) && ( aObject->attributes & kPotentialTarget))
-                                {
-                                    bObject->closestDistance = distance;
-                                    bObject->closestObject = aObject->entryNumber;
-                                }
-                            hackBNoEngageMatch:
-                                bObject->localFoeStrength += aObject->localFriendStrength;
-                                bObject->localFriendStrength += aObject->localFoeStrength;
-
-                            } else if (( bObject->distanceGrid.h ==
-                                superx) && ( bObject->distanceGrid.v == supery) && ( k == 0))
-                            {
-                                if ( aObject->owner != bObject->owner)
-                                {
-                                    bObject->localFoeStrength += aObject->localFriendStrength;
-                                    bObject->localFriendStrength += aObject->localFoeStrength;
-                                } else
-                                {
-                                    bObject->localFoeStrength += aObject->localFoeStrength;
-                                    bObject->localFriendStrength += aObject->localFriendStrength;
-                                }
-                            }
-                            bObject = tbObject;
-                        }
-                    }
-                }
-                aObject = taObject;
-            }
-            proximityObject++;
+            ApplyDistancePair(pair);
         }
     }
 
 // here, it doesn't matter in what order we step through the table
     dcalc = 1ul << globals()->gPlayerAdmiralNumber;
 
-    for (i = 0; i < kMaxSpaceObject; i++) {
+    for (i = NextSpaceObject(-1); i >= 0; i = NextSpaceObject(i)) {
         aObject = mGetSpaceObjectPtr(i);
         if (aObject->active == kObjectToBeFreed)
         {
@@ -1195,62 +940,14 @@ void CollideSpaceObjects() {
                 {
                     aObject->frame.beam.beam->killMe = true;
                 }
-                aObject->active = kObjectAvailable;
-                aObject->attributes = 0;
-                aObject->nextNearObject = aObject->nextFarObject = NULL;
-                if ( aObject->previousObject != NULL)
-                {
-                    bObject = aObject->previousObject;
-                    bObject->nextObject = aObject->nextObject;
-                    bObject->nextObjectNumber = aObject->nextObjectNumber;
-                }
-                if ( aObject->nextObject != NULL)
-                {
-                    bObject = aObject->nextObject;
-                    bObject->previousObject = aObject->previousObject;
-                    bObject->previousObjectNumber = aObject->previousObjectNumber;
-                }
-                if ( gRootObject == aObject)
-                {
-                    gRootObject = aObject->nextObject;
-                    gRootObjectNumber = aObject->nextObjectNumber;
-                }
-                aObject->nextObject = NULL;
-                aObject->nextObjectNumber = -1;
-                aObject->previousObject = NULL;
-                aObject->previousObjectNumber = -1;
             }else
             {
-                aObject->active = kObjectAvailable;
                 if ( aObject->sprite != NULL)
                 {
                     aObject->sprite->killMe = true;
                 }
-                aObject->attributes = 0;
-                aObject->nextNearObject = aObject->nextFarObject = NULL;
-                if ( aObject->previousObject != NULL)
-                {
-                    bObject = aObject->previousObject;
-                    bObject->nextObject = aObject->nextObject;
-                    bObject->nextObjectNumber = aObject->nextObjectNumber;
-                }
-                if ( aObject->nextObject != NULL)
-                {
-                    bObject = aObject->nextObject;
-                    bObject->previousObject = aObject->previousObject;
-                    bObject->previousObjectNumber = aObject->previousObjectNumber;
-                }
-                if ( gRootObject == aObject)
-                {
-                    gRootObject = aObject->nextObject;
-                    gRootObjectNumber = aObject->nextObjectNumber;
-                }
-                aObject->nextObject = NULL;
-                aObject->nextObjectNumber = -1;
-                aObject->previousObject = NULL;
-                aObject->previousObjectNumber = -1;
             }
-
+            FreeSpaceObject(aObject);
         }
         if ( aObject->active)
         {
@@ -1275,7 +972,6 @@ void CollideSpaceObjects() {
         }
         aObject->lastLocation = aObject->location;
         aObject->lastDir = aObject->direction;
-        aObject++;
     }
 }
 
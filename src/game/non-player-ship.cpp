@@ -18,6 +18,9 @@
 
 #include "game/non-player-ship.hpp"
 
+#include <string.h>
+#include <vector>
+
 #include "config/keys.hpp"
 #include "data/string-list.hpp"
 #include "drawing/color.hpp"
@@ -29,6 +32,7 @@
 #include "game/scenario-maker.hpp"
 #include "game/space-object.hpp"
 #include "game/starfield.hpp"
+#include "lang/worker-pool.hpp"
 #include "math/macros.hpp"
 #include "math/random.hpp"
 #include "math/rotation.hpp"
@@ -39,6 +43,7 @@
 
 using sfz::Exception;
 using sfz::StringSlice;
+using std::vector;
 
 namespace antares {
 
@@ -62,6 +67,8 @@ const int32_t kWarpInEnergyFactor   = 3;
 
 const int32_t kDefaultTurnRate      = 0x00000200;
 
+const size_t kMinThinkersPerRange   = 32;
+
 enum {
     kFriendlyColor  = GREEN,
     kHostileColor   = RED,
@@ -88,6 +95,166 @@ spaceObjectType *HackNewNonplayerShip( int32_t owner, int16_t type, Rect *bounds
 
 #ifdef kUseOldThinking
 #else   // if NOT kUseOldThinking
+
+// ThinkObjectNormalPresence() is the bulk of the work in NonplayerShipThink(), and mostly it
+// only writes to the object doing the thinking.  So, before the serial pass over the objects,
+// we run it ahead of time for each object, in parallel, on a copy of the object.  When the
+// serial pass reaches the object, if neither it nor any object it looked at has changed since,
+// the copy is exactly what thinking serially would have produced, and it's used instead.
+
+// The fields of another object that ThinkObjectNormalPresence() can read.
+struct ThinkView {
+    spaceObjectType*    object;
+    uint32_t            attributes;
+    int16_t             active;
+    int32_t             id;
+    int32_t             owner;
+    coordPointType      location;
+    fixedPointType      velocity;
+    int32_t             direction;
+    int32_t             cloakState;
+    int32_t             health;
+    int32_t             longestWeaponRange;
+    uint32_t            keysDown;
+    int32_t             destinationObject;
+    int32_t             destObjectID;
+    uint32_t            seenByPlayerFlags;
+};
+
+// Objects read: closest object, target, destination, and destination's destination.
+const int kMaxThinkViews = 4;
+
+struct ThinkPlan {
+    spaceObjectType*    object;
+    bool                ready;
+    spaceObjectType     before;
+    spaceObjectType     after;
+    uint32_t            keysDown;
+    int                 viewCount;
+    ThinkView           views[kMaxThinkViews];
+};
+
+static bool gThinkAhead = true;
+static vector<spaceObjectType*> gThinkers;
+static vector<ThinkPlan> gThinkPlans;
+
+static void CaptureThinkView(spaceObjectType* object, ThinkView* view) {
+    view->object = object;
+    view->attributes = object->attributes;
+    view->active = object->active;
+    view->id = object->id;
+    view->owner = object->owner;
+    view->location = object->location;
+    view->velocity = object->velocity;
+    view->direction = object->direction;
+    view->cloakState = object->cloakState;
+    view->health = object->health;
+    view->longestWeaponRange = object->longestWeaponRange;
+    view->keysDown = object->keysDown;
+    view->destinationObject = object->destinationObject;
+    view->destObjectID = object->destObjectID;
+    view->seenByPlayerFlags = object->seenByPlayerFlags;
+}
+
+static bool ThinkViewIsCurrent(const ThinkView& view) {
+    const spaceObjectType* object = view.object;
+    return (view.attributes == object->attributes)
+        && (view.active == object->active)
+        && (view.id == object->id)
+        && (view.owner == object->owner)
+        && (view.location.h == object->location.h)
+        && (view.location.v == object->location.v)
+        && (view.velocity.h == object->velocity.h)
+        && (view.velocity.v == object->velocity.v)
+        && (view.direction == object->direction)
+        && (view.cloakState == object->cloakState)
+        && (view.health == object->health)
+        && (view.longestWeaponRange == object->longestWeaponRange)
+        && (view.keysDown == object->keysDown)
+        && (view.destinationObject == object->destinationObject)
+        && (view.destObjectID == object->destObjectID)
+        && (view.seenByPlayerFlags == object->seenByPlayerFlags);
+}
+
+static bool AddThinkView(ThinkPlan* plan, spaceObjectType* object) {
+    if (object == NULL) {
+        return true;
+    } else if (object == plan->object) {
+        // Thinking serially, the object would see its own changes as it made them.
+        return false;
+    }
+    CaptureThinkView(object, &plan->views[plan->viewCount++]);
+    return true;
+}
+
+// Thinks for plan->object on a copy, if ThinkObjectNormalPresence() can run without touching
+// anything but the copy.  It can't when the object might toggle its autopilot or run its
+// arrive action, or if it looks at itself through another reference.
+static void ThinkAhead(ThinkPlan* plan, int32_t timePass) {
+    spaceObjectType* anObject = plan->object;
+    plan->ready = false;
+    plan->viewCount = 0;
+    if ((anObject->attributes & kOnAutoPilot)
+            || ((anObject->baseType->arriveAction >= 0)
+                && !(anObject->runTimeFlags & kHasArrived))) {
+        return;
+    }
+    if (!AddThinkView(plan, mGetSpaceObjectPtr(anObject->closestObject))
+            || !AddThinkView(plan, mGetSpaceObjectPtr(anObject->targetObjectNumber))
+            || !AddThinkView(plan, anObject->destObjectPtr)
+            || !AddThinkView(plan, mGetSpaceObjectPtr(anObject->destObjectDest))) {
+        return;
+    }
+
+    memcpy(&plan->before, anObject, sizeof(spaceObjectType));
+    memcpy(&plan->after, anObject, sizeof(spaceObjectType));
+    plan->after.targetAngle = plan->after.directionGoal = plan->after.direction;
+    plan->keysDown = ThinkObjectNormalPresence(&plan->after, plan->after.baseType, timePass);
+    plan->ready = true;
+}
+
+static void ThinkAheadInParallel(int32_t timePass) {
+    gThinkers.clear();
+    if (!gThinkAhead) {
+        gThinkPlans.clear();
+        return;
+    }
+    for (spaceObjectType* anObject = gRootObject; anObject != NULL;
+            anObject = anObject->nextObject) {
+        if (anObject->active
+                && (anObject->attributes & (kCanThink | kRemoteOrHuman))
+                && (anObject->presenceState == kNormalPresence)) {
+            gThinkers.push_back(anObject);
+        }
+    }
+
+    gThinkPlans.resize(gThinkers.size());
+    WorkerPool::pool()->run(gThinkers.size(), kMinThinkersPerRange,
+            [timePass](int range, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            gThinkPlans[i].object = gThinkers[i];
+            ThinkAhead(&gThinkPlans[i], timePass);
+        }
+    });
+}
+
+void SetThinkAhead(bool enabled) {
+    gThinkAhead = enabled;
+}
+
+// True if thinking for plan->object now would give the same result as plan->after.
+static bool ThinkPlanIsCurrent(const ThinkPlan& plan) {
+    if (!plan.ready || (memcmp(&plan.before, plan.object, sizeof(spaceObjectType)) != 0)) {
+        return false;
+    }
+    for (int i = 0; i < plan.viewCount; ++i) {
+        if (!ThinkViewIsCurrent(plan.views[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void NonplayerShipThink( int32_t timePass)
 {
     admiralType     *anAdmiral;
@@ -100,6 +267,8 @@ void NonplayerShipThink( int32_t timePass)
     Fixed           fcos, fsin;
     RgbColor        friendSick, foeSick, neutralSick;
     uint32_t        sickCount = usecs_to_ticks(globals()->gGameTime) / 9;
+    size_t          nextPlan = 0;
+    const ThinkPlan* plan;
 
     globals()->gSynchValue = gRandomSeed.seed;
     sickCount &= 0x00000003;
@@ -134,12 +303,23 @@ void NonplayerShipThink( int32_t timePass)
         anAdmiral++;
     }
 
+    ThinkAheadInParallel(timePass);
+
 // it probably doesn't matter what order we do this in, but we'll do it in the "ideal" order anyway
 
     anObject = gRootObject;
 
     while ( anObject != NULL)
     {
+        // objects created during the pass are prepended, so the plans stay in list order
+        plan = NULL;
+        if (( nextPlan < gThinkPlans.size()) && ( gThinkPlans[nextPlan].object == anObject))
+        {
+            if ( ThinkPlanIsCurrent( gThinkPlans[nextPlan]))
+                plan = &gThinkPlans[nextPlan];
+            nextPlan++;
+        }
+
         if (anObject->active)
         {
             globals()->gSynchValue += anObject->location.h;
@@ -186,7 +366,14 @@ void NonplayerShipThink( int32_t timePass)
                 switch( anObject->presenceState)
                 {
                     case kNormalPresence:
-                        keysDown = ThinkObjectNormalPresence( anObject, baseObject, timePass);
+                        if ( plan != NULL)
+                        {
+                            *anObject = plan->after;
+                            keysDown = plan->keysDown;
+                        } else
+                        {
+                            keysDown = ThinkObjectNormalPresence( anObject, baseObject, timePass);
+                        }
                         break;
 
                     case kWarpingPresence:
@@ -2324,7 +2511,8 @@ int32_t GetSpritePointSelectObject( Rect *bounds, spaceObjectType *sourceObject,
     uint32_t        myOwnerFlag = 1 << sourceObject->owner;
 
 
-    for (int32_t whichShip = 0; whichShip < kMaxSpaceObject; whichShip++) {
+    for (int32_t whichShip = NextSpaceObject(-1); whichShip >= 0;
+            whichShip = NextSpaceObject(whichShip)) {
         spaceObjectType* anObject = mGetSpaceObjectPtr(whichShip);
         if (( anObject->active) && ( anObject->sprite != NULL) &&
             ( anObject->seenByPlayerFlags & myOwnerFlag) &&
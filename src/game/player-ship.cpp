@@ -51,9 +51,13 @@
 using sfz::Exception;
 using sfz::BytesSlice;
 using sfz::PrintTarget;
+using sfz::ReadSource;
 using sfz::String;
 using sfz::StringSlice;
+using sfz::WriteTarget;
 using sfz::format;
+using sfz::read;
+using sfz::write;
 
 namespace macroman = sfz::macroman;
 
@@ -867,6 +871,38 @@ int32_t PlayerShip::goal_direction() const {
     return 0;
 }
 
+void PlayerShip::save(WriteTarget out) const {
+    write(out, gTheseKeys);
+    write(out, _gamepad_keys);
+    write(out, gLastKeys);
+    write(out, _keys);
+    write<int32_t>(out, _gamepad_state);
+    write(out, _control_active);
+    write(out, _control_direction);
+
+    write(out, gLastKeyMap);
+    write(out, gDestKeyTime);
+    write(out, gDestinationLabel);
+    write(out, gAlarmCount);
+    write(out, gSendMessageLabel);
+}
+
+void PlayerShip::restore(ReadSource in) {
+    read(in, gTheseKeys);
+    read(in, _gamepad_keys);
+    read(in, gLastKeys);
+    read(in, _keys);
+    _gamepad_state = static_cast<GamepadState>(read<int32_t>(in));
+    read(in, _control_active);
+    read(in, _control_direction);
+
+    read(in, gLastKeyMap);
+    read(in, gDestKeyTime);
+    read(in, gDestinationLabel);
+    read(in, gAlarmCount);
+    read(in, gSendMessageLabel);
+}
+
 void PlayerShipHandleClick(Point where, int button) {
     spaceObjectType *theShip = NULL;
     int32_t         selectShipNum;
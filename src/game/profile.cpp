@@ -0,0 +1,209 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "game/profile.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "data/resource.hpp"
+#include "game/space-object.hpp"
+
+using sfz::PrintTarget;
+using sfz::format;
+
+namespace antares {
+
+namespace {
+
+const char* const kPhaseNames[PROFILE_PHASE_COUNT] = {
+    "starfield",
+    "move",
+    "think",
+    "admiral",
+    "actions",
+    "player",
+    "collide",
+    "conditions",
+    "minicomputer",
+    "long_message",
+    "sector_lines",
+    "beams",
+    "labels",
+    "sprites",
+    "messages",
+    "radar",
+};
+
+// Min, mean, and max of a series of samples, kept in constant space.
+struct Range {
+    int64_t count;
+    int64_t total;
+    int64_t min;
+    int64_t max;
+
+    void add(int64_t sample) {
+        if ((count == 0) || (sample < min)) {
+            min = sample;
+        }
+        if ((count == 0) || (sample > max)) {
+            max = sample;
+        }
+        total += sample;
+        ++count;
+    }
+
+    int64_t mean() const { return total / count; }
+};
+
+// Durations are counted in buckets of a fixed histogram, so recording one never allocates.
+// Below 16ns, each nanosecond has a bucket; above, each power of two is split into 8 buckets.
+const int kSubBucketBits = 3;
+const int kSubBuckets = 1 << kSubBucketBits;
+const int kLinearBuckets = 2 * kSubBuckets;
+const int kBucketCount = kLinearBuckets + ((63 - kSubBucketBits - 1) * kSubBuckets);
+
+int bucket(int64_t nsecs) {
+    if (nsecs < kLinearBuckets) {
+        return std::max<int64_t>(nsecs, 0);
+    }
+    int exponent = 63 - __builtin_clzll(nsecs);
+    int shift = exponent - kSubBucketBits;
+    return kLinearBuckets + ((shift - 1) * kSubBuckets)
+        + ((nsecs >> shift) & (kSubBuckets - 1));
+}
+
+// The largest duration that falls in `index`.
+int64_t bucket_max(int index) {
+    if (index < kLinearBuckets) {
+        return index;
+    }
+    int shift = ((index - kLinearBuckets) / kSubBuckets) + 1;
+    uint64_t sub = (index - kLinearBuckets) % kSubBuckets;
+    return std::min<uint64_t>(((kSubBuckets + sub + 1) << shift) - 1, INT64_MAX);
+}
+
+struct PhaseTimes {
+    Range nsecs;
+    int64_t buckets[kBucketCount];
+
+    void add(int64_t sample) {
+        nsecs.add(sample);
+        ++buckets[bucket(sample)];
+    }
+
+    int64_t percentile(int64_t percent) const {
+        const int64_t rank = (nsecs.count * percent) / 100;
+        int64_t seen = 0;
+        for (int i = 0; i < kBucketCount; ++i) {
+            seen += buckets[i];
+            if (seen > rank) {
+                return std::min(bucket_max(i), nsecs.max);
+            }
+        }
+        return nsecs.max;
+    }
+};
+
+bool profiling = false;
+PhaseTimes phase_times[PROFILE_PHASE_COUNT];
+Range object_counts;
+Range draw_call_counts;
+
+int64_t now_nsecs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void print_range(PrintTarget out, const char* name, const Range& range) {
+    if (range.count == 0) {
+        print(out, format("  \"{0}\": {{}},\n", name));
+    } else {
+        print(out, format(
+                    "  \"{0}\": {{\"min\": {1}, \"mean\": {2}, \"max\": {3}},\n",
+                    name, range.min, range.mean(), range.max));
+    }
+}
+
+}  // namespace
+
+void enable_profiling() {
+    profiling = true;
+}
+
+bool profiling_enabled() {
+    return profiling;
+}
+
+void profile_decide_cycle() {
+    if (!profiling) {
+        return;
+    }
+    int32_t count = 0;
+    for (spaceObjectType* o = gRootObject; o; o = o->nextObject) {
+        if (o->active == kObjectInUse) {
+            ++count;
+        }
+    }
+    object_counts.add(count);
+}
+
+void profile_frame(int32_t draw_calls) {
+    if (profiling) {
+        draw_call_counts.add(draw_calls);
+    }
+}
+
+void write_profile(PrintTarget out) {
+    print(out, "{\n");
+    print(out, format("  \"decide_cycles\": {0},\n", object_counts.count));
+    print_range(out, "objects", object_counts);
+    print(out, format("  \"frames\": {0},\n", draw_call_counts.count));
+    print_range(out, "draw_calls", draw_call_counts);
+    const ResourceStats resources = resource_stats();
+    print(out, format(
+                "  \"resources\": {{\"hits\": {0}, \"misses\": {1}, \"scans\": {2}, "
+                "\"dir_reads\": {3}, \"stats\": {4}},\n",
+                resources.hits, resources.misses, resources.scans, resources.dir_reads,
+                resources.stats));
+    print(out, "  \"phases\": {\n");
+    for (int i = 0; i < PROFILE_PHASE_COUNT; ++i) {
+        const PhaseTimes& times = phase_times[i];
+        print(out, format("    \"{0}\": {{\"calls\": {1}", kPhaseNames[i], times.nsecs.count));
+        if (times.nsecs.count > 0) {
+            print(out, format(
+                        ", \"min_ns\": {0}, \"mean_ns\": {1}, \"p99_ns\": {2}",
+                        times.nsecs.min, times.nsecs.mean(), times.percentile(99)));
+        }
+        print(out, (i + 1 < PROFILE_PHASE_COUNT) ? "},\n" : "}\n");
+    }
+    print(out, "  }\n");
+    print(out, "}\n");
+}
+
+ProfileTimer::ProfileTimer(ProfilePhase phase):
+        _phase(phase),
+        _start(profiling ? now_nsecs() : 0) { }
+
+ProfileTimer::~ProfileTimer() {
+    if (profiling) {
+        phase_times[_phase].add(now_nsecs() - _start);
+    }
+}
+
+}  // namespace antares
@@ -22,6 +22,7 @@
 #include <sfz/sfz.hpp>
 
 #include "config/keys.hpp"
+#include "config/preferences.hpp"
 #include "data/races.hpp"
 #include "data/resource.hpp"
 #include "data/string-list.hpp"
@@ -37,6 +38,7 @@
 #include "game/motion.hpp"
 #include "game/non-player-ship.hpp"
 #include "game/player-ship.hpp"
+#include "game/snapshot.hpp"
 #include "game/space-object.hpp"
 #include "game/starfield.hpp"
 #include "lang/casts.hpp"
@@ -50,10 +52,14 @@ using sfz::Bytes;
 using sfz::BytesSlice;
 using sfz::Exception;
 using sfz::PrintTarget;
+using sfz::ReadSource;
+using sfz::Sha1;
 using sfz::String;
 using sfz::StringSlice;
+using sfz::WriteTarget;
 using sfz::range;
 using sfz::read;
+using sfz::write;
 using std::vector;
 
 namespace antares {
@@ -80,6 +86,57 @@ vector<Scenario::BriefPoint> gScenarioBriefData;
 int32_t gScenarioRotation = 0;
 int32_t gAdmiralNumbers[kMaxPlayerNum];
 
+// Running a scenario up to its start time depends only on the scenario, the version of its data,
+// the object limit, and the random seed when the run begins.  Once enabled, the world the last
+// run left behind is kept under a digest of those, so that restarting the level (see SoloGame,
+// which restarts with the same seed) restores it instead of simulating it again.  It isn't kept
+// on disk: the seed is different every time a level is started afresh, so nothing there would
+// ever be restored.
+struct WarmupCache {
+    bool            enabled;
+    bool            valid;
+    Sha1::Digest    key;
+    Bytes           state;
+};
+WarmupCache gWarmupCache;
+
+Sha1::Digest warmup_key(int32_t seed) {
+    Sha1 sha;
+    write_snapshot_string(sha, Preferences::preferences()->scenario_identifier());
+    write(sha, globals()->scenarioFileInfo.version);
+    write(sha, gThisScenario->chapter_number());
+    write(sha, SpaceObjectLimit());
+    write(sha, seed);
+    return sha.digest();
+}
+
+bool load_warmup(const Sha1::Digest& key, Bytes& state) {
+    if (!gWarmupCache.enabled || !gWarmupCache.valid || !(gWarmupCache.key == key)) {
+        return false;
+    }
+    state.assign(gWarmupCache.state);
+    return true;
+}
+
+void save_warmup(const Sha1::Digest& key, const Bytes& state) {
+    if (!gWarmupCache.enabled) {
+        return;
+    }
+    gWarmupCache.valid = true;
+    gWarmupCache.key = key;
+    gWarmupCache.state.assign(state);
+}
+
+void save_warmup_state(WriteTarget out) {
+    SaveSnapshot(out);
+    Messages::save(out);
+}
+
+void restore_warmup_state(ReadSource in) {
+    RestoreSnapshot(in);
+    Messages::restore(in);
+}
+
 void CheckActionMedia(int32_t whichAction, int32_t actionNum, uint8_t color);
 void AddBaseObjectActionMedia(int32_t whichBase, int32_t whichType, uint8_t color);
 void AddActionMedia(objectActionType *action, uint8_t color);
@@ -467,6 +524,11 @@ bool Scenario::Condition::true_yet() const {
     return flags & kHasBeenTrue;
 }
 
+void EnableWarmupCache() {
+    gWarmupCache.enabled = true;
+    gWarmupCache.valid = false;
+}
+
 void ScenarioMakerInit() {
     {
         Resource rsrc("scenario-info", "nlAG", 128);
@@ -1008,10 +1070,19 @@ void construct_scenario(const Scenario* scenario, int32_t* current) {
         RecalcAllAdmiralBuildData();
         Messages::clear();
 
-        int x = 0;
         const int64_t start_ticks
             = (gThisScenario->startTime & kScenario_StartTimeMask) * kScenarioTimeMultiple;
         const int64_t start_time = add_ticks(0, start_ticks);
+        const Sha1::Digest key = warmup_key(gRandomSeed.seed);
+        Bytes state;
+        if (load_warmup(key, state)) {
+            BytesSlice in(state);
+            restore_warmup_state(in);
+            *current += (gThisScenario->startTime & kScenario_StartTimeMask) + 1;
+            return;
+        }
+
+        int x = 0;
         globals()->gGameTime = 0;
         for (int64_t i = 0; i < start_ticks; ++i) {
             globals()->gGameTime = add_ticks(globals()->gGameTime, 1);
@@ -1032,6 +1103,8 @@ void construct_scenario(const Scenario* scenario, int32_t* current) {
             }
         }
         globals()->gGameTime = start_time;
+        save_warmup_state(state);
+        save_warmup(key, state);
 
         (*current)++;
         return;
@@ -1601,4 +1674,28 @@ coordPointType Translate_Coord_To_Scenario_Rotation(int32_t h, int32_t v) {
     return coord;
 }
 
+// The scenario itself is loaded from data; only what play changes about it is written: which
+// conditions have been true, and which objects the initial objects became.
+void SaveScenarioState(WriteTarget out) {
+    for (int32_t i = 0; i < gThisScenario->conditionNum; ++i) {
+        write(out, gThisScenario->condition(i)->flags);
+    }
+    for (int32_t i = 0; i < gThisScenario->initialNum; ++i) {
+        const Scenario::InitialObject* initial = gThisScenario->initial(i);
+        write(out, initial->realObjectNumber);
+        write(out, initial->realObjectID);
+    }
+}
+
+void RestoreScenarioState(ReadSource in) {
+    for (int32_t i = 0; i < gThisScenario->conditionNum; ++i) {
+        read(in, gThisScenario->condition(i)->flags);
+    }
+    for (int32_t i = 0; i < gThisScenario->initialNum; ++i) {
+        Scenario::InitialObject* initial = gThisScenario->initial(i);
+        read(in, initial->realObjectNumber);
+        read(in, initial->realObjectID);
+    }
+}
+
 }  // namespace antares
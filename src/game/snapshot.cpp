@@ -0,0 +1,167 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "game/snapshot.hpp"
+
+#include <sfz/sfz.hpp>
+
+#include "drawing/sprite-handling.hpp"
+#include "game/admiral.hpp"
+#include "game/beam.hpp"
+#include "game/globals.hpp"
+#include "game/labels.hpp"
+#include "game/minicomputer.hpp"
+#include "game/motion.hpp"
+#include "game/scenario-maker.hpp"
+#include "game/space-object.hpp"
+#include "game/starfield.hpp"
+#include "math/random.hpp"
+
+using sfz::Bytes;
+using sfz::Exception;
+using sfz::ReadSource;
+using sfz::String;
+using sfz::StringSlice;
+using sfz::WriteTarget;
+using sfz::format;
+using sfz::read;
+using sfz::write;
+
+namespace utf8 = sfz::utf8;
+
+namespace antares {
+
+static void write_globals(WriteTarget out) {
+    aresGlobalType& g = *globals();
+    write(out, g.gGameTime);
+    write(out, gRandomSeed.seed);
+    write(out, g.gSynchValue);
+    write(out, g.gGameOver);
+    write(out, g.gScenarioWinner.next);
+    write(out, g.gScenarioWinner.text);
+    write(out, g.gScenarioWinner.player);
+    for (int i = 0; i < kMaxPlayerNum; ++i) {
+        write(out, g.gActiveCheats[i]);
+    }
+    write(out, g.gPlayerShipNumber);
+    write(out, g.gPlayerAdmiralNumber);
+    write(out, g.gSelectionLabel);
+    write(out, g.gClosestObject);
+    write(out, g.gFarthestObject);
+    write<int32_t>(out, g.gZoomMode);
+    write<int32_t>(out, g.gPreviousZoomMode);
+    write(out, gAbsoluteScale);
+    write(out, gGlobalCorner);
+    write(out, g.gAutoPilotOff);
+    write(out, g.keyMask);
+    write(out, g.gLastMessageKeyMap);
+    for (size_t i = 0; i < kHotKeyNum; ++i) {
+        write(out, g.hotKey[i].objectNum);
+        write(out, g.hotKey[i].objectID);
+    }
+    write(out, g.hotKeyDownTime);
+    write(out, g.lastHotKey);
+    write(out, g.lastSelectedObject);
+    write(out, g.lastSelectedObjectID);
+    write(out, g.destKeyUsedForSelection);
+    write(out, g.hotKey_target);
+}
+
+static void read_globals(ReadSource in) {
+    aresGlobalType& g = *globals();
+    read(in, g.gGameTime);
+    read(in, gRandomSeed.seed);
+    read(in, g.gSynchValue);
+    read(in, g.gGameOver);
+    read(in, g.gScenarioWinner.next);
+    read(in, g.gScenarioWinner.text);
+    read(in, g.gScenarioWinner.player);
+    for (int i = 0; i < kMaxPlayerNum; ++i) {
+        read(in, g.gActiveCheats[i]);
+    }
+    read(in, g.gPlayerShipNumber);
+    read(in, g.gPlayerAdmiralNumber);
+    read(in, g.gSelectionLabel);
+    read(in, g.gClosestObject);
+    read(in, g.gFarthestObject);
+    g.gZoomMode = static_cast<ZoomType>(read<int32_t>(in));
+    g.gPreviousZoomMode = static_cast<ZoomType>(read<int32_t>(in));
+    read(in, gAbsoluteScale);
+    read(in, gGlobalCorner);
+    read(in, g.gAutoPilotOff);
+    read(in, g.keyMask);
+    read(in, g.gLastMessageKeyMap);
+    for (size_t i = 0; i < kHotKeyNum; ++i) {
+        read(in, g.hotKey[i].objectNum);
+        read(in, g.hotKey[i].objectID);
+    }
+    read(in, g.hotKeyDownTime);
+    read(in, g.lastHotKey);
+    read(in, g.lastSelectedObject);
+    read(in, g.lastSelectedObjectID);
+    read(in, g.destKeyUsedForSelection);
+    read(in, g.hotKey_target);
+}
+
+void SaveSnapshot(WriteTarget out) {
+    write(out, kSnapshotVersion);
+    write_globals(out);
+    SaveSpaceObjects(out);
+    SaveSprites(out);
+    Beams::save(out);
+    Labels::save(out);
+    globals()->starfield.save(out);
+    SaveAdmirals(out);
+    SaveScenarioState(out);
+    write(out, globals()->gMiniScreenData.currentScreen);
+    write(out, globals()->gMiniScreenData.selectLine);
+}
+
+void RestoreSnapshot(ReadSource in) {
+    const uint32_t version = read<uint32_t>(in);
+    if (version != kSnapshotVersion) {
+        throw Exception(format("unsupported snapshot version {0}", version));
+    }
+    read_globals(in);
+    RestoreSpaceObjects(in);
+    RestoreSprites(in);
+    Beams::restore(in);
+    Labels::restore(in);
+    globals()->starfield.restore(in);
+    RestoreAdmirals(in);
+    RestoreScenarioState(in);
+
+    // Rebuilt last, since the minicomputer's screens are made from the objects and admirals.
+    const int32_t screen = read<int32_t>(in);
+    const int32_t line = read<int32_t>(in);
+    MiniComputer_SetScreenAndLineHack(screen, line);
+}
+
+void write_snapshot_string(WriteTarget out, const StringSlice& string) {
+    Bytes bytes(utf8::encode(string));
+    write<uint32_t>(out, bytes.size());
+    write(out, bytes);
+}
+
+String read_snapshot_string(ReadSource in) {
+    Bytes bytes(read<uint32_t>(in), '\0');
+    in.shift(bytes.data(), bytes.size());
+    return String(utf8::decode(bytes));
+}
+
+}  // namespace antares
@@ -18,6 +18,7 @@
 
 #include "game/space-object.hpp"
 
+#include <algorithm>
 #include <sfz/sfz.hpp>
 
 #include "data/resource.hpp"
@@ -27,6 +28,7 @@
 #include "drawing/sprite-handling.hpp"
 #include "game/admiral.hpp"
 #include "game/beam.hpp"
+#include "game/delay-queue.hpp"
 #include "game/globals.hpp"
 #include "game/labels.hpp"
 #include "game/messages.hpp"
@@ -47,13 +49,16 @@ using sfz::Exception;
 using sfz::ReadSource;
 using sfz::String;
 using sfz::StringSlice;
+using sfz::WriteTarget;
+using sfz::format;
 using sfz::read;
+using sfz::write;
+using std::fill;
 using std::unique_ptr;
+using std::vector;
 
 namespace antares {
 
-const size_t kActionQueueLength     = 120;
-
 const uint8_t kFriendlyColor        = GREEN;
 const uint8_t kHostileColor         = RED;
 const uint8_t kNeutralColor         = SKY_BLUE;
@@ -69,35 +74,132 @@ struct actionQueueType {
     objectActionType            *action;
     int32_t                         actionNum;
     int32_t                         actionToDo;
-    int32_t                         scheduledTime;
-    actionQueueType         *nextActionQueue;
-    int32_t                         nextActionQueueNum;
-    spaceObjectType         *subjectObject;
-    int32_t                         subjectObjectNum;
-    int32_t                         subjectObjectID;
-    spaceObjectType         *directObject;
-    int32_t                         directObjectNum;
-    int32_t                         directObjectID;
+    SpaceObjectHandle           subjectObject;
+    SpaceObjectHandle           directObject;
     Point                       offset;
 };
 
 spaceObjectType* gRootObject = NULL;
 int32_t gRootObjectNumber = -1;
 
-static actionQueueType* gFirstActionQueue = NULL;
-static int32_t gFirstActionQueueNumber = -1;
 static baseObjectType kZeroBaseObject;
 static spaceObjectType kZeroSpaceObject = {0, &kZeroBaseObject};
 
-static unique_ptr<spaceObjectType[]> gSpaceObjectData;
+// Objects are allocated in chunks so that growing the pool never moves an object; pointers into
+// the pool stay valid for the life of the process.  Slots are handed out lowest-first, as they
+// were when the pool was a single array, and gSpaceObjectOccupied has a bit set for every slot
+// that is not kObjectAvailable, so that loops over objects can skip free slots 64 at a time.
+static vector<unique_ptr<spaceObjectType[]>> gSpaceObjectChunks;
+static vector<uint64_t> gSpaceObjectOccupied;
+static vector<uint32_t> gSpaceObjectGeneration;
+static int32_t gSpaceObjectLimit = kDefaultSpaceObjectLimit;
 static unique_ptr<baseObjectType[]> gBaseObjectData;
 static unique_ptr<objectActionType[]> gObjectActionData;
-static unique_ptr<actionQueueType[]> gActionQueueData;
+
+static DelayQueue<actionQueueType> gActionQueue;
+
+static int32_t SpaceObjectCapacity() {
+    return gSpaceObjectChunks.size() * kSpaceObjectChunkSize;
+}
+
+static void AddSpaceObjectChunk() {
+    spaceObjectType* chunk = new spaceObjectType[kSpaceObjectChunkSize];
+    for (int32_t i = 0; i < kSpaceObjectChunkSize; ++i) {
+        chunk[i].active = kObjectAvailable;
+        chunk[i].sprite = NULL;
+    }
+    gSpaceObjectChunks.emplace_back(chunk);
+    gSpaceObjectOccupied.resize(SpaceObjectCapacity() / 64, 0);
+    gSpaceObjectGeneration.resize(SpaceObjectCapacity(), 0);
+}
+
+static void SetSpaceObjectOccupied(int32_t whichObject, bool occupied) {
+    const uint64_t bit = 1ull << (whichObject & 63);
+    if (occupied) {
+        gSpaceObjectOccupied[whichObject >> 6] |= bit;
+    } else {
+        gSpaceObjectOccupied[whichObject >> 6] &= ~bit;
+    }
+}
+
+// Returns the lowest-numbered available slot, growing the pool if there are none, or -1 if
+// every slot below the object limit is taken.
+static int32_t FindAvailableSpaceObject() {
+    for (size_t word = 0; word < gSpaceObjectOccupied.size(); ++word) {
+        if (~gSpaceObjectOccupied[word]) {
+            const int32_t whichObject =
+                (word * 64) + __builtin_ctzll(~gSpaceObjectOccupied[word]);
+            return (whichObject < gSpaceObjectLimit) ? whichObject : -1;
+        }
+    }
+    if (SpaceObjectCapacity() >= gSpaceObjectLimit) {
+        return -1;
+    }
+    int32_t whichObject = SpaceObjectCapacity();
+    AddSpaceObjectChunk();
+    return whichObject;
+}
+
+int32_t NextSpaceObject(int32_t whichObject) {
+    ++whichObject;
+    size_t word = whichObject >> 6;
+    if (word >= gSpaceObjectOccupied.size()) {
+        return -1;
+    }
+    uint64_t bits = gSpaceObjectOccupied[word] & (~0ull << (whichObject & 63));
+    while (!bits) {
+        if (++word >= gSpaceObjectOccupied.size()) {
+            return -1;
+        }
+        bits = gSpaceObjectOccupied[word];
+    }
+    return (word * 64) + __builtin_ctzll(bits);
+}
+
+int32_t SpaceObjectLimit() {
+    return gSpaceObjectLimit;
+}
+
+void SetSpaceObjectLimit(int32_t limit) {
+    if ((limit <= 0) || (limit > kMaxSpaceObject)) {
+        throw Exception(format("invalid space object limit {0}", limit));
+    }
+    gSpaceObjectLimit = limit;
+    SetSpriteLimit(kSpritesPerObject * limit);
+}
+
+SpaceObjectHandle::SpaceObjectHandle(const spaceObjectType* object):
+        _number(object ? object->entryNumber : -1),
+        _generation(object ? gSpaceObjectGeneration[object->entryNumber] : 0) { }
+
+spaceObjectType* SpaceObjectHandle::get() const {
+    if ((_number < 0) || (gSpaceObjectGeneration[_number] != _generation)) {
+        return NULL;
+    }
+    spaceObjectType* object = mGetSpaceObjectPtr(_number);
+    if (!object->active) {
+        return NULL;
+    }
+    return object;
+}
+
+void read_from(ReadSource in, SpaceObjectHandle& handle) {
+    read(in, handle._number);
+    read(in, handle._generation);
+}
+
+void write_to(WriteTarget out, const SpaceObjectHandle& handle) {
+    write(out, handle._number);
+    write(out, handle._generation);
+}
 
 void SpaceObjectHandlingInit() {
     bool correctBaseObjectColor = false;
 
-    gSpaceObjectData.reset(new spaceObjectType[kMaxSpaceObject]);
+    gSpaceObjectChunks.clear();
+    gSpaceObjectOccupied.clear();
+    gSpaceObjectGeneration.clear();
+    AddSpaceObjectChunk();
     if (gBaseObjectData.get() == NULL) {
         Resource rsrc("objects", "bsob", kBaseObjectResID);
         BytesSlice in(rsrc.data());
@@ -127,7 +229,6 @@ void SpaceObjectHandlingInit() {
         }
     }
 
-    gActionQueueData.reset(new actionQueueType[kActionQueueLength]);
     if (correctBaseObjectColor) {
         CorrectAllBaseObjectColor();
     }
@@ -140,19 +241,21 @@ void SpaceObjectHandlingInit() {
 
 void CleanupSpaceObjectHandling() {
     gBaseObjectData.reset();
-    gSpaceObjectData.reset();
+    gSpaceObjectChunks.clear();
+    gSpaceObjectOccupied.clear();
+    gSpaceObjectGeneration.clear();
     gObjectActionData.reset();
-    gActionQueueData.reset();
+    gActionQueue.clear();
 }
 
 void ResetAllSpaceObjects() {
     spaceObjectType *anObject = NULL;
-    int16_t         i;
+    int32_t         i;
 
     gRootObject = NULL;
     gRootObjectNumber = -1;
-    anObject = gSpaceObjectData.get();
-    for (i = 0; i < kMaxSpaceObject; i++) {
+    for (i = 0; i < SpaceObjectCapacity(); i++) {
+        anObject = mGetSpaceObjectPtr(i);
 //      anObject->attributes = 0;
         anObject->active = kObjectAvailable;
         anObject->sprite = NULL;
@@ -238,35 +341,13 @@ void ResetAllSpaceObjects() {
         anObject->offlineTime = 0;
         anObject->periodicTime = 0;
 */
-        anObject++;
     }
+    fill(gSpaceObjectOccupied.begin(), gSpaceObjectOccupied.end(), 0);
 }
 
 void ResetActionQueueData( void)
 {
-    actionQueueType *action = gActionQueueData.get();
-    int32_t         i;
-
-    gFirstActionQueueNumber = -1;
-    gFirstActionQueue = NULL;
-
-    for ( i = 0; i < kActionQueueLength; i++)
-    {
-        action->actionNum = -1;
-        action->actionToDo = 0;
-        action->action = NULL;
-        action->nextActionQueueNum = -1;
-        action->nextActionQueue = NULL;
-        action->scheduledTime = -1;
-        action->subjectObject = NULL;
-        action->subjectObjectNum = -1;
-        action->subjectObjectID = -1;
-        action->directObject = NULL;
-        action->directObjectNum = -1;
-        action->directObjectID = -1;
-        action->offset.h = action->offset.v = 0;
-        action++;
-    }
+    gActionQueue.clear();
 }
 
 baseObjectType* mGetBaseObjectPtr(int32_t whichObject) {
@@ -278,7 +359,8 @@ baseObjectType* mGetBaseObjectPtr(int32_t whichObject) {
 
 spaceObjectType* mGetSpaceObjectPtr(int32_t whichObject) {
     if (whichObject >= 0) {
-        return gSpaceObjectData.get() + whichObject;
+        return gSpaceObjectChunks[whichObject / kSpaceObjectChunkSize].get()
+            + (whichObject % kSpaceObjectChunkSize);
     }
     return nullptr;
 }
@@ -329,17 +411,12 @@ int AddSpaceObject( spaceObjectType *sourceObject)
     uint8_t         tinyShade;
     int16_t         whichShape = 0, angle;
 
-    destObject = gSpaceObjectData.get();
-
-    while (( destObject->active) && ( whichObject < kMaxSpaceObject))
-    {
-        whichObject++;
-        destObject++;
-    }
-    if ( whichObject == kMaxSpaceObject)
+    whichObject = FindAvailableSpaceObject();
+    if ( whichObject < 0)
     {
         return( -1);
     }
+    destObject = mGetSpaceObjectPtr(whichObject);
 
     if ( sourceObject->pixResID != kNoSpriteTable)
     {
@@ -478,6 +555,8 @@ int AddSpaceObject( spaceObjectType *sourceObject)
     gRootObjectNumber = whichObject;
 
     destObject->active = kObjectInUse;
+    SetSpaceObjectOccupied(whichObject, true);
+    ++gSpaceObjectGeneration[whichObject];
     destObject->nextNearObject = destObject->nextFarObject = NULL;
     destObject->whichLabel = Labels::kNone;
     destObject->entryNumber = whichObject;
@@ -560,15 +639,40 @@ int AddNumberedSpaceObject( spaceObjectType *sourceObject, int32_t whichObject)
 */  return ( 0);
 }
 
+void FreeSpaceObject(spaceObjectType* object) {
+    object->active = kObjectAvailable;
+    SetSpaceObjectOccupied(object->entryNumber, false);
+    object->attributes = 0;
+    object->nextNearObject = object->nextFarObject = NULL;
+    if (object->previousObject != NULL) {
+        spaceObjectType* previous = object->previousObject;
+        previous->nextObject = object->nextObject;
+        previous->nextObjectNumber = object->nextObjectNumber;
+    }
+    if (object->nextObject != NULL) {
+        spaceObjectType* next = object->nextObject;
+        next->previousObject = object->previousObject;
+        next->previousObjectNumber = object->previousObjectNumber;
+    }
+    if (gRootObject == object) {
+        gRootObject = object->nextObject;
+        gRootObjectNumber = object->nextObjectNumber;
+    }
+    object->nextObject = NULL;
+    object->nextObjectNumber = -1;
+    object->previousObject = NULL;
+    object->previousObjectNumber = -1;
+}
+
 void RemoveAllSpaceObjects( void)
 
 {
     spaceObjectType *anObject;
     int             i;
 
-    anObject = gSpaceObjectData.get();
-    for ( i = 0; i < kMaxSpaceObject; i++)
+    for ( i = 0; i < SpaceObjectCapacity(); i++)
     {
+        anObject = mGetSpaceObjectPtr(i);
         if ( anObject->sprite != NULL)
         {
             RemoveSprite( anObject->sprite);
@@ -578,8 +682,8 @@ void RemoveAllSpaceObjects( void)
         anObject->active = kObjectAvailable;
         anObject->nextNearObject = anObject->nextFarObject = NULL;
         anObject->attributes = 0;
-        anObject++;
     }
+    fill(gSpaceObjectOccupied.begin(), gSpaceObjectOccupied.end(), 0);
 }
 
 void CorrectAllBaseObjectColor( void)
@@ -1048,133 +1152,45 @@ void AddActionToQueue( objectActionType *action, int32_t actionNumber, int32_t a
                         int32_t delayTime, spaceObjectType *subjectObject,
                         spaceObjectType *directObject, Point* offset)
 {
-    int32_t             queueNumber = 0;
-    actionQueueType     *actionQueue = gActionQueueData.get(),
-                        *nextQueue = gFirstActionQueue, *previousQueue = NULL;
-
-    while (( actionQueue->action != NULL) && ( queueNumber < kActionQueueLength))
-    {
-        actionQueue++;
-        queueNumber++;
-    }
+    actionQueueType     actionQueue;
 
-    if ( queueNumber == kActionQueueLength) return;
-    actionQueue->action = action;
-    actionQueue->actionNum = actionNumber;
-    actionQueue->scheduledTime = delayTime;
-    actionQueue->subjectObject = subjectObject;
-    actionQueue->actionToDo = actionToDo;
+    actionQueue.action = action;
+    actionQueue.actionNum = actionNumber;
+    actionQueue.subjectObject = SpaceObjectHandle(subjectObject);
+    actionQueue.actionToDo = actionToDo;
 
     if ( offset == NULL)
     {
-        actionQueue->offset.h = actionQueue->offset.v = 0;
+        actionQueue.offset.h = actionQueue.offset.v = 0;
     } else
     {
-        actionQueue->offset.h = offset->h;
-        actionQueue->offset.v = offset->v;
+        actionQueue.offset.h = offset->h;
+        actionQueue.offset.v = offset->v;
     }
 
-    if ( subjectObject != NULL)
-    {
-        actionQueue->subjectObjectNum = subjectObject->entryNumber;
-        actionQueue->subjectObjectID = subjectObject->id;
-    } else
-    {
-        actionQueue->subjectObjectNum = -1;
-        actionQueue->subjectObjectID = -1;
-    }
-    actionQueue->directObject = directObject;
-    if ( directObject != NULL)
-    {
-        actionQueue->directObjectNum = directObject->entryNumber;
-        actionQueue->directObjectID = directObject->id;
-    } else
-    {
-        actionQueue->directObjectNum = -1;
-        actionQueue->directObjectID = -1;
-    }
+    actionQueue.directObject = SpaceObjectHandle(directObject);
 
-    while (( nextQueue != NULL) && ( nextQueue->scheduledTime < delayTime))
-    {
-        previousQueue = nextQueue;
-        nextQueue = nextQueue->nextActionQueue;
-    }
-    if ( previousQueue == NULL)
-    {
-        actionQueue->nextActionQueue = gFirstActionQueue;
-        actionQueue->nextActionQueueNum = gFirstActionQueueNumber;
-        gFirstActionQueue = actionQueue;
-        gFirstActionQueueNumber = queueNumber;
-    } else
-    {
-        actionQueue->nextActionQueue = previousQueue->nextActionQueue;
-        actionQueue->nextActionQueueNum = previousQueue->nextActionQueueNum;
-
-        previousQueue->nextActionQueue = actionQueue;
-        previousQueue->nextActionQueueNum = queueNumber;
-    }
+    gActionQueue.add(delayTime, actionQueue);
 }
 
 void ExecuteActionQueue( int32_t unitsToDo)
 
 {
-//  actionQueueType     *actionQueue = gFirstActionQueue;
-    actionQueueType     *actionQueue = gActionQueueData.get();
-    int32_t                     subjectid, directid, i;
+    actionQueueType     actionQueue;
 
-    for ( i = 0; i < kActionQueueLength; i++)
+    gActionQueue.advance(unitsToDo);
+    while (gActionQueue.pop(&actionQueue))
     {
-        if ( actionQueue->action != NULL)
+        // Skip the action if either of its objects has died since it was queued.
+        spaceObjectType* subjectObject = actionQueue.subjectObject.get();
+        spaceObjectType* directObject = actionQueue.directObject.get();
+        if (( actionQueue.subjectObject.empty() || subjectObject) &&
+            ( actionQueue.directObject.empty() || directObject))
         {
-            actionQueue->scheduledTime -= unitsToDo;
+            Point offset = actionQueue.offset;
+            ExecuteObjectActions( actionQueue.actionNum, actionQueue.actionToDo,
+                subjectObject, directObject, &offset, false);
         }
-        actionQueue++;
-    }
-
-    actionQueue = gFirstActionQueue;
-    while (( gFirstActionQueue != NULL) &&
-        ( gFirstActionQueue->action != NULL) &&
-        ( gFirstActionQueue->scheduledTime <= 0))
-    {
-        subjectid = -1;
-        directid = -1;
-        if ( gFirstActionQueue->subjectObject != NULL)
-        {
-            if ( gFirstActionQueue->subjectObject->active)
-                subjectid = gFirstActionQueue->subjectObject->id;
-        }
-
-        if ( gFirstActionQueue->directObject != NULL)
-        {
-            if ( gFirstActionQueue->directObject->active)
-                directid = gFirstActionQueue->directObject->id;
-        }
-        if (( subjectid == gFirstActionQueue->subjectObjectID) &&
-            ( directid == gFirstActionQueue->directObjectID))
-        {
-            ExecuteObjectActions( gFirstActionQueue->actionNum, gFirstActionQueue->actionToDo,
-                gFirstActionQueue->subjectObject, gFirstActionQueue->directObject,
-                &(gFirstActionQueue->offset), false);
-        }
-        gFirstActionQueue->actionNum = -1;
-        gFirstActionQueue->actionToDo = 0;
-        gFirstActionQueue->action = NULL;
-        gFirstActionQueue->scheduledTime = -1;
-        gFirstActionQueue->subjectObject = NULL;
-        gFirstActionQueue->subjectObjectNum = -1;
-        gFirstActionQueue->subjectObjectID = -1;
-        gFirstActionQueue->directObject = NULL;
-        gFirstActionQueue->directObjectNum = -1;
-        gFirstActionQueue->directObjectID = -1;
-        gFirstActionQueue->offset.h = gFirstActionQueue->offset.v = 0;
-
-        actionQueue = gFirstActionQueue;
-
-        gFirstActionQueueNumber = gFirstActionQueue->nextActionQueueNum;
-        gFirstActionQueue = gFirstActionQueue->nextActionQueue;
-
-        actionQueue->nextActionQueueNum = -1;
-        actionQueue->nextActionQueue = NULL;
     }
 }
 
@@ -1343,7 +1359,7 @@ void ExecuteObjectActions( int32_t whichAction, int32_t actionNum,
 
                         if ( l >= 0)
                         {
-                            spaceObjectType *newObject = gSpaceObjectData.get() + l;
+                            spaceObjectType *newObject = mGetSpaceObjectPtr(l);
                             if ( newObject->attributes & kCanAcceptDestination)
                             {
                                 ul1 = newObject->attributes;
@@ -2089,7 +2105,7 @@ int32_t CreateAnySpaceObject( int32_t whichBase, fixedPointType *velocity,
                                     direction, velocity, owner, spriteIDOverride);
     newObject.location = *location;
     if ( globals()->gPlayerShipNumber >= 0)
-        player = gSpaceObjectData.get() + globals()->gPlayerShipNumber;
+        player = mGetSpaceObjectPtr(globals()->gPlayerShipNumber);
     else player = NULL;
     if (( player != NULL) && ( player->active))
     {
@@ -2178,7 +2194,7 @@ int32_t CreateAnySpaceObject( int32_t whichBase, fixedPointType *velocity,
         return ( -1);
     } else
     {
-        madeObject = gSpaceObjectData.get() + newObjectNumber;
+        madeObject = mGetSpaceObjectPtr(newObjectNumber);
         madeObject->attributes |= specialAttributes;
         ExecuteObjectActions( madeObject->baseType->createAction, madeObject->baseType->createActionNum,
                             madeObject, NULL, NULL, true);
@@ -2193,13 +2209,12 @@ int32_t CountObjectsOfBaseType( int32_t whichType, int32_t owner)
 
     spaceObjectType *anObject;
 
-    anObject = gSpaceObjectData.get();
-    for ( count = 0; count < kMaxSpaceObject; count++)
+    for ( count = NextSpaceObject(-1); count >= 0; count = NextSpaceObject(count))
     {
+        anObject = mGetSpaceObjectPtr(count);
         if (( anObject->active) &&
             (( anObject->whichBaseObject == whichType) || ( whichType == -1)) &&
             (( anObject->owner == owner) || ( owner == -1))) result++;
-        anObject++;
     }
     return (result);
 }
@@ -2210,7 +2225,7 @@ int32_t GetNextObjectWithAttributes( int32_t startWith, uint32_t attributes, boo
     int32_t original = startWith;
     spaceObjectType *anObject;
 
-    anObject = gSpaceObjectData.get() + startWith;
+    anObject = mGetSpaceObjectPtr(startWith);
 
     if ( exclude)
     {
@@ -2395,9 +2410,9 @@ void AlterObjectOwner( spaceObjectType *anObject, int32_t owner, bool message)
         anObject->bestConsideredTargetValue = anObject->currentTargetValue = 0xffffffff;
         anObject->bestConsideredTargetNumber = -1;
 
-        fixObject = gSpaceObjectData.get();
-        for ( i = 0; i < kMaxSpaceObject; i++)
+        for ( i = NextSpaceObject(-1); i >= 0; i = NextSpaceObject(i))
         {
+            fixObject = mGetSpaceObjectPtr(i);
             if (( fixObject->destinationObject == anObject->entryNumber) && ( fixObject->active !=
                 kObjectAvailable) && ( fixObject->attributes & kCanThink))
             {
@@ -2411,7 +2426,6 @@ void AlterObjectOwner( spaceObjectType *anObject, int32_t owner, bool message)
                     anObject->escortStrength += fixObject->baseType->offenseValue;
                 }
             }
-            fixObject++;
         }
 
         if ( anObject->attributes & kIsDestination)
@@ -2480,7 +2494,8 @@ void AlterObjectCloakState( spaceObjectType *anObject, bool cloak)
 void DestroyObject( spaceObjectType *anObject)
 
 {
-    int16_t energyNum, i;
+    int16_t energyNum;
+    int32_t i;
     spaceObjectType *fixObject;
 
     if ( anObject->active == kObjectInUse)
@@ -2489,9 +2504,9 @@ void DestroyObject( spaceObjectType *anObject)
         {
             anObject->health = anObject->baseType->health;
             // if anyone is targeting it, they should stop
-            fixObject = gSpaceObjectData.get();
-            for ( i = 0; i < kMaxSpaceObject; i++)
+            for ( i = NextSpaceObject(-1); i >= 0; i = NextSpaceObject(i))
             {
+                fixObject = mGetSpaceObjectPtr(i);
                 if (( fixObject->attributes & kCanAcceptDestination) && ( fixObject->active !=
                     kObjectAvailable))
                 {
@@ -2500,7 +2515,6 @@ void DestroyObject( spaceObjectType *anObject)
                         fixObject->targetObjectNumber = kNoDestinationObject;
                     }
                 }
-                fixObject++;
             }
 
             AlterObjectOwner( anObject, -1, true);
@@ -2531,9 +2545,9 @@ void DestroyObject( spaceObjectType *anObject)
                 (!(anObject->baseType->destroyActionNum & kDestroyActionDontDieFlag)))
             {
                 RemoveDestination( anObject->destinationObject);
-                fixObject = gSpaceObjectData.get();
-                for ( i = 0; i < kMaxSpaceObject; i++)
+                for ( i = NextSpaceObject(-1); i >= 0; i = NextSpaceObject(i))
                 {
+                    fixObject = mGetSpaceObjectPtr(i);
                     if (( fixObject->attributes & kCanAcceptDestination) && ( fixObject->active !=
                         kObjectAvailable))
                     {
@@ -2544,7 +2558,6 @@ void DestroyObject( spaceObjectType *anObject)
                             fixObject->attributes &= ~kStaticDestination;
                         }
                     }
-                    fixObject++;
                 }
             }
 
@@ -2652,4 +2665,420 @@ StringSlice get_object_short_name(int16_t id) {
     return space_object_short_names->at(id);
 }
 
+// Snapshots refer to other objects, base objects, actions and sprites by number, since the
+// pointers in a snapshot would mean nothing to the process that restores it.
+
+static int32_t SpaceObjectNumber(const spaceObjectType* object) {
+    return object ? object->entryNumber : -1;
+}
+
+static int32_t BaseObjectNumber(const baseObjectType* base) {
+    const baseObjectType* first = gBaseObjectData.get();
+    if ((base < first) || (base >= (first + globals()->maxBaseObject))) {
+        return -1;
+    }
+    return base - first;
+}
+
+static int32_t ObjectActionNumber(const objectActionType* action) {
+    const objectActionType* first = gObjectActionData.get();
+    if ((action < first) || (action >= (first + globals()->maxObjectAction))) {
+        return -1;
+    }
+    return action - first;
+}
+
+StringSlice space_object_field_group_name(SpaceObjectFieldGroup group) {
+    switch (group) {
+      case kObjectIdentityFields:
+        return "identity (attributes, baseType, keysDown, tinySize, tinyColor)";
+      case kObjectRotationFields:
+        return "rotation (direction, directionGoal, turnVelocity, turnFraction, offlineTime)";
+      case kObjectLocationFields:
+        return "location (location, lastLocation, lastDir)";
+      case kObjectProximityFields:
+        return "proximity (collideObject, nextNearObject, nextFarObject, collisionGrid, "
+            "distanceGrid, previousObject, nextObject)";
+      case kObjectDestinationFields:
+        return "destination (runTimeFlags, destinationLocation, destinationObject, "
+            "destObjectPtr, destObjectDest, destObjectID, destObjectDestID)";
+      case kObjectStrengthFields:
+        return "strength (local/remote friend/foe strength, escortStrength, target values)";
+      case kObjectMotionFields:
+        return "motion (timeFromOrigin, idealLocationCalc, originLocation, motionFraction, "
+            "velocity, thrust, maxVelocity, scaledCornerOffset, scaledSize, absoluteBounds, "
+            "randomSeed)";
+      case kObjectFrameFields:
+        return "frame (beam or animation)";
+      case kObjectConditionFields:
+        return "condition (health, energy, battery, owner, age, naturalScale, id, charges, "
+            "active, warpEnergyCollected)";
+      case kObjectSpriteFields:
+        return "sprite (layer, sprite, whichSprite)";
+      case kObjectTargetFields:
+        return "target (distanceFromPlayer, closestDistance, closestObject, targetObjectNumber, "
+            "targetObjectID, targetAngle, lastTarget, lastTargetDistance, weapon ranges, "
+            "engageRange)";
+      case kObjectPresenceFields:
+        return "presence (presenceState, presenceData, hitState, cloakState, duty, pixResID)";
+      case kObjectWeaponFields:
+        return "weapons (pulse, beam and special base, type, time, ammo, position)";
+      case kObjectFlagFields:
+        return "flags (periodicTime, whichLabel, myPlayerFlag, seenByPlayerFlags, "
+            "hostileTowardsFlags, shieldColor, originalColor)";
+      case kObjectFieldGroupCount:
+        break;
+    }
+    return "unknown";
+}
+
+void SaveSpaceObjectFields(
+        WriteTarget out, const spaceObjectType& o, SpaceObjectFieldGroup group) {
+    switch (group) {
+      case kObjectIdentityFields:
+        write(out, o.attributes);
+        write(out, BaseObjectNumber(o.baseType));
+        write(out, o.whichBaseObject);
+        write(out, o.keysDown);
+        write(out, o.tinySize);
+        write(out, o.tinyColor.alpha);
+        write(out, o.tinyColor);
+        break;
+
+      case kObjectRotationFields:
+        write(out, o.direction);
+        write(out, o.directionGoal);
+        write(out, o.turnVelocity);
+        write(out, o.turnFraction);
+        write(out, o.offlineTime);
+        break;
+
+      case kObjectLocationFields:
+        write(out, o.location);
+        write(out, o.lastLocation);
+        write(out, o.lastDir);
+        break;
+
+      case kObjectProximityFields:
+        write(out, SpaceObjectNumber(o.collideObject));
+        write(out, o.collisionGrid);
+        write(out, SpaceObjectNumber(o.nextNearObject));
+        write(out, o.distanceGrid);
+        write(out, SpaceObjectNumber(o.nextFarObject));
+        write(out, SpaceObjectNumber(o.previousObject));
+        write(out, o.previousObjectNumber);
+        write(out, SpaceObjectNumber(o.nextObject));
+        write(out, o.nextObjectNumber);
+        break;
+
+      case kObjectDestinationFields:
+        write(out, o.runTimeFlags);
+        write(out, o.destinationLocation);
+        write(out, o.destinationObject);
+        write(out, SpaceObjectNumber(o.destObjectPtr));
+        write(out, o.destObjectDest);
+        write(out, o.destObjectID);
+        write(out, o.destObjectDestID);
+        break;
+
+      case kObjectStrengthFields:
+        write(out, o.localFriendStrength);
+        write(out, o.localFoeStrength);
+        write(out, o.escortStrength);
+        write(out, o.remoteFriendStrength);
+        write(out, o.remoteFoeStrength);
+        write(out, o.bestConsideredTargetValue);
+        write(out, o.currentTargetValue);
+        write(out, o.bestConsideredTargetNumber);
+        break;
+
+      case kObjectMotionFields:
+        write(out, o.timeFromOrigin);
+        write(out, o.idealLocationCalc);
+        write(out, o.originLocation);
+        write(out, o.motionFraction);
+        write(out, o.velocity);
+        write(out, o.thrust);
+        write(out, o.maxVelocity);
+        write(out, o.scaledCornerOffset);
+        write(out, o.scaledSize);
+        write(out, o.absoluteBounds);
+        write(out, o.randomSeed.seed);
+        break;
+
+      case kObjectFrameFields:
+        if (o.attributes & kIsBeam) {
+            write(out, o.frame.beam.whichBeam);
+        } else {
+            write(out, o.frame.animation.thisShape);
+            write(out, o.frame.animation.frameFraction);
+            write(out, o.frame.animation.frameDirection);
+            write(out, o.frame.animation.frameSpeed);
+        }
+        break;
+
+      case kObjectConditionFields:
+        write(out, o.health);
+        write(out, o.energy);
+        write(out, o.battery);
+        write(out, o.owner);
+        write(out, o.age);
+        write(out, o.naturalScale);
+        write(out, o.id);
+        write(out, o.rechargeTime);
+        write(out, o.pulseCharge);
+        write(out, o.beamCharge);
+        write(out, o.specialCharge);
+        write(out, o.active);
+        write(out, o.warpEnergyCollected);
+        break;
+
+      case kObjectSpriteFields:
+        write(out, o.layer);
+        write(out, o.sprite != NULL);
+        write(out, o.whichSprite);
+        break;
+
+      case kObjectTargetFields:
+        write(out, o.distanceFromPlayer);
+        write(out, o.closestDistance);
+        write(out, o.closestObject);
+        write(out, o.targetObjectNumber);
+        write(out, o.targetObjectID);
+        write(out, o.targetAngle);
+        write(out, o.lastTarget);
+        write(out, o.lastTargetDistance);
+        write(out, o.longestWeaponRange);
+        write(out, o.shortestWeaponRange);
+        write(out, o.engageRange);
+        break;
+
+      case kObjectPresenceFields:
+        write<int32_t>(out, o.presenceState);
+        write(out, o.presenceData);
+        write(out, o.hitState);
+        write(out, o.cloakState);
+        write<int32_t>(out, o.duty);
+        write<int32_t>(out, o.pixResID);
+        break;
+
+      case kObjectWeaponFields:
+        write(out, BaseObjectNumber(o.pulseBase));
+        write(out, o.pulseType);
+        write(out, o.pulseTime);
+        write(out, o.pulseAmmo);
+        write(out, o.pulsePosition);
+        write(out, BaseObjectNumber(o.beamBase));
+        write(out, o.beamType);
+        write(out, o.beamTime);
+        write(out, o.beamAmmo);
+        write(out, o.beamPosition);
+        write(out, BaseObjectNumber(o.specialBase));
+        write(out, o.specialType);
+        write(out, o.specialTime);
+        write(out, o.specialAmmo);
+        write(out, o.specialPosition);
+        break;
+
+      case kObjectFlagFields:
+        write(out, o.periodicTime);
+        write(out, o.whichLabel);
+        write(out, o.myPlayerFlag);
+        write(out, o.seenByPlayerFlags);
+        write(out, o.hostileTowardsFlags);
+        write(out, o.shieldColor);
+        write(out, o.originalColor);
+        break;
+
+      case kObjectFieldGroupCount:
+        break;
+    }
+}
+
+static void write_object(WriteTarget out, const spaceObjectType& o) {
+    for (int group = 0; group < kObjectFieldGroupCount; ++group) {
+        SaveSpaceObjectFields(out, o, static_cast<SpaceObjectFieldGroup>(group));
+    }
+}
+
+static void read_object(ReadSource in, spaceObjectType& o) {
+    read(in, o.attributes);
+    o.baseType = mGetBaseObjectPtr(read<int32_t>(in));
+    read(in, o.whichBaseObject);
+    read(in, o.keysDown);
+    read(in, o.tinySize);
+    read(in, o.tinyColor.alpha);
+    read(in, o.tinyColor);
+    read(in, o.direction);
+    read(in, o.directionGoal);
+    read(in, o.turnVelocity);
+    read(in, o.turnFraction);
+    read(in, o.offlineTime);
+    read(in, o.location);
+    read(in, o.lastLocation);
+    read(in, o.lastDir);
+    o.collideObject = mGetSpaceObjectPtr(read<int32_t>(in));
+    read(in, o.collisionGrid);
+    o.nextNearObject = mGetSpaceObjectPtr(read<int32_t>(in));
+    read(in, o.distanceGrid);
+    o.nextFarObject = mGetSpaceObjectPtr(read<int32_t>(in));
+    o.previousObject = mGetSpaceObjectPtr(read<int32_t>(in));
+    read(in, o.previousObjectNumber);
+    o.nextObject = mGetSpaceObjectPtr(read<int32_t>(in));
+    read(in, o.nextObjectNumber);
+    read(in, o.runTimeFlags);
+    read(in, o.destinationLocation);
+    read(in, o.destinationObject);
+    o.destObjectPtr = mGetSpaceObjectPtr(read<int32_t>(in));
+    read(in, o.destObjectDest);
+    read(in, o.destObjectID);
+    read(in, o.destObjectDestID);
+    read(in, o.localFriendStrength);
+    read(in, o.localFoeStrength);
+    read(in, o.escortStrength);
+    read(in, o.remoteFriendStrength);
+    read(in, o.remoteFoeStrength);
+    read(in, o.bestConsideredTargetValue);
+    read(in, o.currentTargetValue);
+    read(in, o.bestConsideredTargetNumber);
+    read(in, o.timeFromOrigin);
+    read(in, o.idealLocationCalc);
+    read(in, o.originLocation);
+    read(in, o.motionFraction);
+    read(in, o.velocity);
+    read(in, o.thrust);
+    read(in, o.maxVelocity);
+    read(in, o.scaledCornerOffset);
+    read(in, o.scaledSize);
+    read(in, o.absoluteBounds);
+    read(in, o.randomSeed.seed);
+    if (o.attributes & kIsBeam) {
+        read(in, o.frame.beam.whichBeam);
+        o.frame.beam.beam = Beams::get(o.frame.beam.whichBeam);
+    } else {
+        read(in, o.frame.animation.thisShape);
+        read(in, o.frame.animation.frameFraction);
+        read(in, o.frame.animation.frameDirection);
+        read(in, o.frame.animation.frameSpeed);
+    }
+    read(in, o.health);
+    read(in, o.energy);
+    read(in, o.battery);
+    read(in, o.owner);
+    read(in, o.age);
+    read(in, o.naturalScale);
+    read(in, o.id);
+    read(in, o.rechargeTime);
+    read(in, o.pulseCharge);
+    read(in, o.beamCharge);
+    read(in, o.specialCharge);
+    read(in, o.active);
+    read(in, o.warpEnergyCollected);
+    read(in, o.layer);
+    const bool has_sprite = read<bool>(in);
+    read(in, o.whichSprite);
+    o.sprite = has_sprite ? GetSprite(o.whichSprite) : NULL;
+    read(in, o.distanceFromPlayer);
+    read(in, o.closestDistance);
+    read(in, o.closestObject);
+    read(in, o.targetObjectNumber);
+    read(in, o.targetObjectID);
+    read(in, o.targetAngle);
+    read(in, o.lastTarget);
+    read(in, o.lastTargetDistance);
+    read(in, o.longestWeaponRange);
+    read(in, o.shortestWeaponRange);
+    read(in, o.engageRange);
+    o.presenceState = static_cast<kPresenceStateType>(read<int32_t>(in));
+    read(in, o.presenceData);
+    read(in, o.hitState);
+    read(in, o.cloakState);
+    o.duty = static_cast<dutyType>(read<int32_t>(in));
+    o.pixResID = read<int32_t>(in);
+    o.pulseBase = mGetBaseObjectPtr(read<int32_t>(in));
+    read(in, o.pulseType);
+    read(in, o.pulseTime);
+    read(in, o.pulseAmmo);
+    read(in, o.pulsePosition);
+    o.beamBase = mGetBaseObjectPtr(read<int32_t>(in));
+    read(in, o.beamType);
+    read(in, o.beamTime);
+    read(in, o.beamAmmo);
+    read(in, o.beamPosition);
+    o.specialBase = mGetBaseObjectPtr(read<int32_t>(in));
+    read(in, o.specialType);
+    read(in, o.specialTime);
+    read(in, o.specialAmmo);
+    read(in, o.specialPosition);
+    read(in, o.periodicTime);
+    read(in, o.whichLabel);
+    read(in, o.myPlayerFlag);
+    read(in, o.seenByPlayerFlags);
+    read(in, o.hostileTowardsFlags);
+    read(in, o.shieldColor);
+    read(in, o.originalColor);
+}
+
+// Every slot that has ever held an object is written in full, free or not: objects that are
+// still alive may point at dead ones and compare their IDs.  Slots that have never been used
+// (generation 0) hold nothing worth keeping.
+void SaveSpaceObjects(WriteTarget out) {
+    write(out, gSpaceObjectLimit);
+    write<int32_t>(out, SpaceObjectCapacity());
+    write<int32_t>(out, gRootObjectNumber);
+    for (int32_t i = 0; i < SpaceObjectCapacity(); ++i) {
+        write(out, gSpaceObjectGeneration[i]);
+        if (gSpaceObjectGeneration[i] > 0) {
+            write_object(out, *mGetSpaceObjectPtr(i));
+        }
+    }
+    SaveActionQueue(out);
+}
+
+void SaveActionQueue(WriteTarget out) {
+    gActionQueue.save(out, [](WriteTarget out, const actionQueueType& entry) {
+        write(out, ObjectActionNumber(entry.action));
+        write(out, entry.actionNum);
+        write(out, entry.actionToDo);
+        write(out, entry.subjectObject);
+        write(out, entry.directObject);
+        write(out, entry.offset);
+    });
+}
+
+void RestoreSpaceObjects(ReadSource in) {
+    SetSpaceObjectLimit(read<int32_t>(in));
+    const int32_t capacity = read<int32_t>(in);
+    if ((capacity < 0) || (capacity > kMaxSpaceObject) || (capacity % kSpaceObjectChunkSize)) {
+        throw Exception(format("invalid space object capacity {0}", capacity));
+    }
+    gSpaceObjectChunks.clear();
+    gSpaceObjectOccupied.clear();
+    gSpaceObjectGeneration.clear();
+    while (SpaceObjectCapacity() < capacity) {
+        AddSpaceObjectChunk();
+    }
+
+    gRootObjectNumber = read<int32_t>(in);
+    gRootObject = mGetSpaceObjectPtr(gRootObjectNumber);
+    for (int32_t i = 0; i < capacity; ++i) {
+        spaceObjectType* object = mGetSpaceObjectPtr(i);
+        read(in, gSpaceObjectGeneration[i]);
+        if (gSpaceObjectGeneration[i] > 0) {
+            read_object(in, *object);
+        }
+        object->entryNumber = i;
+        SetSpaceObjectOccupied(i, object->active != kObjectAvailable);
+    }
+
+    gActionQueue.restore(in, [](ReadSource in, actionQueueType* entry) {
+        entry->action = mGetObjectActionPtr(read<int32_t>(in));
+        read(in, entry->actionNum);
+        read(in, entry->actionToDo);
+        read(in, entry->subjectObject);
+        read(in, entry->directObject);
+        read(in, entry->offset);
+    });
+}
+
 }  // namespace antares
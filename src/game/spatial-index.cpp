@@ -0,0 +1,200 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "game/spatial-index.hpp"
+
+#include <algorithm>
+
+#include "data/space-object.hpp"
+
+using std::equal_range;
+using std::vector;
+
+namespace antares {
+
+namespace {
+
+const int32_t kWrap = 16;
+
+// Offsets of the cells to check for each neighbor, relative to the object's own cell.
+const int32_t kNeighborOffset[SpatialIndex::NEIGHBOR_COUNT][2] = {
+    {0, 0},
+    {1, 0},
+    {-1, 1},
+    {0, 1},
+    {1, 1},
+};
+
+// Insertion sort is linear on the nearly-sorted orders we get from one frame to the next, but
+// quadratic if a lot has changed (say, on the first frame).  Past this many moves per entry,
+// give up and sort from scratch.
+const size_t kMaxMovesPerEntry = 8;
+
+template <typename T>
+inline int32_t wrapped_cell(const T& e) {
+    return ((e.v & (kWrap - 1)) * kWrap) + (e.h & (kWrap - 1));
+}
+
+// Visit order: by wrapped cell, row by row, then oldest first.
+struct VisitLess {
+    template <typename T>
+    bool operator()(const T& x, const T& y) const {
+        const int32_t cx = wrapped_cell(x), cy = wrapped_cell(y);
+        if (cx != cy) {
+            return cx < cy;
+        }
+        return x.rank > y.rank;
+    }
+};
+
+// Cell order: by cell, row by row, then oldest first.
+struct CellLess {
+    template <typename T>
+    bool operator()(const T& x, const T& y) const {
+        if (x.v != y.v) {
+            return x.v < y.v;
+        } else if (x.h != y.h) {
+            return x.h < y.h;
+        }
+        return x.rank > y.rank;
+    }
+};
+
+// Compares only the cell, for finding all entries in one.
+struct SameCell {
+    template <typename T>
+    bool operator()(const T& x, const T& y) const {
+        return (x.v != y.v) ? (x.v < y.v) : (x.h < y.h);
+    }
+};
+
+}  // namespace
+
+SpatialIndex::SpatialIndex(int32_t shift)
+        : _shift(shift) { }
+
+void SpatialIndex::clear() {
+    _added.clear();
+}
+
+void SpatialIndex::add(spaceObjectType* object) {
+    // Same arithmetic as the old grid, which treated locations as signed.
+    Entry e;
+    e.h = static_cast<int32_t>(object->location.h) >> _shift;
+    e.v = static_cast<int32_t>(object->location.v) >> _shift;
+    e.rank = _added.size();
+    e.number = object->entryNumber;
+    e.object = object;
+    if (e.number >= _rank.size()) {
+        _rank.resize(e.number + 1, -1);
+    }
+    _rank[e.number] = e.rank;
+    _added.push_back(e);
+}
+
+void SpatialIndex::sort() {
+    reorder(_visit, VisitLess());
+    reorder(_cells, CellLess());
+
+    _cell_objects.resize(_cells.size());
+    _cell_position.resize(_cells.size());
+    for (size_t i = 0; i < _cells.size(); ++i) {
+        _cell_objects[i] = _cells[i].object;
+        _cell_position[_cells[i].rank] = i;
+    }
+}
+
+// Rebuilds `order` from the objects added this frame, starting from last frame's order of
+// whichever of them were around then, followed by the newcomers.
+template <typename Less>
+void SpatialIndex::reorder(vector<Entry>& order, Less less) {
+    _taken.assign(_added.size(), 0);
+    _scratch.clear();
+    for (const Entry& e: order) {
+        // Compares pointers without following them: the objects of last frame may be gone.
+        if (e.number >= _rank.size()) {
+            continue;
+        }
+        const int32_t rank = _rank[e.number];
+        if ((rank >= 0) && (rank < _added.size()) && (_added[rank].object == e.object)
+                && !_taken[rank]) {
+            _taken[rank] = 1;
+            _scratch.push_back(_added[rank]);
+        }
+    }
+    for (const Entry& e: _added) {
+        if (!_taken[e.rank]) {
+            _scratch.push_back(e);
+        }
+    }
+    order.swap(_scratch);
+
+    size_t moves = 0;
+    const size_t max_moves = kMaxMovesPerEntry * order.size();
+    for (size_t i = 1; i < order.size(); ++i) {
+        Entry e = order[i];
+        size_t j = i;
+        while ((j > 0) && less(e, order[j - 1])) {
+            order[j] = order[j - 1];
+            --j;
+            if (++moves > max_moves) {
+                order[j] = e;
+                std::sort(order.begin(), order.end(), less);
+                return;
+            }
+        }
+        order[j] = e;
+    }
+}
+
+SpatialIndex::Span SpatialIndex::cell(int32_t h, int32_t v) const {
+    Entry key;
+    key.h = h;
+    key.v = v;
+    auto range = equal_range(_cells.begin(), _cells.end(), key, SameCell());
+    Span span;
+    span.begin = _cell_objects.data() + (range.first - _cells.begin());
+    span.end = _cell_objects.data() + (range.second - _cells.begin());
+    return span;
+}
+
+SpatialIndex::Span SpatialIndex::candidates(size_t index, int neighbor) const {
+    const Entry& e = _visit[index];
+    const int32_t h = e.h + kNeighborOffset[neighbor][0];
+    const int32_t v = e.v + kNeighborOffset[neighbor][1];
+    if ((h < 0) || (v < 0)) {
+        Span empty = {NULL, NULL};
+        return empty;
+    }
+    Span span = cell(h, v);
+    if (neighbor == 0) {
+        // The rest of the object's own cell: everything newer than it.
+        span.begin = _cell_objects.data() + _cell_position[e.rank] + 1;
+    }
+    return span;
+}
+
+spaceObjectType* SpatialIndex::next_in_wrapped_cell(size_t index) const {
+    if (((index + 1) < _visit.size())
+            && (wrapped_cell(_visit[index]) == wrapped_cell(_visit[index + 1]))) {
+        return _visit[index + 1].object;
+    }
+    return NULL;
+}
+
+}  // namespace antares
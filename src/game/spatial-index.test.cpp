@@ -0,0 +1,282 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "game/spatial-index.hpp"
+
+#include <random>
+#include <utility>
+#include <vector>
+#include <gmock/gmock.h>
+
+#include "data/space-object.hpp"
+#include "math/units.hpp"
+
+using std::pair;
+using std::vector;
+using testing::ElementsAre;
+
+namespace antares {
+namespace {
+
+typedef testing::Test SpatialIndexTest;
+typedef vector<pair<int32_t, int32_t>> Pairs;
+
+const int32_t kWrap = 16;
+const int32_t kWrapShift = 4;
+const int32_t kOffsets[SpatialIndex::NEIGHBOR_COUNT][2] = {
+    {0, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1},
+};
+
+// The 16x16 grid that CollideSpaceObjects() used before SpatialIndex, reduced to the pairs it
+// considered.  Objects are pushed onto the front of their cell's chain in list order; each
+// object is paired with the rest of its own chain, then with the chains of the cells to its
+// east, southwest, south and southeast, wrapping around the edges of the grid.  A pair counts
+// only if both objects are in the same "super" cell once the wrap-around is accounted for.
+class OldGrid {
+  public:
+    OldGrid(const vector<spaceObjectType*>& list, int32_t shift) {
+        for (spaceObjectType* o: list) {
+            Cell c;
+            c.object = o;
+            c.h = static_cast<int32_t>(o->location.h) >> shift;
+            c.v = static_cast<int32_t>(o->location.v) >> shift;
+            _chains[wrapped(c.h, c.v)].insert(_chains[wrapped(c.h, c.v)].begin(), c);
+        }
+    }
+
+    Pairs pairs() const {
+        Pairs result;
+        for (int32_t slot = 0; slot < (kWrap * kWrap); ++slot) {
+            const vector<Cell>& chain = _chains[slot];
+            for (size_t a = 0; a < chain.size(); ++a) {
+                const int32_t super_h = chain[a].h >> kWrapShift;
+                const int32_t super_v = chain[a].v >> kWrapShift;
+                for (int k = 0; k < SpatialIndex::NEIGHBOR_COUNT; ++k) {
+                    int32_t x = (slot % kWrap) + kOffsets[k][0];
+                    int32_t y = (slot / kWrap) + kOffsets[k][1];
+                    int32_t super_x = super_h, super_y = super_v;
+                    if (x < 0) {
+                        x += kWrap;
+                        --super_x;
+                    } else if (x >= kWrap) {
+                        x -= kWrap;
+                        ++super_x;
+                    }
+                    if (y >= kWrap) {
+                        y -= kWrap;
+                        ++super_y;
+                    }
+                    if ((super_x < 0) || (super_y < 0)) {
+                        continue;
+                    }
+                    const vector<Cell>& other = _chains[(y * kWrap) + x];
+                    for (size_t b = (k == 0) ? (a + 1) : 0; b < other.size(); ++b) {
+                        if (((other[b].h >> kWrapShift) == super_x)
+                                && ((other[b].v >> kWrapShift) == super_y)) {
+                            result.push_back(std::make_pair(
+                                        chain[a].object->entryNumber,
+                                        other[b].object->entryNumber));
+                        }
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    // Each object's successor in its chain, as nextNearObject/nextFarObject were set.
+    Pairs chains() const {
+        Pairs result;
+        for (const vector<Cell>& chain: _chains) {
+            for (size_t i = 0; i < chain.size(); ++i) {
+                result.push_back(std::make_pair(
+                            chain[i].object->entryNumber,
+                            (i + 1 < chain.size()) ? chain[i + 1].object->entryNumber : -1));
+            }
+        }
+        return result;
+    }
+
+  private:
+    struct Cell {
+        spaceObjectType*    object;
+        int32_t             h;
+        int32_t             v;
+    };
+
+    static int32_t wrapped(int32_t h, int32_t v) {
+        return ((v & (kWrap - 1)) * kWrap) + (h & (kWrap - 1));
+    }
+
+    vector<Cell> _chains[kWrap * kWrap];
+};
+
+Pairs index_pairs(const SpatialIndex& index) {
+    Pairs result;
+    for (size_t n = 0; n < index.size(); ++n) {
+        for (int k = 0; k < SpatialIndex::NEIGHBOR_COUNT; ++k) {
+            SpatialIndex::Span span = index.candidates(n, k);
+            for (spaceObjectType* const* b = span.begin; b != span.end; ++b) {
+                result.push_back(std::make_pair(index.at(n)->entryNumber, (*b)->entryNumber));
+            }
+        }
+    }
+    return result;
+}
+
+Pairs index_chains(const SpatialIndex& index) {
+    Pairs result;
+    for (size_t n = 0; n < index.size(); ++n) {
+        spaceObjectType* next = index.next_in_wrapped_cell(n);
+        result.push_back(std::make_pair(index.at(n)->entryNumber, next ? next->entryNumber : -1));
+    }
+    return result;
+}
+
+// Places objects in clusters around points where the grid wraps: the edges of the universe,
+// the point where locations turn negative as signed values, and the universe's center, plus a
+// few anywhere at all.  Clusters span several cells and super cells, so there are many pairs.
+class RandomWorld {
+  public:
+    RandomWorld(uint32_t seed, int32_t shift): _engine(seed), _shift(shift) { }
+
+    uint32_t location() {
+        static const uint32_t kCenters[] = {
+            0, 0x7fffffff, 0x80000000, 0xffffffff, kUniversalCenter,
+        };
+        if ((_engine() % 16) == 0) {
+            return _engine();
+        }
+        const uint32_t center = kCenters[_engine() % 5];
+        const int32_t spread = (kWrap * 3) << _shift;
+        return center + static_cast<uint32_t>((_engine() % (2 * spread)) - spread);
+    }
+
+    void place(spaceObjectType* o) {
+        o->location.h = location();
+        o->location.v = location();
+    }
+
+    // Moves objects a little, as from one frame to the next, and now and then a long way.
+    void move(spaceObjectType* o) {
+        if ((_engine() % 32) == 0) {
+            place(o);
+            return;
+        }
+        const int32_t step = 2 << _shift;
+        o->location.h += static_cast<uint32_t>((_engine() % (2 * step)) - step);
+        o->location.v += static_cast<uint32_t>((_engine() % (2 * step)) - step);
+    }
+
+    uint32_t next() { return _engine(); }
+
+  private:
+    std::mt19937 _engine;
+    const int32_t _shift;
+};
+
+// Runs several frames against one index, so that the orders it keeps between frames are
+// exercised: objects move, die, and are created, sometimes in slots that were just freed.
+void check_frames(uint32_t seed, int32_t shift, size_t count) {
+    RandomWorld world(seed, shift);
+    vector<spaceObjectType> objects(count * 2);
+    vector<spaceObjectType*> free;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        objects[i].entryNumber = i;
+        free.push_back(&objects[objects.size() - 1 - i]);
+    }
+
+    vector<spaceObjectType*> list;  // newest first, as the game's object list is
+    SpatialIndex index(shift);
+    for (int frame = 0; frame < 20; ++frame) {
+        vector<spaceObjectType*> survivors;
+        for (spaceObjectType* o: list) {
+            if ((world.next() % 16) == 0) {
+                free.push_back(o);
+            } else {
+                world.move(o);
+                survivors.push_back(o);
+            }
+        }
+        list.swap(survivors);
+        while ((list.size() < count) && !free.empty()) {
+            spaceObjectType* o = free.back();
+            free.pop_back();
+            world.place(o);
+            list.insert(list.begin(), o);
+        }
+
+        index.clear();
+        for (spaceObjectType* o: list) {
+            index.add(o);
+        }
+        index.sort();
+
+        OldGrid grid(list, shift);
+        ASSERT_EQ(grid.pairs(), index_pairs(index))
+            << "seed " << seed << ", shift " << shift << ", frame " << frame;
+        EXPECT_EQ(grid.chains(), index_chains(index))
+            << "seed " << seed << ", shift " << shift << ", frame " << frame;
+    }
+}
+
+// The collision pass, with 128-unit cells.
+TEST_F(SpatialIndexTest, CollisionPairs) {
+    for (uint32_t seed = 1; seed <= 50; ++seed) {
+        check_frames(seed, 7, 250);
+    }
+}
+
+// The distance pass, with 2048-unit cells.
+TEST_F(SpatialIndexTest, DistancePairs) {
+    for (uint32_t seed = 1; seed <= 50; ++seed) {
+        check_frames(seed, 11, 250);
+    }
+}
+
+// Enough objects that most cells hold several, and the insertion sort gives up sometimes.
+TEST_F(SpatialIndexTest, Crowded) {
+    for (uint32_t seed = 1; seed <= 5; ++seed) {
+        check_frames(seed, 7, 2000);
+    }
+}
+
+// Locations are taken as signed, so the ends of the universe are next to each other: the objects
+// just below zero pair with the one at zero, but only from the south and east of it.
+TEST_F(SpatialIndexTest, Edges) {
+    vector<spaceObjectType> objects(4);
+    const uint32_t kLocations[][2] = {
+        {0, 0}, {0xffffffff, 0}, {0, 0xffffffff}, {0xffffffff, 0xffffffff},
+    };
+    vector<spaceObjectType*> list;
+    SpatialIndex index(7);
+    for (size_t i = 0; i < objects.size(); ++i) {
+        objects[i].entryNumber = i;
+        objects[i].location.h = kLocations[i][0];
+        objects[i].location.v = kLocations[i][1];
+        list.push_back(&objects[i]);
+        index.add(&objects[i]);
+    }
+    index.sort();
+    EXPECT_THAT(index_pairs(index), ElementsAre(
+                std::make_pair(1, 0), std::make_pair(2, 0), std::make_pair(3, 0)));
+    EXPECT_EQ(OldGrid(list, 7).pairs(), index_pairs(index));
+}
+
+}  // namespace
+}  // namespace antares
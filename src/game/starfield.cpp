@@ -29,7 +29,11 @@
 #include "video/driver.hpp"
 
 using sfz::Exception;
+using sfz::ReadSource;
+using sfz::WriteTarget;
 using sfz::range;
+using sfz::read;
+using sfz::write;
 
 namespace antares {
 
@@ -357,4 +361,42 @@ void Starfield::show() {
     _last_clip_bottom = viewport.bottom;
 }
 
+// The starfield is scenery, but moving it draws on gRandomSeed, so it has to come back exactly
+// as it was for play to continue the same way.
+void Starfield::save(WriteTarget out) const {
+    write<int32_t>(out, gScrollStarObject ? gScrollStarObject->entryNumber : -1);
+    write(out, _last_clip_bottom);
+    write(out, _warp_stars);
+    for (const scrollStarType* star: range(_stars, _stars + kAllStarNum)) {
+        write(out, star->speed);
+        if (star->speed == kNoStar) {
+            continue;
+        }
+        write(out, star->oldLocation);
+        write(out, star->location);
+        write(out, star->motionFraction);
+        write(out, star->velocity);
+        write(out, star->age);
+        write(out, star->color);
+    }
+}
+
+void Starfield::restore(ReadSource in) {
+    gScrollStarObject = mGetSpaceObjectPtr(read<int32_t>(in));
+    read(in, _last_clip_bottom);
+    read(in, _warp_stars);
+    for (scrollStarType* star: range(_stars, _stars + kAllStarNum)) {
+        read(in, star->speed);
+        if (star->speed == kNoStar) {
+            continue;
+        }
+        read(in, star->oldLocation);
+        read(in, star->location);
+        read(in, star->motionFraction);
+        read(in, star->velocity);
+        read(in, star->age);
+        read(in, star->color);
+    }
+}
+
 }  // namespace antares
@@ -0,0 +1,383 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "game/sync.hpp"
+
+#include <algorithm>
+#include <sfz/sfz.hpp>
+
+#include "game/admiral.hpp"
+#include "game/beam.hpp"
+#include "game/globals.hpp"
+#include "game/scenario-maker.hpp"
+#include "game/space-object.hpp"
+#include "math/random.hpp"
+#include "math/units.hpp"
+
+using sfz::Bytes;
+using sfz::BytesSlice;
+using sfz::PrintItem;
+using sfz::PrintTarget;
+using sfz::String;
+using sfz::StringSlice;
+using sfz::format;
+using sfz::hex;
+using sfz::print;
+using sfz::read;
+using sfz::write;
+using std::equal;
+using std::max;
+using std::vector;
+
+namespace antares {
+
+namespace {
+
+// FNV-1a: the digest may be taken every decide cycle, so it has to be cheap, but it only has to
+// catch accidents, not adversaries.
+const uint64_t kHashInit    = 14695981039346656037ULL;
+const uint64_t kHashPrime   = 1099511628211ULL;
+
+// Set in every field group hash of an object in use, so that none is 0.
+const uint64_t kObjectInUseBit = 0x8000000000000000ULL;
+
+// A delta names the groups that changed in a 16-bit mask.
+static_assert(kObjectFieldGroupCount <= 16, "too many field groups for a uint16_t mask");
+
+const ObjectFieldHashes kFreeSlot = {-1, -1, {}};
+
+const size_t kMaxReportedObjects = 8;
+
+bool sync_log = false;
+String sync_log_lines;
+
+// A WriteTarget that hashes what is written to it, so that state can be hashed as it is
+// serialized instead of serialized into a buffer first.
+class HashTarget {
+  public:
+    explicit HashTarget(uint64_t hash): _hash(hash) { }
+
+    uint64_t hash() const { return _hash; }
+
+    void push(const BytesSlice& bytes) {
+        const uint8_t* data = bytes.data();
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            _hash ^= data[i];
+            _hash *= kHashPrime;
+        }
+    }
+
+    void push(size_t num, uint8_t byte) {
+        for (size_t i = 0; i < num; ++i) {
+            _hash ^= byte;
+            _hash *= kHashPrime;
+        }
+    }
+
+  private:
+    uint64_t _hash;
+};
+
+uint64_t hash_value(uint64_t hash, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        hash ^= (value & 0xff);
+        hash *= kHashPrime;
+        value >>= 8;
+    }
+    return hash;
+}
+
+bool in_use(const ObjectFieldHashes& fields) {
+    return fields.group[0] != 0;
+}
+
+bool same_fields(const ObjectFieldHashes& a, const ObjectFieldHashes& b) {
+    return equal(a.group, a.group + kObjectFieldGroupCount, b.group);
+}
+
+const ObjectFieldHashes& object_fields_at(const vector<ObjectFieldHashes>& table, size_t i) {
+    return (i < table.size()) ? table[i] : kFreeSlot;
+}
+
+ObjectFieldHashes& mutable_object_fields_at(vector<ObjectFieldHashes>& table, size_t i) {
+    if (i >= table.size()) {
+        table.resize(i + 1, kFreeSlot);
+    }
+    return table[i];
+}
+
+void describe_object(
+        String& out, StringSlice (*object_name)(int16_t base), size_t number,
+        const ObjectFieldHashes& expected, const ObjectFieldHashes& actual) {
+    if (!in_use(expected)) {
+        print(out, format("object {0} is in use, but was free in the recording", number));
+        return;
+    } else if (!in_use(actual)) {
+        print(out, format("object {0} is free, but was in use in the recording", number));
+        return;
+    }
+    print(out, format(
+                "object {0} ({1}, id {2}) differs in", number, object_name(actual.base),
+                actual.id));
+    const char* separator = " ";
+    for (int group = 0; group < kObjectFieldGroupCount; ++group) {
+        if (expected.group[group] != actual.group[group]) {
+            print(out, separator);
+            print(out, space_object_field_group_name(static_cast<SpaceObjectFieldGroup>(group)));
+            separator = ", ";
+        }
+    }
+}
+
+void append_part(String& out, const PrintItem& part) {
+    if (!out.empty()) {
+        print(out, "; ");
+    }
+    print(out, part);
+}
+
+}  // namespace
+
+void HashSpaceObjectFields(const spaceObjectType& object, ObjectFieldHashes* hashes) {
+    hashes->base = object.whichBaseObject;
+    hashes->id = object.id;
+    for (int group = 0; group < kObjectFieldGroupCount; ++group) {
+        HashTarget hash(kHashInit);
+        SaveSpaceObjectFields(hash, object, static_cast<SpaceObjectFieldGroup>(group));
+        hashes->group[group] = hash.hash() | kObjectInUseBit;
+    }
+}
+
+void ComputeSyncDigest(SyncDigest* digest) {
+    digest->objects = kHashInit;
+    digest->object_fields.clear();
+    for (int32_t i = NextSpaceObject(-1); i >= 0; i = NextSpaceObject(i)) {
+        ObjectFieldHashes& fields = mutable_object_fields_at(digest->object_fields, i);
+        HashSpaceObjectFields(*mGetSpaceObjectPtr(i), &fields);
+        digest->objects = hash_value(digest->objects, i);
+        for (int group = 0; group < kObjectFieldGroupCount; ++group) {
+            digest->objects = hash_value(digest->objects, fields.group[group]);
+        }
+    }
+
+    HashTarget actions(kHashInit);
+    SaveActionQueue(actions);
+    digest->actions = actions.hash();
+
+    digest->admirals = kHashInit;
+    for (int i = 0; i < kMaxPlayerNum; ++i) {
+        HashTarget admiral(kHashInit);
+        SaveAdmiral(admiral, i);
+        const uint64_t hash = admiral.hash();
+        digest->admiral[i] = hash ^ (hash >> 32);
+        digest->admirals = hash_value(digest->admirals, hash);
+    }
+    HashTarget balances(digest->admirals);
+    SaveDestBalances(balances);
+    digest->admirals = balances.hash();
+
+    HashTarget scenario(kHashInit);
+    write(scenario, globals()->gGameTime);
+    write(scenario, gRandomSeed.seed);
+    write(scenario, globals()->gGameOver);
+    write(scenario, globals()->gScenarioWinner.player);
+    write(scenario, globals()->gScenarioWinner.next);
+    write(scenario, globals()->gScenarioWinner.text);
+    SaveScenarioState(scenario);
+    Beams::save(scenario);
+    digest->scenario = scenario.hash();
+}
+
+void enable_sync_log() {
+    sync_log = true;
+}
+
+bool sync_log_enabled() {
+    return sync_log;
+}
+
+void log_sync_digest(const SyncDigest& digest) {
+    print(sync_log_lines, format(
+                "{0}\t{1}\t{2}\t{3}\t{4}\n", usecs_to_ticks(globals()->gGameTime),
+                hex(digest.objects, 16), hex(digest.actions, 16), hex(digest.admirals, 16),
+                hex(digest.scenario, 16)));
+}
+
+void write_sync_log(PrintTarget out) {
+    print(out, sync_log_lines);
+}
+
+SyncRecorder::SyncRecorder():
+        _full(true) { }
+
+void SyncRecorder::reset() {
+    _full = true;
+}
+
+void SyncRecorder::encode(const SyncDigest& digest, Bytes* out) {
+    write<uint8_t>(*out, _full);
+    write(*out, digest.objects);
+    write(*out, digest.actions);
+    write(*out, digest.admirals);
+    write(*out, digest.scenario);
+    for (int i = 0; i < kMaxPlayerNum; ++i) {
+        write(*out, digest.admiral[i]);
+    }
+
+    if (_full) {
+        write<uint32_t>(*out, digest.object_fields.size());
+        for (const ObjectFieldHashes& fields: digest.object_fields) {
+            write<uint8_t>(*out, in_use(fields));
+            if (in_use(fields)) {
+                write(*out, fields.group, kObjectFieldGroupCount);
+            }
+        }
+    } else {
+        // Each changed slot is written with a mask of the groups that changed, and their new
+        // hashes.  A slot that was freed has a mask of 0.
+        const size_t size = max(digest.object_fields.size(), _object_fields.size());
+        uint32_t changed = 0;
+        for (size_t i = 0; i < size; ++i) {
+            if (!same_fields(
+                        object_fields_at(digest.object_fields, i),
+                        object_fields_at(_object_fields, i))) {
+                ++changed;
+            }
+        }
+        write(*out, changed);
+        for (size_t i = 0; i < size; ++i) {
+            const ObjectFieldHashes& fields = object_fields_at(digest.object_fields, i);
+            const ObjectFieldHashes& last = object_fields_at(_object_fields, i);
+            if (same_fields(fields, last)) {
+                continue;
+            }
+            uint16_t mask = 0;
+            if (in_use(fields)) {
+                for (int group = 0; group < kObjectFieldGroupCount; ++group) {
+                    if (fields.group[group] != last.group[group]) {
+                        mask |= 1 << group;
+                    }
+                }
+            }
+            write<uint32_t>(*out, i);
+            write(*out, mask);
+            for (int group = 0; group < kObjectFieldGroupCount; ++group) {
+                if (mask & (1 << group)) {
+                    write(*out, fields.group[group]);
+                }
+            }
+        }
+    }
+
+    _full = false;
+    _object_fields = digest.object_fields;
+}
+
+SyncChecker::SyncChecker(StringSlice (*object_name)(int16_t base)):
+        _object_name(object_name),
+        _have_objects(false) { }
+
+bool SyncChecker::check(BytesSlice recorded, const SyncDigest& actual, String* mismatch) {
+    SyncDigest expected;
+    const bool full = read<uint8_t>(recorded);
+    read(recorded, expected.objects);
+    read(recorded, expected.actions);
+    read(recorded, expected.admirals);
+    read(recorded, expected.scenario);
+    for (int i = 0; i < kMaxPlayerNum; ++i) {
+        read(recorded, expected.admiral[i]);
+    }
+
+    // A resumed replay may start reading between full tables; until it reaches one, only the
+    // hashes of each part can be compared.
+    if (full) {
+        _object_fields.assign(read<uint32_t>(recorded), kFreeSlot);
+        for (ObjectFieldHashes& fields: _object_fields) {
+            if (read<uint8_t>(recorded)) {
+                read(recorded, fields.group, kObjectFieldGroupCount);
+            }
+        }
+        _have_objects = true;
+    } else {
+        for (uint32_t count = read<uint32_t>(recorded); count > 0; --count) {
+            const uint32_t i = read<uint32_t>(recorded);
+            const uint16_t mask = read<uint16_t>(recorded);
+            ObjectFieldHashes changed = kFreeSlot;
+            if (_have_objects && mask) {
+                changed = object_fields_at(_object_fields, i);
+            }
+            for (int group = 0; group < kObjectFieldGroupCount; ++group) {
+                if (mask & (1 << group)) {
+                    read(recorded, changed.group[group]);
+                }
+            }
+            if (_have_objects) {
+                mutable_object_fields_at(_object_fields, i) = changed;
+            }
+        }
+    }
+
+    mismatch->clear();
+    if (expected.objects != actual.objects) {
+        size_t reported = 0;
+        size_t unreported = 0;
+        if (_have_objects) {
+            const size_t size = max(_object_fields.size(), actual.object_fields.size());
+            for (size_t i = 0; i < size; ++i) {
+                const ObjectFieldHashes& e = object_fields_at(_object_fields, i);
+                const ObjectFieldHashes& a = object_fields_at(actual.object_fields, i);
+                if (same_fields(e, a)) {
+                    continue;
+                } else if (reported == kMaxReportedObjects) {
+                    ++unreported;
+                    continue;
+                }
+                String description;
+                describe_object(description, _object_name, i, e, a);
+                append_part(*mismatch, description);
+                ++reported;
+            }
+        }
+        if (unreported > 0) {
+            append_part(*mismatch, format("{0} more objects differ", unreported));
+        } else if (reported == 0) {
+            append_part(*mismatch, "objects differ");
+        }
+    }
+    if (expected.actions != actual.actions) {
+        append_part(*mismatch, "the action queue differs");
+    }
+    if (expected.admirals != actual.admirals) {
+        bool any = false;
+        for (int i = 0; i < kMaxPlayerNum; ++i) {
+            if (expected.admiral[i] != actual.admiral[i]) {
+                append_part(*mismatch, format("admiral {0} differs", i));
+                any = true;
+            }
+        }
+        if (!any) {
+            append_part(*mismatch, "destination balances differ");
+        }
+    }
+    if (expected.scenario != actual.scenario) {
+        append_part(*mismatch, "game time, random seed, winner, conditions or beams differ");
+    }
+    return mismatch->empty();
+}
+
+}  // namespace antares
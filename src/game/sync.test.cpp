@@ -0,0 +1,176 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "game/sync.hpp"
+
+#include <gmock/gmock.h>
+
+#include "config/preferences.hpp"
+#include "game/globals.hpp"
+#include "math/fixed.hpp"
+#include "math/units.hpp"
+
+using sfz::Bytes;
+using sfz::String;
+using sfz::StringSlice;
+using sfz::format;
+
+namespace antares {
+namespace {
+
+const int kSlot = 3;
+
+class SyncTest : public testing::Test {
+  public:
+    // Hashing an object looks up its base object number, which needs the globals.
+    static void SetUpTestCase() {
+        prefs = new NullPrefsDriver;
+        init_globals();
+    }
+
+    static void TearDownTestCase() {
+        delete prefs;
+    }
+
+  private:
+    static NullPrefsDriver* prefs;
+};
+
+NullPrefsDriver* SyncTest::prefs;
+
+StringSlice object_name(int16_t base) {
+    return "Cruiser";
+}
+
+spaceObjectType cruiser() {
+    spaceObjectType object = {};
+    object.whichBaseObject = 5;
+    object.entryNumber = kSlot;
+    object.id = 7;
+    object.location.h = kUniversalCenter;
+    object.location.v = kUniversalCenter;
+    object.velocity.h = mLongToFixed(1);
+    object.health = 400;
+    object.owner = 1;
+    object.pulseAmmo = 10;
+    return object;
+}
+
+// A digest of a world with `object` in kSlot and nothing else.
+SyncDigest digest_of(const spaceObjectType& object) {
+    SyncDigest digest = {};
+    digest.object_fields.resize(kSlot + 1);
+    HashSpaceObjectFields(object, &digest.object_fields[kSlot]);
+    for (uint64_t hash: digest.object_fields[kSlot].group) {
+        digest.objects = (digest.objects * 31) + hash;
+    }
+    return digest;
+}
+
+// A digest of a world with nothing in it.
+SyncDigest empty_digest() {
+    SyncDigest digest = {};
+    return digest;
+}
+
+String differs_in(SpaceObjectFieldGroup group) {
+    return String(format(
+                "object {0} (Cruiser, id 7) differs in {1}", kSlot,
+                space_object_field_group_name(group)));
+}
+
+TEST_F(SyncTest, Match) {
+    SyncRecorder recorder;
+    SyncChecker checker(object_name);
+    Bytes recorded;
+    recorder.encode(digest_of(cruiser()), &recorded);
+    String mismatch;
+    EXPECT_TRUE(checker.check(recorded, digest_of(cruiser()), &mismatch));
+    EXPECT_EQ("", mismatch);
+}
+
+// Changing one field of an object makes the report name that field's group, and no other.
+TEST_F(SyncTest, FlippedField) {
+    struct Flip {
+        void (*flip)(spaceObjectType* object);
+        SpaceObjectFieldGroup group;
+    };
+    const Flip flips[] = {
+        {[](spaceObjectType* o) { o->direction += 1; }, kObjectRotationFields},
+        {[](spaceObjectType* o) { o->location.h += 1; }, kObjectLocationFields},
+        {[](spaceObjectType* o) { o->velocity.v += 1; }, kObjectMotionFields},
+        {[](spaceObjectType* o) { o->health -= 1; }, kObjectConditionFields},
+        {[](spaceObjectType* o) { o->owner = 0; }, kObjectConditionFields},
+        {[](spaceObjectType* o) { o->targetObjectID = 12; }, kObjectTargetFields},
+        {[](spaceObjectType* o) { o->pulseAmmo -= 1; }, kObjectWeaponFields},
+        {[](spaceObjectType* o) { o->periodicTime = 3; }, kObjectFlagFields},
+    };
+    for (const Flip& flip: flips) {
+        SyncRecorder recorder;
+        SyncChecker checker(object_name);
+        Bytes recorded;
+        recorder.encode(digest_of(cruiser()), &recorded);
+
+        spaceObjectType flipped = cruiser();
+        flip.flip(&flipped);
+        String mismatch;
+        EXPECT_FALSE(checker.check(recorded, digest_of(flipped), &mismatch));
+        EXPECT_EQ(differs_in(flip.group), mismatch);
+    }
+}
+
+// After the first digest, only changed groups are recorded; the checker has to apply them to
+// the table it already has.
+TEST_F(SyncTest, FlippedFieldAfterDelta) {
+    SyncRecorder recorder;
+    SyncChecker checker(object_name);
+    String mismatch;
+
+    spaceObjectType object = cruiser();
+    Bytes recorded;
+    recorder.encode(digest_of(object), &recorded);
+    EXPECT_TRUE(checker.check(recorded, digest_of(object), &mismatch));
+
+    object.location.h += 1;
+    recorded.clear();
+    recorder.encode(digest_of(object), &recorded);
+    spaceObjectType flipped = object;
+    flipped.health -= 1;
+    EXPECT_FALSE(checker.check(recorded, digest_of(flipped), &mismatch));
+    EXPECT_EQ(differs_in(kObjectConditionFields), mismatch);
+}
+
+TEST_F(SyncTest, Free) {
+    SyncRecorder recorder;
+    SyncChecker checker(object_name);
+    String mismatch;
+
+    Bytes recorded;
+    recorder.encode(digest_of(cruiser()), &recorded);
+    EXPECT_FALSE(checker.check(recorded, empty_digest(), &mismatch));
+    EXPECT_EQ(format("object {0} is free, but was in use in the recording", kSlot), mismatch);
+
+    // The slot is freed in a delta.
+    recorded.clear();
+    recorder.encode(empty_digest(), &recorded);
+    EXPECT_FALSE(checker.check(recorded, digest_of(cruiser()), &mismatch));
+    EXPECT_EQ(format("object {0} is in use, but was free in the recording", kSlot), mismatch);
+}
+
+}  // namespace
+}  // namespace antares
@@ -0,0 +1,142 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "lang/worker-pool.hpp"
+
+#include <algorithm>
+
+using std::exception_ptr;
+using std::max;
+using std::min;
+using std::mutex;
+using std::thread;
+using std::unique_lock;
+
+namespace antares {
+
+namespace {
+
+// Past this, the simulation's passes are too small for more threads to pay off.
+const int kMaxThreads = 8;
+
+}  // namespace
+
+WorkerPool* WorkerPool::pool() {
+    static WorkerPool pool(min<int>(max<int>(thread::hardware_concurrency(), 1), kMaxThreads));
+    return &pool;
+}
+
+WorkerPool::WorkerPool(int threads)
+        : _job(NULL),
+          _count(0),
+          _ranges(0),
+          _pending(0),
+          _generation(0),
+          _stopping(false) {
+    for (int i = 1; i < threads; ++i) {
+        _threads.push_back(thread(&WorkerPool::work, this, i));
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        unique_lock<mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _start.notify_all();
+    for (thread& t: _threads) {
+        t.join();
+    }
+}
+
+void WorkerPool::run(size_t count, size_t grain, const Job& job) {
+    const size_t wanted = (count + max<size_t>(grain, 1) - 1) / max<size_t>(grain, 1);
+    const int ranges = min<size_t>(max<size_t>(wanted, 1), size());
+    if (ranges == 1) {
+        job(0, 0, count);
+        return;
+    }
+
+    {
+        unique_lock<mutex> lock(_mutex);
+        _job = &job;
+        _count = count;
+        _ranges = ranges;
+        _pending = ranges - 1;
+        _exception = exception_ptr();
+        ++_generation;
+    }
+    _start.notify_all();
+
+    exception_ptr exception;
+    try {
+        run_range(0);
+    } catch (...) {
+        exception = std::current_exception();
+    }
+
+    unique_lock<mutex> lock(_mutex);
+    _done.wait(lock, [this] { return _pending == 0; });
+    _job = NULL;
+    if (!exception) {
+        exception = _exception;
+    }
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void WorkerPool::run_range(int range) {
+    const size_t begin = (_count * range) / _ranges;
+    const size_t end = (_count * (range + 1)) / _ranges;
+    (*_job)(range, begin, end);
+}
+
+void WorkerPool::work(int range) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            unique_lock<mutex> lock(_mutex);
+            _start.wait(lock, [this, seen] { return _stopping || (_generation != seen); });
+            if (_stopping) {
+                return;
+            }
+            seen = _generation;
+            if (range >= _ranges) {
+                continue;
+            }
+        }
+
+        exception_ptr exception;
+        try {
+            run_range(range);
+        } catch (...) {
+            exception = std::current_exception();
+        }
+
+        unique_lock<mutex> lock(_mutex);
+        if (exception && !_exception) {
+            _exception = exception;
+        }
+        if (--_pending == 0) {
+            _done.notify_one();
+        }
+    }
+}
+
+}  // namespace antares
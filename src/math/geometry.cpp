@@ -22,8 +22,10 @@
 #include <sfz/sfz.hpp>
 
 using sfz::ReadSource;
+using sfz::WriteTarget;
 using sfz::format;
 using sfz::read;
+using sfz::write;
 
 namespace antares {
 
@@ -60,6 +62,11 @@ void read_from(ReadSource in, Point& p) {
     read(in, p.v);
 }
 
+void write_to(WriteTarget out, const Point& p) {
+    write(out, p.h);
+    write(out, p.v);
+}
+
 Size::Size():
         width(0),
         height(0) { }
@@ -183,8 +190,25 @@ void read_from(ReadSource in, Rect& r) {
     read(in, r.bottom);
 }
 
+void write_to(WriteTarget out, const Rect& r) {
+    write(out, r.left);
+    write(out, r.top);
+    write(out, r.right);
+    write(out, r.bottom);
+}
+
 void print_to(sfz::PrintTarget out, Rect r) {
     print(out, format("{{{0}, {1}, {2}, {3}}}", r.left, r.top, r.right, r.bottom));
 }
 
+void read_from(ReadSource in, coordPointType& p) {
+    read(in, p.h);
+    read(in, p.v);
+}
+
+void write_to(WriteTarget out, const coordPointType& p) {
+    write(out, p.h);
+    write(out, p.v);
+}
+
 }  // namespace antares
@@ -0,0 +1,69 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "test/replay.hpp"
+
+#include "config/preferences.hpp"
+#include "drawing/sprite-handling.hpp"
+#include "drawing/text.hpp"
+#include "game/admiral.hpp"
+#include "game/beam.hpp"
+#include "game/cheat.hpp"
+#include "game/globals.hpp"
+#include "game/instruments.hpp"
+#include "game/labels.hpp"
+#include "game/messages.hpp"
+#include "game/motion.hpp"
+#include "game/scenario-maker.hpp"
+#include "game/space-object.hpp"
+#include "math/rotation.hpp"
+#include "sound/driver.hpp"
+#include "sound/fx.hpp"
+#include "sound/music.hpp"
+#include "ui/interface-handling.hpp"
+
+namespace antares {
+
+void init_replay() {
+    init_globals();
+
+    SoundDriver::driver()->set_global_volume(8);  // Max volume.
+
+    world = Rect(Point(0, 0), Preferences::preferences()->screen_size());
+    play_screen = Rect(
+        world.left + kLeftPanelWidth, world.top,
+        world.right - kRightPanelWidth, world.bottom);
+    viewport = play_screen;
+
+    RotationInit();
+    InitDirectText();
+    Labels::init();
+    Messages::init();
+    InstrumentInit();
+    SpriteHandlingInit();
+    AresCheatInit();
+    ScenarioMakerInit();
+    SpaceObjectHandlingInit();  // MUST be after ScenarioMakerInit()
+    InitSoundFX();
+    MusicInit();
+    InitMotion();
+    AdmiralInit();
+    Beams::init();
+}
+
+}  // namespace antares
@@ -18,6 +18,7 @@
 
 #include "ui/event-scheduler.hpp"
 
+#include <limits>
 #include <sfz/sfz.hpp>
 
 #include "config/preferences.hpp"
@@ -30,10 +31,14 @@
 using sfz::Exception;
 using std::greater;
 using std::max;
+using std::min;
+using std::numeric_limits;
 using std::unique_ptr;
 
 namespace antares {
 
+const int64_t EventScheduler::kForever = numeric_limits<int64_t>::max();
+
 EventScheduler::EventScheduler():
         _ticks(0),
         _event_tracker(true) { }
@@ -43,6 +48,16 @@ void EventScheduler::schedule_snapshot(int64_t at) {
     push_heap(_snapshot_times.begin(), _snapshot_times.end(), greater<int64_t>());
 }
 
+void EventScheduler::schedule_snapshots(int64_t start, int64_t interval, int64_t end) {
+    if (interval <= 0) {
+        throw Exception("snapshot interval must be positive");
+    }
+    if (start < end) {
+        SnapshotSchedule schedule = {start, interval, end};
+        _snapshot_schedules.push_back(schedule);
+    }
+}
+
 void EventScheduler::schedule_event(unique_ptr<Event> event) {
     _event_heap.emplace_back(std::move(event));
     push_heap(_event_heap.begin(), _event_heap.end(), is_later);
@@ -83,20 +98,48 @@ void EventScheduler::loop(EventScheduler::MainLoop& loop) {
 }
 
 void EventScheduler::advance_tick_count(EventScheduler::MainLoop& loop, int64_t ticks) {
-    if (loop.takes_snapshots() && have_snapshots_before(ticks)) {
+    int64_t at;
+    if (loop.takes_snapshots() && next_snapshot_before(ticks, &at)) {
         loop.draw();
-        while (have_snapshots_before(ticks)) {
-            _ticks = _snapshot_times.front();
+        do {
+            _ticks = at;
             loop.snapshot(_ticks);
-            pop_heap(_snapshot_times.begin(), _snapshot_times.end(), greater<int64_t>());
-            _snapshot_times.pop_back();
-        }
+            pop_snapshot(at);
+        } while (next_snapshot_before(ticks, &at));
     }
     _ticks = ticks;
 }
 
-bool EventScheduler::have_snapshots_before(int64_t ticks) const {
-    return !_snapshot_times.empty() && (_snapshot_times.front() < ticks);
+// Finds the earliest snapshot, whether scheduled once or recurring, and returns true if it is
+// before `ticks`.
+bool EventScheduler::next_snapshot_before(int64_t ticks, int64_t* at) const {
+    int64_t next = kForever;
+    if (!_snapshot_times.empty()) {
+        next = _snapshot_times.front();
+    }
+    for (const SnapshotSchedule& schedule: _snapshot_schedules) {
+        next = min(next, schedule.next);
+    }
+    *at = next;
+    return next < ticks;
+}
+
+// Removes every snapshot at `at`, so that overlapping schedules only take it once.
+void EventScheduler::pop_snapshot(int64_t at) {
+    while (!_snapshot_times.empty() && (_snapshot_times.front() == at)) {
+        pop_heap(_snapshot_times.begin(), _snapshot_times.end(), greater<int64_t>());
+        _snapshot_times.pop_back();
+    }
+    for (auto it = _snapshot_schedules.begin(); it != _snapshot_schedules.end(); ) {
+        if (it->next == at) {
+            if ((it->end - it->next) <= it->interval) {
+                it = _snapshot_schedules.erase(it);
+                continue;
+            }
+            it->next += it->interval;
+        }
+        ++it;
+    }
 }
 
 bool EventScheduler::is_later(const unique_ptr<Event>& x, const unique_ptr<Event>& y) {
@@ -0,0 +1,114 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "ui/event-scheduler.hpp"
+
+#include <vector>
+#include <gmock/gmock.h>
+
+#include "ui/card.hpp"
+
+using sfz::Exception;
+using std::vector;
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+namespace antares {
+namespace {
+
+typedef testing::Test EventSchedulerTest;
+
+// A card whose timer is always due, so that the scheduler steps one tick at a time.
+class TickCard : public Card {
+  public:
+    virtual bool next_timer(int64_t& time) {
+        time = 0;
+        return true;
+    }
+};
+
+// Runs the scheduler up to `until` and records when it takes snapshots.
+class SnapshotLoop : public EventScheduler::MainLoop {
+  public:
+    SnapshotLoop(const EventScheduler& scheduler, int64_t until):
+            _scheduler(scheduler),
+            _until(until) { }
+
+    virtual bool takes_snapshots() { return true; }
+    virtual void snapshot(int64_t ticks) { snapshots.push_back(ticks); }
+    virtual void draw() { }
+    virtual bool done() const { return _scheduler.ticks() >= _until; }
+    virtual Card* top() const { return &_card; }
+
+    vector<int64_t> snapshots;
+
+  private:
+    const EventScheduler& _scheduler;
+    const int64_t _until;
+    mutable TickCard _card;
+};
+
+vector<int64_t> run(EventScheduler& scheduler, int64_t until) {
+    SnapshotLoop loop(scheduler, until);
+    scheduler.loop(loop);
+    return loop.snapshots;
+}
+
+// A tick that several schedules land on is only captured once.
+TEST_F(EventSchedulerTest, Overlapping) {
+    EventScheduler scheduler;
+    scheduler.schedule_snapshots(2, 3, EventScheduler::kForever);
+    scheduler.schedule_snapshots(2, 2, EventScheduler::kForever);
+    scheduler.schedule_snapshot(8);
+    scheduler.schedule_snapshot(9);
+    EXPECT_THAT(run(scheduler, 12), ElementsAre(2, 4, 5, 6, 8, 9, 10, 11));
+}
+
+// A schedule that runs forever keeps going for as long as the loop does.
+TEST_F(EventSchedulerTest, Forever) {
+    EventScheduler scheduler;
+    scheduler.schedule_snapshots(0, 100, EventScheduler::kForever);
+    const vector<int64_t> snapshots = run(scheduler, 100000);
+    ASSERT_EQ(1000u, snapshots.size());
+    EXPECT_EQ(0, snapshots.front());
+    EXPECT_EQ(99900, snapshots.back());
+}
+
+// `end` itself is never captured, even when the interval lands on it.
+TEST_F(EventSchedulerTest, End) {
+    EventScheduler scheduler;
+    scheduler.schedule_snapshots(1, 3, 10);
+    EXPECT_THAT(run(scheduler, 20), ElementsAre(1, 4, 7));
+
+    EventScheduler late;
+    late.schedule_snapshots(1, 3, 11);
+    EXPECT_THAT(run(late, 20), ElementsAre(1, 4, 7, 10));
+
+    EventScheduler empty;
+    empty.schedule_snapshots(5, 3, 5);
+    EXPECT_THAT(run(empty, 20), IsEmpty());
+}
+
+TEST_F(EventSchedulerTest, Interval) {
+    EventScheduler scheduler;
+    EXPECT_THROW(scheduler.schedule_snapshots(0, 0, 10), Exception);
+    EXPECT_THROW(scheduler.schedule_snapshots(0, -1, 10), Exception);
+}
+
+}  // namespace
+}  // namespace antares
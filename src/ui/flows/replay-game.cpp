@@ -23,6 +23,7 @@
 #include "game/globals.hpp"
 #include "game/input-source.hpp"
 #include "game/scenario-maker.hpp"
+#include "game/space-object.hpp"
 #include "math/random.hpp"
 #include "ui/card.hpp"
 #include "video/transitions.hpp"
@@ -54,6 +55,7 @@ void ReplayGame::become_front() {
             _state = PLAYING;
             globals()->gInputSource.reset(new ReplayInputSource(&_data));
             swap(_random_seed, gRandomSeed);
+            SetSpaceObjectLimit(_data.object_limit);
             _game_result = NO_GAME;
             _seconds = 0;
             stack()->push(new MainPlay(_scenario, true, true, &_game_result, &_seconds));
@@ -27,6 +27,8 @@
 #include "game/input-source.hpp"
 #include "game/main.hpp"
 #include "game/scenario-maker.hpp"
+#include "game/space-object.hpp"
+#include "math/random.hpp"
 #include "sound/music.hpp"
 #include "ui/card.hpp"
 #include "ui/screens/debriefing.hpp"
@@ -76,11 +78,17 @@ void SoloGame::become_front() {
         // else fall through
 
       case PROLOGUE:
+        _random_seed = gRandomSeed;
+        // fall through
+
       case RESTART_LEVEL:
+        // Unlike Ares, which went on with whatever seed the last attempt left behind.
+        gRandomSeed = _random_seed;
         _state = PLAYING;
         _game_result = NO_GAME;
         _seconds = 0;
         globals()->gInputSource.reset();
+        SetSpaceObjectLimit(Preferences::preferences()->space_object_limit());
         stack()->push(new MainPlay(_scenario, false, true, &_game_result, &_seconds));
         break;
 
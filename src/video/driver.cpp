@@ -21,6 +21,9 @@
 #include <sfz/sfz.hpp>
 
 using sfz::Exception;
+using sfz::String;
+using std::unique_ptr;
+using std::vector;
 
 namespace antares {
 
@@ -45,6 +48,15 @@ VideoDriver* VideoDriver::driver() {
     return antares::video_driver;
 }
 
+vector<unique_ptr<Sprite>> VideoDriver::new_sprites(
+        const vector<String>& names, const vector<const PixMap*>& contents) {
+    vector<unique_ptr<Sprite>> sprites;
+    for (size_t i = 0; i < contents.size(); ++i) {
+        sprites.push_back(new_sprite(names[i], *contents[i]));
+    }
+    return sprites;
+}
+
 Sprite::~Sprite() { }
 
 }  // namespace antares
@@ -18,34 +18,33 @@
 
 #include "video/offscreen-driver.hpp"
 
-#include <fcntl.h>
 #include <stdlib.h>
 #include <strings.h>
 #include <algorithm>
+#include <thread>
 #include <OpenGL/OpenGL.h>
 #include <OpenGL/gl.h>
 #include <sfz/sfz.hpp>
 
 #include "cocoa/core-opengl.hpp"
 #include "config/preferences.hpp"
-#include "drawing/pix-map.hpp"
 #include "game/time.hpp"
 #include "math/geometry.hpp"
 #include "ui/card.hpp"
 #include "ui/event.hpp"
+#include "video/snapshot-encoder.hpp"
+#include "video/y4m-writer.hpp"
 
 using sfz::BytesSlice;
 using sfz::Exception;
 using sfz::Optional;
-using sfz::ScopedFd;
 using sfz::String;
 using sfz::StringSlice;
-using sfz::WriteTarget;
 using sfz::dec;
 using sfz::format;
-using sfz::range;
 using std::greater;
 using std::max;
+using std::thread;
 using std::unique_ptr;
 
 namespace utf8 = sfz::utf8;
@@ -54,42 +53,16 @@ namespace antares {
 
 namespace {
 
-class SnapshotBuffer {
-  public:
-    SnapshotBuffer(Size screen_size, int32_t bytes_per_pixel):
-            _screen_size(screen_size),
-            _bytes_per_pixel(bytes_per_pixel),
-            _data(new uint8_t[width() * height() * bytes_per_pixel]) { }
-
-    int32_t width() const { return _screen_size.width; }
-    int32_t height() const { return _screen_size.height; }
-    int32_t row_bytes() const { return width() * _bytes_per_pixel; }
-    void* mutable_data() { return _data.get(); }
-
-    void write_to(const WriteTarget& out) const {
-        ArrayPixMap pix(_screen_size.width, _screen_size.height);
-        uint8_t* p = _data.get();
-        for (int32_t y: range(_screen_size.height)) {
-            for (int32_t x: range(_screen_size.width)) {
-                uint8_t blue = *(p++);
-                uint8_t green = *(p++);
-                uint8_t red = *(p++);
-                ++p;
-                pix.set(x, _screen_size.height - y - 1, RgbColor(red, green, blue));
-            }
-        }
-        write(out, pix);
-    }
+// Encoding a frame takes much longer than drawing one, so encode on every core but the one the
+// game runs on, and let a few frames queue up behind each encoder.
+int encoder_threads() {
+    return max<int>(thread::hardware_concurrency() - 1, 1);
+}
 
-  private:
-    const Size _screen_size;
-    const int32_t _bytes_per_pixel;
-    unique_ptr<uint8_t[]> _data;
-};
+const int kFramesPerEncoderThread = 2;
 
-void write_to(const WriteTarget& out, const SnapshotBuffer& buffer) {
-    buffer.write_to(out);
-}
+// A tick is 1/60th of a second (see kTimeUnit in math/units.hpp).
+const int kTicksPerSecond = 60;
 
 static const CGLPixelFormatAttribute kAttrs[] = {
     kCGLPFAColorSize, static_cast<CGLPixelFormatAttribute>(24),
@@ -130,6 +103,19 @@ struct Renderbuffer {
     }
 };
 
+struct PixelBuffer {
+    GLuint id;
+
+    PixelBuffer() {
+        glGenBuffers(1, &id);
+        gl_check();
+    }
+
+    ~PixelBuffer() {
+        glDeleteBuffers(1, &id);
+    }
+};
+
 }  // namespace
 
 class OffscreenVideoDriver::MainLoop : public EventScheduler::MainLoop {
@@ -137,25 +123,65 @@ class OffscreenVideoDriver::MainLoop : public EventScheduler::MainLoop {
     MainLoop(OffscreenVideoDriver& driver, const Optional<String>& output_dir, Card* initial):
             _pix(kAttrs),
             _context(_pix.c_obj(), NULL),
-            _buffer(Preferences::preferences()->screen_size(), 4),
+            _size(Preferences::preferences()->screen_size()),
             _setup(*this),
             _output_dir(output_dir),
-            _loop(driver, initial) {
+            _loop(driver, initial),
+            _next_buffer(0),
+            _pending(false) {
+        if (driver._y4m_fd >= 0) {
+            _stream.reset(new Y4mWriter(
+                        driver._y4m_fd, _size, kTicksPerSecond, driver._ticks_per_frame));
+        }
+        if (takes_snapshots()) {
+            for (const PixelBuffer& buffer: _read_buffers) {
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.id);
+                glBufferData(
+                        GL_PIXEL_PACK_BUFFER, _size.width * _size.height * 4, NULL,
+                        GL_STREAM_READ);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            gl_check();
+            if (!_stream) {
+                _encoder.reset(new SnapshotEncoder(
+                            _size, encoder_threads(),
+                            encoder_threads() * kFramesPerEncoderThread));
+            }
+        }
     }
 
     bool takes_snapshots() {
-        return _output_dir.has();
+        return _stream || _output_dir.has();
     }
 
+    // Reads the frame back into one of two pixel buffers, without waiting for it to arrive.  By
+    // the next snapshot it has, and is handed to the encoder while the next frame is read into
+    // the other buffer.
     void snapshot(int64_t ticks) {
-        glReadPixels(
-                0, 0, _buffer.width(), _buffer.height(), GL_BGRA, GL_UNSIGNED_BYTE,
-                _buffer.mutable_data());
-        String dir(format("{0}/screens", *_output_dir));
-        makedirs(dir, 0755);
-        String path(format("{0}/{1}.png", dir, dec(ticks, 6)));
-        ScopedFd file(open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
-        write(file, _buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, _read_buffers[_next_buffer].id);
+        glReadPixels(0, 0, _size.width, _size.height, GL_BGRA, GL_UNSIGNED_BYTE, NULL);
+        encode_pending();
+        if (!_stream) {
+            String dir(format("{0}/screens", *_output_dir));
+            makedirs(dir, 0755);
+            _pending_path.assign(format("{0}/{1}.png", dir, dec(ticks, 6)));
+        }
+        _pending_buffer = _next_buffer;
+        _pending = true;
+        _next_buffer = 1 - _next_buffer;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    // Encodes the last frame read back, and waits for every frame to be written.
+    void finish() {
+        if (!takes_snapshots()) {
+            return;
+        }
+        encode_pending();
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if (_encoder) {
+            _encoder->finish();
+        }
     }
 
     void draw() { _loop.draw(); }
@@ -163,18 +189,37 @@ class OffscreenVideoDriver::MainLoop : public EventScheduler::MainLoop {
     Card* top() const { return _loop.top(); }
 
   private:
+    void encode_pending() {
+        if (!_pending) {
+            return;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, _read_buffers[_pending_buffer].id);
+        const void* data = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        if (!data) {
+            gl_check();
+            throw Exception("couldn't map pixel buffer");
+        }
+        _pending = false;
+        if (_stream) {
+            _stream->add(static_cast<const uint8_t*>(data));
+        } else {
+            _encoder->add(_pending_path, static_cast<const uint8_t*>(data));
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+
     cgl::PixelFormat _pix;
     cgl::Context _context;
     Framebuffer _fb;
     Renderbuffer _rb;
-    SnapshotBuffer _buffer;
+    const Size _size;
     struct Setup {
         Setup(OffscreenVideoDriver::MainLoop& loop) {
             cgl::check(CGLSetCurrentContext(loop._context.c_obj()));
             glBindFramebuffer(GL_FRAMEBUFFER, loop._fb.id);
             glBindRenderbuffer(GL_RENDERBUFFER, loop._rb.id);
             glRenderbufferStorage(
-                    GL_RENDERBUFFER, GL_RGBA, loop._buffer.width(), loop._buffer.height());
+                    GL_RENDERBUFFER, GL_RGBA, loop._size.width, loop._size.height);
             glFramebufferRenderbuffer(
                     GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, loop._rb.id);
         }
@@ -182,17 +227,32 @@ class OffscreenVideoDriver::MainLoop : public EventScheduler::MainLoop {
     Setup _setup;
     Optional<String> _output_dir;
     OpenGlVideoDriver::MainLoop _loop;
+    PixelBuffer _read_buffers[2];
+    int _next_buffer;
+    int _pending_buffer;
+    bool _pending;
+    String _pending_path;
+    unique_ptr<Y4mWriter> _stream;
+    unique_ptr<SnapshotEncoder> _encoder;
 };
 
 OffscreenVideoDriver::OffscreenVideoDriver(
         Size screen_size, EventScheduler& scheduler, const Optional<String>& output_dir):
         _screen_size(screen_size),
         _output_dir(output_dir),
+        _y4m_fd(-1),
+        _ticks_per_frame(1),
         _scheduler(scheduler) { }
 
+void OffscreenVideoDriver::stream_y4m(int fd, int ticks_per_frame) {
+    _y4m_fd = fd;
+    _ticks_per_frame = ticks_per_frame;
+}
+
 void OffscreenVideoDriver::loop(Card* initial) {
     MainLoop loop(*this, _output_dir, initial);
     _scheduler.loop(loop);
+    loop.finish();
 }
 
 }  // namespace antares
@@ -18,8 +18,12 @@
 
 #include "video/opengl-driver.hpp"
 
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #include <algorithm>
+#include <memory>
+#include <vector>
 #include <OpenGL/OpenGL.h>
 #include <OpenGL/gl.h>
 #include <sfz/sfz.hpp>
@@ -28,6 +32,7 @@
 #include "drawing/pix-map.hpp"
 #include "drawing/shapes.hpp"
 #include "game/globals.hpp"
+#include "game/profile.hpp"
 #include "math/geometry.hpp"
 #include "math/random.hpp"
 #include "ui/card.hpp"
@@ -43,6 +48,7 @@ using sfz::print;
 using std::min;
 using std::max;
 using std::unique_ptr;
+using std::vector;
 
 namespace io = sfz::io;
 
@@ -50,6 +56,9 @@ namespace antares {
 
 namespace {
 
+// Largest atlas to pack a pix table's frames into.  Most tables fit in a fraction of this.
+static const int32_t kAtlasSize = 2048;
+
 static const char kShaderColorModeUniform[] = "color_mode";
 static const char kShaderSpriteUniform[] = "sprite";
 static const char kShaderStaticImageUniform[] = "static_image";
@@ -67,9 +76,13 @@ static const GLchar* kShaderSource =
     "uniform vec4 outline_color;\n"
     "uniform int seed;\n"
     "\n"
+    "vec4 sprite_at(vec2 uv) {\n"
+    "    return texture2DRect(sprite, clamp(uv, gl_TexCoord[2].xy, gl_TexCoord[2].zw));\n"
+    "}\n"
+    "\n"
     "void main() {\n"
     "    vec2 uv = gl_TexCoord[0].xy;\n"
-    "    vec4 sprite_color = texture2DRect(sprite, uv);\n"
+    "    vec4 sprite_color = sprite_at(uv);\n"
     "    if (color_mode == 0) {\n"
     "        gl_FragColor = gl_Color;\n"
     "    } else if (color_mode == 1) {\n"
@@ -93,14 +106,14 @@ static const GLchar* kShaderSource =
     "        }\n"
     "    } else if (color_mode == 5) {\n"
     "        float neighborhood =\n"
-    "                texture2DRect(sprite, uv + vec2(-unit.s, -unit.t)).w +\n"
-    "                texture2DRect(sprite, uv + vec2(-unit.s,       0)).w +\n"
-    "                texture2DRect(sprite, uv + vec2(-unit.s,  unit.t)).w +\n"
-    "                texture2DRect(sprite, uv + vec2(      0, -unit.t)).w +\n"
-    "                texture2DRect(sprite, uv + vec2(      0,  unit.t)).w +\n"
-    "                texture2DRect(sprite, uv + vec2( unit.s, -unit.t)).w +\n"
-    "                texture2DRect(sprite, uv + vec2( unit.s,       0)).w +\n"
-    "                texture2DRect(sprite, uv + vec2( unit.s,  unit.t)).w;\n"
+    "                sprite_at(uv + vec2(-unit.s, -unit.t)).w +\n"
+    "                sprite_at(uv + vec2(-unit.s,       0)).w +\n"
+    "                sprite_at(uv + vec2(-unit.s,  unit.t)).w +\n"
+    "                sprite_at(uv + vec2(      0, -unit.t)).w +\n"
+    "                sprite_at(uv + vec2(      0,  unit.t)).w +\n"
+    "                sprite_at(uv + vec2( unit.s, -unit.t)).w +\n"
+    "                sprite_at(uv + vec2( unit.s,       0)).w +\n"
+    "                sprite_at(uv + vec2( unit.s,  unit.t)).w;\n"
     "        if (sprite_color.w > (neighborhood / 8)) {\n"
     "            gl_FragColor = outline_color;\n"
     "        } else if (sprite_color.w > 0) {\n"
@@ -137,35 +150,246 @@ void gl_log(GLint object) {
     print(io::err, format("object {0} log: {1}\n", object, (const char*)log.get()));
 }
 
-class OpenGlSprite : public Sprite {
+struct Texture {
+    Texture() { glGenTextures(1, &id); }
+    ~Texture() { glDeleteTextures(1, &id); }
+
+    GLuint id;
+    DISALLOW_COPY_AND_ASSIGN(Texture);
+};
+
+}  // namespace
+
+class OpenGlVideoDriver::Batch {
   public:
-    OpenGlSprite(PrintItem name, const PixMap& image, const OpenGlVideoDriver::Uniforms& uniforms)
-            : _name(name),
-              _size(image.size()),
-              _uniforms(uniforms) {
-        glBindTexture(GL_TEXTURE_RECTANGLE_EXT, _texture.id);
-        glTexParameteri(GL_TEXTURE_RECTANGLE_EXT, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_RECTANGLE_EXT, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_RECTANGLE_EXT, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_RECTANGLE_EXT, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    struct Vertex {
+        GLfloat x, y;
+        GLfloat s0, t0;  // Texture unit 0: the sprite.
+        GLfloat s1, t1;  // Texture unit 1: dither and static patterns.
+        GLfloat region[4];  // Texture unit 2: the sprite's part of its texture, as min and max.
+        GLubyte color[4];
+    };
+
+    // Everything that has to be the same for two primitives to be drawn in one call.  The
+    // uniforms for a color mode only count in that mode, and `texture` is null in modes that
+    // don't sample the sprite.  Runs hold on to their texture until they are flushed, since the
+    // sprite that added them may be destroyed before then.
+    struct State {
+        GLenum primitive;
+        std::shared_ptr<Texture> texture;
+        int color_mode;
+        GLfloat static_fraction;
+        GLfloat unit[2];
+        GLfloat outline_color[4];
+    };
+
+    explicit Batch(const Uniforms& uniforms):
+            _uniforms(uniforms),
+            _buffer(0),
+            _draw_calls(0) { }
+
+    ~Batch() {
+        if (_buffer) {
+            glDeleteBuffers(1, &_buffer);
+        }
+    }
+
+    // Returns space for `count` vertices, to be drawn with `state`.  The space is valid until
+    // the next call to add() or flush().
+    Vertex* add(const State& state, size_t count) {
+        if (_runs.empty() || !same_state(_runs.back().state, state)) {
+            Run run = {state, static_cast<GLint>(_vertices.size()), 0};
+            _runs.push_back(run);
+        }
+        _runs.back().count += count;
+        _vertices.resize(_vertices.size() + count);
+        return &_vertices[_vertices.size() - count];
+    }
+
+    // Draws everything added so far, uploading the vertices in one piece.
+    void flush() {
+        if (_runs.empty()) {
+            return;
+        }
+        if (!_buffer) {
+            glGenBuffers(1, &_buffer);
+        }
+        const GLsizei stride = sizeof(Vertex);
+        glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+        glBufferData(
+                GL_ARRAY_BUFFER, _vertices.size() * sizeof(Vertex), _vertices.data(),
+                GL_STREAM_DRAW);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(2, GL_FLOAT, stride, offset(offsetof(Vertex, x)));
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(4, GL_UNSIGNED_BYTE, stride, offset(offsetof(Vertex, color)));
+        glClientActiveTexture(GL_TEXTURE0);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, stride, offset(offsetof(Vertex, s0)));
+        glClientActiveTexture(GL_TEXTURE1);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, stride, offset(offsetof(Vertex, s1)));
+        glClientActiveTexture(GL_TEXTURE2);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(4, GL_FLOAT, stride, offset(offsetof(Vertex, region)));
+        glActiveTexture(GL_TEXTURE0);
+
+        const State* last = NULL;
+        for (const Run& run: _runs) {
+            const State& state = run.state;
+            if (!last || (state.color_mode != last->color_mode)) {
+                glUniform1i(_uniforms.color_mode, state.color_mode);
+            }
+            if (state.color_mode == 4) {
+                glUniform1f(_uniforms.static_fraction, state.static_fraction);
+            } else if (state.color_mode == 5) {
+                glUniform2f(_uniforms.unit, state.unit[0], state.unit[1]);
+                glUniform4f(
+                        _uniforms.outline_color, state.outline_color[0],
+                        state.outline_color[1], state.outline_color[2],
+                        state.outline_color[3]);
+            }
+            if (state.texture && (!last || (state.texture != last->texture))) {
+                glBindTexture(GL_TEXTURE_RECTANGLE_EXT, state.texture->id);
+            }
+            glDrawArrays(state.primitive, run.first, run.count);
+            ++_draw_calls;
+            last = &state;
+        }
+
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glClientActiveTexture(GL_TEXTURE1);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glClientActiveTexture(GL_TEXTURE0);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        gl_check();
+
+        _runs.clear();
+        _vertices.clear();
+    }
+
+    // Flushes, and returns the number of draw calls made since the last call.
+    int end_frame() {
+        flush();
+        const int draw_calls = _draw_calls;
+        _draw_calls = 0;
+        return draw_calls;
+    }
+
+  private:
+    struct Run {
+        State state;
+        GLint first;
+        GLsizei count;
+    };
+
+    static const GLvoid* offset(size_t bytes) {
+        return reinterpret_cast<const GLvoid*>(bytes);
+    }
+
+    static bool same_state(const State& x, const State& y) {
+        if ((x.primitive != y.primitive)
+                || (x.texture != y.texture)
+                || (x.color_mode != y.color_mode)) {
+            return false;
+        }
+        switch (x.color_mode) {
+          case 4:
+            return x.static_fraction == y.static_fraction;
+          case 5:
+            return (memcmp(x.unit, y.unit, sizeof(x.unit)) == 0)
+                && (memcmp(x.outline_color, y.outline_color, sizeof(x.outline_color)) == 0);
+          default:
+            return true;
+        }
+    }
+
+    const Uniforms& _uniforms;
+    GLuint _buffer;
+    std::vector<Vertex> _vertices;
+    std::vector<Run> _runs;
+    int _draw_calls;
+
+    DISALLOW_COPY_AND_ASSIGN(Batch);
+};
+
+namespace {
+
+typedef OpenGlVideoDriver::Batch Batch;
+
+Batch::State make_state(
+        GLenum primitive, int color_mode, const std::shared_ptr<Texture>& texture = nullptr) {
+    Batch::State state = {};
+    state.primitive = primitive;
+    state.color_mode = color_mode;
+    state.texture = texture;
+    return state;
+}
+
+void set_vertex(
+        Batch::Vertex* vertex, GLfloat x, GLfloat y, GLfloat s0, GLfloat t0, GLfloat s1,
+        GLfloat t1, const RgbColor& color) {
+    vertex->x = x;
+    vertex->y = y;
+    vertex->s0 = s0;
+    vertex->t0 = t0;
+    vertex->s1 = s1;
+    vertex->t1 = t1;
+    vertex->region[0] = vertex->region[1] = vertex->region[2] = vertex->region[3] = 0;
+    vertex->color[0] = color.red;
+    vertex->color[1] = color.green;
+    vertex->color[2] = color.blue;
+    vertex->color[3] = color.alpha;
+}
+
+// Uploads `image` as a texture.
+std::shared_ptr<Texture> make_texture(const PixMap& image) {
+    std::shared_ptr<Texture> texture(new Texture);
+    glBindTexture(GL_TEXTURE_RECTANGLE_EXT, texture->id);
+    glTexParameteri(GL_TEXTURE_RECTANGLE_EXT, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_RECTANGLE_EXT, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_RECTANGLE_EXT, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_RECTANGLE_EXT, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 #if defined(__LITTLE_ENDIAN__)
-        GLenum type = GL_UNSIGNED_INT_8_8_8_8;
+    GLenum type = GL_UNSIGNED_INT_8_8_8_8;
 #elif defined(__BIG_ENDIAN__)
-        GLenum type = GL_UNSIGNED_INT_8_8_8_8_REV;
+    GLenum type = GL_UNSIGNED_INT_8_8_8_8_REV;
 #else
 #error "Couldn't determine endianness of platform"
 #endif
+    glTexImage2D(
+            GL_TEXTURE_RECTANGLE_EXT, 0, GL_RGBA, image.size().width, image.size().height,
+            0, GL_BGRA, type, image.bytes());
+    return texture;
+}
 
-        // Add a 1-pixel clear border.  Color mode 5 (outline) won't work unless we do this.
-        Size size = image.size();
-        size.width += 2;
-        size.height += 2;
-        ArrayPixMap copy(size);
-        copy.fill(RgbColor::kClear);
-        copy.view(Rect(1, 1, size.width - 1, size.height - 1)).copy(image);
-        glTexImage2D(
-                GL_TEXTURE_RECTANGLE_EXT, 0, GL_RGBA, size.width, size.height,
-                0, GL_BGRA, type, copy.bytes());
+// Each sprite is stored with a 1-pixel clear border.  Color mode 5 (outline) won't work unless
+// we do this.
+Size bordered(Size size) {
+    return Size(size.width + 2, size.height + 2);
+}
+
+// A sprite is a region of a texture: either one of its own, or an atlas shared with the other
+// frames of its pix table.  `origin` is the top-left corner of the sprite's border.
+class OpenGlSprite : public Sprite {
+  public:
+    OpenGlSprite(
+            PrintItem name, Size size, std::shared_ptr<Texture> texture, Point origin,
+            Batch& batch)
+            : _name(name),
+              _size(size),
+              _texture(texture),
+              _origin(origin),
+              _batch(batch) {
+        // Samples are clamped to the center of the border texels, so that sampling outside the
+        // sprite sees its clear border rather than its neighbors in an atlas.
+        _region[0] = origin.h + 0.5;
+        _region[1] = origin.v + 0.5;
+        _region[2] = origin.h + size.width + 1.5;
+        _region[3] = origin.v + size.height + 1.5;
     }
 
     virtual StringSlice name() const {
@@ -173,57 +397,48 @@ class OpenGlSprite : public Sprite {
     }
 
     virtual void draw(const Rect& draw_rect) const {
-        glUniform1i(_uniforms.color_mode, 2);
-        draw_internal(draw_rect);
+        draw_internal(make_state(GL_QUADS, 2, _texture), draw_rect, RgbColor::kWhite);
     }
 
     virtual void draw_cropped(const Rect& draw_rect, Point origin) const {
         Rect texture_rect(origin, draw_rect.size());
-        texture_rect.offset(1, 1);
-
-        glUniform1i(_uniforms.color_mode, 2);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_RECTANGLE_EXT, _texture.id);
-        gl_check();
-        glBegin(GL_QUADS);
-        glMultiTexCoord2f(GL_TEXTURE0, texture_rect.left, texture_rect.top);
-        glVertex2f(draw_rect.left, draw_rect.top);
-        glMultiTexCoord2f(GL_TEXTURE0, texture_rect.left, texture_rect.bottom);
-        glVertex2f(draw_rect.left, draw_rect.bottom);
-        glMultiTexCoord2f(GL_TEXTURE0, texture_rect.right, texture_rect.bottom);
-        glVertex2f(draw_rect.right, draw_rect.bottom);
-        glMultiTexCoord2f(GL_TEXTURE0, texture_rect.right, texture_rect.top);
-        glVertex2f(draw_rect.right, draw_rect.top);
-        glEnd();
-        gl_check();
+        texture_rect.offset(_origin.h + 1, _origin.v + 1);
+
+        Batch::Vertex* v = _batch.add(make_state(GL_QUADS, 2, _texture), 4);
+        const RgbColor& c = RgbColor::kWhite;
+        set_vertex(v, draw_rect.left, draw_rect.top,
+                texture_rect.left, texture_rect.top, 0, 0, c);
+        set_vertex(v + 1, draw_rect.left, draw_rect.bottom,
+                texture_rect.left, texture_rect.bottom, 0, 0, c);
+        set_vertex(v + 2, draw_rect.right, draw_rect.bottom,
+                texture_rect.right, texture_rect.bottom, 0, 0, c);
+        set_vertex(v + 3, draw_rect.right, draw_rect.top,
+                texture_rect.right, texture_rect.top, 0, 0, c);
+        set_region(v);
     }
 
     virtual void draw_shaded(const Rect& draw_rect, const RgbColor& tint) const {
-        glColor4ub(tint.red, tint.green, tint.blue, 255);
-        glUniform1i(_uniforms.color_mode, 3);
-        draw_internal(draw_rect);
+        const RgbColor color(255, tint.red, tint.green, tint.blue);
+        draw_internal(make_state(GL_QUADS, 3, _texture), draw_rect, color);
     }
 
     virtual void draw_static(const Rect& draw_rect, const RgbColor& color, uint8_t frac) const {
-        glColor4ub(color.red, color.green, color.blue, color.alpha);
-        glUniform1i(_uniforms.color_mode, 4);
-        glUniform1f(_uniforms.static_fraction, frac / 255.0);
-        draw_internal(draw_rect);
+        Batch::State state = make_state(GL_QUADS, 4, _texture);
+        state.static_fraction = frac / 255.0;
+        draw_internal(state, draw_rect, color);
     }
 
     virtual void draw_outlined(
             const Rect& draw_rect, const RgbColor& outline_color,
             const RgbColor& fill_color) const {
-        glUniform1i(_uniforms.color_mode, 5);
-        glUniform2f(
-                _uniforms.unit,
-                double(_size.width) / draw_rect.width(),
-                double(_size.height) / draw_rect.height());
-        glColor4ub(fill_color.red, fill_color.green, fill_color.blue, fill_color.alpha);
-        glUniform4f(
-                _uniforms.outline_color, outline_color.red / 255.0, outline_color.green / 255.0,
-                outline_color.blue / 255.0, outline_color.alpha / 255.0);
-        draw_internal(draw_rect);
+        Batch::State state = make_state(GL_QUADS, 5, _texture);
+        state.unit[0] = double(_size.width) / draw_rect.width();
+        state.unit[1] = double(_size.height) / draw_rect.height();
+        state.outline_color[0] = outline_color.red / 255.0;
+        state.outline_color[1] = outline_color.green / 255.0;
+        state.outline_color[2] = outline_color.blue / 255.0;
+        state.outline_color[3] = outline_color.alpha / 255.0;
+        draw_internal(state, draw_rect, fill_color);
     }
 
     virtual const Size& size() const {
@@ -231,41 +446,37 @@ class OpenGlSprite : public Sprite {
     }
 
   private:
-    virtual void draw_internal(const Rect& draw_rect) const {
-        const int32_t w = _size.width;
-        const int32_t h = _size.height;
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_RECTANGLE_EXT, _texture.id);
-        gl_check();
-        glBegin(GL_QUADS);
-        glMultiTexCoord2f(GL_TEXTURE0, 1, 1);
-        glMultiTexCoord2f(GL_TEXTURE1, draw_rect.left, draw_rect.top);
-        glVertex2f(draw_rect.left, draw_rect.top);
-        glMultiTexCoord2f(GL_TEXTURE0, 1, h + 1);
-        glMultiTexCoord2f(GL_TEXTURE1, draw_rect.left, draw_rect.bottom);
-        glVertex2f(draw_rect.left, draw_rect.bottom);
-        glMultiTexCoord2f(GL_TEXTURE0, w + 1, h + 1);
-        glMultiTexCoord2f(GL_TEXTURE1, draw_rect.right, draw_rect.bottom);
-        glVertex2f(draw_rect.right, draw_rect.bottom);
-        glMultiTexCoord2f(GL_TEXTURE0, w + 1, 1);
-        glMultiTexCoord2f(GL_TEXTURE1, draw_rect.right, draw_rect.top);
-        glVertex2f(draw_rect.right, draw_rect.top);
-        glEnd();
-        gl_check();
+    void draw_internal(
+            const Batch::State& state, const Rect& draw_rect, const RgbColor& color) const {
+        const GLfloat left = _origin.h + 1;
+        const GLfloat top = _origin.v + 1;
+        const GLfloat right = left + _size.width;
+        const GLfloat bottom = top + _size.height;
+        Batch::Vertex* v = _batch.add(state, 4);
+        set_vertex(v, draw_rect.left, draw_rect.top,
+                left, top, draw_rect.left, draw_rect.top, color);
+        set_vertex(v + 1, draw_rect.left, draw_rect.bottom,
+                left, bottom, draw_rect.left, draw_rect.bottom, color);
+        set_vertex(v + 2, draw_rect.right, draw_rect.bottom,
+                right, bottom, draw_rect.right, draw_rect.bottom, color);
+        set_vertex(v + 3, draw_rect.right, draw_rect.top,
+                right, top, draw_rect.right, draw_rect.top, color);
+        set_region(v);
     }
 
-    struct Texture {
-        Texture() { glGenTextures(1, &id); }
-        ~Texture() { glDeleteTextures(1, &id); }
-
-        GLuint id;
-        DISALLOW_COPY_AND_ASSIGN(Texture);
-    };
+    // Sets the region of the four vertices of a quad.
+    void set_region(Batch::Vertex* v) const {
+        for (int i = 0; i < 4; ++i) {
+            memcpy(v[i].region, _region, sizeof(_region));
+        }
+    }
 
     const String _name;
-    Texture _texture;
     Size _size;
-    const OpenGlVideoDriver::Uniforms& _uniforms;
+    const std::shared_ptr<Texture> _texture;
+    const Point _origin;
+    GLfloat _region[4];
+    Batch& _batch;
 
     DISALLOW_COPY_AND_ASSIGN(OpenGlSprite);
 };
@@ -273,49 +484,117 @@ class OpenGlSprite : public Sprite {
 }  // namespace
 
 OpenGlVideoDriver::OpenGlVideoDriver()
-        : _static_seed{0} { }
+        : _static_seed{0},
+          _batch(new Batch(_uniforms)),
+          _draw_calls(0) { }
+
+OpenGlVideoDriver::~OpenGlVideoDriver() { }
 
 unique_ptr<Sprite> OpenGlVideoDriver::new_sprite(PrintItem name, const PixMap& content) {
-    return unique_ptr<Sprite>(new OpenGlSprite(name, content, _uniforms));
+    ArrayPixMap copy(bordered(content.size()));
+    copy.fill(RgbColor::kClear);
+    copy.view(Rect(Point(1, 1), content.size())).copy(content);
+    return unique_ptr<Sprite>(new OpenGlSprite(
+                name, content.size(), make_texture(copy), Point(0, 0), *_batch));
+}
+
+// Packs the sprites into atlases, in rows (or "shelves") from top to bottom, tallest first so
+// that little height is wasted in each row.  A sprite too big for an atlas gets its own texture.
+vector<unique_ptr<Sprite>> OpenGlVideoDriver::new_sprites(
+        const vector<String>& names, const vector<const PixMap*>& contents) {
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_RECTANGLE_TEXTURE_SIZE_EXT, &max_size);
+    const int32_t atlas_width = min<int32_t>(max_size, kAtlasSize);
+    const int32_t atlas_height = atlas_width;
+
+    vector<size_t> order;
+    for (size_t i = 0; i < contents.size(); ++i) {
+        order.push_back(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&contents](size_t x, size_t y) {
+        return contents[x]->size().height > contents[y]->size().height;
+    });
+
+    vector<unique_ptr<Sprite>> sprites(contents.size());
+    size_t begin = 0;
+    while (begin < order.size()) {
+        // Lay out as many of the remaining sprites as fit in one atlas.
+        vector<Point> origins;
+        Point at(0, 0);
+        int32_t row_height = 0;
+        int32_t used_width = 0;
+        int32_t used_height = 0;
+        size_t end = begin;
+        for ( ; end < order.size(); ++end) {
+            const Size size = bordered(contents[order[end]]->size());
+            if ((size.width > atlas_width) || (size.height > atlas_height)) {
+                break;
+            }
+            if ((at.h + size.width) > atlas_width) {
+                at = Point(0, at.v + row_height);
+                row_height = 0;
+            }
+            if ((at.v + size.height) > atlas_height) {
+                break;
+            }
+            origins.push_back(at);
+            at.h += size.width;
+            row_height = max(row_height, size.height);
+            used_width = max(used_width, at.h);
+            used_height = max(used_height, at.v + size.height);
+        }
+
+        if (end == begin) {
+            // Too big for an atlas.
+            sprites[order[begin]] = new_sprite(names[order[begin]], *contents[order[begin]]);
+            ++begin;
+            continue;
+        }
+
+        // Only as much of the atlas as was used is uploaded, so a table of a few small frames
+        // doesn't cost a full-width texture.
+        ArrayPixMap atlas(used_width, used_height);
+        atlas.fill(RgbColor::kClear);
+        for (size_t i = begin; i < end; ++i) {
+            const PixMap& content = *contents[order[i]];
+            Point origin = origins[i - begin];
+            origin.offset(1, 1);
+            atlas.view(Rect(origin, content.size())).copy(content);
+        }
+        std::shared_ptr<Texture> texture = make_texture(atlas);
+        for (size_t i = begin; i < end; ++i) {
+            const size_t index = order[i];
+            sprites[index].reset(new OpenGlSprite(
+                        names[index], contents[index]->size(), texture, origins[i - begin],
+                        *_batch));
+        }
+        begin = end;
+    }
+    return sprites;
 }
 
 void OpenGlVideoDriver::fill_rect(const Rect& rect, const RgbColor& color) {
-    glUniform1i(_uniforms.color_mode, 0);
-    glColor4ub(color.red, color.green, color.blue, color.alpha);
-    glBegin(GL_QUADS);
-    glVertex2f(rect.right, rect.top);
-    glVertex2f(rect.left, rect.top);
-    glVertex2f(rect.left, rect.bottom);
-    glVertex2f(rect.right, rect.bottom);
-    glEnd();
+    Batch::Vertex* v = _batch->add(make_state(GL_QUADS, 0), 4);
+    set_vertex(v++, rect.right, rect.top, 0, 0, 0, 0, color);
+    set_vertex(v++, rect.left, rect.top, 0, 0, 0, 0, color);
+    set_vertex(v++, rect.left, rect.bottom, 0, 0, 0, 0, color);
+    set_vertex(v++, rect.right, rect.bottom, 0, 0, 0, 0, color);
 }
 
 void OpenGlVideoDriver::dither_rect(const Rect& rect, const RgbColor& color) {
-    glUniform1i(_uniforms.color_mode, 1);
-    glColor4ub(color.red, color.green, color.blue, color.alpha);
-    glBegin(GL_QUADS);
-    glMultiTexCoord2f(GL_TEXTURE1, rect.right, rect.top);
-    glVertex2f(rect.right, rect.top);
-    glMultiTexCoord2f(GL_TEXTURE1, rect.left, rect.top);
-    glVertex2f(rect.left, rect.top);
-    glMultiTexCoord2f(GL_TEXTURE1, rect.left, rect.bottom);
-    glVertex2f(rect.left, rect.bottom);
-    glMultiTexCoord2f(GL_TEXTURE1, rect.right, rect.bottom);
-    glVertex2f(rect.right, rect.bottom);
-    glEnd();
+    Batch::Vertex* v = _batch->add(make_state(GL_QUADS, 1), 4);
+    set_vertex(v++, rect.right, rect.top, 0, 0, rect.right, rect.top, color);
+    set_vertex(v++, rect.left, rect.top, 0, 0, rect.left, rect.top, color);
+    set_vertex(v++, rect.left, rect.bottom, 0, 0, rect.left, rect.bottom, color);
+    set_vertex(v++, rect.right, rect.bottom, 0, 0, rect.right, rect.bottom, color);
 }
 
 void OpenGlVideoDriver::draw_point(const Point& at, const RgbColor& color) {
-    glUniform1i(_uniforms.color_mode, 0);
-    glColor4ub(color.red, color.green, color.blue, color.alpha);
-    glBegin(GL_POINTS);
-    glVertex2f(at.h + 0.5, at.v + 0.5);
-    glEnd();
+    Batch::Vertex* v = _batch->add(make_state(GL_POINTS, 0), 1);
+    set_vertex(v, at.h + 0.5, at.v + 0.5, 0, 0, 0, 0, color);
 }
 
 void OpenGlVideoDriver::draw_line(const Point& from, const Point& to, const RgbColor& color) {
-    glUniform1i(_uniforms.color_mode, 0);
-
     // Shortcut: when `from` == `to`, we can draw just a point.
     if (from == to) {
         draw_point(from, color);
@@ -371,11 +650,9 @@ void OpenGlVideoDriver::draw_line(const Point& from, const Point& to, const RgbC
         y2 += 0.5f;
     }
 
-    glColor4ub(color.red, color.green, color.blue, color.alpha);
-    glBegin(GL_LINES);
-    glVertex2f(x1, y1);
-    glVertex2f(x2, y2);
-    glEnd();
+    Batch::Vertex* v = _batch->add(make_state(GL_LINES, 0), 2);
+    set_vertex(v++, x1, y1, 0, 0, 0, 0, color);
+    set_vertex(v++, x2, y2, 0, 0, 0, 0, color);
 }
 
 void OpenGlVideoDriver::draw_triangle(const Rect& rect, const RgbColor& color) {
@@ -517,6 +794,8 @@ void OpenGlVideoDriver::MainLoop::draw() {
     gl_check();
 
     _stack.top()->draw();
+    _driver._draw_calls = _driver._batch->end_frame();
+    profile_frame(_driver._draw_calls);
 
     glPopMatrix();
     glMatrixMode(GL_PROJECTION);
@@ -0,0 +1,205 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "video/snapshot-encoder.hpp"
+
+#include <fcntl.h>
+#include <string.h>
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using sfz::Bytes;
+using sfz::ScopedFd;
+using sfz::StringSlice;
+using sfz::open;
+using std::exception_ptr;
+using std::max;
+using std::mutex;
+using std::thread;
+using std::unique_lock;
+using std::unique_ptr;
+
+namespace antares {
+
+static_assert(sizeof(RgbColor) == 4, "RgbColor must be packed ARGB");
+
+namespace {
+
+// On a little-endian machine, a BGRA pixel loaded as a 32-bit word is 0xAARRGGBB, and an opaque
+// RgbColor is 0xBBGGRRFF.
+inline uint32_t swizzle_pixel(uint32_t bgra) {
+    return (bgra << 24) | ((bgra << 8) & 0x00ff0000) | ((bgra >> 8) & 0x0000ff00) | 0x000000ff;
+}
+
+}  // namespace
+
+void swizzle_bgra_frame(const uint8_t* bgra, Size size, RgbColor* out) {
+    const int32_t width = size.width;
+    for (int32_t y = 0; y < size.height; ++y) {
+        const uint8_t* src = bgra + ((size.height - y - 1) * width * 4);
+        uint8_t* dst = reinterpret_cast<uint8_t*>(out + (y * width));
+        int32_t x = 0;
+#ifdef __SSE2__
+        const __m128i green = _mm_set1_epi32(0x00ff0000);
+        const __m128i red = _mm_set1_epi32(0x0000ff00);
+        const __m128i alpha = _mm_set1_epi32(0x000000ff);
+        for ( ; (x + 4) <= width; x += 4) {
+            const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (x * 4)));
+            __m128i q = _mm_slli_epi32(p, 24);
+            q = _mm_or_si128(q, _mm_and_si128(_mm_slli_epi32(p, 8), green));
+            q = _mm_or_si128(q, _mm_and_si128(_mm_srli_epi32(p, 8), red));
+            q = _mm_or_si128(q, alpha);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (x * 4)), q);
+        }
+#endif  // __SSE2__
+        for ( ; x < width; ++x) {
+            uint32_t p;
+            memcpy(&p, src + (x * 4), 4);
+            p = swizzle_pixel(p);
+            memcpy(dst + (x * 4), &p, 4);
+        }
+    }
+}
+
+SnapshotEncoder::SnapshotEncoder(Size size, int threads, int capacity):
+        _size(size),
+        _next_sequence(0),
+        _next_write(0),
+        _stopping(false) {
+    for (int i = 0; i < max(capacity, 1); ++i) {
+        unique_ptr<Frame> frame(new Frame);
+        frame->data.reset(new uint8_t[size.width * size.height * 4]);
+        _free.push_back(std::move(frame));
+    }
+    for (int i = 0; i < max(threads, 1); ++i) {
+        _threads.push_back(thread(&SnapshotEncoder::work, this));
+    }
+}
+
+SnapshotEncoder::~SnapshotEncoder() {
+    try {
+        finish();
+    } catch (...) {
+        // Already reported, or nobody is left to report it to.
+    }
+    {
+        unique_lock<mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _queued.notify_all();
+    for (thread& t: _threads) {
+        t.join();
+    }
+}
+
+void SnapshotEncoder::add(StringSlice path, const uint8_t* bgra) {
+    unique_ptr<Frame> frame;
+    {
+        unique_lock<mutex> lock(_mutex);
+        check();
+        _written.wait(lock, [this] { return !_free.empty(); });
+        frame = std::move(_free.back());
+        _free.pop_back();
+    }
+
+    frame->path.assign(path);
+    memcpy(frame->data.get(), bgra, _size.width * _size.height * 4);
+
+    {
+        unique_lock<mutex> lock(_mutex);
+        frame->sequence = _next_sequence++;
+        _queue.push_back(std::move(frame));
+    }
+    _queued.notify_one();
+}
+
+void SnapshotEncoder::finish() {
+    unique_lock<mutex> lock(_mutex);
+    _written.wait(lock, [this] { return _next_write == _next_sequence; });
+    check();
+}
+
+// Rethrows the first failure, if there was one.  Must be called with _mutex held.
+void SnapshotEncoder::check() {
+    if (_exception) {
+        exception_ptr exception = _exception;
+        _exception = exception_ptr();
+        std::rethrow_exception(exception);
+    }
+}
+
+void SnapshotEncoder::work() {
+    ArrayPixMap pix(_size);
+    Bytes png;
+    while (true) {
+        unique_ptr<Frame> frame;
+        {
+            unique_lock<mutex> lock(_mutex);
+            _queued.wait(lock, [this] { return _stopping || !_queue.empty(); });
+            if (_queue.empty()) {
+                return;
+            }
+            frame = std::move(_queue.front());
+            _queue.pop_front();
+        }
+
+        exception_ptr exception;
+        try {
+            encode(frame.get(), &pix, &png);
+        } catch (...) {
+            exception = std::current_exception();
+        }
+
+        {
+            // Frames are taken from the queue in order, so the frames before this one are all
+            // being encoded or written already, and none of them waits on this one.
+            unique_lock<mutex> lock(_mutex);
+            const uint64_t sequence = frame->sequence;
+            _written.wait(lock, [this, sequence] { return _next_write == sequence; });
+        }
+
+        if (!exception) {
+            try {
+                ScopedFd file(open(frame->path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+                write(file, png);
+            } catch (...) {
+                exception = std::current_exception();
+            }
+        }
+
+        {
+            unique_lock<mutex> lock(_mutex);
+            if (exception && !_exception) {
+                _exception = exception;
+            }
+            ++_next_write;
+            _free.push_back(std::move(frame));
+        }
+        _written.notify_all();
+    }
+}
+
+void SnapshotEncoder::encode(Frame* frame, ArrayPixMap* pix, Bytes* png) {
+    swizzle_bgra_frame(frame->data.get(), _size, pix->mutable_bytes());
+    png->clear();
+    write(*png, *pix);
+}
+
+}  // namespace antares
@@ -0,0 +1,735 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "video/software-driver.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <sfz/sfz.hpp>
+
+#include "drawing/pix-map.hpp"
+#include "drawing/shapes.hpp"
+#include "game/profile.hpp"
+#include "lang/worker-pool.hpp"
+#include "ui/card.hpp"
+#include "video/snapshot-encoder.hpp"
+#include "video/y4m-writer.hpp"
+
+using sfz::Optional;
+using sfz::PrintItem;
+using sfz::String;
+using sfz::StringSlice;
+using sfz::dec;
+using sfz::format;
+using sfz::makedirs;
+using std::max;
+using std::min;
+using std::shared_ptr;
+using std::thread;
+using std::unique_ptr;
+using std::vector;
+
+namespace antares {
+
+namespace {
+
+// As in OffscreenVideoDriver: encoding a frame takes longer than drawing one, so encode on every
+// core but one, and let a few frames queue up behind each encoder.
+int encoder_threads() {
+    return max<int>(thread::hardware_concurrency() - 1, 1);
+}
+
+const int kFramesPerEncoderThread = 2;
+
+// A tick is 1/60th of a second (see kTimeUnit in math/units.hpp).
+const int kTicksPerSecond = 60;
+
+// Bands of fewer rows than this aren't worth handing to another thread.
+const int32_t kMinRowsPerBand = 16;
+
+// Pixels are four bytes, in the order blue, green, red, alpha: the format OpenGL reads frames
+// back in.  Blending happens channel by channel, so the order only matters when packing and
+// unpacking them.
+enum { B = 0, G = 1, R = 2, A = 3 };
+
+inline uint32_t pack(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha) {
+    const uint8_t bytes[4] = {blue, green, red, alpha};
+    uint32_t pixel;
+    memcpy(&pixel, bytes, 4);
+    return pixel;
+}
+
+inline uint32_t pack(const RgbColor& color) {
+    return pack(color.red, color.green, color.blue, color.alpha);
+}
+
+inline uint8_t channel(const uint32_t& pixel, int index) {
+    return reinterpret_cast<const uint8_t*>(&pixel)[index];
+}
+
+// x / 255, rounded to nearest, for x in [0, 255 * 255].  This is how OpenGL converts the
+// product of two 8-bit colors back to 8 bits.
+inline uint32_t div255(uint32_t x) {
+    return ((x + 128) * 257) >> 16;
+}
+
+inline uint8_t multiply(uint8_t x, uint8_t y) {
+    return div255(x * y);
+}
+
+// Blends `src` over `dst`, like glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA).  The
+// framebuffer itself is always opaque.
+inline uint32_t blend(uint32_t src, uint32_t dst) {
+    const uint32_t a = channel(src, A);
+    const uint32_t b = 255 - a;
+    return pack(
+            div255((channel(src, R) * a) + (channel(dst, R) * b)),
+            div255((channel(src, G) * a) + (channel(dst, G) * b)),
+            div255((channel(src, B) * a) + (channel(dst, B) * b)),
+            255);
+}
+
+#ifdef __SSE2__
+// Blends two pixels, unpacked to 16 bits per channel, exactly as blend() does.  Neither product
+// nor their sum exceeds 255 * 255, so 16-bit lanes are wide enough.
+inline __m128i blend_pixels(__m128i src, __m128i dst) {
+    const __m128i a = _mm_shufflehi_epi16(
+            _mm_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    const __m128i b = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(src, a), _mm_mullo_epi16(dst, b));
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_mulhi_epu16(x, _mm_set1_epi16(257));
+}
+
+inline __m128i alpha_mask() {
+    return _mm_slli_epi32(_mm_set1_epi32(0xff), 24);
+}
+
+// Blends four pixels.
+inline __m128i blend4(__m128i src, __m128i dst) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo = blend_pixels(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero));
+    const __m128i hi = blend_pixels(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero));
+    return _mm_or_si128(_mm_packus_epi16(lo, hi), alpha_mask());
+}
+#endif  // __SSE2__
+
+void fill_span(uint32_t* dst, uint32_t color, int32_t count) {
+    int32_t x = 0;
+#ifdef __SSE2__
+    const __m128i c = _mm_set1_epi32(color);
+    for ( ; (x + 4) <= count; x += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), c);
+    }
+#endif  // __SSE2__
+    for ( ; x < count; ++x) {
+        dst[x] = color;
+    }
+}
+
+void blend_color_span(uint32_t* dst, uint32_t color, int32_t count) {
+    if (channel(color, A) == 0) {
+        return;
+    } else if (channel(color, A) == 255) {
+        fill_span(dst, color, count);
+        return;
+    }
+    int32_t x = 0;
+#ifdef __SSE2__
+    const __m128i c = _mm_set1_epi32(color);
+    for ( ; (x + 4) <= count; x += 4) {
+        __m128i* p = reinterpret_cast<__m128i*>(dst + x);
+        _mm_storeu_si128(p, blend4(c, _mm_loadu_si128(p)));
+    }
+#endif  // __SSE2__
+    for ( ; x < count; ++x) {
+        dst[x] = blend(color, dst[x]);
+    }
+}
+
+// Most of most sprites is either opaque or clear, so runs of four opaque pixels are copied, and
+// runs of four clear ones skipped, without blending.
+void blend_span(uint32_t* dst, const uint32_t* src, int32_t count) {
+    int32_t x = 0;
+#ifdef __SSE2__
+    const __m128i mask = alpha_mask();
+    const __m128i zero = _mm_setzero_si128();
+    for ( ; (x + 4) <= count; x += 4) {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+        const __m128i a = _mm_and_si128(s, mask);
+        __m128i* p = reinterpret_cast<__m128i*>(dst + x);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, mask)) == 0xffff) {
+            _mm_storeu_si128(p, s);
+        } else if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, zero)) != 0xffff) {
+            _mm_storeu_si128(p, blend4(s, _mm_loadu_si128(p)));
+        }
+    }
+#endif  // __SSE2__
+    for ( ; x < count; ++x) {
+        const uint8_t a = channel(src[x], A);
+        if (a == 255) {
+            dst[x] = src[x];
+        } else if (a != 0) {
+            dst[x] = blend(src[x], dst[x]);
+        }
+    }
+}
+
+// Floors, rather than truncating, for negative `x`.
+inline int32_t floor_div(int32_t x, int32_t y) {
+    return (x >= 0) ? (x / y) : -((y - 1 - x) / y);
+}
+
+// A sprite's pixels, in top-down rows.
+struct Image {
+    Size size;
+    unique_ptr<uint32_t[]> pixels;
+
+    const uint32_t* row(int32_t y) const {
+        return pixels.get() + (y * size.width);
+    }
+};
+
+struct Command {
+    enum Kind {
+        FILL,      // Fills `rect` with `color`.
+        DITHER,    // Fills every other pixel of `rect` with `color`, in a checkerboard.
+        LINE,      // Draws a line from `from` to `to`, inclusive, in `color`.
+        SPRITE,    // Draws the `source` region of `image`, scaled to `rect`.
+        SHADED,    // ...multiplied by `color`.
+        STATIC,    // ...with `fraction` of it replaced by `color`.
+        OUTLINED,  // ...with its edges in `outline_color` and the rest in `color`.
+    };
+
+    Kind kind;
+    Rect rect;
+    Rect source;
+    Point from;
+    Point to;
+    uint32_t color;
+    uint32_t outline_color;
+    uint8_t fraction;
+    shared_ptr<const Image> image;
+};
+
+// Per-thread working space for rasterizing sprites.
+struct Scratch {
+    vector<int32_t> columns;
+    vector<uint32_t> pixels;
+};
+
+}  // namespace
+
+class SoftwareVideoDriver::Canvas {
+  public:
+    Canvas(Size size):
+            _size(size),
+            _pixels(new uint32_t[size.width * size.height]),
+            _static(new uint8_t[256 * 256]),
+            _seed(0) {
+        fill_span(_pixels.get(), pack(RgbColor::kBlack), size.width * size.height);
+        // The same static as the OpenGL driver's texture.
+        Random static_index = {0};
+        for (int i = 0; i < (256 * 256); ++i) {
+            _static[i] = static_index.next(256);
+        }
+    }
+
+    // The last frame rasterized, as bottom-up rows of BGRA pixels: the format OpenGL reads
+    // frames back in, and so the one SnapshotEncoder and Y4mWriter take.
+    const uint8_t* frame() const {
+        return reinterpret_cast<const uint8_t*>(_pixels.get());
+    }
+
+    void begin_frame(int32_t seed) {
+        _seed = seed;
+        _commands.clear();
+    }
+
+    void add(Command command) {
+        _commands.push_back(std::move(command));
+    }
+
+    // Rasterizes the commands added since begin_frame(), and returns how many there were.
+    int end_frame(bool parallel) {
+        if (parallel) {
+            WorkerPool* pool = WorkerPool::pool();
+            _scratch.resize(pool->size());
+            pool->run(_size.height, kMinRowsPerBand, [this](int range, size_t begin, size_t end) {
+                rasterize(begin, end, &_scratch[range]);
+            });
+        } else {
+            _scratch.resize(1);
+            rasterize(0, _size.height, &_scratch[0]);
+        }
+        const int count = _commands.size();
+        _commands.clear();
+        return count;
+    }
+
+  private:
+    uint32_t* row(int32_t y) {
+        return _pixels.get() + ((_size.height - y - 1) * _size.width);
+    }
+
+    // Draws every command, clipped to the rows [top, bottom).  Each band of rows is drawn
+    // independently, so they may be drawn on different threads.
+    void rasterize(int32_t top, int32_t bottom, Scratch* scratch) {
+        const Rect band(0, top, _size.width, bottom);
+        const uint32_t black = pack(RgbColor::kBlack);
+        for (int32_t y = top; y < bottom; ++y) {
+            fill_span(row(y), black, _size.width);
+        }
+        for (const Command& command: _commands) {
+            if (command.kind == Command::LINE) {
+                draw_line(command, band);
+                continue;
+            }
+            Rect clip = command.rect;
+            clip.clip_to(band);
+            if (clip.empty()) {
+                continue;
+            }
+            switch (command.kind) {
+              case Command::FILL:
+                for (int32_t y = clip.top; y < clip.bottom; ++y) {
+                    blend_color_span(row(y) + clip.left, command.color, clip.width());
+                }
+                break;
+              case Command::DITHER:
+                draw_dither(command, clip);
+                break;
+              default:
+                draw_sprite(command, clip, scratch);
+                break;
+            }
+        }
+    }
+
+    // Like the OpenGL driver's shader, colors pixels whose coordinates sum to an odd number.
+    void draw_dither(const Command& command, const Rect& clip) {
+        for (int32_t y = clip.top; y < clip.bottom; ++y) {
+            uint32_t* p = row(y);
+            for (int32_t x = clip.left + ((clip.left + y + 1) & 1); x < clip.right; x += 2) {
+                p[x] = blend(command.color, p[x]);
+            }
+        }
+    }
+
+    // Bresenham's algorithm, plotting both end points.
+    void draw_line(const Command& command, const Rect& band) {
+        if ((max(command.from.v, command.to.v) < band.top)
+                || (min(command.from.v, command.to.v) >= band.bottom)) {
+            return;
+        }
+        int32_t x = command.from.h;
+        int32_t y = command.from.v;
+        const int32_t dx = abs(command.to.h - x);
+        const int32_t dy = -abs(command.to.v - y);
+        const int32_t step_x = (x < command.to.h) ? 1 : -1;
+        const int32_t step_y = (y < command.to.v) ? 1 : -1;
+        int32_t error = dx + dy;
+        while (true) {
+            if (band.contains(Point(x, y))) {
+                uint32_t* p = row(y) + x;
+                *p = blend(command.color, *p);
+            }
+            if ((x == command.to.h) && (y == command.to.v)) {
+                break;
+            }
+            const int32_t error2 = 2 * error;
+            if (error2 >= dy) {
+                error += dy;
+                x += step_x;
+            }
+            if (error2 <= dx) {
+                error += dx;
+                y += step_y;
+            }
+        }
+    }
+
+    void draw_sprite(const Command& command, const Rect& clip, Scratch* scratch) {
+        const Image& image = *command.image;
+        const Rect& dst = command.rect;
+        const Rect& src = command.source;
+
+        if ((command.kind == Command::SPRITE) && (dst.size() == src.size())) {
+            // Unscaled: blend straight from the sprite's rows.
+            const int32_t dx = src.left - dst.left;
+            const int32_t dy = src.top - dst.top;
+            const int32_t left = max(clip.left, -dx);
+            const int32_t right = min(clip.right, image.size.width - dx);
+            if (left >= right) {
+                return;
+            }
+            for (int32_t y = max(clip.top, -dy); y < min(clip.bottom, image.size.height - dy);
+                    ++y) {
+                blend_span(row(y) + left, image.row(y + dy) + left + dx, right - left);
+            }
+            return;
+        }
+
+        // Sample each pixel's center, as OpenGL does with GL_NEAREST.  Outlines look at the
+        // pixels around each, so map the columns either side of `clip` too.
+        const int32_t width = clip.width();
+        scratch->columns.resize(width + 2);
+        scratch->pixels.resize(width);
+        for (int32_t i = 0; i < (width + 2); ++i) {
+            const int32_t x = clip.left + i - 1;
+            scratch->columns[i] = sample(x - dst.left, dst.width(), src.left, src.width(),
+                    image.size.width);
+        }
+        const int32_t* columns = scratch->columns.data() + 1;
+        uint32_t* out = scratch->pixels.data();
+
+        for (int32_t y = clip.top; y < clip.bottom; ++y) {
+            const int32_t sy = sample(y - dst.top, dst.height(), src.top, src.height(),
+                    image.size.height);
+            if (sy < 0) {
+                continue;  // Every mode draws clear pixels as clear.
+            }
+            const uint32_t* texels = image.row(sy);
+            switch (command.kind) {
+              case Command::SPRITE:
+                for (int32_t i = 0; i < width; ++i) {
+                    out[i] = (columns[i] < 0) ? 0 : texels[columns[i]];
+                }
+                break;
+
+              case Command::SHADED:
+                for (int32_t i = 0; i < width; ++i) {
+                    const uint32_t t = (columns[i] < 0) ? 0 : texels[columns[i]];
+                    out[i] = pack(
+                            multiply(channel(command.color, R), channel(t, R)),
+                            multiply(channel(command.color, G), channel(t, G)),
+                            multiply(channel(command.color, B), channel(t, B)),
+                            channel(t, A));
+                }
+                break;
+
+              case Command::STATIC:
+                {
+                    const uint8_t* noise = _static.get() + (((y + _seed) & 0xff) * 256);
+                    const int32_t offset = _seed >> 8;
+                    for (int32_t i = 0; i < width; ++i) {
+                        const uint32_t t = (columns[i] < 0) ? 0 : texels[columns[i]];
+                        if (noise[(clip.left + i + offset) & 0xff] <= command.fraction) {
+                            out[i] = pack(
+                                    channel(command.color, R), channel(command.color, G),
+                                    channel(command.color, B),
+                                    multiply(channel(command.color, A), channel(t, A)));
+                        } else {
+                            out[i] = t;
+                        }
+                    }
+                }
+                break;
+
+              case Command::OUTLINED:
+                {
+                    const int32_t up = sample(y - 1 - dst.top, dst.height(), src.top,
+                            src.height(), image.size.height);
+                    const int32_t down = sample(y + 1 - dst.top, dst.height(), src.top,
+                            src.height(), image.size.height);
+                    for (int32_t i = 0; i < width; ++i) {
+                        const uint32_t alpha = alpha_at(image, columns[i], sy);
+                        if (alpha == 0) {
+                            out[i] = 0;
+                            continue;
+                        }
+                        uint32_t neighborhood =
+                            alpha_at(image, columns[i - 1], sy)
+                            + alpha_at(image, columns[i + 1], sy);
+                        for (int32_t j = -1; j <= 1; ++j) {
+                            neighborhood += alpha_at(image, columns[i + j], up)
+                                + alpha_at(image, columns[i + j], down);
+                        }
+                        out[i] = ((8 * alpha) > neighborhood)
+                            ? command.outline_color
+                            : command.color;
+                    }
+                }
+                break;
+
+              default:
+                break;
+            }
+            blend_span(row(y) + clip.left, out, width);
+        }
+    }
+
+    // Maps pixel `d` of `dst_size` to a texel of the span [src_begin, src_begin + src_size) of
+    // the sprite, or to -1 if that falls outside the sprite's `limit`.
+    static int32_t sample(
+            int32_t d, int32_t dst_size, int32_t src_begin, int32_t src_size, int32_t limit) {
+        const int32_t s = src_begin + floor_div(((2 * d) + 1) * src_size, 2 * dst_size);
+        return ((s < 0) || (s >= limit)) ? -1 : s;
+    }
+
+    static uint32_t alpha_at(const Image& image, int32_t x, int32_t y) {
+        return ((x < 0) || (y < 0)) ? 0 : channel(image.row(y)[x], A);
+    }
+
+    const Size _size;
+    unique_ptr<uint32_t[]> _pixels;
+    unique_ptr<uint8_t[]> _static;
+    int32_t _seed;
+    vector<Command> _commands;
+    vector<Scratch> _scratch;
+
+    DISALLOW_COPY_AND_ASSIGN(Canvas);
+};
+
+class SoftwareVideoDriver::Sprite : public antares::Sprite {
+  public:
+    Sprite(PrintItem name, shared_ptr<const Image> image, Canvas& canvas):
+            _name(name),
+            _image(image),
+            _canvas(canvas) { }
+
+    virtual StringSlice name() const {
+        return _name;
+    }
+
+    virtual void draw(const Rect& draw_rect) const {
+        _canvas.add(command(Command::SPRITE, draw_rect, Rect(Point(0, 0), size())));
+    }
+
+    virtual void draw_cropped(const Rect& draw_rect, Point origin) const {
+        _canvas.add(command(Command::SPRITE, draw_rect, Rect(origin, draw_rect.size())));
+    }
+
+    virtual void draw_shaded(const Rect& draw_rect, const RgbColor& tint) const {
+        Command c = command(Command::SHADED, draw_rect, Rect(Point(0, 0), size()));
+        c.color = pack(tint.red, tint.green, tint.blue, 255);
+        _canvas.add(std::move(c));
+    }
+
+    virtual void draw_static(const Rect& draw_rect, const RgbColor& color, uint8_t frac) const {
+        Command c = command(Command::STATIC, draw_rect, Rect(Point(0, 0), size()));
+        c.color = pack(color);
+        c.fraction = frac;
+        _canvas.add(std::move(c));
+    }
+
+    virtual void draw_outlined(
+            const Rect& draw_rect, const RgbColor& outline_color,
+            const RgbColor& fill_color) const {
+        Command c = command(Command::OUTLINED, draw_rect, Rect(Point(0, 0), size()));
+        c.color = pack(fill_color);
+        c.outline_color = pack(outline_color);
+        _canvas.add(std::move(c));
+    }
+
+    virtual const Size& size() const {
+        return _image->size;
+    }
+
+  private:
+    Command command(Command::Kind kind, const Rect& draw_rect, const Rect& source) const {
+        Command c = {kind, draw_rect, source};
+        c.image = _image;
+        return c;
+    }
+
+    const String _name;
+    const shared_ptr<const Image> _image;
+    Canvas& _canvas;
+
+    DISALLOW_COPY_AND_ASSIGN(Sprite);
+};
+
+class SoftwareVideoDriver::MainLoop : public EventScheduler::MainLoop {
+  public:
+    MainLoop(SoftwareVideoDriver& driver, Card* initial):
+            _driver(driver),
+            _stack(initial) {
+        if (driver._y4m_fd >= 0) {
+            _stream.reset(new Y4mWriter(
+                        driver._y4m_fd, driver._size, kTicksPerSecond,
+                        driver._ticks_per_frame));
+        } else if (driver._output_dir.has()) {
+            _encoder.reset(new SnapshotEncoder(
+                        driver._size, encoder_threads(),
+                        encoder_threads() * kFramesPerEncoderThread));
+        }
+    }
+
+    bool takes_snapshots() {
+        return _stream || _encoder;
+    }
+
+    void snapshot(int64_t ticks) {
+        const uint8_t* frame = _driver._canvas->frame();
+        if (_stream) {
+            _stream->add(frame);
+        } else {
+            String dir(format("{0}/screens", *_driver._output_dir));
+            makedirs(dir, 0755);
+            String path(format("{0}/{1}.png", dir, dec(ticks, 6)));
+            _encoder->add(path, frame);
+        }
+    }
+
+    // Waits for every snapshot to be written.
+    void finish() {
+        if (_encoder) {
+            _encoder->finish();
+        }
+    }
+
+    void draw() {
+        if (done()) {
+            return;
+        }
+        int32_t seed = {_driver._static_seed.next(256)};
+        seed <<= 8;
+        seed += _driver._static_seed.next(256);
+        _driver._canvas->begin_frame(seed);
+        _stack.top()->draw();
+        profile_frame(_driver._canvas->end_frame(_driver._parallel));
+    }
+
+    bool done() const { return _stack.empty(); }
+    Card* top() const { return _stack.top(); }
+
+  private:
+    SoftwareVideoDriver& _driver;
+    CardStack _stack;
+    unique_ptr<Y4mWriter> _stream;
+    unique_ptr<SnapshotEncoder> _encoder;
+};
+
+SoftwareVideoDriver::SoftwareVideoDriver(
+        Size screen_size, EventScheduler& scheduler, const Optional<String>& output_dir):
+        _size(screen_size),
+        _scheduler(scheduler),
+        _output_dir(output_dir),
+        _y4m_fd(-1),
+        _ticks_per_frame(1),
+        _parallel(false),
+        _static_seed{0},
+        _canvas(new Canvas(screen_size)) { }
+
+SoftwareVideoDriver::~SoftwareVideoDriver() { }
+
+void SoftwareVideoDriver::stream_y4m(int fd, int ticks_per_frame) {
+    _y4m_fd = fd;
+    _ticks_per_frame = ticks_per_frame;
+}
+
+void SoftwareVideoDriver::loop(Card* initial) {
+    MainLoop loop(*this, initial);
+    _scheduler.loop(loop);
+    loop.finish();
+}
+
+unique_ptr<antares::Sprite> SoftwareVideoDriver::new_sprite(
+        PrintItem name, const PixMap& content) {
+    shared_ptr<Image> image(new Image);
+    image->size = content.size();
+    image->pixels.reset(new uint32_t[content.size().width * content.size().height]);
+    for (int32_t y = 0; y < content.size().height; ++y) {
+        const RgbColor* src = content.row(y);
+        uint32_t* dst = image->pixels.get() + (y * content.size().width);
+        for (int32_t x = 0; x < content.size().width; ++x) {
+            dst[x] = pack(src[x]);
+        }
+    }
+    return unique_ptr<antares::Sprite>(new Sprite(name, image, *_canvas));
+}
+
+void SoftwareVideoDriver::fill_rect(const Rect& rect, const RgbColor& color) {
+    Command command = {Command::FILL, rect};
+    command.color = pack(color);
+    _canvas->add(std::move(command));
+}
+
+void SoftwareVideoDriver::dither_rect(const Rect& rect, const RgbColor& color) {
+    Command command = {Command::DITHER, rect};
+    command.color = pack(color);
+    _canvas->add(std::move(command));
+}
+
+void SoftwareVideoDriver::draw_point(const Point& at, const RgbColor& color) {
+    fill_rect(Rect(at.h, at.v, at.h + 1, at.v + 1), color);
+}
+
+void SoftwareVideoDriver::draw_line(const Point& from, const Point& to, const RgbColor& color) {
+    // As in the OpenGL driver, horizontal and vertical lines are rects.
+    if ((from.h == to.h) || (from.v == to.v)) {
+        Rect rect(
+                min(from.h, to.h), min(from.v, to.v),
+                max(from.h, to.h) + 1, max(from.v, to.v) + 1);
+        fill_rect(rect, color);
+        return;
+    }
+    Command command = {Command::LINE};
+    command.from = from;
+    command.to = to;
+    command.color = pack(color);
+    _canvas->add(std::move(command));
+}
+
+void SoftwareVideoDriver::draw_triangle(const Rect& rect, const RgbColor& color) {
+    size_t size = min(rect.width(), rect.height());
+    Rect to(0, 0, size, size);
+    to.offset(rect.left, rect.top);
+    if (_triangles.find(size) == _triangles.end()) {
+        ArrayPixMap pix(size, size);
+        pix.fill(RgbColor::kClear);
+        draw_triangle_up(&pix, RgbColor::kWhite);
+        _triangles[size] = new_sprite("", pix);
+    }
+    _triangles[size]->draw_shaded(to, color);
+}
+
+void SoftwareVideoDriver::draw_diamond(const Rect& rect, const RgbColor& color) {
+    size_t size = min(rect.width(), rect.height());
+    Rect to(0, 0, size, size);
+    to.offset(rect.left, rect.top);
+    if (_diamonds.find(size) == _diamonds.end()) {
+        ArrayPixMap pix(size, size);
+        pix.fill(RgbColor::kClear);
+        draw_compat_diamond(&pix, RgbColor::kWhite);
+        _diamonds[size] = new_sprite("", pix);
+    }
+    _diamonds[size]->draw_shaded(to, color);
+}
+
+void SoftwareVideoDriver::draw_plus(const Rect& rect, const RgbColor& color) {
+    size_t size = min(rect.width(), rect.height());
+    Rect to(0, 0, size, size);
+    to.offset(rect.left, rect.top);
+    if (_pluses.find(size) == _pluses.end()) {
+        ArrayPixMap pix(size, size);
+        pix.fill(RgbColor::kClear);
+        draw_compat_plus(&pix, RgbColor::kWhite);
+        _pluses[size] = new_sprite("", pix);
+    }
+    _pluses[size]->draw_shaded(to, color);
+}
+
+}  // namespace antares
@@ -0,0 +1,195 @@
+// Copyright (C) 1997, 1999-2001, 2008 Nathan Lamont
+// Copyright (C) 2008-2012 The Antares Authors
+//
+// This file is part of Antares, a tactical space combat game.
+//
+// Antares is free software: you can redistribute it and/or modify it
+// under the terms of the Lesser GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Antares is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with Antares.  If not, see http://www.gnu.org/licenses/
+
+#include "video/y4m-writer.hpp"
+
+#include <string.h>
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using sfz::String;
+using sfz::format;
+using sfz::write;
+using std::min;
+
+namespace utf8 = sfz::utf8;
+
+namespace antares {
+
+namespace {
+
+// BT.601 coefficients, scaled by 256.
+inline uint8_t luma(int r, int g, int b) {
+    return ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+}
+
+inline uint8_t chroma_blue(int r, int g, int b) {
+    return ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+}
+
+inline uint8_t chroma_red(int r, int g, int b) {
+    return ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+}
+
+#ifdef __SSE2__
+
+// Each 32-bit lane of `r`, `g` and `b` holds one channel of a pixel, from 0 to 255.
+inline __m128i dot(__m128i r, __m128i g, __m128i b, int16_t kr, int16_t kg, int16_t kb) {
+    // With the high half of each lane zero, _mm_madd_epi16() is a signed 32-bit multiply.
+    const __m128i sum = _mm_add_epi32(
+            _mm_add_epi32(
+                _mm_madd_epi16(r, _mm_set1_epi32(static_cast<uint16_t>(kr))),
+                _mm_madd_epi16(g, _mm_set1_epi32(static_cast<uint16_t>(kg)))),
+            _mm_madd_epi16(b, _mm_set1_epi32(static_cast<uint16_t>(kb))));
+    return _mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8);
+}
+
+// Splits four BGRA pixels into one vector per channel.
+inline void split(__m128i p, __m128i* r, __m128i* g, __m128i* b) {
+    const __m128i mask = _mm_set1_epi32(0xff);
+    *b = _mm_and_si128(p, mask);
+    *g = _mm_and_si128(_mm_srli_epi32(p, 8), mask);
+    *r = _mm_and_si128(_mm_srli_epi32(p, 16), mask);
+}
+
+inline __m128i load(const uint8_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+inline __m128i luma4(const uint8_t* p) {
+    __m128i r, g, b;
+    split(load(p), &r, &g, &b);
+    return _mm_add_epi32(dot(r, g, b, 66, 129, 25), _mm_set1_epi32(16));
+}
+
+// Sums lanes 0 and 1, and lanes 2 and 3, of `lo` and `hi`, and returns the four sums.
+inline __m128i sum_pairs(__m128i lo, __m128i hi) {
+    lo = _mm_add_epi32(lo, _mm_srli_epi64(lo, 32));
+    hi = _mm_add_epi32(hi, _mm_srli_epi64(hi, 32));
+    return _mm_unpacklo_epi64(
+            _mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 1, 2, 0)),
+            _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+#endif  // __SSE2__
+
+void luma_row(const uint8_t* src, uint8_t* dst, int32_t width) {
+    int32_t x = 0;
+#ifdef __SSE2__
+    for ( ; (x + 8) <= width; x += 8) {
+        const __m128i y = _mm_packs_epi32(luma4(src + (x * 4)), luma4(src + (x * 4) + 16));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(y, y));
+    }
+#endif  // __SSE2__
+    for ( ; x < width; ++x) {
+        const uint8_t* p = src + (x * 4);
+        dst[x] = luma(p[2], p[1], p[0]);
+    }
+}
+
+// Averages each 2x2 block of pixels in rows `src0` and `src1`.
+void chroma_row(
+        const uint8_t* src0, const uint8_t* src1, uint8_t* u, uint8_t* v, int32_t width) {
+    int32_t x = 0;
+#ifdef __SSE2__
+    for ( ; (x + 8) <= width; x += 8) {
+        __m128i r[4], g[4], b[4];
+        split(load(src0 + (x * 4)), &r[0], &g[0], &b[0]);
+        split(load(src0 + (x * 4) + 16), &r[1], &g[1], &b[1]);
+        split(load(src1 + (x * 4)), &r[2], &g[2], &b[2]);
+        split(load(src1 + (x * 4) + 16), &r[3], &g[3], &b[3]);
+        const __m128i two = _mm_set1_epi32(2);
+        const __m128i red = _mm_srli_epi32(_mm_add_epi32(sum_pairs(
+                        _mm_add_epi32(r[0], r[2]), _mm_add_epi32(r[1], r[3])), two), 2);
+        const __m128i green = _mm_srli_epi32(_mm_add_epi32(sum_pairs(
+                        _mm_add_epi32(g[0], g[2]), _mm_add_epi32(g[1], g[3])), two), 2);
+        const __m128i blue = _mm_srli_epi32(_mm_add_epi32(sum_pairs(
+                        _mm_add_epi32(b[0], b[2]), _mm_add_epi32(b[1], b[3])), two), 2);
+        const __m128i offset = _mm_set1_epi32(128);
+        const __m128i cb = _mm_add_epi32(dot(red, green, blue, -38, -74, 112), offset);
+        const __m128i cr = _mm_add_epi32(dot(red, green, blue, 112, -94, -18), offset);
+        __m128i packed = _mm_packs_epi32(cb, cr);
+        packed = _mm_packus_epi16(packed, packed);
+        const int32_t cb4 = _mm_cvtsi128_si32(packed);
+        const int32_t cr4 = _mm_cvtsi128_si32(_mm_srli_si128(packed, 4));
+        memcpy(u + (x / 2), &cb4, 4);
+        memcpy(v + (x / 2), &cr4, 4);
+    }
+#endif  // __SSE2__
+    for ( ; x < width; x += 2) {
+        const int32_t n = min(width - x, 2);
+        int r = 0, g = 0, b = 0;
+        for (int32_t i = 0; i < n; ++i) {
+            const uint8_t* p0 = src0 + ((x + i) * 4);
+            const uint8_t* p1 = src1 + ((x + i) * 4);
+            r += p0[2] + p1[2];
+            g += p0[1] + p1[1];
+            b += p0[0] + p1[0];
+        }
+        r = (r + n) / (2 * n);
+        g = (g + n) / (2 * n);
+        b = (b + n) / (2 * n);
+        u[x / 2] = chroma_blue(r, g, b);
+        v[x / 2] = chroma_red(r, g, b);
+    }
+}
+
+}  // namespace
+
+void convert_bgra_to_i420(const uint8_t* bgra, Size size, uint8_t* y, uint8_t* u, uint8_t* v) {
+    const int32_t width = size.width;
+    const int32_t height = size.height;
+    const int32_t chroma_width = (width + 1) / 2;
+    for (int32_t row = 0; row < height; row += 2) {
+        // The frame is bottom-up; an odd last row is averaged with itself.
+        const uint8_t* src0 = bgra + ((height - row - 1) * width * 4);
+        const uint8_t* src1 = ((row + 1) < height) ? (src0 - (width * 4)) : src0;
+        luma_row(src0, y + (row * width), width);
+        if ((row + 1) < height) {
+            luma_row(src1, y + ((row + 1) * width), width);
+        }
+        chroma_row(
+                src0, src1, u + ((row / 2) * chroma_width), v + ((row / 2) * chroma_width),
+                width);
+    }
+}
+
+Y4mWriter::Y4mWriter(int fd, Size size, int rate_num, int rate_den):
+        _file(fd),
+        _size(size),
+        _luma_size(size.width * size.height),
+        _chroma_size(((size.width + 1) / 2) * ((size.height + 1) / 2)),
+        _frame(new uint8_t[_luma_size + (2 * _chroma_size)]) {
+    String header(format(
+                "YUV4MPEG2 W{0} H{1} F{2}:{3} Ip A1:1 C420jpeg\n",
+                size.width, size.height, rate_num, rate_den));
+    write(_file, utf8::encode(header));
+}
+
+void Y4mWriter::add(const uint8_t* bgra) {
+    uint8_t* y = _frame.get();
+    uint8_t* u = y + _luma_size;
+    uint8_t* v = u + _chroma_size;
+    convert_bgra_to_i420(bgra, _size, y, u, v);
+    write(_file, "FRAME\n");
+    write(_file, _frame.get(), _luma_size + (2 * _chroma_size));
+}
+
+}  // namespace antares